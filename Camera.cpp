@@ -60,6 +60,19 @@ Transform Camera::getRelativeMotion()
 	return relativeMotion;
 }
 
+float Camera::GetProjectedSize(DirectX::XMFLOAT3 center, float radius)
+{
+	//_22 is the vertical projection scale, 1 / tan(fov / 2) for perspective
+	if (viewType == CameraViewType::orthographic)
+		return radius * projectionMatrix._22;
+
+	XMFLOAT3 position = transform.getPosition();
+	float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&center), XMLoadFloat3(&position))));
+	if (distance <= radius)
+		return 1.0f; //inside the sphere, it fills the screen
+	return radius * projectionMatrix._22 / distance;
+}
+
 //update
 
 void Camera::Update(float dt) {
@@ -95,22 +108,27 @@ void Camera::Update(float dt) {
 	}
 
 	//use mouse to look around if mouse is down
+	// clamp pitch to prevent flipping over
+	// also when camera moves it will rotate around the x axis to maintain what the user sees since the look at is indepdant from the position
+	//clamped before it is set so the orientation only gets rebuilt once per look
 	if (InputManager::MouseLeftDown()) {
 		int cursorMovementX = InputManager::GetMouseXDelta();  //make float
 		int cursorMovementY = InputManager::GetMouseYDelta();
-		transform.Rotate(cursorMovementY * mouseLookSpeed, (cursorMovementX * mouseLookSpeed), 0);
+		XMFLOAT3 pitchYawRoll = transform.getPitchYawRoll();
+		pitchYawRoll.x += cursorMovementY * mouseLookSpeed;
+		pitchYawRoll.y += cursorMovementX * mouseLookSpeed;
+		if (pitchYawRoll.x > (3.141592f / 2.0f)) {
+			pitchYawRoll.x = (3.141592f / 2.0f);
+		}
+		if (pitchYawRoll.x < -(3.141592f / 2.0f)) {
+			pitchYawRoll.x = -(3.141592f / 2.0f);
+		}
+		if (cursorMovementX != 0 || cursorMovementY != 0) {
+			transform.setRotation(pitchYawRoll);
+		}
 		relativeMotion.moveAbsolute(cursorMovementX * mouseLookSpeed * 2, cursorMovementY * mouseLookSpeed * 2, 0);
 	}
 
-	// clamp pitch to prevent flipping over
-	// also when camera moves it will rotate around the x axis to maintain what the user sees since the look at is indepdant from the position
-	if (transform.getPitchYawRoll().x > (3.141592f / 2.0f)) {
-		transform.setRotation((3.141592f / 2.0f), transform.getPitchYawRoll().y, transform.getPitchYawRoll().z);
-	}
-	if (transform.getPitchYawRoll().x < -(3.141592f / 2.0f)) {
-		transform.setRotation(-(3.141592f / 2.0f), transform.getPitchYawRoll().y, transform.getPitchYawRoll().z);
-	}
-
 
 	UpdateViewMatrix();
 }
@@ -130,6 +148,7 @@ void Camera::UpdateViewMatrix()
 			XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)             // Up vector
 		)
 	);
+	UpdateFrustum();
 }
 
 
@@ -137,4 +156,12 @@ void Camera::UpdateViewMatrix()
 void Camera::UpdateProjectionMatrix(float aspectRatio)
 {
 	XMStoreFloat4x4(&projectionMatrix, XMMatrixPerspectiveFovLH(fov, aspectRatio, nearP, farP));
+	UpdateFrustum();
+}
+
+void Camera::UpdateFrustum()
+{
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(XMLoadFloat4x4(&viewMatrix), XMLoadFloat4x4(&projectionMatrix)));
+	frustum = Culling::ExtractFrustum(viewProjection);
 }
\ No newline at end of file
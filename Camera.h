@@ -2,6 +2,7 @@
 #include "DirectXMath.h"
 #include "Transform.h"
 #include "Input.h"
+#include "Culling.h"
 
 enum CameraViewType
 {
@@ -26,6 +27,12 @@ public:
 	Transform getTransform();
 	Transform getRelativeMotion();
 
+	//diameter of a world space sphere on screen as a fraction of the screen height, used to pick lods
+	float GetProjectedSize(DirectX::XMFLOAT3 center, float radius);
+	float GetFarClip() { return farP; }
+	//world space planes from view * projection, rebuilt whenever either matrix is
+	const Frustum& GetFrustum() { return frustum; }
+
 	void Update(float deltaTime);
 	void UpdateProjectionMatrix(float aspectRatio);	
 
@@ -35,7 +42,8 @@ private:
 	Transform relativeMotion;
 
 	DirectX::XMFLOAT4X4 viewMatrix;
-	DirectX::XMFLOAT4X4 projectionMatrix;
+	DirectX::XMFLOAT4X4 projectionMatrix = {}; //zeroed, the constructors build the frustum once before it exists
+	Frustum frustum;
 
 	float fov;
 	float aspectRatio;
@@ -48,5 +56,6 @@ private:
 	CameraViewType viewType;
 
 	void UpdateViewMatrix();
+	void UpdateFrustum();
 };
 
@@ -0,0 +1,300 @@
+#include "CommandBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace
+{
+	constexpr size_t COMMAND_ALIGNMENT = sizeof(uint64_t);
+
+	inline size_t AlignCommand(size_t bytes)
+	{
+		return (bytes + COMMAND_ALIGNMENT - 1) & ~(COMMAND_ALIGNMENT - 1);
+	}
+
+	const char* const COMMAND_NAMES[] =
+	{
+		"SetVertexShader",
+		"SetPixelShader",
+		"UpdateBuffer",
+		"SetConstantBuffer",
+		"SetVertexBuffer",
+		"SetIndexBuffer",
+		"DrawIndexed",
+		"DrawIndexedInstanced",
+	};
+	static_assert(sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]) == (size_t)CommandType::Count, "a name for every command");
+
+	//smallest size each command can have, anything under it is malformed
+	const size_t COMMAND_SIZES[] =
+	{
+		sizeof(SetVertexShaderCommand),
+		sizeof(SetPixelShaderCommand),
+		sizeof(UpdateBufferCommand),
+		sizeof(SetConstantBufferCommand),
+		sizeof(SetVertexBufferCommand),
+		sizeof(SetIndexBufferCommand),
+		sizeof(DrawIndexedCommand),
+		sizeof(DrawIndexedInstancedCommand),
+	};
+}
+
+const char* GetCommandName(CommandType type)
+{
+	return type < CommandType::Count ? COMMAND_NAMES[(size_t)type] : "Unknown";
+}
+
+void CommandBuffer::Reset()
+{
+	size = 0;
+	commandCount = 0;
+}
+
+template<typename T>
+T* CommandBuffer::Allocate(CommandType type, size_t extraBytes)
+{
+	size_t commandSize = AlignCommand(sizeof(T) + extraBytes);
+	//grows by doubling like a vector would, but never shrinks
+	size_t words = (size + commandSize) / sizeof(uint64_t);
+	if (words > storage.size())
+		storage.resize(std::max(words, storage.size() * 2));
+	T* command = new ((uint8_t*)storage.data() + size) T();
+	command->type = type;
+	command->size = (uint32_t)commandSize;
+	size += commandSize;
+	commandCount++;
+	return command;
+}
+
+const CommandHeader* CommandBuffer::Next(const CommandHeader* command) const
+{
+	size_t offset = (const uint8_t*)command - GetData() + command->size;
+	//a zero size would walk in place forever, treat it as the end (NullCommandExecutor reports it)
+	if (command->size == 0 || offset >= size)
+		return nullptr;
+	return (const CommandHeader*)(GetData() + offset);
+}
+
+void CommandBuffer::SetVertexShader(ID3D11VertexShader* shader, ID3D11InputLayout* inputLayout)
+{
+	SetVertexShaderCommand* command = Allocate<SetVertexShaderCommand>(CommandType::SetVertexShader);
+	command->shader = shader;
+	command->inputLayout = inputLayout;
+}
+
+void CommandBuffer::SetPixelShader(ID3D11PixelShader* shader)
+{
+	Allocate<SetPixelShaderCommand>(CommandType::SetPixelShader)->shader = shader;
+}
+
+void CommandBuffer::UpdateBuffer(ID3D11Buffer* buffer, const void* data, uint32_t size, uint32_t offset, BufferWrite mode)
+{
+	memcpy(WriteBuffer(buffer, size, offset, mode), data, size);
+}
+
+void* CommandBuffer::WriteBuffer(ID3D11Buffer* buffer, uint32_t size, uint32_t offset, BufferWrite mode)
+{
+	UpdateBufferCommand* command = Allocate<UpdateBufferCommand>(CommandType::UpdateBuffer, size);
+	command->buffer = buffer;
+	command->offset = offset;
+	command->dataSize = size;
+	command->mode = mode;
+	return command + 1;
+}
+
+void CommandBuffer::SetConstantBuffer(ShaderStage stage, uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant, uint32_t constantCount)
+{
+	SetConstantBufferCommand* command = Allocate<SetConstantBufferCommand>(CommandType::SetConstantBuffer);
+	command->stage = stage;
+	command->slot = slot;
+	command->buffer = buffer;
+	command->firstConstant = firstConstant;
+	command->constantCount = constantCount;
+}
+
+void CommandBuffer::SetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset)
+{
+	SetVertexBufferCommand* command = Allocate<SetVertexBufferCommand>(CommandType::SetVertexBuffer);
+	command->slot = slot;
+	command->stride = stride;
+	command->offset = offset;
+	command->buffer = buffer;
+}
+
+void CommandBuffer::SetIndexBuffer(ID3D11Buffer* buffer, bool sixteenBit)
+{
+	SetIndexBufferCommand* command = Allocate<SetIndexBufferCommand>(CommandType::SetIndexBuffer);
+	command->buffer = buffer;
+	command->sixteenBit = sixteenBit;
+}
+
+void CommandBuffer::DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex)
+{
+	DrawIndexedCommand* command = Allocate<DrawIndexedCommand>(CommandType::DrawIndexed);
+	command->indexCount = indexCount;
+	command->firstIndex = firstIndex;
+	command->baseVertex = baseVertex;
+}
+
+void CommandBuffer::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+{
+	DrawIndexedInstancedCommand* command = Allocate<DrawIndexedInstancedCommand>(CommandType::DrawIndexedInstanced);
+	command->indexCount = indexCount;
+	command->instanceCount = instanceCount;
+	command->firstIndex = firstIndex;
+	command->baseVertex = baseVertex;
+	command->firstInstance = firstInstance;
+}
+
+void NullCommandExecutor::Reset()
+{
+	*this = NullCommandExecutor();
+}
+
+void NullCommandExecutor::Error(size_t offset, const char* message)
+{
+	errorCount++;
+	if (errors.size() < MAX_ERRORS)
+		errors.push_back("byte " + std::to_string(offset) + ": " + message);
+}
+
+void NullCommandExecutor::ValidateDraw(size_t offset, bool instanced)
+{
+	if (!vertexShader)
+		Error(offset, "draw without a vertex shader");
+	if (!inputLayout)
+		Error(offset, "draw without an input layout");
+	if (!pixelShader)
+		Error(offset, "draw without a pixel shader");
+	if (!indexBuffer)
+		Error(offset, "indexed draw without an index buffer");
+	if (!vertexBuffers[0].buffer)
+		Error(offset, "draw without a vertex buffer in slot 0");
+	if (instanced && !vertexBuffers[1].buffer)
+		Error(offset, "instanced draw without an instance buffer in slot 1");
+}
+
+void NullCommandExecutor::Execute(const CommandBuffer& commands)
+{
+	const uint8_t* data = commands.GetData();
+	size_t size = commands.GetSize();
+	for (size_t offset = 0; offset < size;)
+	{
+		const CommandHeader* command = (const CommandHeader*)(data + offset);
+		if ((size_t)command->type >= (size_t)CommandType::Count)
+		{
+			Error(offset, "unknown command type");
+			return;
+		}
+		if (command->size < COMMAND_SIZES[(size_t)command->type] || command->size % COMMAND_ALIGNMENT || offset + command->size > size)
+		{
+			Error(offset, "bad command size");
+			return;
+		}
+		stats.commands[(size_t)command->type]++;
+
+		switch (command->type)
+		{
+		case CommandType::SetVertexShader:
+		{
+			const SetVertexShaderCommand* set = static_cast<const SetVertexShaderCommand*>(command);
+			if (!set->shader)
+				Error(offset, "null vertex shader");
+			if (set->shader == vertexShader && set->inputLayout == inputLayout)
+				stats.redundantBinds++;
+			vertexShader = set->shader;
+			inputLayout = set->inputLayout;
+			break;
+		}
+		case CommandType::SetPixelShader:
+		{
+			const SetPixelShaderCommand* set = static_cast<const SetPixelShaderCommand*>(command);
+			if (!set->shader)
+				Error(offset, "null pixel shader");
+			if (set->shader == pixelShader)
+				stats.redundantBinds++;
+			pixelShader = set->shader;
+			break;
+		}
+		case CommandType::UpdateBuffer:
+		{
+			const UpdateBufferCommand* update = static_cast<const UpdateBufferCommand*>(command);
+			if (!update->buffer)
+				Error(offset, "update of a null buffer");
+			if (sizeof(UpdateBufferCommand) + update->dataSize > command->size)
+				Error(offset, "update data runs past its command");
+			if (update->mode == BufferWrite::Replace && update->offset != 0)
+				Error(offset, "replacing updates cover the whole buffer, offset has to be 0");
+			if (update->dataSize == 0)
+				Error(offset, "empty update");
+			stats.uploadedBytes += update->dataSize;
+			break;
+		}
+		case CommandType::SetConstantBuffer:
+		{
+			const SetConstantBufferCommand* set = static_cast<const SetConstantBufferCommand*>(command);
+			if (set->slot >= MAX_CONSTANT_BUFFER_SLOTS || (size_t)set->stage > (size_t)ShaderStage::Pixel)
+			{
+				Error(offset, "constant buffer slot out of range");
+				break;
+			}
+			if (set->constantCount && (set->firstConstant % 16 || set->constantCount % 16))
+				Error(offset, "constant buffer range not in multiples of 16 constants");
+			ConstantBinding& bound = constantBuffers[(size_t)set->stage][set->slot];
+			if (bound.buffer == set->buffer && bound.firstConstant == set->firstConstant && bound.constantCount == set->constantCount)
+				stats.redundantBinds++;
+			bound = { set->buffer, set->firstConstant, set->constantCount };
+			break;
+		}
+		case CommandType::SetVertexBuffer:
+		{
+			const SetVertexBufferCommand* set = static_cast<const SetVertexBufferCommand*>(command);
+			if (set->slot >= MAX_VERTEX_BUFFER_SLOTS)
+			{
+				Error(offset, "vertex buffer slot out of range");
+				break;
+			}
+			if (set->buffer && set->stride == 0)
+				Error(offset, "vertex buffer with a zero stride");
+			VertexBinding& bound = vertexBuffers[set->slot];
+			if (bound.buffer == set->buffer && bound.stride == set->stride && bound.offset == set->offset)
+				stats.redundantBinds++;
+			bound = { set->buffer, set->stride, set->offset };
+			break;
+		}
+		case CommandType::SetIndexBuffer:
+		{
+			const SetIndexBufferCommand* set = static_cast<const SetIndexBufferCommand*>(command);
+			if (set->buffer == indexBuffer && set->sixteenBit == sixteenBitIndices)
+				stats.redundantBinds++;
+			indexBuffer = set->buffer;
+			sixteenBitIndices = set->sixteenBit;
+			break;
+		}
+		case CommandType::DrawIndexed:
+		{
+			const DrawIndexedCommand* draw = static_cast<const DrawIndexedCommand*>(command);
+			ValidateDraw(offset, false);
+			if (draw->indexCount == 0)
+				Error(offset, "draw with no indices");
+			stats.drawCalls++;
+			stats.indices += draw->indexCount;
+			break;
+		}
+		case CommandType::DrawIndexedInstanced:
+		{
+			const DrawIndexedInstancedCommand* draw = static_cast<const DrawIndexedInstancedCommand*>(command);
+			ValidateDraw(offset, true);
+			if (draw->indexCount == 0 || draw->instanceCount == 0)
+				Error(offset, "instanced draw with no indices or instances");
+			stats.drawCalls++;
+			stats.indices += (uint64_t)draw->indexCount * draw->instanceCount;
+			stats.instances += draw->instanceCount;
+			break;
+		}
+		default:
+			break;
+		}
+		offset += command->size;
+	}
+}
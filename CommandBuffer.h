@@ -0,0 +1,209 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//only ever passed through as handles here, so no d3d headers are needed (CommandBuffer builds anywhere)
+struct ID3D11Buffer;
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11InputLayout;
+
+enum class CommandType : uint8_t
+{
+	SetVertexShader,
+	SetPixelShader,
+	UpdateBuffer,
+	SetConstantBuffer,
+	SetVertexBuffer,
+	SetIndexBuffer,
+	DrawIndexed,
+	DrawIndexedInstanced,
+	Count
+};
+const char* GetCommandName(CommandType type);
+
+enum class ShaderStage : uint8_t
+{
+	Vertex,
+	Pixel
+};
+
+//how UpdateBuffer gets its bytes into the buffer
+enum class BufferWrite : uint8_t
+{
+	Replace, //UpdateSubresource of the whole buffer (default usage, constant buffers), offset has to be 0
+	Discard, //map with WRITE_DISCARD, then write at offset
+	NoOverwrite //map with WRITE_NO_OVERWRITE, then write at offset
+};
+
+//every command starts with this, size covers the command and anything after it (always a multiple of 8)
+struct CommandHeader
+{
+	CommandType type;
+	uint32_t size;
+};
+
+struct SetVertexShaderCommand : CommandHeader
+{
+	ID3D11VertexShader* shader;
+	ID3D11InputLayout* inputLayout;
+};
+
+struct SetPixelShaderCommand : CommandHeader
+{
+	ID3D11PixelShader* shader;
+};
+
+//dataSize bytes follow the command
+struct UpdateBufferCommand : CommandHeader
+{
+	ID3D11Buffer* buffer;
+	uint32_t offset;
+	uint32_t dataSize;
+	BufferWrite mode;
+	const void* GetData() const { return this + 1; }
+};
+
+//constantCount 0 binds the whole buffer, otherwise a range of it (16 byte constants, d3d 11.1 wants multiples of 16 of them)
+struct SetConstantBufferCommand : CommandHeader
+{
+	ShaderStage stage;
+	uint32_t slot;
+	ID3D11Buffer* buffer;
+	uint32_t firstConstant;
+	uint32_t constantCount;
+};
+
+struct SetVertexBufferCommand : CommandHeader
+{
+	uint32_t slot;
+	uint32_t stride;
+	uint32_t offset;
+	ID3D11Buffer* buffer;
+};
+
+struct SetIndexBufferCommand : CommandHeader
+{
+	ID3D11Buffer* buffer;
+	bool sixteenBit;
+};
+
+struct DrawIndexedCommand : CommandHeader
+{
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t baseVertex;
+};
+
+struct DrawIndexedInstancedCommand : CommandHeader
+{
+	uint32_t indexCount;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t baseVertex;
+	uint32_t firstInstance;
+};
+
+// A frame's draw submission recorded as a flat list of commands, replayed later by an ICommandExecutor
+// - commands are packed back to back in one growing allocation, Reset keeps the capacity so steady state recording doesn't allocate
+// - buffer uploads are commands too (their bytes are copied in), so they land in order with the draws that read them
+class CommandBuffer
+{
+public:
+	void Reset();
+
+	void SetVertexShader(ID3D11VertexShader* shader, ID3D11InputLayout* inputLayout);
+	void SetPixelShader(ID3D11PixelShader* shader);
+	void UpdateBuffer(ID3D11Buffer* buffer, const void* data, uint32_t size, uint32_t offset = 0, BufferWrite mode = BufferWrite::Replace);
+	//same as UpdateBuffer, but the caller fills in the size bytes it returns, only until the next command is recorded (they may move)
+	void* WriteBuffer(ID3D11Buffer* buffer, uint32_t size, uint32_t offset = 0, BufferWrite mode = BufferWrite::Replace);
+	void SetConstantBuffer(ShaderStage stage, uint32_t slot, ID3D11Buffer* buffer, uint32_t firstConstant = 0, uint32_t constantCount = 0);
+	void SetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset = 0);
+	void SetIndexBuffer(ID3D11Buffer* buffer, bool sixteenBit);
+	void DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex);
+	void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance);
+
+	//walking the commands: for (const CommandHeader* c = First(); c; c = Next(c)), then static_cast by c->type
+	const CommandHeader* First() const { return size ? (const CommandHeader*)storage.data() : nullptr; }
+	const CommandHeader* Next(const CommandHeader* command) const;
+
+	const uint8_t* GetData() const { return (const uint8_t*)storage.data(); }
+	size_t GetSize() const { return size; } //bytes
+	unsigned int GetCommandCount() const { return commandCount; }
+
+private:
+	std::vector<uint64_t> storage; //64 bit words so the commands' pointers stay aligned
+	size_t size = 0;
+	unsigned int commandCount = 0;
+
+	template<typename T>
+	T* Allocate(CommandType type, size_t extraBytes = 0);
+};
+
+//plays a CommandBuffer back somewhere
+class ICommandExecutor
+{
+public:
+	virtual ~ICommandExecutor() = default;
+	virtual void Execute(const CommandBuffer& commands) = 0;
+};
+
+struct CommandStats
+{
+	unsigned int commands[(size_t)CommandType::Count] = {};
+	unsigned int drawCalls = 0; //both kinds
+	uint64_t indices = 0; //times instances for instanced draws
+	uint64_t instances = 0;
+	uint64_t uploadedBytes = 0;
+	unsigned int redundantBinds = 0; //shader or buffer set to what was already bound
+};
+
+// Executor that talks to no gpu at all, it tracks the binding state the commands would leave behind and checks every one against it
+// - counts go in GetStats, problems (draws with nothing bound, bad slots or ranges, malformed commands) in GetErrors
+// - stats and errors add up over Execute calls until Reset, so several buffers can make up one frame
+class NullCommandExecutor : public ICommandExecutor
+{
+public:
+	static constexpr unsigned int MAX_CONSTANT_BUFFER_SLOTS = 14; //D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT
+	static constexpr unsigned int MAX_VERTEX_BUFFER_SLOTS = 32; //D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT
+	static constexpr size_t MAX_ERRORS = 32; //the count keeps going, the messages stop
+
+	void Execute(const CommandBuffer& commands) override;
+	//forgets the stats, errors and binding state
+	void Reset();
+
+	const CommandStats& GetStats() const { return stats; }
+	unsigned int GetErrorCount() const { return errorCount; }
+	const std::vector<std::string>& GetErrors() const { return errors; }
+
+private:
+	CommandStats stats;
+	unsigned int errorCount = 0;
+	std::vector<std::string> errors;
+
+	//what the commands have bound so far
+	ID3D11VertexShader* vertexShader = nullptr;
+	ID3D11InputLayout* inputLayout = nullptr;
+	ID3D11PixelShader* pixelShader = nullptr;
+	ID3D11Buffer* indexBuffer = nullptr;
+	bool sixteenBitIndices = false;
+	struct VertexBinding
+	{
+		ID3D11Buffer* buffer = nullptr;
+		uint32_t stride = 0;
+		uint32_t offset = 0;
+	};
+	VertexBinding vertexBuffers[MAX_VERTEX_BUFFER_SLOTS];
+	struct ConstantBinding
+	{
+		ID3D11Buffer* buffer = nullptr;
+		uint32_t firstConstant = 0;
+		uint32_t constantCount = 0;
+	};
+	ConstantBinding constantBuffers[2][MAX_CONSTANT_BUFFER_SLOTS]; //by ShaderStage
+
+	void Error(size_t offset, const char* message);
+	void ValidateDraw(size_t offset, bool instanced);
+};
@@ -0,0 +1,39 @@
+#include "ShaderStructs.hlsli"
+
+
+cbuffer PerFrameData : register(b0)
+{
+    matrix view;
+    matrix projection;
+}
+
+cbuffer PerObjectData : register(b1)
+{
+    matrix world;
+    matrix worldInvTrans;
+    float3 positionOffset; // mesh bounds min
+    float3 positionScale; // mesh bounds max - min
+}
+
+// octahedral decode, matches VertexQuantization::Decode
+float3 DecodeOctahedral(float2 e)
+{
+    float3 n = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy -= t * (step(0.0f, n.xy) * 2.0f - 1.0f);
+    return normalize(n);
+}
+
+
+VertexToPixel main(CompactVertexShaderInput input)
+{
+    VertexToPixel output;
+
+    float3 localPosition = positionOffset + input.localPosition * positionScale;
+    matrix wvp = mul(projection, mul(view, world));
+    output.screenPosition = mul(wvp, float4(localPosition, 1.0f));
+    output.uv = input.uv;
+    output.normal = normalize(mul((float3x3) worldInvTrans, DecodeOctahedral(input.octNormal)));
+    output.worldPos = mul(world, float4(localPosition, 1.0f)).xyz;
+    return output;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+
+class Mesh;
+class Material;
+struct OccluderMesh;
+
+//components the renderer reads, stored in EntityWorld columns next to each entity's Transform
+//plain pointers, Game owns the meshes and materials and outlives the world
+
+struct MeshRef
+{
+	Mesh* mesh = nullptr;
+};
+
+struct MaterialRef
+{
+	Material* material = nullptr;
+};
+
+//the entity's leaf in the scene's DynamicBvh, RenderSystem::UpdateSpatialIndex inserts and moves it
+//remove the proxy from the bvh before destroying the entity
+struct SpatialProxy
+{
+	int proxy = -1; //DynamicBvh::NULL_NODE until inserted
+	uint64_t version = 0; //transform version the box was made from
+	const Mesh* mesh = nullptr; //and the mesh (the placeholder gets swapped once loading finishes)
+};
+
+//opts the entity in as an occluder, mesh gets drawn into the OcclusionBuffer in its place (RenderSystem::RenderOccluders)
+//only worth it for big things that hide a lot, every occluder costs cpu time each frame
+struct Occluder
+{
+	const OccluderMesh* mesh = nullptr;
+};
+
+//what the last draw worked out for the entity
+struct RenderState
+{
+	unsigned int lod = 0;
+
+	//world bounds cache, redone only when the transform version or the mesh drawn differs from last time
+	DirectX::XMFLOAT3 worldBoundsCenter = {};
+	float worldBoundsRadius = 0.0f;
+	uint64_t boundsVersion = 0;
+	const Mesh* boundsMesh = nullptr;
+};
@@ -0,0 +1,213 @@
+#include "Culling.h"
+#include <cmath>
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	//writes the 4 lane mask as 0/1 bytes
+	inline void StoreMask(__m128 mask, unsigned char* out)
+	{
+		int bits = _mm_movemask_ps(mask);
+		out[0] = (unsigned char)(bits & 1);
+		out[1] = (unsigned char)((bits >> 1) & 1);
+		out[2] = (unsigned char)((bits >> 2) & 1);
+		out[3] = (unsigned char)((bits >> 3) & 1);
+	}
+
+	inline __m128 LoadMask(const unsigned char* in)
+	{
+		__m128i bytes = _mm_setr_epi32(in[0], in[1], in[2], in[3]);
+		return _mm_castsi128_ps(_mm_cmpgt_epi32(bytes, _mm_setzero_si128()));
+	}
+
+	bool CpuHasAVX2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		bool osxsave = (info[2] >> 27) & 1;
+		bool avx = (info[2] >> 28) & 1;
+		bool fma = (info[2] >> 12) & 1;
+		//the os has to save the ymm registers on context switches too
+		if (!osxsave || !avx || !fma || (_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] >> 5) & 1;
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+}
+
+bool Culling::HasAVX2()
+{
+	static const bool hasAVX2 = CpuHasAVX2();
+	return hasAVX2;
+}
+
+Frustum Culling::ExtractFrustum(const XMFLOAT4X4& m)
+{
+	// clip = p * m, so each clip coordinate is p dotted with a column of m
+	// d3d clip space is -w <= x,y <= w and 0 <= z <= w
+	XMVECTOR col1 = XMVectorSet(m._11, m._21, m._31, m._41);
+	XMVECTOR col2 = XMVectorSet(m._12, m._22, m._32, m._42);
+	XMVECTOR col3 = XMVectorSet(m._13, m._23, m._33, m._43);
+	XMVECTOR col4 = XMVectorSet(m._14, m._24, m._34, m._44);
+
+	XMVECTOR planes[6] = {
+		XMVectorAdd(col4, col1),		//left
+		XMVectorSubtract(col4, col1),	//right
+		XMVectorAdd(col4, col2),		//bottom
+		XMVectorSubtract(col4, col2),	//top
+		col3,							//near
+		XMVectorSubtract(col4, col3),	//far
+	};
+
+	Frustum frustum;
+	for (int i = 0; i < 6; i++)
+		XMStoreFloat4(&frustum.planes[i], XMPlaneNormalize(planes[i]));
+	return frustum;
+}
+
+Aabb Culling::TransformAabb(const Aabb& local, const XMFLOAT4X4& world)
+{
+	XMFLOAT3 center = { (local.min.x + local.max.x) * 0.5f, (local.min.y + local.max.y) * 0.5f, (local.min.z + local.max.z) * 0.5f };
+	XMFLOAT3 extent = { (local.max.x - local.min.x) * 0.5f, (local.max.y - local.min.y) * 0.5f, (local.max.z - local.min.z) * 0.5f };
+	//row vectors, output axis j takes row i's j-th component for input axis i
+	XMFLOAT3 worldCenter = {
+		center.x * world._11 + center.y * world._21 + center.z * world._31 + world._41,
+		center.x * world._12 + center.y * world._22 + center.z * world._32 + world._42,
+		center.x * world._13 + center.y * world._23 + center.z * world._33 + world._43 };
+	XMFLOAT3 worldExtent = {
+		extent.x * std::fabs(world._11) + extent.y * std::fabs(world._21) + extent.z * std::fabs(world._31),
+		extent.x * std::fabs(world._12) + extent.y * std::fabs(world._22) + extent.z * std::fabs(world._32),
+		extent.x * std::fabs(world._13) + extent.y * std::fabs(world._23) + extent.z * std::fabs(world._33) };
+	return {
+		{ worldCenter.x - worldExtent.x, worldCenter.y - worldExtent.y, worldCenter.z - worldExtent.z },
+		{ worldCenter.x + worldExtent.x, worldCenter.y + worldExtent.y, worldCenter.z + worldExtent.z } };
+}
+
+CullResult Culling::TestAabb(const Frustum& frustum, const Aabb& box)
+{
+	CullResult result = CullResult::Inside;
+	for (const XMFLOAT4& plane : frustum.planes)
+	{
+		//corner furthest along the normal, if that is behind the plane the whole box is
+		float furthest = plane.x * (plane.x > 0 ? box.max.x : box.min.x) + plane.y * (plane.y > 0 ? box.max.y : box.min.y) + plane.z * (plane.z > 0 ? box.max.z : box.min.z) + plane.w;
+		if (furthest < 0)
+			return CullResult::Outside;
+		float nearest = plane.x * (plane.x > 0 ? box.min.x : box.max.x) + plane.y * (plane.y > 0 ? box.min.y : box.max.y) + plane.z * (plane.z > 0 ? box.min.z : box.max.z) + plane.w;
+		if (nearest < 0)
+			result = CullResult::Intersecting;
+	}
+	return result;
+}
+
+void Culling::FrustumCullSpheres(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+	size_t count, unsigned char* visible)
+{
+	__m128 planeA[6], planeB[6], planeC[6], planeD[6];
+	for (int p = 0; p < 6; p++)
+	{
+		planeA[p] = _mm_set1_ps(frustum.planes[p].x);
+		planeB[p] = _mm_set1_ps(frustum.planes[p].y);
+		planeC[p] = _mm_set1_ps(frustum.planes[p].z);
+		planeD[p] = _mm_set1_ps(frustum.planes[p].w);
+	}
+
+	for (size_t i = 0; i < count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(centerX + i);
+		__m128 y = _mm_loadu_ps(centerY + i);
+		__m128 z = _mm_loadu_ps(centerZ + i);
+		__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+		//inside unless the sphere is completely behind one of the planes
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; p++)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planeA[p]), _mm_mul_ps(y, planeB[p])), _mm_add_ps(_mm_mul_ps(z, planeC[p]), planeD[p]));
+			inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negativeRadius));
+		}
+		StoreMask(inside, visible + i);
+	}
+}
+
+size_t Culling::FrustumCullSpheresCompact(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+	size_t count, uint32_t* visibleIndices)
+{
+	if (HasAVX2())
+		return FrustumCullSpheresCompactAVX2(frustum, centerX, centerY, centerZ, radius, count, visibleIndices);
+	return FrustumCullSpheresCompactSSE(frustum, centerX, centerY, centerZ, radius, count, visibleIndices);
+}
+
+size_t Culling::FrustumCullSpheresCompactSSE(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+	size_t count, uint32_t* visibleIndices)
+{
+	__m128 planeA[6], planeB[6], planeC[6], planeD[6];
+	for (int p = 0; p < 6; p++)
+	{
+		planeA[p] = _mm_set1_ps(frustum.planes[p].x);
+		planeB[p] = _mm_set1_ps(frustum.planes[p].y);
+		planeC[p] = _mm_set1_ps(frustum.planes[p].z);
+		planeD[p] = _mm_set1_ps(frustum.planes[p].w);
+	}
+	__m128i end = _mm_set1_epi32((int)count);
+
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(centerX + i);
+		__m128 y = _mm_loadu_ps(centerY + i);
+		__m128 z = _mm_loadu_ps(centerZ + i);
+		__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+		//padding lanes start out culled
+		__m128i lanes = _mm_add_epi32(_mm_set1_epi32((int)i), _mm_setr_epi32(0, 1, 2, 3));
+		__m128 inside = _mm_castsi128_ps(_mm_cmplt_epi32(lanes, end));
+		for (int p = 0; p < 6; p++)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planeA[p]), _mm_mul_ps(y, planeB[p])), _mm_add_ps(_mm_mul_ps(z, planeC[p]), planeD[p]));
+			inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negativeRadius));
+		}
+
+		//every lane gets written, only the visible ones move the end forward (no branches to mispredict)
+		int bits = _mm_movemask_ps(inside);
+		for (unsigned int lane = 0; lane < 4; lane++)
+		{
+			visibleIndices[visibleCount] = (uint32_t)(i + lane);
+			visibleCount += (bits >> lane) & 1;
+		}
+	}
+	return visibleCount;
+}
+
+void Culling::ConeCullClusters(XMFLOAT3 viewer, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+	const float* axisX, const float* axisY, const float* axisZ, const float* cutoff, size_t count, unsigned char* visible)
+{
+	__m128 viewerX = _mm_set1_ps(viewer.x);
+	__m128 viewerY = _mm_set1_ps(viewer.y);
+	__m128 viewerZ = _mm_set1_ps(viewer.z);
+
+	for (size_t i = 0; i < count; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(centerX + i), viewerX);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(centerY + i), viewerY);
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(centerZ + i), viewerZ);
+		__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+		__m128 alongAxis = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(axisX + i)), _mm_mul_ps(dy, _mm_loadu_ps(axisY + i))), _mm_mul_ps(dz, _mm_loadu_ps(axisZ + i)));
+
+		//dot(normalize(d), axis) >= cutoff + radius / |d|, multiplied through by |d| to skip the divide
+		__m128 limit = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(cutoff + i), distance), _mm_loadu_ps(radius + i));
+		__m128 backFacing = _mm_cmpge_ps(alongAxis, limit);
+		StoreMask(_mm_andnot_ps(backFacing, LoadMask(visible + i)), visible + i);
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+//6 planes facing inwards (left, right, bottom, top, near, far), normalized so plane . (p, 1) is a distance
+struct Frustum
+{
+	DirectX::XMFLOAT4 planes[6];
+};
+
+//axis aligned box, world space unless said otherwise
+struct Aabb
+{
+	DirectX::XMFLOAT3 min;
+	DirectX::XMFLOAT3 max;
+};
+
+enum class CullResult
+{
+	Outside,
+	Intersecting,
+	Inside
+};
+
+// CPU visibility tests, SSE 4 at a time over arrays of bounds (structure of arrays)
+// Every array has to be padded to a multiple of 4, results for the padding are written but meaningless
+namespace Culling
+{
+	//Gribb/Hartmann plane extraction from a row vector (DirectXMath) matrix
+	//view * projection gives world space planes, world * view * projection gives them in the object's local space
+	Frustum ExtractFrustum(const DirectX::XMFLOAT4X4& matrix);
+
+	//visible[i] = 1 when sphere i touches the frustum, 0 otherwise
+	void FrustumCullSpheres(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+		size_t count, unsigned char* visible);
+
+	//arrays for the compact version have to be padded to a multiple of this (the AVX2 width)
+	constexpr size_t COMPACT_PADDING = 8;
+
+	//whether the cpu (and os) can run the AVX2 kernels, checked once
+	bool HasAVX2();
+
+	//writes the index of every sphere that touches the frustum to visibleIndices, in order, and returns how many
+	//visibleIndices needs room for count rounded up to COMPACT_PADDING, the padding itself never gets listed
+	//picks the AVX2 kernel when HasAVX2, SSE otherwise
+	size_t FrustumCullSpheresCompact(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+		size_t count, uint32_t* visibleIndices);
+	size_t FrustumCullSpheresCompactSSE(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+		size_t count, uint32_t* visibleIndices);
+	//CullingAVX2.cpp, only call it when HasAVX2
+	size_t FrustumCullSpheresCompactAVX2(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+		size_t count, uint32_t* visibleIndices);
+
+	//box around a local box after world (Arvo's method, absolute matrix times the extents)
+	Aabb TransformAabb(const Aabb& local, const DirectX::XMFLOAT4X4& world);
+	//plane by plane with the corner furthest along/against each normal, Inside means every plane has the whole box in front
+	CullResult TestAabb(const Frustum& frustum, const Aabb& box);
+
+	//clears visible[i] when every triangle of cluster i faces away from the viewer (see Meshlet for the cone test)
+	void ConeCullClusters(DirectX::XMFLOAT3 viewer, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+		const float* axisX, const float* axisY, const float* axisZ, const float* cutoff, size_t count, unsigned char* visible);
+}
@@ -0,0 +1,62 @@
+// Compiled with /arch:AVX2 (see the project file), only called when the cpu has AVX2 and FMA
+#include "Culling.h"
+#include <immintrin.h>
+#include <array>
+
+namespace
+{
+	//for each 8 bit visibility mask, the lanes that are set packed to the front (one byte each), for _mm256_permutevar8x32_epi32
+	constexpr std::array<uint64_t, 256> BuildCompactTable()
+	{
+		std::array<uint64_t, 256> table = {};
+		for (unsigned int mask = 0; mask < 256; mask++)
+		{
+			unsigned int packed = 0;
+			for (unsigned int lane = 0; lane < 8; lane++)
+				if ((mask >> lane) & 1)
+					table[mask] |= (uint64_t)lane << (8 * packed++);
+		}
+		return table;
+	}
+	constexpr std::array<uint64_t, 256> compactTable = BuildCompactTable();
+}
+
+size_t Culling::FrustumCullSpheresCompactAVX2(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+	size_t count, uint32_t* visibleIndices)
+{
+	__m256 planeA[6], planeB[6], planeC[6], planeD[6];
+	for (int p = 0; p < 6; p++)
+	{
+		planeA[p] = _mm256_set1_ps(frustum.planes[p].x);
+		planeB[p] = _mm256_set1_ps(frustum.planes[p].y);
+		planeC[p] = _mm256_set1_ps(frustum.planes[p].z);
+		planeD[p] = _mm256_set1_ps(frustum.planes[p].w);
+	}
+	__m256i end = _mm256_set1_epi32((int)count);
+	__m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < count; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(centerX + i);
+		__m256 y = _mm256_loadu_ps(centerY + i);
+		__m256 z = _mm256_loadu_ps(centerZ + i);
+		__m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+
+		//padding lanes start out culled
+		__m256i lanes = _mm256_add_epi32(_mm256_set1_epi32((int)i), laneOffsets);
+		__m256 inside = _mm256_castsi256_ps(_mm256_cmpgt_epi32(end, lanes));
+		for (int p = 0; p < 6; p++)
+		{
+			__m256 distance = _mm256_fmadd_ps(x, planeA[p], _mm256_fmadd_ps(y, planeB[p], _mm256_fmadd_ps(z, planeC[p], planeD[p])));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GT_OQ));
+		}
+
+		//left pack the visible lanes' indices, all 8 get stored and the end only moves past the visible ones
+		unsigned int bits = (unsigned int)_mm256_movemask_ps(inside);
+		__m256i permutation = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&compactTable[bits]));
+		_mm256_storeu_si256((__m256i*)(visibleIndices + visibleCount), _mm256_permutevar8x32_epi32(lanes, permutation));
+		visibleCount += _mm_popcnt_u32(bits);
+	}
+	return visibleCount;
+}
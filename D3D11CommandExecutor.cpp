@@ -0,0 +1,77 @@
+#include "D3D11CommandExecutor.h"
+#include <cstring>
+
+void D3D11CommandExecutor::BeginFrame(ID3D11DeviceContext1* context)
+{
+	stateCache.BeginFrame(context);
+}
+
+void D3D11CommandExecutor::Execute(const CommandBuffer& commands)
+{
+	//binds go through the cache, uploads and draws straight to the context
+	ID3D11DeviceContext1* context = stateCache.GetContext();
+	for (const CommandHeader* command = commands.First(); command; command = commands.Next(command))
+	{
+		switch (command->type)
+		{
+		case CommandType::SetVertexShader:
+		{
+			const SetVertexShaderCommand* set = static_cast<const SetVertexShaderCommand*>(command);
+			stateCache.SetInputLayout(set->inputLayout);
+			stateCache.SetVertexShader(set->shader);
+			break;
+		}
+		case CommandType::SetPixelShader:
+			stateCache.SetPixelShader(static_cast<const SetPixelShaderCommand*>(command)->shader);
+			break;
+		case CommandType::UpdateBuffer:
+		{
+			const UpdateBufferCommand* update = static_cast<const UpdateBufferCommand*>(command);
+			if (update->mode == BufferWrite::Replace)
+			{
+				context->UpdateSubresource(update->buffer, 0, nullptr, update->GetData(), 0, 0);
+				break;
+			}
+			D3D11_MAPPED_SUBRESOURCE mapped = {};
+			D3D11_MAP mapType = update->mode == BufferWrite::Discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+			if (FAILED(context->Map(update->buffer, 0, mapType, 0, &mapped)))
+				break;
+			memcpy((char*)mapped.pData + update->offset, update->GetData(), update->dataSize);
+			context->Unmap(update->buffer, 0);
+			break;
+		}
+		case CommandType::SetConstantBuffer:
+		{
+			const SetConstantBufferCommand* set = static_cast<const SetConstantBufferCommand*>(command);
+			stateCache.SetConstantBuffer(set->stage, set->slot, set->buffer, set->firstConstant, set->constantCount);
+			break;
+		}
+		case CommandType::SetVertexBuffer:
+		{
+			const SetVertexBufferCommand* set = static_cast<const SetVertexBufferCommand*>(command);
+			stateCache.SetVertexBuffer(set->slot, set->buffer, set->stride, set->offset);
+			break;
+		}
+		case CommandType::SetIndexBuffer:
+		{
+			const SetIndexBufferCommand* set = static_cast<const SetIndexBufferCommand*>(command);
+			stateCache.SetIndexBuffer(set->buffer, set->sixteenBit ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT);
+			break;
+		}
+		case CommandType::DrawIndexed:
+		{
+			const DrawIndexedCommand* draw = static_cast<const DrawIndexedCommand*>(command);
+			context->DrawIndexed(draw->indexCount, draw->firstIndex, draw->baseVertex);
+			break;
+		}
+		case CommandType::DrawIndexedInstanced:
+		{
+			const DrawIndexedInstancedCommand* draw = static_cast<const DrawIndexedInstancedCommand*>(command);
+			context->DrawIndexedInstanced(draw->indexCount, draw->instanceCount, draw->firstIndex, draw->baseVertex, draw->firstInstance);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "CommandBuffer.h"
+#include "D3D11StateCache.h"
+
+//replays a CommandBuffer onto the context it was given in BeginFrame (Graphics::Context11_1), main thread only
+//binds go through a D3D11StateCache, so the ones that change nothing (across command buffers too) are dropped
+class D3D11CommandExecutor : public ICommandExecutor
+{
+public:
+	//before the frame's first Execute, after anything else has touched the context
+	void BeginFrame(ID3D11DeviceContext1* context);
+	void Execute(const CommandBuffer& commands) override;
+
+	const D3D11StateCache& GetStateCache() const { return stateCache; }
+
+private:
+	D3D11StateCache stateCache;
+};
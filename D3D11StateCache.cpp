@@ -0,0 +1,142 @@
+#include "D3D11StateCache.h"
+
+namespace
+{
+	const char* const STATE_CALL_NAMES[] =
+	{
+		"IASetInputLayout",
+		"VSSetShader",
+		"PSSetShader",
+		"*SetConstantBuffers",
+		"IASetVertexBuffers",
+		"IASetIndexBuffer",
+	};
+	static_assert(sizeof(STATE_CALL_NAMES) / sizeof(STATE_CALL_NAMES[0]) == (size_t)StateCall::Count, "a name for every call");
+}
+
+const char* GetStateCallName(StateCall call)
+{
+	return call < StateCall::Count ? STATE_CALL_NAMES[(size_t)call] : "Unknown";
+}
+
+unsigned int StateCacheStats::GetIssued() const
+{
+	unsigned int total = 0;
+	for (unsigned int count : issued)
+		total += count;
+	return total;
+}
+
+unsigned int StateCacheStats::GetElided() const
+{
+	unsigned int total = 0;
+	for (unsigned int count : elided)
+		total += count;
+	return total;
+}
+
+void D3D11StateCache::BeginFrame(ID3D11DeviceContext1* context)
+{
+	this->context = context;
+	stats = StateCacheStats();
+	Invalidate();
+}
+
+void D3D11StateCache::Invalidate()
+{
+	inputLayout.known = false;
+	vertexShader.known = false;
+	pixelShader.known = false;
+	for (auto& stage : constantBuffers)
+		for (ConstantBinding& binding : stage)
+			binding.known = false;
+	for (VertexBinding& binding : vertexBuffers)
+		binding.known = false;
+	indexBuffer.known = false;
+}
+
+bool D3D11StateCache::Count(StateCall call, bool changed)
+{
+	if (changed)
+		stats.issued[(size_t)call]++;
+	else
+		stats.elided[(size_t)call]++;
+	return changed;
+}
+
+void D3D11StateCache::SetInputLayout(ID3D11InputLayout* layout)
+{
+	if (!Count(StateCall::InputLayout, !inputLayout.known || inputLayout.value != layout))
+		return;
+	context->IASetInputLayout(layout);
+	inputLayout = { layout, true };
+}
+
+void D3D11StateCache::SetVertexShader(ID3D11VertexShader* shader)
+{
+	if (!Count(StateCall::VertexShader, !vertexShader.known || vertexShader.value != shader))
+		return;
+	context->VSSetShader(shader, nullptr, 0);
+	vertexShader = { shader, true };
+}
+
+void D3D11StateCache::SetPixelShader(ID3D11PixelShader* shader)
+{
+	if (!Count(StateCall::PixelShader, !pixelShader.known || pixelShader.value != shader))
+		return;
+	context->PSSetShader(shader, nullptr, 0);
+	pixelShader = { shader, true };
+}
+
+void D3D11StateCache::SetConstantBuffer(ShaderStage stage, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT constantCount)
+{
+	//out of range slots go through untracked, the debug layer has something to say about them
+	bool tracked = slot < CONSTANT_BUFFER_SLOTS && (size_t)stage <= (size_t)ShaderStage::Pixel;
+	if (tracked)
+	{
+		const ConstantBinding& bound = constantBuffers[(size_t)stage][slot];
+		bool changed = !bound.known || bound.buffer != buffer || bound.firstConstant != firstConstant || bound.constantCount != constantCount;
+		if (!Count(StateCall::ConstantBuffer, changed))
+			return;
+		constantBuffers[(size_t)stage][slot] = { buffer, firstConstant, constantCount, true };
+	}
+	else
+		Count(StateCall::ConstantBuffer, true);
+
+	if (constantCount == 0)
+	{
+		if (stage == ShaderStage::Vertex)
+			context->VSSetConstantBuffers(slot, 1, &buffer);
+		else
+			context->PSSetConstantBuffers(slot, 1, &buffer);
+		return;
+	}
+	if (stage == ShaderStage::Vertex)
+		context->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+	else
+		context->PSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+}
+
+void D3D11StateCache::SetVertexBuffer(UINT slot, ID3D11Buffer* buffer, UINT stride, UINT offset)
+{
+	if (slot < VERTEX_BUFFER_SLOTS)
+	{
+		const VertexBinding& bound = vertexBuffers[slot];
+		bool changed = !bound.known || bound.buffer != buffer || bound.stride != stride || bound.offset != offset;
+		if (!Count(StateCall::VertexBuffer, changed))
+			return;
+		vertexBuffers[slot] = { buffer, stride, offset, true };
+	}
+	else
+		Count(StateCall::VertexBuffer, true);
+	context->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+}
+
+void D3D11StateCache::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+{
+	bool changed = !indexBuffer.known || indexBuffer.buffer != buffer || indexBuffer.format != format || indexBuffer.offset != offset;
+	if (!Count(StateCall::IndexBuffer, changed))
+		return;
+	context->IASetIndexBuffer(buffer, format, offset);
+	indexBuffer = { buffer, format, offset, true };
+}
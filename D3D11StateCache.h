@@ -0,0 +1,97 @@
+#pragma once
+#include <d3d11_1.h>
+#include <cstdint>
+
+#include "CommandBuffer.h"
+
+//the context calls the cache looks at, one counter each
+enum class StateCall : uint8_t
+{
+	InputLayout,
+	VertexShader,
+	PixelShader,
+	ConstantBuffer,
+	VertexBuffer,
+	IndexBuffer,
+	Count
+};
+const char* GetStateCallName(StateCall call);
+
+struct StateCacheStats
+{
+	unsigned int issued[(size_t)StateCall::Count] = {}; //reached the context
+	unsigned int elided[(size_t)StateCall::Count] = {}; //would have bound what was already bound
+
+	unsigned int GetIssued() const;
+	unsigned int GetElided() const;
+};
+
+// Sits in front of the device context and remembers what went through it, binds that change nothing never reach the context
+// - it only knows about its own calls, anything else touching the context (imgui, the clear) has to be followed by Invalidate
+// - buffer contents don't matter, a buffer that got updated while bound stays bound
+// - one slot per call, neighbouring slots aren't merged into one call
+class D3D11StateCache
+{
+public:
+	static constexpr unsigned int CONSTANT_BUFFER_SLOTS = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+	static constexpr unsigned int VERTEX_BUFFER_SLOTS = D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+
+	//starts the frame's counters and forgets what was bound, before the frame's first call
+	void BeginFrame(ID3D11DeviceContext1* context);
+	//forgets what was bound, the next call of every kind goes through
+	void Invalidate();
+
+	void SetInputLayout(ID3D11InputLayout* layout);
+	void SetVertexShader(ID3D11VertexShader* shader);
+	void SetPixelShader(ID3D11PixelShader* shader);
+	//constantCount 0 binds the whole buffer, otherwise the range goes through the 11.1 call
+	void SetConstantBuffer(ShaderStage stage, UINT slot, ID3D11Buffer* buffer, UINT firstConstant = 0, UINT constantCount = 0);
+	void SetVertexBuffer(UINT slot, ID3D11Buffer* buffer, UINT stride, UINT offset = 0);
+	void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset = 0);
+
+	ID3D11DeviceContext1* GetContext() const { return context; }
+	//since BeginFrame
+	const StateCacheStats& GetStats() const { return stats; }
+
+private:
+	ID3D11DeviceContext1* context = nullptr;
+	StateCacheStats stats;
+
+	//known is false until something has been bound through the cache, null is a real binding
+	template<typename T>
+	struct Bound
+	{
+		T* value = nullptr;
+		bool known = false;
+	};
+	Bound<ID3D11InputLayout> inputLayout;
+	Bound<ID3D11VertexShader> vertexShader;
+	Bound<ID3D11PixelShader> pixelShader;
+	struct ConstantBinding
+	{
+		ID3D11Buffer* buffer = nullptr;
+		UINT firstConstant = 0;
+		UINT constantCount = 0;
+		bool known = false;
+	};
+	ConstantBinding constantBuffers[2][CONSTANT_BUFFER_SLOTS]; //by ShaderStage
+	struct VertexBinding
+	{
+		ID3D11Buffer* buffer = nullptr;
+		UINT stride = 0;
+		UINT offset = 0;
+		bool known = false;
+	};
+	VertexBinding vertexBuffers[VERTEX_BUFFER_SLOTS];
+	struct IndexBinding
+	{
+		ID3D11Buffer* buffer = nullptr;
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		UINT offset = 0;
+		bool known = false;
+	};
+	IndexBinding indexBuffer;
+
+	//true when the call has to go through, counts it either way
+	bool Count(StateCall call, bool changed);
+};
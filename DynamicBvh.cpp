@@ -0,0 +1,502 @@
+#include "DynamicBvh.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	//ranges at least this big get their right half built by the pool
+	constexpr unsigned int PARALLEL_BUILD_MIN = 4096;
+	constexpr unsigned int SAH_BINS = 16;
+
+	Aabb Union(const Aabb& a, const Aabb& b)
+	{
+		return {
+			{ std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z) },
+			{ std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z) } };
+	}
+
+	//in place version for the build loops, keeps the running box in registers instead of going through a returned struct
+	inline void Grow(Aabb& box, const XMFLOAT3& min, const XMFLOAT3& max)
+	{
+		box.min.x = std::min(box.min.x, min.x);
+		box.min.y = std::min(box.min.y, min.y);
+		box.min.z = std::min(box.min.z, min.z);
+		box.max.x = std::max(box.max.x, max.x);
+		box.max.y = std::max(box.max.y, max.y);
+		box.max.z = std::max(box.max.z, max.z);
+	}
+
+	//half the surface area, the factor of 2 cancels in every comparison
+	float Area(const Aabb& box)
+	{
+		float x = box.max.x - box.min.x;
+		float y = box.max.y - box.min.y;
+		float z = box.max.z - box.min.z;
+		return x * y + y * z + z * x;
+	}
+
+	bool Contains(const Aabb& outer, const Aabb& inner)
+	{
+		return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+			outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+	}
+
+	bool Overlaps(const Aabb& a, const Aabb& b)
+	{
+		return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y && a.min.z <= b.max.z && a.max.z >= b.min.z;
+	}
+
+	bool Equal(const Aabb& a, const Aabb& b)
+	{
+		return a.min.x == b.min.x && a.min.y == b.min.y && a.min.z == b.min.z && a.max.x == b.max.x && a.max.y == b.max.y && a.max.z == b.max.z;
+	}
+
+	float Axis(const XMFLOAT3& v, int axis) { return axis == 0 ? v.x : axis == 1 ? v.y : v.z; }
+
+	const Aabb EMPTY = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+}
+
+struct DynamicBvh::BuildContext
+{
+	//copies of the fat boxes, partitioned in place as the build goes down so every pass reads memory in order
+	struct Primitive
+	{
+		Aabb box;
+		XMFLOAT3 centroid;
+		int proxy;
+	};
+	std::vector<Primitive> primitives;
+	std::atomic<int> nextNode = 0;
+	ThreadPool* pool = nullptr;
+};
+
+DynamicBvh::DynamicBvh(float margin) : margin(margin)
+{
+}
+
+int DynamicBvh::AllocateNode()
+{
+	if (freeNodes.empty())
+	{
+		nodes.emplace_back();
+		return (int)nodes.size() - 1;
+	}
+	int node = freeNodes.back();
+	freeNodes.pop_back();
+	nodes[node] = Node();
+	return node;
+}
+
+void DynamicBvh::FreeNode(int node)
+{
+	freeNodes.push_back(node);
+}
+
+int DynamicBvh::Insert(const Aabb& box, uint64_t userData)
+{
+	int proxy;
+	if (freeProxies.empty())
+	{
+		proxy = (int)proxies.size();
+		proxies.emplace_back();
+	}
+	else
+	{
+		proxy = freeProxies.back();
+		freeProxies.pop_back();
+	}
+	Aabb fat = { { box.min.x - margin, box.min.y - margin, box.min.z - margin }, { box.max.x + margin, box.max.y + margin, box.max.z + margin } };
+	int leaf = AllocateNode();
+	nodes[leaf].box = fat;
+	nodes[leaf].proxy = proxy;
+	proxies[proxy] = { fat, userData, leaf };
+	InsertLeaf(leaf);
+	proxyCount++;
+	return proxy;
+}
+
+void DynamicBvh::Remove(int proxy)
+{
+	int leaf = proxies[proxy].leaf;
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+	proxies[proxy].leaf = NULL_NODE;
+	freeProxies.push_back(proxy);
+	proxyCount--;
+}
+
+bool DynamicBvh::Move(int proxy, const Aabb& box)
+{
+	if (Contains(proxies[proxy].box, box))
+		return false;
+	Aabb fat = { { box.min.x - margin, box.min.y - margin, box.min.z - margin }, { box.max.x + margin, box.max.y + margin, box.max.z + margin } };
+	proxies[proxy].box = fat;
+	int leaf = proxies[proxy].leaf;
+	nodes[leaf].box = fat;
+	Refit(nodes[leaf].parent);
+	refitsSinceRebuild++;
+	return true;
+}
+
+//Catto's branch and bound from Box2D: going down costs the growth of the node (the inheritance), stop where pairing up is cheapest
+void DynamicBvh::InsertLeaf(int leaf)
+{
+	if (root == NULL_NODE)
+	{
+		root = leaf;
+		nodes[leaf].parent = NULL_NODE;
+		return;
+	}
+
+	Aabb leafBox = nodes[leaf].box;
+	int index = root;
+	while (nodes[index].left != NULL_NODE)
+	{
+		const Node& node = nodes[index];
+		float area = Area(node.box);
+		float combinedArea = Area(Union(node.box, leafBox));
+		//a new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+		//what every level below pays for this one growing
+		float inheritance = 2.0f * (combinedArea - area);
+
+		auto childCost = [&](int child)
+		{
+			const Node& childNode = nodes[child];
+			float grown = Area(Union(childNode.box, leafBox));
+			return (childNode.left == NULL_NODE ? grown : grown - Area(childNode.box)) + inheritance;
+		};
+		float leftCost = childCost(node.left);
+		float rightCost = childCost(node.right);
+		if (cost < leftCost && cost < rightCost)
+			break;
+		index = leftCost < rightCost ? node.left : node.right;
+	}
+
+	int sibling = index;
+	int oldParent = nodes[sibling].parent;
+	int newParent = AllocateNode(); //may grow nodes, nothing above holds a reference past here
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = Union(leafBox, nodes[sibling].box);
+	nodes[newParent].left = sibling;
+	nodes[newParent].right = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent == NULL_NODE)
+	{
+		root = newParent;
+		return;
+	}
+	if (nodes[oldParent].left == sibling)
+		nodes[oldParent].left = newParent;
+	else
+		nodes[oldParent].right = newParent;
+	Refit(oldParent);
+}
+
+void DynamicBvh::RemoveLeaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = NULL_NODE;
+		return;
+	}
+
+	//the sibling takes the parent's place
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+	FreeNode(parent);
+	nodes[sibling].parent = grandParent;
+	if (grandParent == NULL_NODE)
+	{
+		root = sibling;
+		return;
+	}
+	if (nodes[grandParent].left == parent)
+		nodes[grandParent].left = sibling;
+	else
+		nodes[grandParent].right = sibling;
+	Refit(grandParent);
+}
+
+void DynamicBvh::Refit(int node)
+{
+	while (node != NULL_NODE)
+	{
+		Aabb box = Union(nodes[nodes[node].left].box, nodes[nodes[node].right].box);
+		//everything above only depends on this box
+		if (Equal(box, nodes[node].box))
+			return;
+		nodes[node].box = box;
+		node = nodes[node].parent;
+	}
+}
+
+void DynamicBvh::Rebuild(ThreadPool* pool)
+{
+	BuildContext context;
+	context.pool = pool;
+	context.primitives.reserve(proxyCount);
+	for (int proxy = 0; proxy < (int)proxies.size(); proxy++)
+	{
+		const Proxy& p = proxies[proxy];
+		if (p.leaf == NULL_NODE)
+			continue;
+		XMFLOAT3 centroid = { (p.box.min.x + p.box.max.x) * 0.5f, (p.box.min.y + p.box.max.y) * 0.5f, (p.box.min.z + p.box.max.z) * 0.5f };
+		context.primitives.push_back({ p.box, centroid, proxy });
+	}
+
+	//a binary tree with one proxy per leaf always has 2n - 1 nodes, so they can all be handed out up front
+	unsigned int count = (unsigned int)context.primitives.size();
+	nodes.assign(count ? count * 2 - 1 : 0, Node());
+	freeNodes.clear();
+	refitsSinceRebuild = 0;
+	if (count == 0)
+	{
+		root = NULL_NODE;
+		return;
+	}
+	root = context.nextNode++;
+	Build(context, 0, count, root, NULL_NODE);
+	if (pool)
+		pool->Wait();
+}
+
+//binned SAH, the centroids' longest axis cut into SAH_BINS slabs, split at the slab boundary with the lowest area * count
+void DynamicBvh::Build(BuildContext& context, unsigned int begin, unsigned int end, int node, int parent)
+{
+	using Primitive = BuildContext::Primitive;
+	Primitive* primitives = context.primitives.data();
+	Node& target = nodes[node];
+	target.parent = parent;
+	if (end - begin == 1)
+	{
+		target.box = primitives[begin].box;
+		target.proxy = primitives[begin].proxy;
+		proxies[target.proxy].leaf = node;
+		return;
+	}
+
+	Aabb box = EMPTY;
+	Aabb centroidBox = EMPTY;
+	for (unsigned int i = begin; i < end; i++)
+	{
+		Grow(box, primitives[i].box.min, primitives[i].box.max);
+		Grow(centroidBox, primitives[i].centroid, primitives[i].centroid);
+	}
+	target.box = box;
+	target.proxy = NULL_NODE;
+
+	XMFLOAT3 extent = { centroidBox.max.x - centroidBox.min.x, centroidBox.max.y - centroidBox.min.y, centroidBox.max.z - centroidBox.min.z };
+	int axis = extent.x > extent.y && extent.x > extent.z ? 0 : extent.y > extent.z ? 1 : 2;
+	float axisMin = Axis(centroidBox.min, axis);
+	float axisExtent = Axis(extent, axis);
+
+	unsigned int mid = begin + (end - begin) / 2;
+	//pairs split the one way they can, the bins would only cost time
+	if (end - begin > 2 && axisExtent > 1e-6f)
+	{
+		float scale = SAH_BINS / axisExtent;
+		auto binOf = [&](const Primitive& primitive) { return std::min(SAH_BINS - 1, (unsigned int)((Axis(primitive.centroid, axis) - axisMin) * scale)); };
+
+		unsigned int binCounts[SAH_BINS] = {};
+		Aabb binBoxes[SAH_BINS];
+		std::fill(binBoxes, binBoxes + SAH_BINS, EMPTY);
+		for (unsigned int i = begin; i < end; i++)
+		{
+			unsigned int bin = binOf(primitives[i]);
+			binCounts[bin]++;
+			Grow(binBoxes[bin], primitives[i].box.min, primitives[i].box.max);
+		}
+
+		//right to left sweep for the right side costs, then left to right picks the split
+		float rightCosts[SAH_BINS] = {};
+		Aabb right = EMPTY;
+		unsigned int rightCount = 0;
+		for (unsigned int bin = SAH_BINS - 1; bin > 0; bin--)
+		{
+			Grow(right, binBoxes[bin].min, binBoxes[bin].max);
+			rightCount += binCounts[bin];
+			rightCosts[bin] = rightCount ? Area(right) * rightCount : 0.0f;
+		}
+		Aabb left = EMPTY;
+		unsigned int leftCount = 0;
+		float bestCost = FLT_MAX;
+		unsigned int bestSplit = 0; //bins up to and including this one go left
+		for (unsigned int bin = 0; bin < SAH_BINS - 1; bin++)
+		{
+			Grow(left, binBoxes[bin].min, binBoxes[bin].max);
+			leftCount += binCounts[bin];
+			float cost = (leftCount ? Area(left) * leftCount : 0.0f) + rightCosts[bin + 1];
+			if (leftCount && leftCount < end - begin && cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = bin;
+			}
+		}
+		if (bestCost < FLT_MAX)
+			mid = (unsigned int)(std::partition(primitives + begin, primitives + end,
+				[&](const Primitive& primitive) { return binOf(primitive) <= bestSplit; }) - primitives);
+	}
+	//everything in one slab (stacked on top of each other), halve by count instead
+
+	int children = context.nextNode.fetch_add(2);
+	target.left = children;
+	target.right = children + 1;
+	if (context.pool && end - begin >= PARALLEL_BUILD_MIN)
+		context.pool->Submit([this, &context, mid, end, children, node]() { Build(context, mid, end, children + 1, node); });
+	else
+		Build(context, mid, end, children + 1, node);
+	Build(context, begin, mid, children, node);
+}
+
+void DynamicBvh::CollectLeaves(int node, std::vector<uint64_t>& results) const
+{
+	std::vector<int> stack = { node };
+	while (!stack.empty())
+	{
+		const Node& current = nodes[stack.back()];
+		stack.pop_back();
+		if (current.left == NULL_NODE)
+		{
+			results.push_back(proxies[current.proxy].userData);
+			continue;
+		}
+		stack.push_back(current.left);
+		stack.push_back(current.right);
+	}
+}
+
+void DynamicBvh::QueryFrustum(const Frustum& frustum, std::vector<uint64_t>& results) const
+{
+	if (root == NULL_NODE)
+		return;
+	std::vector<int> stack = { root };
+	while (!stack.empty())
+	{
+		int index = stack.back();
+		stack.pop_back();
+		const Node& node = nodes[index];
+		CullResult result = Culling::TestAabb(frustum, node.box);
+		if (result == CullResult::Outside)
+			continue;
+		//the whole subtree is in, no more plane tests under here
+		if (result == CullResult::Inside)
+		{
+			CollectLeaves(index, results);
+			continue;
+		}
+		if (node.left == NULL_NODE)
+		{
+			results.push_back(proxies[node.proxy].userData);
+			continue;
+		}
+		stack.push_back(node.left);
+		stack.push_back(node.right);
+	}
+}
+
+void DynamicBvh::QueryAabb(const Aabb& box, std::vector<uint64_t>& results) const
+{
+	if (root == NULL_NODE)
+		return;
+	std::vector<int> stack = { root };
+	while (!stack.empty())
+	{
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if (!Overlaps(node.box, box))
+			continue;
+		if (node.left == NULL_NODE)
+		{
+			results.push_back(proxies[node.proxy].userData);
+			continue;
+		}
+		stack.push_back(node.left);
+		stack.push_back(node.right);
+	}
+}
+
+void DynamicBvh::QueryRay(XMFLOAT3 origin, XMFLOAT3 direction, float maxDistance, std::vector<uint64_t>& results) const
+{
+	if (root == NULL_NODE)
+		return;
+	//slab test, a zero component gives an infinite inverse and fmin/fmax drop the nan from 0 * inf
+	XMFLOAT3 inverse = { 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z };
+	auto hits = [&](const Aabb& box)
+	{
+		float t1 = (box.min.x - origin.x) * inverse.x, t2 = (box.max.x - origin.x) * inverse.x;
+		float enter = std::fmin(t1, t2), exit = std::fmax(t1, t2);
+		t1 = (box.min.y - origin.y) * inverse.y;
+		t2 = (box.max.y - origin.y) * inverse.y;
+		enter = std::fmax(enter, std::fmin(t1, t2));
+		exit = std::fmin(exit, std::fmax(t1, t2));
+		t1 = (box.min.z - origin.z) * inverse.z;
+		t2 = (box.max.z - origin.z) * inverse.z;
+		enter = std::fmax(enter, std::fmin(t1, t2));
+		exit = std::fmin(exit, std::fmax(t1, t2));
+		return std::fmax(enter, 0.0f) <= std::fmin(exit, maxDistance);
+	};
+
+	std::vector<int> stack = { root };
+	while (!stack.empty())
+	{
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if (!hits(node.box))
+			continue;
+		if (node.left == NULL_NODE)
+		{
+			results.push_back(proxies[node.proxy].userData);
+			continue;
+		}
+		stack.push_back(node.left);
+		stack.push_back(node.right);
+	}
+}
+
+unsigned int DynamicBvh::GetHeight() const
+{
+	if (root == NULL_NODE)
+		return 0;
+	unsigned int height = 0;
+	std::vector<std::pair<int, unsigned int>> stack = { { root, 1 } };
+	while (!stack.empty())
+	{
+		auto [index, depth] = stack.back();
+		stack.pop_back();
+		height = std::max(height, depth);
+		if (nodes[index].left != NULL_NODE)
+		{
+			stack.push_back({ nodes[index].left, depth + 1 });
+			stack.push_back({ nodes[index].right, depth + 1 });
+		}
+	}
+	return height;
+}
+
+float DynamicBvh::GetCost() const
+{
+	if (root == NULL_NODE || nodes[root].left == NULL_NODE)
+		return 0.0f;
+	float internalArea = 0.0f;
+	std::vector<int> stack = { root };
+	while (!stack.empty())
+	{
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if (node.left == NULL_NODE)
+			continue;
+		internalArea += Area(node.box);
+		stack.push_back(node.left);
+		stack.push_back(node.right);
+	}
+	return internalArea / Area(nodes[root].box);
+}
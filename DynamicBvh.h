@@ -0,0 +1,85 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+#include "Culling.h"
+
+class ThreadPool;
+
+// Bounding volume hierarchy over boxes that move, one leaf per proxy
+// - proxies keep a fat box (the real one grown by the margin), small moves that stay inside it don't touch the tree
+// - moves that leave it refit the leaf and its ancestors in place, cheap but the tree gets worse as things wander
+// - Rebuild builds it again top down with binned SAH, in parallel when given a pool
+// - Insert finds a sibling with the SAH cost too, so things added between rebuilds still land somewhere sensible
+// queries report the fat boxes, so they're conservative, test the real bounds after if that matters
+class DynamicBvh
+{
+public:
+	static constexpr int NULL_NODE = -1;
+
+	explicit DynamicBvh(float margin = 0.1f);
+
+	//returns the proxy id, userData comes back from the queries
+	int Insert(const Aabb& box, uint64_t userData);
+	void Remove(int proxy);
+	//true when the box left the fat box and the tree was refit
+	bool Move(int proxy, const Aabb& box);
+
+	uint64_t GetUserData(int proxy) const { return proxies[proxy].userData; }
+	const Aabb& GetFatAabb(int proxy) const { return proxies[proxy].box; }
+
+	//pool can be null (single threaded), blocks until done either way
+	void Rebuild(ThreadPool* pool = nullptr);
+	//worth a rebuild once enough of the tree has been refit, moves since the last one over the proxy count
+	float GetRefitRatio() const { return proxyCount ? (float)refitsSinceRebuild / proxyCount : 0.0f; }
+
+	//each appends the userData of every proxy whose fat box passes
+	void QueryFrustum(const Frustum& frustum, std::vector<uint64_t>& results) const;
+	void QueryAabb(const Aabb& box, std::vector<uint64_t>& results) const;
+	//direction doesn't have to be normalized, maxDistance is in its units
+	void QueryRay(DirectX::XMFLOAT3 origin, DirectX::XMFLOAT3 direction, float maxDistance, std::vector<uint64_t>& results) const;
+
+	unsigned int GetProxyCount() const { return proxyCount; }
+	unsigned int GetHeight() const;
+	//sum of internal node areas over the root's, lower is a better tree (what SAH minimizes)
+	float GetCost() const;
+
+private:
+	struct Node
+	{
+		Aabb box;
+		int parent = NULL_NODE;
+		int left = NULL_NODE; //NULL_NODE on leaves
+		int right = NULL_NODE;
+		int proxy = NULL_NODE; //leaves only
+	};
+
+	struct Proxy
+	{
+		Aabb box; //fat
+		uint64_t userData = 0;
+		int leaf = NULL_NODE; //NULL_NODE while the proxy is free
+	};
+
+	float margin;
+	std::vector<Node> nodes;
+	std::vector<int> freeNodes;
+	int root = NULL_NODE;
+	std::vector<Proxy> proxies;
+	std::vector<int> freeProxies;
+	unsigned int proxyCount = 0;
+	unsigned int refitsSinceRebuild = 0;
+
+	int AllocateNode();
+	void FreeNode(int node);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	//recomputes node's box from its children and walks up until a box stops changing
+	void Refit(int node);
+	void CollectLeaves(int node, std::vector<uint64_t>& results) const;
+
+	struct BuildContext;
+	//node was allocated by the caller, it allocates node's children the same way so the right half can go to another thread
+	void Build(BuildContext& context, unsigned int begin, unsigned int end, int node, int parent);
+};
@@ -0,0 +1,91 @@
+#include "EntityWorld.h"
+
+using namespace EntityComponents;
+
+unsigned int EntityComponents::NextTypeId()
+{
+	static unsigned int next = 0;
+	return next++;
+}
+
+void EntityWorld::Destroy(Entity entity)
+{
+	if (!IsAlive(entity))
+		return;
+	Record& record = records[entity.index];
+	Archetype* archetype = record.archetype;
+	uint32_t row = record.row;
+
+	for (const std::unique_ptr<IColumn>& column : archetype->columns)
+		if (column)
+			column->SwapRemove(row);
+	Entity moved = archetype->entities.back();
+	archetype->entities[row] = moved;
+	archetype->entities.pop_back();
+	records[moved.index].row = row;
+
+	//bumping the generation is what invalidates every handle still around
+	record.archetype = nullptr;
+	record.generation++;
+	freeIndices.push_back(entity.index);
+}
+
+Archetype* EntityWorld::FindArchetype(Mask mask)
+{
+	auto found = archetypesByMask.find(mask);
+	return found == archetypesByMask.end() ? nullptr : found->second;
+}
+
+Archetype* EntityWorld::AddArchetype(Mask mask, const Archetype* like)
+{
+	std::unique_ptr<Archetype> archetype = std::make_unique<Archetype>();
+	archetype->mask = mask;
+	if (like)
+		for (unsigned int i = 0; i < MAX_COMPONENTS; i++)
+			if ((mask >> i) & 1 && like->columns[i])
+				archetype->columns[i] = like->columns[i]->CreateEmpty();
+	Archetype* added = archetype.get();
+	archetypes.push_back(std::move(archetype));
+	archetypesByMask[mask] = added;
+	return added;
+}
+
+Entity EntityWorld::AllocateEntity(Archetype* archetype, uint32_t row)
+{
+	uint32_t index;
+	if (freeIndices.empty())
+	{
+		index = (uint32_t)records.size();
+		records.emplace_back();
+	}
+	else
+	{
+		index = freeIndices.back();
+		freeIndices.pop_back();
+	}
+	records[index].archetype = archetype;
+	records[index].row = row;
+	return { index, records[index].generation };
+}
+
+void EntityWorld::MoveEntity(Entity entity, Archetype* to, unsigned int skipColumn)
+{
+	Record& record = records[entity.index];
+	Archetype* from = record.archetype;
+	uint32_t row = record.row;
+
+	for (unsigned int i = 0; i < MAX_COMPONENTS; i++)
+	{
+		if (!from->columns[i] || i == skipColumn)
+			continue;
+		from->columns[i]->MoveRowTo(row, *to->columns[i]);
+	}
+	Entity moved = from->entities.back();
+	from->entities[row] = moved;
+	from->entities.pop_back();
+	records[moved.index].row = row;
+
+	record.archetype = to;
+	record.row = (uint32_t)to->entities.size();
+	to->entities.push_back(entity);
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//handle to an entity, the generation makes handles to a destroyed entity invalid even after its index is reused
+struct Entity
+{
+	uint32_t index = ~0u;
+	uint32_t generation = 0;
+	bool operator==(const Entity& other) const = default;
+
+	//packed into one integer, for things that only carry a uint64_t around (DynamicBvh user data)
+	uint64_t ToBits() const { return (uint64_t)generation << 32 | index; }
+	static Entity FromBits(uint64_t bits) { return { (uint32_t)bits, (uint32_t)(bits >> 32) }; }
+};
+
+namespace EntityComponents
+{
+	//one bit per component type in an archetype's mask
+	constexpr unsigned int MAX_COMPONENTS = 64;
+	using Mask = uint64_t;
+
+	unsigned int NextTypeId();
+	//ids are handed out the first time a type is used, they only mean something inside this run
+	template<class T> unsigned int TypeId()
+	{
+		static const unsigned int id = NextTypeId();
+		return id;
+	}
+	template<class T> Mask Bit() { return 1ull << TypeId<T>(); }
+
+	//one component type's values for every entity in an archetype, type erased so archetypes can hold any set
+	class IColumn
+	{
+	public:
+		virtual ~IColumn() = default;
+		//last row moves into row, keeps the column packed
+		virtual void SwapRemove(size_t row) = 0;
+		//appends row to other (same type) then swap removes it here
+		virtual void MoveRowTo(size_t row, IColumn& other) = 0;
+		virtual std::unique_ptr<IColumn> CreateEmpty() const = 0;
+	};
+
+	template<class T>
+	class Column : public IColumn
+	{
+	public:
+		std::vector<T> values;
+
+		void SwapRemove(size_t row) override
+		{
+			if (row + 1 != values.size())
+				values[row] = std::move(values.back());
+			values.pop_back();
+		}
+		void MoveRowTo(size_t row, IColumn& other) override
+		{
+			static_cast<Column<T>&>(other).values.push_back(std::move(values[row]));
+			SwapRemove(row);
+		}
+		std::unique_ptr<IColumn> CreateEmpty() const override { return std::make_unique<Column<T>>(); }
+	};
+
+	//every entity with exactly the same set of components, row i of every column belongs to entities[i]
+	struct Archetype
+	{
+		Mask mask = 0;
+		std::vector<Entity> entities;
+		std::array<std::unique_ptr<IColumn>, MAX_COMPONENTS> columns;
+
+		template<class T> std::vector<T>& Values() { return static_cast<Column<T>&>(*columns[TypeId<T>()]).values; }
+	};
+}
+
+// Entities and their components, stored by archetype
+// - an archetype keeps one packed array per component, so a query walks plain arrays instead of chasing pointers
+// - adding or removing a component moves the entity's row to the archetype for its new set
+// - destroying swap removes, the last row takes the hole (row order isn't stable, handles are)
+// - no creating, destroying, Add or Remove from inside Each, the arrays it walks would move
+class EntityWorld
+{
+public:
+	template<class... Components>
+	Entity Create(Components... components)
+	{
+		using namespace EntityComponents;
+		Mask mask = (Bit<Components>() | ... | 0ull);
+		Archetype* archetype = FindArchetype(mask);
+		if (!archetype)
+		{
+			archetype = AddArchetype(mask);
+			((archetype->columns[TypeId<Components>()] = std::make_unique<Column<Components>>()), ...);
+		}
+		Entity entity = AllocateEntity(archetype, (uint32_t)archetype->entities.size());
+		archetype->entities.push_back(entity);
+		(archetype->Values<Components>().push_back(std::move(components)), ...);
+		return entity;
+	}
+
+	void Destroy(Entity entity);
+	bool IsAlive(Entity entity) const { return entity.index < records.size() && records[entity.index].generation == entity.generation && records[entity.index].archetype; }
+
+	//nullptr when the entity is gone or doesn't have one, only good until the next structural change
+	template<class T>
+	T* Get(Entity entity)
+	{
+		using namespace EntityComponents;
+		if (!IsAlive(entity))
+			return nullptr;
+		const Record& record = records[entity.index];
+		if (!(record.archetype->mask & Bit<T>()))
+			return nullptr;
+		return &record.archetype->Values<T>()[record.row];
+	}
+
+	//replaces the value if it already has one
+	template<class T>
+	void Add(Entity entity, T component)
+	{
+		using namespace EntityComponents;
+		if (T* existing = Get<T>(entity))
+		{
+			*existing = std::move(component);
+			return;
+		}
+		if (!IsAlive(entity))
+			return;
+		Archetype* from = records[entity.index].archetype;
+		Archetype* to = FindArchetype(from->mask | Bit<T>());
+		if (!to)
+		{
+			to = AddArchetype(from->mask | Bit<T>(), from);
+			to->columns[TypeId<T>()] = std::make_unique<Column<T>>();
+		}
+		MoveEntity(entity, to);
+		to->Values<T>().push_back(std::move(component));
+	}
+
+	template<class T>
+	void Remove(Entity entity)
+	{
+		using namespace EntityComponents;
+		if (!Get<T>(entity))
+			return;
+		Archetype* from = records[entity.index].archetype;
+		Mask mask = from->mask & ~Bit<T>();
+		Archetype* to = FindArchetype(mask);
+		if (!to)
+			to = AddArchetype(mask, from);
+		//the removed column has no counterpart, its value is dropped before the move
+		from->columns[TypeId<T>()]->SwapRemove(records[entity.index].row);
+		MoveEntity(entity, to, TypeId<T>());
+	}
+
+	// Calls function(Entity, Components&...) for every entity that has (at least) all of Components
+	// archetype by archetype, each one a straight walk over its arrays
+	template<class... Components, class Function>
+	void Each(Function&& function)
+	{
+		using namespace EntityComponents;
+		Mask mask = (Bit<Components>() | ... | 0ull);
+		for (const std::unique_ptr<Archetype>& archetype : archetypes)
+		{
+			if ((archetype->mask & mask) != mask || archetype->entities.empty())
+				continue;
+			size_t count = archetype->entities.size();
+			const Entity* entities = archetype->entities.data();
+			EachRows(count, entities, function, archetype->Values<Components>().data()...);
+		}
+	}
+
+	size_t GetCount() const { return records.size() - freeIndices.size(); }
+	size_t GetArchetypeCount() const { return archetypes.size(); }
+
+private:
+	struct Record
+	{
+		EntityComponents::Archetype* archetype = nullptr; //null while the index is free
+		uint32_t row = 0;
+		uint32_t generation = 0;
+	};
+
+	std::vector<Record> records;
+	std::vector<uint32_t> freeIndices;
+	std::vector<std::unique_ptr<EntityComponents::Archetype>> archetypes;
+	std::unordered_map<EntityComponents::Mask, EntityComponents::Archetype*> archetypesByMask;
+
+	EntityComponents::Archetype* FindArchetype(EntityComponents::Mask mask);
+	//columns are copied (empty) from like for the types both masks have
+	EntityComponents::Archetype* AddArchetype(EntityComponents::Mask mask, const EntityComponents::Archetype* like = nullptr);
+	Entity AllocateEntity(EntityComponents::Archetype* archetype, uint32_t row);
+	//every column both archetypes share, skipColumn was already taken out by the caller
+	void MoveEntity(Entity entity, EntityComponents::Archetype* to, unsigned int skipColumn = EntityComponents::MAX_COMPONENTS);
+
+	template<class Function, class... Pointers>
+	static void EachRows(size_t count, const Entity* entities, Function& function, Pointers... columns)
+	{
+		for (size_t row = 0; row < count; row++)
+			function(entities[row], columns[row]...);
+	}
+};
@@ -0,0 +1,29 @@
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(float step, unsigned int maxSteps) : step(step), maxSteps(maxSteps)
+{
+}
+
+unsigned int FixedTimestep::Advance(float frameDelta)
+{
+	if (frameDelta > 0.0f)
+		accumulator += frameDelta;
+
+	unsigned int steps = 0;
+	while (accumulator >= step)
+	{
+		if (steps == maxSteps)
+		{
+			//throw away the whole steps we can't afford, keep the fraction so alpha stays smooth
+			unsigned int dropped = (unsigned int)(accumulator / step);
+			droppedSteps += dropped;
+			accumulator -= dropped * (double)step;
+			break;
+		}
+		accumulator -= step;
+		steps++;
+	}
+	time += steps * (double)step;
+	stepCount += steps;
+	return steps;
+}
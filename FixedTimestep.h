@@ -0,0 +1,31 @@
+#pragma once
+
+// Accumulator for running the simulation at a fixed rate no matter the frame rate
+// - every frame the real delta goes in, Advance says how many whole steps to simulate
+// - what is left over (less than a step) comes back as the alpha to blend the last two steps for rendering
+// - a very long frame (breakpoint, window drag) is capped at MaxSteps, the extra time is dropped instead of
+//   piling up into ever longer catch up frames
+class FixedTimestep
+{
+public:
+	explicit FixedTimestep(float step = 1.0f / 60.0f, unsigned int maxSteps = 5);
+
+	//adds frameDelta, returns how many steps to simulate this frame
+	unsigned int Advance(float frameDelta);
+
+	float GetStep() const { return step; }
+	//where rendering sits between the previous and the current step, [0, 1)
+	float GetAlpha() const { return (float)(accumulator / step); }
+	//simulated time, a multiple of the step
+	double GetTime() const { return time; }
+	unsigned long long GetStepCount() const { return stepCount; }
+	unsigned int GetDroppedSteps() const { return droppedSteps; } //lost to the cap since the start
+
+private:
+	float step;
+	unsigned int maxSteps;
+	double accumulator = 0.0; //double so tiny deltas don't vanish into a big float
+	double time = 0.0;
+	unsigned long long stepCount = 0;
+	unsigned int droppedSteps = 0;
+};
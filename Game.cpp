@@ -6,6 +6,7 @@
 #include "Window.h"
 #include "Camera.h"
 #include "AudioManager.h"
+#include "RenderSystem.h"
 #include <DirectXMath.h>
 
 // Needed for a helper function to load pre-compiled shader files
@@ -32,20 +33,43 @@ void Game::Initialize()
 	}
 	CreateGeometry();
 	std::shared_ptr<Material> redMaterial = std::make_shared<Material>("Red Solid", pixelShader, vertexShader, XMFLOAT3(1.0f, 0.0f, 0.0f), 0.5);
-	materials.insert(materials.end(), { redMaterial });
+	std::shared_ptr<Material> redCompactMaterial = std::make_shared<Material>("Red Solid (compact)", pixelShader, compactVertexShader, XMFLOAT3(1.0f, 0.0f, 0.0f), 0.5);
+	//objects sharing a mesh with this material get batched into instanced draws
+	redMaterial->SetInstancedVertexShader(instancedVertexShader);
+	materials.insert(materials.end(), { redMaterial, redCompactMaterial });
 	for (auto& material : materials) {
 		material->Initialize();
 	}
 
-	//create gameobjects:
+	//create entities, each one a row of Transform/MeshRef/MaterialRef/RenderState/SpatialProxy in the world
 	{
-		std::shared_ptr<GameObject> cubeObject = std::make_shared<GameObject>(meshes[0], redMaterial);
-		entities.push_back(cubeObject);
-		for (const auto& entity : entities)
+		auto createEntity = [&](const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material, XMFLOAT3 position)
 		{
-			auto vertexShader = entity->GetMaterial()->GetVertexShader();
-			shaderGroups[vertexShader].push_back(entity);
-		}
+			Transform transform;
+			transform.setPosition(position);
+			return world.Create(std::move(transform), MeshRef{ mesh.get() }, MaterialRef{ material.get() }, RenderState{}, SpatialProxy{});
+		};
+		spinningCube = createEntity(meshes[0], redMaterial, XMFLOAT3(0.0f, 0.0f, 0.0f));
+		createEntity(meshes[1], redMaterial, XMFLOAT3(-3.0f, 0.0f, 0.0f));
+		createEntity(meshes[2], redCompactMaterial, XMFLOAT3(3.0f, 0.0f, 0.0f));
+		createEntity(meshes[3], redMaterial, XMFLOAT3(0.0f, 3.0f, 0.0f));
+		//small cube hanging off the first one, it follows the parent's spin in Update
+		Entity childCube = createEntity(meshes[0], redMaterial, XMFLOAT3(0.0f, 1.5f, 0.0f));
+		//moves keep the pool slot, so pointing at the cube's column entry is fine
+		world.Get<Transform>(childCube)->setParent(world.Get<Transform>(spinningCube));
+		world.Get<Transform>(childCube)->setScale(XMFLOAT3(0.5f, 0.5f, 0.5f));
+		//field of cubes behind everything, one long run of the same mesh + material for the instanced path
+		for (int x = 0; x < INSTANCE_GRID_SIZE; x++)
+			for (int z = 0; z < INSTANCE_GRID_SIZE; z++)
+			{
+				Entity gridCube = createEntity(meshes[0], redMaterial, XMFLOAT3((x - INSTANCE_GRID_SIZE / 2) * 1.5f, -4.0f, 10.0f + z * 1.5f));
+				world.Get<Transform>(gridCube)->setScale(XMFLOAT3(0.4f, 0.4f, 0.4f));
+			}
+		//low wall in front of the field, hides most of it from the starting camera so occlusion culling has something to do
+		cubeOccluder = OccluderMesh::Box(meshes[0]->GetBounds().Min, meshes[0]->GetBounds().Max);
+		Entity wall = createEntity(meshes[0], redMaterial, XMFLOAT3(0.0f, -2.6f, 8.0f));
+		world.Get<Transform>(wall)->setScale(XMFLOAT3(25.0f, 1.9f, 0.25f));
+		world.Add(wall, Occluder{ &cubeOccluder });
 	}
 
 	//camera basic setup //TODO: CAMERA NEEDS IMPROVED CONTROLS and bug fix so we can set proper looking at position instead of directly at mouse pos.
@@ -120,6 +144,10 @@ void Game::LoadShaders()
 	pixelShader = std::make_shared<SimplePixelShader>(Graphics::Device,
 		Graphics::Context11_1, FixPath(L"PixelShader.cso").c_str());
 	instancedVertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context11_1, FixPath(L"InstancedVertexShader.cso").c_str());
+	//reflection can't tell unorm/half/snorm inputs apart from floats so the compact layout is built by hand
+	std::wstring compactPath = FixPath(L"CompactVertexShader.cso");
+	compactVertexShader = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context11_1, compactPath.c_str(),
+		Mesh::CreateInputLayout(VertexFormat::Compact, compactPath), false);
 }
 
 
@@ -128,22 +156,63 @@ void Game::LoadShaders()
 // --------------------------------------------------------
 void Game::CreateGeometry()
 {
-	// Create the mesh
-	std::shared_ptr<Mesh> cube = std::make_shared<Mesh>("cube", FixPath(L"../../Assets/Models/cube.obj").c_str());
+	// Create the meshes
+	// - the cube is loaded right away, it is tiny (and cached) and doubles as the placeholder
+	// - everything else is parsed/optimized on the loader's threads and uploaded by Update once it is done,
+	//   so the first frame doesn't wait on the asset count
+	MeshImportOptions compactOptions;
+	compactOptions.vertexFormat = VertexFormat::Compact;
+	MeshImportOptions meshletOptions;
+	meshletOptions.buildMeshlets = true;
+	std::wstring cubePath = FixPath(L"../../Assets/Models/cube.obj");
+	std::shared_ptr<Mesh> cube = std::make_shared<Mesh>("cube", cubePath);
+	meshLoader = std::make_unique<MeshLoader>();
+	meshLoader->SetPlaceholder(VertexFormat::Full, cube);
+	meshLoader->SetPlaceholder(VertexFormat::Compact, std::make_shared<Mesh>("cube (compact)", cubePath, compactOptions));
+
 	meshes.push_back(cube);
+	//same sphere twice, full floats and quantized, to compare them side by side
+	meshes.push_back(meshLoader->Load("sphere", FixPath(L"../../Assets/Models/sphere.obj")));
+	meshes.push_back(meshLoader->Load("sphere (compact)", FixPath(L"../../Assets/Models/sphere.obj"), compactOptions));
+	meshes.push_back(meshLoader->Load("helix", FixPath(L"../../Assets/Models/helix.obj"), meshletOptions));
+}
+
+
+// --------------------------------------------------------
+// Copies the occlusion buffer into a texture ImGui can show
+// --------------------------------------------------------
+void Game::UpdateOcclusionTexture()
+{
+	if (!occlusionTexture)
+	{
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = occlusion.GetWidth();
+		desc.Height = occlusion.GetHeight();
+		desc.MipLevels = 1;
+		desc.ArraySize = 1;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM; //grey, imgui's shader doesn't swizzle single channel textures
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		Graphics::Device->CreateTexture2D(&desc, nullptr, occlusionTexture.GetAddressOf());
+		Graphics::Device->CreateShaderResourceView(occlusionTexture.Get(), nullptr, occlusionTextureView.GetAddressOf());
+	}
 
-	// Create instance data 
-	//std::vector<InstanceData> instanceData;
-	//for (int i = 0; i < NUM_INSTANCES; i++)
-	//{
-	//	InstanceData data;
-	//	// Set up the world matrix for each instance
-	//	XMStoreFloat4x4(&data.world, XMMatrixTranslation(i * 4.0f, 0.0f, 0.0f));
-	//	instanceData.push_back(data);
-	//}
-
-	//// Update the instance buffer with the instance data
-	//Graphics::UpdateInstanceBuffer(instanceData);
+	occlusion.GetDepthImage(occlusionPixels);
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(Graphics::Context11_1->Map(occlusionTexture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		return;
+	for (unsigned int y = 0; y < occlusion.GetHeight(); y++)
+	{
+		uint32_t* row = (uint32_t*)((uint8_t*)mapped.pData + y * mapped.RowPitch);
+		for (unsigned int x = 0; x < occlusion.GetWidth(); x++)
+		{
+			uint32_t grey = occlusionPixels[y * occlusion.GetWidth() + x];
+			row[x] = 0xFF000000u | grey << 16 | grey << 8 | grey;
+		}
+	}
+	Graphics::Context11_1->Unmap(occlusionTexture.Get(), 0);
 }
 
 
@@ -184,49 +253,143 @@ void Game:: updateUi(float deltaTime) {
 		//color picker
 		ImGui::ColorEdit4("RGBA color editor", bgColor);
 		//info bout each mesh
+		if (meshLoader->GetPendingCount() > 0)
+			ImGui::Text("Meshes loading: %u", meshLoader->GetPendingCount());
 		if (ImGui::TreeNode("Meshes:")) {
 			for (auto& mesh : meshes) {
 				ImGui::Text("Mesh: %s", mesh->GetName());
+				if (!mesh->IsReady())
+				{
+					ImGui::Text("Loading...");
+					continue;
+				}
 				//vertex count
 				ImGui::Text("Vertex Count: %d", mesh->GetVertexCount());
+				//vertex count before welding, only obj meshes are welded
+				if (mesh->GetUnweldedVertexCount() > 0)
+					ImGui::Text("Vertex Count (unwelded): %d", mesh->GetUnweldedVertexCount());
 				//index count
 				ImGui::Text("Index Count: %d", mesh->GetIndexCount());
+				//load time, from the .meshbin cache or a full obj import
+				ImGui::Text("Load Time: %.3f ms (%s)", mesh->GetLoadMilliseconds(), mesh->WasLoadedFromCache() ? "cache" : "obj");
+				//post-transform cache efficiency before and after the optimization pass
+				ImGui::Text("ACMR: %.3f -> %.3f", mesh->GetCacheStatsBefore().acmr, mesh->GetCacheStatsAfter().acmr);
+				ImGui::Text("ATVR: %.3f -> %.3f", mesh->GetCacheStatsBefore().atvr, mesh->GetCacheStatsAfter().atvr);
+				//levels of detail, error is how far the surface may move from lod 0
+				for (unsigned int lod = 0; lod < mesh->GetLodCount(); lod++)
+					ImGui::Text("LOD %u: %u triangles, error %.4f", lod, mesh->GetLod(lod).indexCount / 3, mesh->GetLod(lod).error);
+				//meshlets that survived the frustum and backface tests in the last draw
+				if (mesh->HasMeshlets())
+					ImGui::Text("Meshlets: %u / %u visible, %u triangles drawn", mesh->GetVisibleMeshletCount(), mesh->GetMeshletCount(), mesh->GetCulledIndexCount() / 3);
+				//gpu memory layout
+				ImGui::Text("Vertex Stride: %u bytes, Indices: %s", mesh->GetVertexStride(), mesh->GetIndexFormat() == DXGI_FORMAT_R16_UINT ? "16 bit" : "32 bit");
+				//round trip error of the quantized format
+				if (mesh->GetVertexFormat() == VertexFormat::Compact)
+				{
+					const QuantizationError& error = mesh->GetQuantizationError();
+					ImGui::Text("Quantization Error: pos %.6f, uv %.6f, normal %.3f deg", error.position, error.uv, error.normalDegrees);
+				}
 			}
 			ImGui::TreePop(); //close tree node
 		}
+		//shared vertex/index buffers, fragmentation is how much of the free space is outside the biggest free block
+		if (ImGui::TreeNode("Geometry Arenas:")) {
+			for (auto& arena : GeometryArenas::GetAll()) {
+				GeometryArenaStats stats = arena->GetStats();
+				ImGui::Text("Stride %u, %s indices: %u meshes", arena->GetVertexStride(), arena->GetIndexFormat() == DXGI_FORMAT_R16_UINT ? "16 bit" : "32 bit", stats.ranges);
+				ImGui::Text("Vertices: %u / %u, %u free blocks, fragmentation %.1f%%", stats.vertices.used, stats.vertices.capacity, stats.vertices.freeBlocks, stats.vertices.fragmentation * 100.0f);
+				ImGui::Text("Indices: %u / %u, %u free blocks, fragmentation %.1f%%", stats.indices.used, stats.indices.capacity, stats.indices.freeBlocks, stats.indices.fragmentation * 100.0f);
+				ImGui::Text("Compactions: %u, Growths: %u", stats.compactions, stats.growths);
+				std::string compactLabel = "Compact##" + std::to_string(arena->GetVertexStride()) + "_" + std::to_string(arena->GetIndexFormat());
+				if (ImGui::Button(compactLabel.c_str()))
+					arena->Compact();
+			}
+			ImGui::TreePop();
+		}
+		//instance ring, wraps are the only frames that discard the buffer
+		{
+			const RingAllocator& ring = SharedBuffers::Instances.GetAllocator();
+			ImGui::Text("Instance Ring: %zu / %zu bytes this frame, %u wraps total", ring.GetFrameBytes(), ring.GetCapacity(), ring.GetTotalWraps());
+		}
+		//transforms rebuilt by the last batch update
+		ImGui::Text("Transforms: %u updated / %u (%s), version %llu", TransformPool::Get().GetLastUpdateCount(), TransformPool::Get().GetCount(), TransformPool::Get().UsesAVX2() ? "AVX2" : "SSE", (unsigned long long)TransformPool::Get().GetGlobalVersion());
+		ImGui::Text("Interpolated transforms: %u", TransformPool::Get().GetLastInterpolateCount());
+		ImGui::Text("Rotation trig calls last frame: %u, normal matrices built: %u", TransformPool::Get().GetLastTrigCount(), TransformPool::Get().GetLastNormalCount());
+		ImGui::Text("Hierarchy: %u children, max depth %u, %u composed", TransformPool::Get().GetChildCount(), TransformPool::Get().GetMaxDepth(), TransformPool::Get().GetLastComposeCount());
+		//state changes the render queue's sort saved, submission order vs sorted
+		const StateChangeCounts& unsortedChanges = renderQueue.GetUnsortedChanges();
+		const StateChangeCounts& sortedChanges = renderQueue.GetSortedChanges();
+		ImGui::Text("Draws: %zu, shader/material/mesh changes %u/%u/%u unsorted, %u/%u/%u sorted", renderQueue.GetCount(),
+			unsortedChanges.shaders, unsortedChanges.materials, unsortedChanges.meshes, sortedChanges.shaders, sortedChanges.materials, sortedChanges.meshes);
+		ImGui::Text("Draw calls: %u single, %u instanced (%u instances), %u culled, %u past the shader's slots", drawStats.drawCalls, drawStats.instancedDrawCalls, drawStats.instances, drawStats.culled, drawStats.slotOverflow);
+		unsigned int commandCount = 0;
+		size_t commandBytes = 0;
+		for (const CommandBuffer& commands : frameCommands) {
+			commandCount += commands.GetCommandCount();
+			commandBytes += commands.GetSize();
+		}
+		ImGui::Text("Commands: %u (%.1f KB), recorded by %u threads in %.3f ms", commandCount, commandBytes / 1024.0f,
+			drawStats.recordJobs, drawStats.recordMilliseconds);
+		//for comparing how recording scales, 0 is all of them
+		ImGui::SliderInt("Draw threads", &drawThreads, 0, (int)workers.GetThreadCount() + 1);
+		const StateCacheStats& stateStats = commandExecutor.GetStateCache().GetStats();
+		ImGui::Text("State calls: %u issued, %u elided", stateStats.GetIssued(), stateStats.GetElided());
+		if (ImGui::TreeNode("State calls by kind:")) {
+			for (size_t i = 0; i < (size_t)StateCall::Count; i++)
+				ImGui::Text("%s: %u issued, %u elided", GetStateCallName((StateCall)i), stateStats.issued[i], stateStats.elided[i]);
+			ImGui::TreePop();
+		}
+		ImGui::Checkbox("Validate commands", &validateCommands);
+		if (validateCommands) {
+			const CommandStats& commandStats = commandValidator.GetStats();
+			ImGui::Text("%u draw calls, %.1f KB uploaded, %u redundant binds, %u errors", commandStats.drawCalls,
+				commandStats.uploadedBytes / 1024.0f, commandStats.redundantBinds, commandValidator.GetErrorCount());
+			if (!commandValidator.GetErrors().empty())
+				ImGui::TextWrapped("%s", commandValidator.GetErrors()[0].c_str());
+		}
+		if (ImGui::TreeNode("Occlusion culling:")) {
+			ImGui::Checkbox("Enabled", &occlusionCulling);
+			ImGui::Text("%u occluders, %u triangles, %u entities occluded", occluderCount, occlusion.GetTriangleCount(), drawStats.occluded);
+			//last frame's buffer, brighter is nearer
+			UpdateOcclusionTexture();
+			ImGui::Image(occlusionTextureView.Get(), ImVec2((float)occlusion.GetWidth(), (float)occlusion.GetHeight()));
+			ImGui::TreePop();
+		}
+		ImGui::Text("BVH: %u proxies, height %u, SAH cost %.1f, refit %.0f%%", spatialIndex.GetProxyCount(), spatialIndex.GetHeight(), spatialIndex.GetCost(), spatialIndex.GetRefitRatio() * 100.0f);
 		//info bout each entity
 		if (ImGui::TreeNode("Entities:")) {
-			for (size_t i = 0; i < entities.size(); i++) {
-				auto& entity = entities[i];
-				ImGui::Text("Entity %d: %s", i, entity->GetMesh()->GetName());
+			int i = 0;
+			world.Each<Transform, MeshRef, RenderState>([&](Entity, Transform& transform, MeshRef& meshRef, RenderState& state) {
+				ImGui::Text("Entity %d: %s (LOD %u)", i, meshRef.mesh->GetName(), state.lod);
 
 				// Transform Component
 				std::string transformNodeLabel = "Transform Component##" + std::to_string(i); // Unique label
 				if (ImGui::TreeNode(transformNodeLabel.c_str())) {
 					// Position
-					XMFLOAT3 position = entity->GetTransform()->getPosition();
+					XMFLOAT3 position = transform.getPosition();
 					std::string sliderLabel = "Position##" + std::to_string(i);
 					if (ImGui::SliderFloat3(sliderLabel.c_str(), &position.x, -1.0f, 1.0f)) {
-						entity->GetTransform()->setPosition(position); // Update position
+						transform.setPosition(position); // Update position
 					}
 
 					// Rotation
-					XMFLOAT3 rotation = entity->GetTransform()->getRotation();
+					XMFLOAT3 rotation = transform.getRotation();
 					sliderLabel = "Rotation##" + std::to_string(i);
 					if (ImGui::SliderFloat3(sliderLabel.c_str(), &rotation.x, -XM_2PI, XM_2PI)) {
-						entity->GetTransform()->setRotation(rotation); // Update rotation
+						transform.setRotation(rotation); // Update rotation
 					}
 
 					// Scale
-					XMFLOAT3 scale = entity->GetTransform()->getScale();
+					XMFLOAT3 scale = transform.getScale();
 					sliderLabel = "Scale##" + std::to_string(i);
 					if (ImGui::SliderFloat3(sliderLabel.c_str(), &scale.x, 0.1f, 2.0f)) {
-						entity->GetTransform()->setScale(scale); // Update scale
+						transform.setScale(scale); // Update scale
 					}
 
 					ImGui::TreePop(); // Close transform node
 				}
-			}
+				i++;
+			});
 			ImGui::TreePop(); // Close entities node
 		}
 
@@ -265,6 +428,8 @@ void Game::Update(float deltaTime, float totalTime)
 	//reallocate the constant buffer for world matrix because it is per object and it is dirty
 	//stoping rotation for now to test above claim
 	//entities[0]->GetTransform()->Rotate(0, 0, deltaTime);
+	//finished background loads get their gpu buffers here, before anything is drawn this frame
+	meshLoader->Update();
 	cameras[activeCamera]->Update(deltaTime);
 	updateUi(deltaTime);
 	audioManager->update_audio(deltaTime);
@@ -274,10 +439,23 @@ void Game::Update(float deltaTime, float totalTime)
 }
 
 
+// --------------------------------------------------------
+// Simulation at a fixed rate, transforms changed in here get blended between steps when drawn
+// --------------------------------------------------------
+void Game::FixedUpdate(float step, float simulationTime)
+{
+	TransformPool::Get().BeginFixedStep();
+	//the parent cube spins on its own, its child only gets recomposed by the hierarchy sweep
+	if (Transform* cube = world.Get<Transform>(spinningCube))
+		cube->Rotate(0, step * 0.5f, 0);
+	TransformPool::Get().EndFixedStep();
+}
+
+
 // --------------------------------------------------------
 // Clear the screen, redraw everything, present to the user
 // --------------------------------------------------------
-void Game::Draw(float deltaTime, float totalTime)
+void Game::Draw(float deltaTime, float totalTime, float alpha)
 {
 	// Frame START
 	// - At the beginning of Game::Draw() before drawing *anything*
@@ -285,6 +463,10 @@ void Game::Draw(float deltaTime, float totalTime)
 		// Clear the back buffer (erase what's on screen) and depth buffer
 		Graphics::Context11_1->ClearRenderTargetView(Graphics::BackBufferRTV.Get(),	bgColor);
 		Graphics::Context11_1->ClearDepthStencilView(Graphics::DepthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+		//imgui and anything else may have bound its own buffers since last frame
+		GeometryArenas::InvalidateBinding();
+		commandExecutor.BeginFrame(Graphics::Context11_1.Get());
+		SharedBuffers::Instances.BeginFrame();
 	}
 
 	//post processing goes here
@@ -292,18 +474,30 @@ void Game::Draw(float deltaTime, float totalTime)
 	//then drawing
 
 
-	Material::UpdatePerFrameData(cameras[activeCamera]);
-	// sort by each group of entities with the same vertex shader
-	for (const auto& [shader, shared_entities] : shaderGroups)
+	//whatever the simulation moved gets blended between its last two steps, then every transform touched since
+	//last frame gets its matrices rebuilt here in one batch
+	TransformPool::Get().Interpolate(alpha);
+	TransformPool::Get().UpdateDirty();
+	//every entity gets drawn and its material uploads the normal matrix, so build them all in one pass too
+	TransformPool::Get().UpdateNormals();
+	frameCommands[0].Reset();
+	Material::UpdatePerFrameData(frameCommands[0], cameras[activeCamera]);
+	//same lights for everything, set once and copied with each material's pixel data
+	pixelShader->SetFloat3("ambientColor", ambientColor);
+	pixelShader->SetData("lights", &lights[0], sizeof(Light) * (int)lights.size());
+	//after the matrices are rebuilt, the bvh boxes come from them
+	RenderSystem::UpdateSpatialIndex(world, spatialIndex, &workers);
+	occluderCount = occlusionCulling ? RenderSystem::RenderOccluders(world, *cameras[activeCamera], occlusion, &workers) : 0;
+	drawStats = RenderSystem::Draw(world, cameras[activeCamera], renderQueue, frameCommands, &spatialIndex, occlusionCulling ? &occlusion : nullptr,
+		&workers, (unsigned int)drawThreads);
+	//nothing has touched the context since the clear, the whole scene goes out here, the lists in order
+	for (const CommandBuffer& commands : frameCommands)
+		commandExecutor.Execute(commands);
+	if (validateCommands)
 	{
-		shader->SetShader(); //sets Vertex Shaderv
-
-		for (unsigned int i = 0; i < shared_entities.size(); ++i)
-		{
-			pixelShader->SetFloat3("ambientColor", ambientColor);
-			pixelShader->SetData("lights", &lights[0], sizeof(Light) * (int)lights.size());
-			shared_entities[i]->Draw(cameras[activeCamera], i); // Pass the object index
-		}
+		commandValidator.Reset();
+		for (const CommandBuffer& commands : frameCommands)
+			commandValidator.Execute(commands);
 	}
 
 
@@ -5,7 +5,15 @@
 #include <memory>
 
 #include "Mesh.h"
-#include "GameObject.h"
+#include "MeshLoader.h"
+#include "ThreadPool.h"
+#include "DynamicBvh.h"
+#include "OcclusionBuffer.h"
+#include "EntityWorld.h"
+#include "Components.h"
+#include "RenderQueue.h"
+#include "RenderSystem.h"
+#include "D3D11CommandExecutor.h"
 #include "Camera.h"
 #include "Material.h"
 #include "SimpleShader/SimpleShader.h"
@@ -22,7 +30,7 @@
 
 #include "InputManager.h"
 
-#define NUM_INSTANCES 10
+#define INSTANCE_GRID_SIZE 40 //cubes per side of the instancing test field
 
 class Game
 {
@@ -35,7 +43,10 @@ public:
 	// Primary functions
 	void Initialize();
 	void Update(float deltaTime, float totalTime);
-	void Draw(float deltaTime, float totalTime);
+	//simulation, called 0 or more times per frame at a fixed rate (see FixedTimestep)
+	void FixedUpdate(float step, float simulationTime);
+	//alpha blends the last two simulation steps for transforms that moved
+	void Draw(float deltaTime, float totalTime, float alpha);
 	void OnResize();
 
 private:
@@ -53,10 +64,30 @@ private:
 
 	//Meshes shared smart pointer
 	std::vector<std::shared_ptr<Mesh>> meshes;
-	std::vector<std::shared_ptr<GameObject>> entities;
+	std::unique_ptr<MeshLoader> meshLoader; //background obj loading, uploads in Update
 	std::vector<std::shared_ptr<Material>> materials;
-	std::unordered_map<std::shared_ptr<ISimpleShader>, std::vector<std::shared_ptr<GameObject>>> shaderGroups; 
 	std::vector<Light> lights;
+	OccluderMesh cubeOccluder; //the cube mesh's bounds, exact for it
+	//entities only point at the meshes and materials above, declared after them so it goes first on shutdown
+	EntityWorld world;
+	Entity spinningCube; //the one FixedUpdate rotates
+	RenderQueue renderQueue; //refilled every Draw, kept around for its buffers and the ui counts
+	RenderSystem::DrawStats drawStats; //from the last Draw, for the ui
+	std::vector<CommandBuffer> frameCommands = std::vector<CommandBuffer>(1); //one per thread RenderSystem::Draw records with, replayed in order by commandExecutor
+	D3D11CommandExecutor commandExecutor;
+	NullCommandExecutor commandValidator; //replays the frame a second time against no gpu when validateCommands is on
+	bool validateCommands = false;
+	int drawThreads = 0; //most threads recording the draws, 0 for every worker plus the main thread
+	DynamicBvh spatialIndex; //every entity's bounds, the frustum query picks what gets drawn
+	ThreadPool workers; //frame work like bvh rebuilds, separate from the loader's so waiting on it doesn't wait on file io
+	OcclusionBuffer occlusion; //occluders drawn from the active camera each frame
+	bool occlusionCulling = true;
+	unsigned int occluderCount = 0; //from the last RenderOccluders, for the ui
+	//the occlusion buffer as a texture for the ui, only updated while it's being looked at
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> occlusionTexture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> occlusionTextureView;
+	std::vector<uint8_t> occlusionPixels;
+	void UpdateOcclusionTexture();
 
 	//lighting
 
@@ -65,6 +96,7 @@ private:
 	std::shared_ptr<SimplePixelShader> pixelShader;
 	std::shared_ptr<SimpleVertexShader> vertexShader;
 	std::shared_ptr<SimpleVertexShader> instancedVertexShader;
+	std::shared_ptr<SimpleVertexShader> compactVertexShader; //decodes CompactVertex meshes
 
 	//ImGui
 	bool showDemoWindow = false;
@@ -0,0 +1,201 @@
+#include "GeometryArena.h"
+#include "Graphics.h"
+#include <algorithm>
+
+namespace
+{
+	std::vector<std::unique_ptr<GeometryArena>> arenas;
+	//per thread, each thread recording draws has its own command buffer and so its own idea of what is bound
+	thread_local GeometryArena* boundArena = nullptr;
+}
+
+GeometryArena::GeometryArena(unsigned int vertexStride, DXGI_FORMAT indexFormat, unsigned int vertexCapacity, unsigned int indexCapacity)
+	: vertexStride(vertexStride), indexFormat(indexFormat), vertexAllocator(vertexCapacity), indexAllocator(indexCapacity)
+{
+	indexFormatSize = indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4;
+	vertexBuffer = CreateBuffer(vertexCapacity * vertexStride, D3D11_BIND_VERTEX_BUFFER);
+	indexBuffer = CreateBuffer(indexCapacity * indexFormatSize, D3D11_BIND_INDEX_BUFFER);
+}
+
+unsigned int GeometryArena::Allocate(const void* vertices, unsigned int vertexCount, const void* indices, unsigned int indexCount)
+{
+	if (!vertexBuffer || !indexBuffer)
+		return INVALID_HANDLE;
+	GeometryRange range = {};
+	if (!TryAllocate(vertexCount, indexCount, range))
+	{
+		// Out of space: compacting is enough when the free space is only split up,
+		// otherwise the buffers have to grow (at least double so this stays rare)
+		OffsetAllocatorStats v = vertexAllocator.GetStats();
+		OffsetAllocatorStats i = indexAllocator.GetStats();
+		if (v.capacity - v.used >= vertexCount && i.capacity - i.used >= indexCount)
+			Compact();
+		if (!TryAllocate(vertexCount, indexCount, range))
+		{
+			//the new space goes on the end in one piece, so capacity + count always fits whatever the old space looks like
+			//(used + count doesn't when the free space is split up and compacting failed)
+			if (!Grow(std::max(v.capacity * 2, v.capacity + vertexCount), std::max(i.capacity * 2, i.capacity + indexCount)) ||
+				!TryAllocate(vertexCount, indexCount, range))
+				return INVALID_HANDLE;
+		}
+	}
+
+	D3D11_BOX vertexBox = { range.baseVertex * vertexStride, 0, 0, (range.baseVertex + vertexCount) * vertexStride, 1, 1 };
+	Graphics::Context11_1->UpdateSubresource(vertexBuffer.Get(), 0, &vertexBox, vertices, 0, 0);
+	D3D11_BOX indexBox = { range.firstIndex * indexFormatSize, 0, 0, (range.firstIndex + indexCount) * indexFormatSize, 1, 1 };
+	Graphics::Context11_1->UpdateSubresource(indexBuffer.Get(), 0, &indexBox, indices, 0, 0);
+
+	unsigned int handle;
+	if (!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+		ranges[handle] = range;
+		live[handle] = true;
+	}
+	else
+	{
+		handle = (unsigned int)ranges.size();
+		ranges.push_back(range);
+		live.push_back(true);
+	}
+	return handle;
+}
+
+void GeometryArena::Free(unsigned int handle)
+{
+	if (handle == INVALID_HANDLE || !live[handle])
+		return;
+	const GeometryRange& range = ranges[handle];
+	vertexAllocator.Free(range.baseVertex, range.vertexCount);
+	indexAllocator.Free(range.firstIndex, range.indexCount);
+	live[handle] = false;
+	freeHandles.push_back(handle);
+}
+
+void GeometryArena::Bind(CommandBuffer& commands)
+{
+	if (boundArena == this)
+		return;
+	commands.SetVertexBuffer(0, vertexBuffer.Get(), vertexStride);
+	commands.SetIndexBuffer(indexBuffer.Get(), indexFormat == DXGI_FORMAT_R16_UINT);
+	boundArena = this;
+}
+
+bool GeometryArena::Compact()
+{
+	// Copy every live range into fresh buffers back to back, in their current order so the copies never overlap
+	// (the gpu can't copy a buffer onto itself when source and destination overlap)
+	std::vector<unsigned int> order;
+	for (unsigned int handle = 0; handle < ranges.size(); handle++)
+		if (live[handle])
+			order.push_back(handle);
+	std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) { return ranges[a].baseVertex < ranges[b].baseVertex; });
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> newVertexBuffer = CreateBuffer(vertexAllocator.GetCapacity() * vertexStride, D3D11_BIND_VERTEX_BUFFER);
+	Microsoft::WRL::ComPtr<ID3D11Buffer> newIndexBuffer = CreateBuffer(indexAllocator.GetCapacity() * indexFormatSize, D3D11_BIND_INDEX_BUFFER);
+	if (!newVertexBuffer || !newIndexBuffer)
+		return false; //nothing moved yet
+	unsigned int vertexEnd = 0;
+	unsigned int indexEnd = 0;
+	for (unsigned int handle : order)
+	{
+		GeometryRange& range = ranges[handle];
+		D3D11_BOX vertexBox = { range.baseVertex * vertexStride, 0, 0, (range.baseVertex + range.vertexCount) * vertexStride, 1, 1 };
+		Graphics::Context11_1->CopySubresourceRegion(newVertexBuffer.Get(), 0, vertexEnd * vertexStride, 0, 0, vertexBuffer.Get(), 0, &vertexBox);
+		D3D11_BOX indexBox = { range.firstIndex * indexFormatSize, 0, 0, (range.firstIndex + range.indexCount) * indexFormatSize, 1, 1 };
+		Graphics::Context11_1->CopySubresourceRegion(newIndexBuffer.Get(), 0, indexEnd * indexFormatSize, 0, 0, indexBuffer.Get(), 0, &indexBox);
+		//indices are relative to baseVertex so they don't need rewriting
+		range.baseVertex = vertexEnd;
+		range.firstIndex = indexEnd;
+		vertexEnd += range.vertexCount;
+		indexEnd += range.indexCount;
+	}
+
+	vertexBuffer = newVertexBuffer;
+	indexBuffer = newIndexBuffer;
+	vertexAllocator.Reset(vertexEnd);
+	indexAllocator.Reset(indexEnd);
+	if (boundArena == this)
+		boundArena = nullptr;
+	compactions++;
+	return true;
+}
+
+GeometryArenaStats GeometryArena::GetStats() const
+{
+	GeometryArenaStats stats = {};
+	stats.ranges = (unsigned int)std::count(live.begin(), live.end(), true);
+	stats.vertices = vertexAllocator.GetStats();
+	stats.indices = indexAllocator.GetStats();
+	stats.compactions = compactions;
+	stats.growths = growths;
+	return stats;
+}
+
+bool GeometryArena::TryAllocate(unsigned int vertexCount, unsigned int indexCount, GeometryRange& range)
+{
+	range.baseVertex = vertexAllocator.Allocate(vertexCount);
+	if (range.baseVertex == OffsetAllocator::INVALID_OFFSET)
+		return false;
+	range.firstIndex = indexAllocator.Allocate(indexCount);
+	if (range.firstIndex == OffsetAllocator::INVALID_OFFSET)
+	{
+		vertexAllocator.Free(range.baseVertex, vertexCount);
+		return false;
+	}
+	range.vertexCount = vertexCount;
+	range.indexCount = indexCount;
+	return true;
+}
+
+bool GeometryArena::Grow(unsigned int vertexCapacity, unsigned int indexCapacity)
+{
+	//same offsets in a bigger buffer, only the used part of the old one gets copied
+	Microsoft::WRL::ComPtr<ID3D11Buffer> newVertexBuffer = CreateBuffer(vertexCapacity * vertexStride, D3D11_BIND_VERTEX_BUFFER);
+	Microsoft::WRL::ComPtr<ID3D11Buffer> newIndexBuffer = CreateBuffer(indexCapacity * indexFormatSize, D3D11_BIND_INDEX_BUFFER);
+	if (!newVertexBuffer || !newIndexBuffer)
+		return false; //out of memory or too big for a buffer, the old ones stay
+	Graphics::Context11_1->CopySubresourceRegion(newVertexBuffer.Get(), 0, 0, 0, 0, vertexBuffer.Get(), 0, nullptr);
+	Graphics::Context11_1->CopySubresourceRegion(newIndexBuffer.Get(), 0, 0, 0, 0, indexBuffer.Get(), 0, nullptr);
+	vertexBuffer = newVertexBuffer;
+	indexBuffer = newIndexBuffer;
+	vertexAllocator.Grow(vertexCapacity);
+	indexAllocator.Grow(indexCapacity);
+	if (boundArena == this)
+		boundArena = nullptr;
+	growths++;
+	return true;
+}
+
+Microsoft::WRL::ComPtr<ID3D11Buffer> GeometryArena::CreateBuffer(UINT byteWidth, UINT bindFlags)
+{
+	//default usage, filled with UpdateSubresource and moved around with CopySubresourceRegion
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = bindFlags;
+	desc.ByteWidth = byteWidth;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	if (FAILED(Graphics::Device->CreateBuffer(&desc, nullptr, buffer.GetAddressOf())))
+		return nullptr;
+	return buffer;
+}
+
+GeometryArena& GeometryArenas::Get(unsigned int vertexStride, DXGI_FORMAT indexFormat)
+{
+	for (auto& arena : arenas)
+		if (arena->GetVertexStride() == vertexStride && arena->GetIndexFormat() == indexFormat)
+			return *arena;
+	arenas.push_back(std::make_unique<GeometryArena>(vertexStride, indexFormat));
+	return *arenas.back();
+}
+
+const std::vector<std::unique_ptr<GeometryArena>>& GeometryArenas::GetAll()
+{
+	return arenas;
+}
+
+void GeometryArenas::InvalidateBinding()
+{
+	boundArena = nullptr;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <vector>
+
+#include "OffsetAllocator.h"
+#include "CommandBuffer.h"
+
+//where a mesh lives in its arena, indices are relative to baseVertex
+struct GeometryRange
+{
+	unsigned int baseVertex;
+	unsigned int vertexCount;
+	unsigned int firstIndex;
+	unsigned int indexCount;
+};
+
+struct GeometryArenaStats
+{
+	unsigned int ranges;
+	OffsetAllocatorStats vertices;
+	OffsetAllocatorStats indices;
+	unsigned int compactions;
+	unsigned int growths;
+};
+
+// One big vertex buffer and index buffer shared by every mesh with the same vertex stride and index format
+// - meshes get a handle to a range instead of their own buffers, so switching meshes doesn't touch the IA state
+// - ranges are placed by an OffsetAllocator per buffer, a failed allocation first compacts
+//   (when there is enough free space, just in pieces) and otherwise grows the buffers
+// - compaction moves ranges around, always look them up through the handle when drawing
+class GeometryArena
+{
+public:
+	static constexpr unsigned int INVALID_HANDLE = ~0u;
+
+	GeometryArena(unsigned int vertexStride, DXGI_FORMAT indexFormat, unsigned int vertexCapacity = 1 << 16, unsigned int indexCapacity = 1 << 18);
+	GeometryArena(const GeometryArena&) = delete; // Remove copy constructor
+	GeometryArena& operator=(const GeometryArena&) = delete; // Remove copy-assignment operator
+
+	//copies the data in, main thread only, INVALID_HANDLE when the buffers couldn't be made big enough
+	unsigned int Allocate(const void* vertices, unsigned int vertexCount, const void* indices, unsigned int indexCount);
+	void Free(unsigned int handle);
+	const GeometryRange& GetRange(unsigned int handle) const { return ranges[handle]; }
+
+	//records binding both buffers to the input assembler, skipped when they are still bound from the last Bind
+	void Bind(CommandBuffer& commands);
+	//packs every range to the front of the buffers, false (and nothing changed) when the new buffers couldn't be created
+	bool Compact();
+
+	unsigned int GetVertexStride() const { return vertexStride; }
+	DXGI_FORMAT GetIndexFormat() const { return indexFormat; }
+	ID3D11Buffer* GetVertexBuffer() { return vertexBuffer.Get(); }
+	ID3D11Buffer* GetIndexBuffer() { return indexBuffer.Get(); }
+	GeometryArenaStats GetStats() const;
+
+private:
+	unsigned int vertexStride;
+	unsigned int indexFormatSize;
+	DXGI_FORMAT indexFormat;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
+	OffsetAllocator vertexAllocator;
+	OffsetAllocator indexAllocator;
+
+	std::vector<GeometryRange> ranges; //by handle
+	std::vector<bool> live;
+	std::vector<unsigned int> freeHandles;
+	unsigned int compactions = 0;
+	unsigned int growths = 0;
+
+	//allocates both ranges or neither
+	bool TryAllocate(unsigned int vertexCount, unsigned int indexCount, GeometryRange& range);
+	//false (and nothing changed) when the new buffers couldn't be created
+	bool Grow(unsigned int vertexCapacity, unsigned int indexCapacity);
+	Microsoft::WRL::ComPtr<ID3D11Buffer> CreateBuffer(UINT byteWidth, UINT bindFlags);
+};
+
+//one arena per vertex stride / index format pair, created on first use
+namespace GeometryArenas
+{
+	GeometryArena& Get(unsigned int vertexStride, DXGI_FORMAT indexFormat);
+	const std::vector<std::unique_ptr<GeometryArena>>& GetAll();
+
+	//call after binding vertex slot 0 or the index buffer without going through an arena, or before recording into
+	//another command buffer (only forgets the calling thread's binding)
+	void InvalidateBinding();
+}
@@ -146,6 +146,9 @@ HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight
 	// We're set up
 	apiInitialized = true;
 
+	// Streaming buffer for per instance data, shared by every instanced draw
+	SharedBuffers::Instances.Initialize(sizeof(InstanceData), INSTANCE_RING_CAPACITY);
+
 	// Call ResizeBuffers() to set up the render target and depth stencil views
 	ResizeBuffers(windowWidth, windowHeight);
 
@@ -314,13 +317,7 @@ void Graphics::PrintDebugMessages()
 	// Clear any messages we've printed
 	InfoQueue->ClearStoredMessages();
 }
-void Graphics::UpdateInstanceBuffer(const std::vector<InstanceData>& instances)
+InstanceRange Graphics::UpdateInstanceBuffer(CommandBuffer& commands, const std::vector<InstanceData>& instances)
 {
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	HRESULT hr = Context11_1->Map(SharedBuffers::InstanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (SUCCEEDED(hr))
-	{
-		memcpy(mappedResource.pData, instances.data(), sizeof(InstanceData) * instances.size());
-		Context11_1->Unmap(SharedBuffers::InstanceBuffer.Get(), 0);
-	}
+	return SharedBuffers::Instances.Write(commands, instances.data(), (unsigned int)instances.size());
 }
@@ -39,7 +39,8 @@ namespace Graphics
 	HRESULT Initialize(unsigned int windowWidth, unsigned int windowHeight, HWND windowHandle, bool vsyncIfPossible);
 	void ShutDown();
 	void ResizeBuffers(unsigned int width, unsigned int height);
-	void UpdateInstanceBuffer(const std::vector<InstanceData>& instances);
+	//appends a batch to SharedBuffers::Instances, draw it with the returned range
+	InstanceRange UpdateInstanceBuffer(CommandBuffer& commands, const std::vector<InstanceData>& instances);
 	// Debug Layer
 	void PrintDebugMessages();
 }
@@ -0,0 +1,51 @@
+#include "InstanceRing.h"
+#include "Graphics.h"
+#include <cstring>
+
+void InstanceRing::Initialize(unsigned int instanceStride, unsigned int capacity)
+{
+	this->instanceStride = instanceStride;
+	this->capacity = capacity;
+	allocator = RingAllocator((size_t)instanceStride * capacity);
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = instanceStride * capacity;
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER; // Not a constant buffer
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	buffer.Reset();
+	Graphics::Device->CreateBuffer(&desc, nullptr, buffer.GetAddressOf());
+}
+
+InstanceRange InstanceRing::Write(CommandBuffer& commands, const void* instances, unsigned int count)
+{
+	InstanceRange range = Allocate(count);
+	if (void* data = Write(commands, range))
+		memcpy(data, instances, (size_t)range.count * instanceStride);
+	return range;
+}
+
+InstanceRange InstanceRing::Allocate(unsigned int count)
+{
+	if (count == 0)
+		return { 0, 0 };
+	//aligned to the stride so every batch starts on a whole instance
+	RingAllocation allocation = allocator.Allocate((size_t)count * instanceStride, instanceStride);
+	if (allocation.offset == RingAllocator::INVALID_OFFSET)
+		return { 0, 0 };
+	return { (unsigned int)(allocation.offset / instanceStride), count, allocation.wrapped };
+}
+
+void* InstanceRing::Write(CommandBuffer& commands, const InstanceRange& range)
+{
+	if (range.count == 0)
+		return nullptr;
+	//a wrap has to discard, the batches before it may still be in flight; executed in order with the draws so they read their own batch
+	BufferWrite mode = range.wrapped ? BufferWrite::Discard : BufferWrite::NoOverwrite;
+	return commands.WriteBuffer(buffer.Get(), range.count * instanceStride, range.firstInstance * instanceStride, mode);
+}
+
+void InstanceRing::Bind(CommandBuffer& commands, unsigned int slot)
+{
+	commands.SetVertexBuffer(slot, buffer.Get(), instanceStride);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include "RingAllocator.h"
+#include "CommandBuffer.h"
+
+//a batch of instances in the ring, pass firstInstance as StartInstanceLocation
+struct InstanceRange
+{
+	unsigned int firstInstance;
+	unsigned int count;
+	bool wrapped = false; //the ring started over for it, its write discards
+};
+
+// Dynamic vertex buffer that per instance data is streamed into, shared by every instanced draw
+// - each Write appends with D3D11_MAP_WRITE_NO_OVERWRITE, so earlier batches that the gpu hasn't drawn yet are left alone
+// - once the ring is full it wraps with D3D11_MAP_WRITE_DISCARD
+// - the buffer stays bound at offset 0, batches are told apart by their first instance instead of rebinding
+class InstanceRing
+{
+public:
+	void Initialize(unsigned int instanceStride, unsigned int capacity);
+
+	//records the copy into commands, count is 0 when the batch didn't fit (bigger than the whole ring)
+	InstanceRange Write(CommandBuffer& commands, const void* instances, unsigned int count);
+	//the same in two steps, so batches can be filled on other threads: Allocate on one thread, in the order the writes will execute
+	//(a wrap discards everything before it), then Write records the batch and returns where to put its instances (null for count 0)
+	InstanceRange Allocate(unsigned int count);
+	void* Write(CommandBuffer& commands, const InstanceRange& range);
+	void BeginFrame() { allocator.BeginFrame(); }
+
+	//input assembler slot for the per instance stream
+	void Bind(CommandBuffer& commands, unsigned int slot = 1);
+
+	ID3D11Buffer* GetBuffer() { return buffer.Get(); }
+	unsigned int GetCapacity() { return capacity; }
+	//instances the next Allocate can take without wrapping
+	unsigned int GetSpaceLeft() { return instanceStride ? (unsigned int)(allocator.GetSpaceLeft(instanceStride) / instanceStride) : 0; }
+	const RingAllocator& GetAllocator() { return allocator; }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	RingAllocator allocator;
+	unsigned int instanceStride = 0;
+	unsigned int capacity = 0;
+};
@@ -9,12 +9,6 @@ cbuffer PerFrameData : register(b0)
     // matrix shadowProjection;
 }
 
-cbuffer PerObjectData : register(b1)
-{
-    matrix world;
-    //matrix worldInvTrans;
-}
-
 /*
 cbuffer PerMaterialData : register(b2)
 {
@@ -30,17 +24,17 @@ cbuffer PerMaterialData : register(b2)
 // - Output is a single struct of data to pass down the pipeline
 // - Named "main" because that's the default the shader compiler looks for
 // --------------------------------------------------------
-VertexToPixel main( VertexShaderInput input )
+VertexToPixel main( InstancedVertexShaderInput input )
 {
 	// Set up output struct
 	VertexToPixel output;
 	
-	// Use the instance ID to get the correct world matrix
-    matrix wvp = mul(projection, mul(view, instances[input.instanceID].world));
+	// the world matrix comes in with the instance instead of from a cbuffer
+    matrix wvp = mul(projection, mul(view, input.world));
     output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
     output.uv = input.uv;
-    output.normal = input.normal;
-    output.worldPos = mul(instances[input.instanceID].world, float4(input.localPosition, 1.0f)).xyz;
+    output.normal = normalize(mul((float3x3) input.worldInvTrans, input.normal));
+    output.worldPos = mul(input.world, float4(input.localPosition, 1.0f)).xyz;
     
 	return output;
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "Graphics.h"
 #include "Game.h"
 #include "InputManager.h"
+#include "FixedTimestep.h"
 
 // Annonymous namespace to hold variables
 // only accessible in this file
@@ -102,6 +103,9 @@ int WINAPI WinMain(
 	currentTime = startTime;
 	previousTime = startTime;
 
+	// Simulation runs at a fixed 30 hz, rendering as fast as it can and blending between steps
+	FixedTimestep timestep(1.0f / 30.0f);
+
 	// Windows message loop (and our game loop)
 	MSG msg = {};
 	while (msg.message != WM_QUIT)
@@ -128,9 +132,11 @@ int WINAPI WinMain(
 			// Input updating
 			InputManager::Update();
 
-			// Update and draw
+			// Update (input, camera, ui every frame), simulate in fixed steps, then draw
 			game->Update(deltaTime, totalTime);
-			game->Draw(deltaTime, totalTime);
+			for (unsigned int steps = timestep.Advance(deltaTime); steps > 0; steps--)
+				game->FixedUpdate(timestep.GetStep(), (float)(timestep.GetTime() - (steps - 1) * (double)timestep.GetStep()));
+			game->Draw(deltaTime, totalTime, timestep.GetAlpha());
 
 			// Notify Input system about end of frame
 			InputManager::EndOfFrame();
@@ -0,0 +1,149 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+namespace
+{
+	//posix paths are narrow so encode the wide path as utf-8
+	std::string ToUtf8(const std::wstring& str)
+	{
+		std::string result;
+		result.reserve(str.size());
+		for (wchar_t wc : str)
+		{
+			unsigned int c = (unsigned int)wc;
+			if (c < 0x80) result += (char)c;
+			else if (c < 0x800) { result += (char)(0xC0 | (c >> 6)); result += (char)(0x80 | (c & 0x3F)); }
+			else if (c < 0x10000) { result += (char)(0xE0 | (c >> 12)); result += (char)(0x80 | ((c >> 6) & 0x3F)); result += (char)(0x80 | (c & 0x3F)); }
+			else { result += (char)(0xF0 | (c >> 18)); result += (char)(0x80 | ((c >> 12) & 0x3F)); result += (char)(0x80 | ((c >> 6) & 0x3F)); result += (char)(0x80 | (c & 0x3F)); }
+		}
+		return result;
+	}
+}
+#endif
+
+MappedFile::MappedFile(const std::wstring& path)
+{
+	Open(path);
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		data = std::exchange(other.data, nullptr);
+		size = std::exchange(other.size, 0);
+		isOpen = std::exchange(other.isOpen, false);
+#ifdef _WIN32
+		fileHandle = std::exchange(other.fileHandle, nullptr);
+		mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#else
+		fileDescriptor = std::exchange(other.fileDescriptor, -1);
+#endif
+	}
+	return *this;
+}
+
+bool MappedFile::Open(const std::wstring& path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle = file;
+	size = (size_t)fileSize.QuadPart;
+
+	//windows refuses to map a zero length file
+	if (size > 0)
+	{
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+		{
+			Close();
+			return false;
+		}
+		mappingHandle = mapping;
+		data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!data)
+		{
+			Close();
+			return false;
+		}
+	}
+#else
+	int fd = open(ToUtf8(path).c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info = {};
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	fileDescriptor = fd;
+	size = (size_t)info.st_size;
+
+	if (size > 0)
+	{
+		void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+		madvise(view, size, MADV_SEQUENTIAL);
+		data = (const char*)view;
+	}
+#endif
+
+	isOpen = true;
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (data) UnmapViewOfFile(data);
+	if (mappingHandle) CloseHandle((HANDLE)mappingHandle);
+	if (fileHandle) CloseHandle((HANDLE)fileHandle);
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	if (data) munmap((void*)data, size);
+	if (fileDescriptor >= 0) close(fileDescriptor);
+	fileDescriptor = -1;
+#endif
+	data = nullptr;
+	size = 0;
+	isOpen = false;
+}
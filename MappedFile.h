@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+//read only memory mapped view of a file
+//the os pages the file in on demand so loaders can parse straight out of it without copying into a buffer first
+//works on both windows and posix so the asset pipeline can run headless
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::wstring& path);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete; // Remove copy constructor
+	MappedFile& operator=(const MappedFile&) = delete; // Remove copy-assignment operator
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	bool Open(const std::wstring& path);
+	void Close();
+
+	//an empty file opens successfully but has no data
+	bool IsOpen() const { return isOpen; }
+	const char* Data() const { return data; }
+	size_t Size() const { return size; }
+
+private:
+	const char* data = nullptr;
+	size_t size = 0;
+	bool isOpen = false;
+
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int fileDescriptor = -1;
+#endif
+};
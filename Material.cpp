@@ -38,6 +38,11 @@ std::shared_ptr<ISimpleShader> Material::GetVertexShader()
     return vertexShader;
 }
 
+std::shared_ptr<SimpleVertexShader> Material::GetInstancedVertexShader()
+{
+    return instancedVertexShader;
+}
+
 DirectX::XMFLOAT3 Material::GetColorTint() const
 {
     return colorTint;
@@ -53,6 +58,11 @@ void Material::SetVertexShader(std::shared_ptr<ISimpleShader> vs)
     vertexShader = vs;
 }
 
+void Material::SetInstancedVertexShader(std::shared_ptr<SimpleVertexShader> vs)
+{
+    instancedVertexShader = vs;
+}
+
 void Material::SetColorTint(DirectX::XMFLOAT3 color)
 {
     colorTint = color;
@@ -90,19 +100,6 @@ void Material::RegisterMaterialWithShader()
         << sharedVertexShaders[vertexShader].size() << std::endl;
 }
 
-bool Material::CheckAndSetPerObjectData(UINT objectIndex)
-{
-    auto it = perObjectDataProcessed.find(objectIndex);
-    if (it != perObjectDataProcessed.end() && it-> second)
-    {
-	    //Per-object data has already been set for this object
-        return false;
-    }
-    //Mark the object as processed:
-    perObjectDataProcessed[objectIndex] = true;
-    return true;
-}
-
 
 #pragma endregion SortingMethods
 
@@ -112,59 +109,56 @@ bool Material::CheckAndSetPerObjectData(UINT objectIndex)
 #pragma region RenderMethods
 
 //Can not use dirty checks
-void Material::PrepareMaterial(std::shared_ptr<Transform> transform, std::shared_ptr<Camera> camera)
+// Pixel shader settings go through PreparePixelShader, these only do the per object vertex data
+RecordedConstantBuffer Material::PrepareMaterial(CommandBuffer& commands, Transform& transform, std::shared_ptr<Camera> camera)
 {
 	//vertexShader->SetShader(); //shader is turned on in UpdatePerFrameData
-    pixelShader->SetShader();
-
-    vertexShader->SetMatrix4x4("world", transform->getWorldMatrix());
-    vertexShader->SetMatrix4x4("worldInvTrans", transform->getWorldInverseTransposeMatrix());
-
-    vertexShader->CopyBufferData("PerObjectData");
-
-    // Pixel shader settings
-    pixelShader->SetFloat3("colorTint", colorTint);
-    pixelShader->CopyAllBufferData();
+    RecordedConstantBuffer perObjectData = ShaderCommands::RecordBufferCopy(commands, *vertexShader, "PerObjectData");
+    //read only, this runs on the recording threads
+    ShaderCommands::SetMatrix4x4(*vertexShader, perObjectData, "world", transform.readWorldMatrix());
+    ShaderCommands::SetMatrix4x4(*vertexShader, perObjectData, "worldInvTrans", transform.readWorldInverseTransposeMatrix());
+    return perObjectData;
 }
 
 //Can use dirty checks
-void Material::PrepareLesserMaterial(const std::shared_ptr<Transform>& transform, std::shared_ptr<Camera> camera, unsigned int objectIndex)
+void Material::PrepareLesserMaterial(CommandBuffer& commands, Transform& transform, std::shared_ptr<Camera> camera, unsigned int objectIndex, bool isDirty)
 {
-    pixelShader->SetShader();
     auto vertexShader = std::static_pointer_cast<LessSimpleVertexShader>(this->vertexShader);
-    if (transform->isDirty())//if it updates we have to unset it
-    {
-        perObjectDataProcessed[objectIndex] = false;
-    }
-    bool mappedValueIsDirty = CheckAndSetPerObjectData(objectIndex);
 
-    // Only update if this objects data has changed
-    if (mappedValueIsDirty) //marks it as clean
+    // Only upload if this objects data has changed, the matrices are copied into the command so threads don't collide here
+    DirectX::XMFLOAT4X4 matrices[2];
+    if (isDirty)
     {
-        DirectX::XMFLOAT4X4 matrices[2] = {
-            transform->getWorldMatrix(),
-            transform->getWorldInverseTransposeMatrix()
-        };
-        vertexShader->WFillPerObjectDataBuffer(objectIndex, matrices);
+        matrices[0] = transform.readWorldMatrix();
+        matrices[1] = transform.readWorldInverseTransposeMatrix();
     }
 
     // Bind the data (copy if needed, always bind)
-    vertexShader->CopyPerObjectData(objectIndex, mappedValueIsDirty);
+    ShaderCommands::RecordPerObjectData(commands, *vertexShader, objectIndex, isDirty ? matrices : nullptr);
     //if not it uses the previous frame's data which is incorrect memory
-    pixelShader->SetFloat3("colorTint", colorTint);
-    pixelShader->CopyAllBufferData();
+}
+
+void Material::PreparePixelShader(CommandBuffer& commands)
+{
+    ShaderCommands::RecordShader(commands, *pixelShader);
+    //the tint only goes into the recorded copy of whichever buffer holds it, the shader's data is shared
+    for (unsigned int i = 0; i < pixelShader->GetBufferCount(); i++)
+    {
+        RecordedConstantBuffer buffer = ShaderCommands::RecordBufferCopy(commands, *pixelShader, i);
+        ShaderCommands::SetFloat3(*pixelShader, buffer, "colorTint", colorTint);
+    }
 }
 
 
 
-void Material::UpdatePerFrameData(std::shared_ptr<Camera> camera)
+void Material::UpdatePerFrameData(CommandBuffer& commands, std::shared_ptr<Camera> camera)
 {
     //writing to both shaders at once but avoid overwriting, means each shader uses its own constant buffer instance one time per frame and use by all materials using that shader
 	for (auto& shaderGroup : sharedVertexShaders)
 	{
 		shaderGroup.first->SetMatrix4x4("view", camera->getViewMatrix());
 		shaderGroup.first->SetMatrix4x4("projection", camera->getProjectionMatrix());
-		shaderGroup.first->CopyBufferData("PerFrameData");
+		ShaderCommands::RecordBufferData(commands, *shaderGroup.first, "PerFrameData");
 	}
 }
 
@@ -6,6 +6,7 @@
 #include <wrl/client.h>
 #include <memory>
 #include "SimpleShader/SimpleShader.h"
+#include "ShaderCommands.h"
 #include <d3d11_1.h>
 
 //enabled_shared_from_this is a base class
@@ -23,29 +24,36 @@ public:
 	void Initialize(); // to prevent weak ptrs as the shared ptrs are not initialized in the ctor
 	std::shared_ptr<SimplePixelShader> GetPixelShader();
 	std::shared_ptr<ISimpleShader> GetVertexShader();
+	//drop in for the vertex shader when several objects with this material and the same mesh get drawn as instances, null to never instance
+	std::shared_ptr<SimpleVertexShader> GetInstancedVertexShader();
 	DirectX::XMFLOAT3 GetColorTint() const;
 	const char* GetName();
 
 	void SetPixelShader(std::shared_ptr<SimplePixelShader>);
 	void SetVertexShader(std::shared_ptr<ISimpleShader>);
+	void SetInstancedVertexShader(std::shared_ptr<SimpleVertexShader>);
 	void SetColorTint(DirectX::XMFLOAT3 color);
 	void SetRoughness(float rough);
 
 	//render loop related code:
 	static std::unordered_map<std::shared_ptr<ISimpleShader>, std::vector<std::shared_ptr<Material>>> sharedVertexShaders; //collection of materials grouped by shader
-	std::unordered_map<unsigned int, bool> perObjectDataProcessed; //i need another unordered map as a material can be shared by multiple objects i need a key and way to track if their "first pass" has been set
-	//marks as dirty for drawFrame
-	bool CheckAndSetPerObjectData(unsigned int objectIndex);
 	//updates only perFrameData per shader group:
-	static void UpdatePerFrameData(std::shared_ptr<Camera> camera);
+	static void UpdatePerFrameData(CommandBuffer& commands, std::shared_ptr<Camera> camera);
 
 
-	void PrepareMaterial(std::shared_ptr<Transform> transform, std::shared_ptr<Camera> camera);
-	void PrepareLesserMaterial(const std::shared_ptr<Transform>& transform, std::shared_ptr<Camera> camera, unsigned int objectIndex);
+	//all of these record into commands, nothing reaches the gpu until it is executed
+	//they only read the shaders (the data goes into recorded copies), so several threads can record with the same material
+	//binds the pixel shader and uploads the tint, once per run of draws using this material (the vertex side is per object)
+	void PreparePixelShader(CommandBuffer& commands);
+	//returns the recorded PerObjectData, more per object variables can be set in it before the next command
+	RecordedConstantBuffer PrepareMaterial(CommandBuffer& commands, Transform& transform, std::shared_ptr<Camera> camera);
+	//isDirty comes from the caller, it keeps track of what each of the shader's slots holds
+	void PrepareLesserMaterial(CommandBuffer& commands, Transform& transform, std::shared_ptr<Camera> camera, unsigned int objectIndex, bool isDirty);
 
 private:
 	std::shared_ptr<ISimpleShader> vertexShader;
 	std::shared_ptr<SimplePixelShader> pixelShader;
+	std::shared_ptr<SimpleVertexShader> instancedVertexShader;
 	void RegisterMaterialWithShader(); //registers this material with the shader
 
 
@@ -1,149 +1,88 @@
 #include "Mesh.h"
 #include "SharedBuffers.h"
+#include "ObjParser.h"
+#include "VertexWelder.h"
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+#include "Culling.h"
+#include <d3dcompiler.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
 
 using namespace DirectX;
 //implement header / interface
 
-//ctor
-Mesh::Mesh(const char* name, Vertex* vertexBuffer, int vertexCount, unsigned int* indexBuffer, int indexCount): name(name)
-{
-	initBuffers(vertexBuffer, vertexCount, indexBuffer, indexCount);
-}
-
-//obj ctor
-Mesh::Mesh(const char* name, const std::wstring& objFile) : name(name)
+namespace
 {
 	// Author: Chris Cascioli
-// Purpose: Basic .OBJ 3D model loading, supporting positions, uvs and normals
-// 
-// - You are allowed to directly copy/paste this into your code base
-//   for assignments, given that you clearly cite that this is not
-//   code of your own design.
-
-
-// File input object
-	this->m_indicesCount = 0;
-	this->m_vertexCount = 0;
-	std::ifstream obj(objFile);
-
-	// Check for successful open
-	if (!obj.is_open())
-		return;
-
-	// Variables used while reading the file
-	std::vector<XMFLOAT3> positions;	// Positions from the file
-	std::vector<XMFLOAT3> normals;		// Normals from the file
-	std::vector<XMFLOAT2> uvs;		// UVs from the file
-	std::vector<Vertex> verts;		// Verts we're assembling
-	std::vector<UINT> indices;		// Indices of these verts
-	int vertCounter = 0;			// Count of vertices
-	int indexCounter = 0;			// Count of indices
-	char chars[100];			// String for line reading
-
-	// Still have data left?
-	while (obj.good())
+	// Purpose: Basic .OBJ 3D model loading, supporting positions, uvs and normals
+	// - file reading now goes through ObjParser (memory mapped + multi-threaded),
+	//   the vertex assembly and handedness conversion below are still based on the original loader
+	bool ImportObj(const std::wstring& objFile, std::vector<Vertex>& verts, std::vector<UINT>& indices, unsigned int& unweldedVertexCount)
 	{
-		// Get the line (100 characters should be more than enough)
-		obj.getline(chars, 100);
-
-		// Check the type of line
-		if (chars[0] == 'v' && chars[1] == 'n')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 norm;
-			sscanf_s(
-				chars,
-				"vn %f %f %f",
-				&norm.x, &norm.y, &norm.z);
-
-			// Add to the list of normals
-			normals.push_back(norm);
-		}
-		else if (chars[0] == 'v' && chars[1] == 't')
+		ObjData obj;
+		if (!ObjParser::Parse(objFile, obj))
+			return false;
+
+		// Gather the corners of every valid triangle, flipping the winding order on the way
+		// (right handed obj to left handed directx, see the vertex conversion below)
+		std::vector<ObjIndex> corners;
+		corners.reserve(obj.faces.size());
+		bool missingNormals = false;
+		for (size_t i = 0; i + 2 < obj.faces.size(); i += 3)
 		{
-			// Read the 2 numbers directly into an XMFLOAT2
-			XMFLOAT2 uv;
-			sscanf_s(
-				chars,
-				"vt %f %f",
-				&uv.x, &uv.y);
-
-			// Add to the list of uv's
-			uvs.push_back(uv);
+			const ObjIndex& c1 = obj.faces[i];
+			const ObjIndex& c2 = obj.faces[i + 1];
+			const ObjIndex& c3 = obj.faces[i + 2];
+			if (c1.Position < 0 || c2.Position < 0 || c3.Position < 0)
+				continue; //broken face, skip it
+			corners.push_back(c1);
+			corners.push_back(c3);
+			corners.push_back(c2);
+			missingNormals |= c1.Normal < 0 || c2.Normal < 0 || c3.Normal < 0;
 		}
-		else if (chars[0] == 'v')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 pos;
-			sscanf_s(
-				chars,
-				"v %f %f %f",
-				&pos.x, &pos.y, &pos.z);
-
-			// Add to the positions
-			positions.push_back(pos);
-		}
-		else if (chars[0] == 'f')
+		if (corners.empty())
+			return false;
+
+		// Corners without a normal share a smoothed one per position, so they still weld together
+		std::vector<XMFLOAT3> positionNormals;
+		if (missingNormals)
 		{
-			// Read the face indices into an array
-			// NOTE: This assumes the given obj file contains
-			//  vertex positions, uv coordinates AND normals.
-			unsigned int i[12];
-			int numbersRead = sscanf_s(
-				chars,
-				"f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
-				&i[0], &i[1], &i[2],
-				&i[3], &i[4], &i[5],
-				&i[6], &i[7], &i[8],
-				&i[9], &i[10], &i[11]);
-
-			// If we only got the first number, chances are the OBJ
-			// file has no UV coordinates.  This isn't great, but we
-			// still want to load the model without crashing, so we
-			// need to re-read a different pattern (in which we assume
-			// there are no UVs denoted for any of the vertices)
-			if (numbersRead == 1)
+			positionNormals.assign(obj.positions.size(), XMFLOAT3(0, 0, 0));
+			for (size_t i = 0; i < corners.size(); i += 3)
 			{
-				// Re-read with a different pattern
-				numbersRead = sscanf_s(
-					chars,
-					"f %d//%d %d//%d %d//%d %d//%d",
-					&i[0], &i[2],
-					&i[3], &i[5],
-					&i[6], &i[8],
-					&i[9], &i[11]);
-
-				// The following indices are where the UVs should 
-				// have been, so give them a valid value
-				i[1] = 1;
-				i[4] = 1;
-				i[7] = 1;
-				i[10] = 1;
-
-				// If we have no UVs, create a single UV coordinate
-				// that will be used for all vertices
-				if (uvs.size() == 0)
-					uvs.push_back(XMFLOAT2(0, 0));
+				XMVECTOR p1 = XMLoadFloat3(&obj.positions[corners[i].Position]);
+				XMVECTOR p2 = XMLoadFloat3(&obj.positions[corners[i + 1].Position]);
+				XMVECTOR p3 = XMLoadFloat3(&obj.positions[corners[i + 2].Position]);
+				//corners are already flipped, so cross the other way round to stay in the file's right handed space
+				XMVECTOR faceNormal = XMVector3Cross(XMVectorSubtract(p3, p1), XMVectorSubtract(p2, p1));
+				for (size_t c = i; c < i + 3; c++)
+				{
+					XMFLOAT3& n = positionNormals[corners[c].Position];
+					XMStoreFloat3(&n, XMVectorAdd(XMLoadFloat3(&n), faceNormal));
+				}
 			}
+			for (auto& n : positionNormals)
+				XMStoreFloat3(&n, XMVector3Normalize(XMLoadFloat3(&n)));
+		}
 
-			// - Create the verts by looking up
-			//    corresponding data from vectors
-			// - OBJ File indices are 1-based, so
-			//    they need to be adusted
-			Vertex v1;
-			v1.Position = positions[i[0] - 1];
-			v1.UV = uvs[i[1] - 1];
-			v1.Normal = normals[i[2] - 1];
-
-			Vertex v2;
-			v2.Position = positions[i[3] - 1];
-			v2.UV = uvs[i[4] - 1];
-			v2.Normal = normals[i[5] - 1];
-
-			Vertex v3;
-			v3.Position = positions[i[6] - 1];
-			v3.UV = uvs[i[7] - 1];
-			v3.Normal = normals[i[8] - 1];
+		// Weld identical (position, uv, normal) triplets so the index buffer does real work
+		std::vector<ObjIndex> uniqueCorners;
+		VertexWelder::Weld(corners.data(), corners.size(), uniqueCorners, indices);
+		unweldedVertexCount = (unsigned int)corners.size();
+
+		// - Create the verts by looking up corresponding data from the parsed streams
+		// - If the file has no UVs a single (0,0) is used
+		verts.resize(uniqueCorners.size());
+		for (size_t i = 0; i < uniqueCorners.size(); i++)
+		{
+			const ObjIndex& corner = uniqueCorners[i];
+			Vertex v = {};
+			v.Position = obj.positions[corner.Position];
+			v.UV = corner.UV >= 0 ? obj.uvs[corner.UV] : XMFLOAT2(0, 0);
+			v.Normal = corner.Normal >= 0 ? obj.normals[corner.Normal] : positionNormals[corner.Position];
 
 			// The model is most likely in a right-handed space,
 			// especially if it came from Maya.  We want to convert
@@ -151,151 +90,475 @@ Mesh::Mesh(const char* name, const std::wstring& objFile) : name(name)
 			// need to:
 			//  - Invert the Z position
 			//  - Invert the normal's Z
-			//  - Flip the winding order
+			//  - Flip the winding order (done while gathering corners)
 			// We also need to flip the UV coordinate since DirectX
 			// defines (0,0) as the top left of the texture, and many
 			// 3D modeling packages use the bottom left as (0,0)
+			v.UV.y = 1.0f - v.UV.y;
+			v.Position.z *= -1.0f;
+			v.Normal.z *= -1.0f;
+			verts[i] = v;
+		}
 
-			// Flip the UV's since they're probably "upside down"
-			v1.UV.y = 1.0f - v1.UV.y;
-			v2.UV.y = 1.0f - v2.UV.y;
-			v3.UV.y = 1.0f - v3.UV.y;
-
-			// Flip Z (LH vs. RH)
-			v1.Position.z *= -1.0f;
-			v2.Position.z *= -1.0f;
-			v3.Position.z *= -1.0f;
-
-			// Flip normal's Z
-			v1.Normal.z *= -1.0f;
-			v2.Normal.z *= -1.0f;
-			v3.Normal.z *= -1.0f;
-
-			// Add the verts to the vector (flipping the winding order)
-			verts.push_back(v1);
-			verts.push_back(v3);
-			verts.push_back(v2);
-			vertCounter += 3;
-
-			// Add three more indices
-			indices.push_back(indexCounter); indexCounter += 1;
-			indices.push_back(indexCounter); indexCounter += 1;
-			indices.push_back(indexCounter); indexCounter += 1;
-
-			// Was there a 4th face?
-			// - 12 numbers read means 4 faces WITH uv's
-			// - 8 numbers read means 4 faces WITHOUT uv's
-			if (numbersRead == 12 || numbersRead == 8)
-			{
-				// Make the last vertex
-				Vertex v4;
-				v4.Position = positions[i[9] - 1];
-				v4.UV = uvs[i[10] - 1];
-				v4.Normal = normals[i[11] - 1];
-
-				// Flip the UV, Z pos and normal's Z
-				v4.UV.y = 1.0f - v4.UV.y;
-				v4.Position.z *= -1.0f;
-				v4.Normal.z *= -1.0f;
-
-				// Add a whole triangle (flipping the winding order)
-				verts.push_back(v1);
-				verts.push_back(v4);
-				verts.push_back(v3);
-				vertCounter += 3;
-
-				// Add three more indices
-				indices.push_back(indexCounter); indexCounter += 1;
-				indices.push_back(indexCounter); indexCounter += 1;
-				indices.push_back(indexCounter); indexCounter += 1;
-			}
+		return true;
+	}
+
+	//describes Vertex / CompactVertex for the .meshbin layout descriptor
+	const MeshBinAttribute VERTEX_LAYOUT[] = {
+		{ MeshBinPosition, MeshBinFloat3, (uint32_t)offsetof(Vertex, Position) },
+		{ MeshBinTexcoord, MeshBinFloat2, (uint32_t)offsetof(Vertex, UV) },
+		{ MeshBinNormal, MeshBinFloat3, (uint32_t)offsetof(Vertex, Normal) },
+	};
+	const MeshBinAttribute COMPACT_VERTEX_LAYOUT[] = {
+		{ MeshBinPosition, MeshBinUnorm16x4, (uint32_t)offsetof(CompactVertex, Position) },
+		{ MeshBinTexcoord, MeshBinHalf2, (uint32_t)offsetof(CompactVertex, UV) },
+		{ MeshBinNormal, MeshBinSnorm16x2Oct, (uint32_t)offsetof(CompactVertex, Normal) },
+	};
+	constexpr uint32_t VERTEX_LAYOUT_COUNT = sizeof(VERTEX_LAYOUT) / sizeof(VERTEX_LAYOUT[0]);
+	static_assert(sizeof(COMPACT_VERTEX_LAYOUT) == sizeof(VERTEX_LAYOUT), "both layouts have the same attribute count");
+
+	const MeshBinAttribute* GetLayout(VertexFormat format)
+	{
+		return format == VertexFormat::Compact ? COMPACT_VERTEX_LAYOUT : VERTEX_LAYOUT;
+	}
+
+	//the same layouts for the input assembler, the names have to match the shader input semantics
+	const D3D11_INPUT_ELEMENT_DESC VERTEX_INPUT_LAYOUT[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, (UINT)offsetof(Vertex, Position), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, (UINT)offsetof(Vertex, UV), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, (UINT)offsetof(Vertex, Normal), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+	const D3D11_INPUT_ELEMENT_DESC COMPACT_VERTEX_INPUT_LAYOUT[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, (UINT)offsetof(CompactVertex, Position), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, (UINT)offsetof(CompactVertex, UV), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, (UINT)offsetof(CompactVertex, Normal), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+
+	//a cache is only usable when its vertices are laid out exactly like the requested format
+	bool MatchesVertexLayout(const MeshBinHeader& header, VertexFormat format)
+	{
+		const MeshBinAttribute* layout = GetLayout(format);
+		unsigned int expectedIndexStride = header.vertexCount < 65536 ? sizeof(uint16_t) : sizeof(unsigned int);
+		if (header.vertexStride != VertexQuantization::GetStride(format) || header.indexStride != expectedIndexStride || header.attributeCount != VERTEX_LAYOUT_COUNT)
+			return false;
+		for (uint32_t i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+		{
+			const MeshBinAttribute& a = header.attributes[i];
+			if (a.Semantic != layout[i].Semantic || a.Format != layout[i].Format || a.Offset != layout[i].Offset)
+				return false;
+		}
+		return true;
+	}
+
+	uint32_t ImportFlags(const MeshImportOptions& options)
+	{
+		uint32_t lodCount = std::min(options.lodCount, MESH_MAX_LODS);
+		return (options.optimize ? MESHBIN_FLAG_OPTIMIZED : 0) | (options.buildMeshlets ? MESHBIN_FLAG_MESHLETS : 0) | (lodCount << MESHBIN_FLAG_LOD_SHIFT);
+	}
+
+	//simplification stops before the surface moves further than this, as a fraction of the bounding radius
+	constexpr float MAX_LOD_ERROR = 0.25f;
+	static_assert(MESH_MAX_LODS <= MESHBIN_MAX_LODS, "the cache has to be able to store every lod");
+	static_assert(offsetof(Meshlet, firstIndex) == offsetof(MeshBinMeshletRange, firstIndex) &&
+		offsetof(Meshlet, triangleCount) == offsetof(MeshBinMeshletRange, triangleCount), "MeshCache::Load checks meshlets through MeshBinMeshletRange");
+
+	//each level halves the previous one until lodCount levels exist or a level stops paying for itself
+	void BuildLods(const std::vector<Vertex>& verts, std::vector<UINT>& indices, float radius, unsigned int lodCount, std::vector<MeshLod>& lods)
+	{
+		std::vector<unsigned int> lodIndices;
+		float totalError = 0.0f;
+		while (lods.size() < lodCount)
+		{
+			const MeshLod& source = lods.back();
+			float errorBudget = radius * MAX_LOD_ERROR - totalError;
+			if (errorBudget <= 0.0f)
+				break;
+			lodIndices.resize(source.indexCount);
+			float error = 0.0f;
+			//simplifying the previous level is much cheaper than starting from lod 0, the errors just add up
+			size_t count = MeshSimplifier::Simplify(lodIndices.data(), &indices[source.firstIndex], source.indexCount,
+				&verts[0].Position.x, verts.size(), sizeof(Vertex), source.indexCount / 2, errorBudget, &error);
+			if (count == 0 || count > source.indexCount * 8 / 10)
+				break;
+
+			MeshOptimizer::OptimizeVertexCache(lodIndices.data(), count, verts.size());
+			totalError += error;
+			MeshLod lod = { (unsigned int)indices.size(), (unsigned int)count, totalError };
+			indices.insert(indices.end(), lodIndices.begin(), lodIndices.begin() + count);
+			lods.push_back(lod);
+		}
+	}
+
+	MeshBounds ComputeBounds(const Vertex* vertices, size_t numVerts)
+	{
+		MeshBounds bounds = {};
+		if (numVerts == 0)
+			return bounds;
+
+		XMVECTOR minV = XMLoadFloat3(&vertices[0].Position);
+		XMVECTOR maxV = minV;
+		for (size_t i = 1; i < numVerts; i++)
+		{
+			XMVECTOR p = XMLoadFloat3(&vertices[i].Position);
+			minV = XMVectorMin(minV, p);
+			maxV = XMVectorMax(maxV, p);
 		}
+		//sphere around the box center, radius is the farthest vertex rather than the box corner so it stays tight
+		XMVECTOR center = XMVectorScale(XMVectorAdd(minV, maxV), 0.5f);
+		XMVECTOR radiusSq = XMVectorZero();
+		for (size_t i = 0; i < numVerts; i++)
+			radiusSq = XMVectorMax(radiusSq, XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&vertices[i].Position), center)));
+
+		XMStoreFloat3(&bounds.Min, minV);
+		XMStoreFloat3(&bounds.Max, maxV);
+		XMStoreFloat3(&bounds.Center, center);
+		bounds.Radius = sqrtf(XMVectorGetX(radiusSq));
+		return bounds;
 	}
 
-	// Close the file and create the actual buffers
-	obj.close();
-	initBuffers(&verts[0], vertCounter, &indices[0], indexCounter);
-
-	// - At this point, "verts" is a vector of Vertex structs, and can be used
-	//    directly to create a vertex buffer:  &verts[0] is the address of the first vert
-	//
-	// - The vector "indices" is similar. It's a vector of unsigned ints and
-	//    can be used directly for the index buffer: &indices[0] is the address of the first int
-	//
-	// - "vertCounter" is the number of vertices
-	// - "indexCounter" is the number of indices
-	// - Yes, these are effectively the same since OBJs do not index entire vertices!  This means
-	//    an index buffer isn't doing much for us.  We could try to optimize the mesh ourselves
-	//    and detect duplicate vertices, but at that point it would be better to use a more
-	//    sophisticated model loading library like TinyOBJLoader or The Open Asset Importer Library
+	//DrawCulled's scratch, per thread since the same mesh can be drawn on several at once
+	thread_local std::vector<unsigned char> meshletVisible;
+	thread_local std::vector<unsigned char> culledIndices; //visible indices, copied into the command that uploads them
+}
+
+//ctor
+Mesh::Mesh(const char* name, Vertex* vertexBuffer, int vertexCount, unsigned int* indexBuffer, int indexCount): name(name)
+{
+	m_bounds = ComputeBounds(vertexBuffer, vertexCount);
+	std::vector<unsigned char> packedIndices;
+	unsigned int indexStride = PackIndices(indexBuffer, indexCount, vertexCount, packedIndices);
+	initBuffers(vertexBuffer, vertexCount, sizeof(Vertex), packedIndices.data(), indexCount, indexStride);
+	m_lods.push_back({ 0, (unsigned int)indexCount, 0.0f });
+}
+
+//obj ctor
+//loads from the .meshbin cache next to the obj when it is up to date, otherwise imports the obj and rewrites the cache
+Mesh::Mesh(const char* name, const std::wstring& objFile, const MeshImportOptions& options) : name(name)
+{
+	this->m_indicesCount = 0;
+	this->m_vertexCount = 0;
+	MeshData data;
+	if (LoadObj(objFile, options, data))
+		initFromData(data);
+}
+
+Mesh::Mesh(const char* name, const MeshData& data) : name(name)
+{
+	this->m_indicesCount = 0;
+	this->m_vertexCount = 0;
+	if (data.vertices && data.indices)
+		initFromData(data);
+}
+
+Mesh::Mesh(const char* name, std::shared_ptr<Mesh> placeholder) : name(name), m_ready(false), m_placeholder(placeholder)
+{
+	this->m_indicesCount = 0;
+	this->m_vertexCount = 0;
+}
+
+void Mesh::Upload(const MeshData& data)
+{
+	if (data.vertices && data.indices)
+		initFromData(data);
+	m_ready = true;
+	m_placeholder.reset();
+}
+
+bool Mesh::LoadObj(const std::wstring& objFile, const MeshImportOptions& options, MeshData& data)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	data.vertexFormat = options.vertexFormat;
+	std::wstring cachePath = MeshCache::GetCachePath(objFile, data.vertexFormat == VertexFormat::Compact ? L"compact" : L"");
+	if (MeshCache::IsFresh(cachePath, objFile))
+	{
+		MeshBinView view;
+		if (MeshCache::Load(cachePath, data.cacheFile, view) && MatchesVertexLayout(view.header, data.vertexFormat) && view.header.flags == ImportFlags(options) &&
+			(view.header.meshletCount == 0 || view.header.meshletStride == sizeof(Meshlet)))
+		{
+			//zero copy, the gpu buffers get created straight out of the mapped file
+			const MeshBinHeader& header = view.header;
+			data.vertices = view.vertices;
+			data.indices = view.indices;
+			data.vertexCount = header.vertexCount;
+			data.vertexStride = header.vertexStride;
+			data.indexCount = header.indexCount;
+			data.indexStride = header.indexStride;
+			data.unweldedVertexCount = header.unweldedVertexCount;
+			data.bounds.Min = XMFLOAT3(header.boundsMin);
+			data.bounds.Max = XMFLOAT3(header.boundsMax);
+			data.bounds.Center = XMFLOAT3(header.sphereCenter);
+			data.bounds.Radius = header.sphereRadius;
+			data.cacheStatsBefore.acmr = header.acmrBefore;
+			data.cacheStatsBefore.atvr = header.atvrBefore;
+			data.cacheStatsAfter.acmr = header.acmrAfter;
+			data.cacheStatsAfter.atvr = header.atvrAfter;
+			data.quantizationError.position = header.positionError;
+			data.quantizationError.uv = header.uvError;
+			data.quantizationError.normalDegrees = header.normalErrorDegrees;
+			for (uint32_t i = 0; i < header.lodCount; i++)
+				data.lods.push_back({ header.lods[i].firstIndex, header.lods[i].indexCount, header.lods[i].error });
+			data.meshlets = (const Meshlet*)view.meshlets;
+			data.meshletCount = header.meshletCount;
+			data.loadedFromCache = true;
+			data.loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			return true;
+		}
+		data.cacheFile.Close();
+	}
+
+	std::vector<Vertex> verts;
+	std::vector<UINT> indices;
+	if (!ImportObj(objFile, verts, indices, data.unweldedVertexCount))
+		return false;
+
+	// Optional reordering pass before upload:
+	//  - triangles for post-transform cache hits
+	//  - clusters of those triangles so outward facing ones draw first (less overdraw)
+	//  - vertices into first use order so fetches walk the buffer linearly
+	data.cacheStatsBefore = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), verts.size());
+	if (options.optimize)
+	{
+		MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), verts.size());
+		MeshOptimizer::OptimizeOverdraw(indices.data(), indices.size(), &verts[0].Position.x, verts.size(), sizeof(Vertex));
+		verts.resize(MeshOptimizer::OptimizeVertexFetch(verts.data(), indices.data(), indices.size(), verts.size(), sizeof(Vertex)));
+	}
+	//meshlets regroup the triangles, the vertex cache order only survives inside each one
+	if (options.buildMeshlets)
+	{
+		MeshletBuilder::Build(indices.data(), indices.size(), &verts[0].Position.x, verts.size(), sizeof(Vertex), data.meshletStorage);
+		data.meshlets = data.meshletStorage.data();
+		data.meshletCount = (unsigned int)data.meshletStorage.size();
+	}
+	data.cacheStatsAfter = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), verts.size());
+	data.bounds = ComputeBounds(verts.data(), verts.size());
+
+	//lower levels of detail are appended to the same index array
+	data.lods.push_back({ 0, (unsigned int)indices.size(), 0.0f });
+	BuildLods(verts, indices, data.bounds.Radius, std::min(options.lodCount, MESH_MAX_LODS), data.lods);
+
+	//quantize after the reordering so the passes above only ever deal with Vertex
+	data.vertexStride = (unsigned int)VertexQuantization::GetStride(data.vertexFormat);
+	data.vertexStorage.resize(verts.size() * data.vertexStride);
+	if (data.vertexFormat == VertexFormat::Compact)
+	{
+		CompactVertex* compactVerts = (CompactVertex*)data.vertexStorage.data();
+		VertexQuantization::Encode(verts.data(), verts.size(), data.bounds.Min, data.bounds.Max, compactVerts);
+		data.quantizationError = VertexQuantization::MeasureError(verts.data(), compactVerts, verts.size(), data.bounds.Min, data.bounds.Max);
+	}
+	else
+	{
+		memcpy(data.vertexStorage.data(), verts.data(), data.vertexStorage.size());
+	}
+	data.indexStride = PackIndices(indices.data(), indices.size(), verts.size(), data.indexStorage);
+	data.vertices = data.vertexStorage.data();
+	data.indices = data.indexStorage.data();
+	data.vertexCount = (unsigned int)verts.size();
+	data.indexCount = (unsigned int)indices.size();
+	data.loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	//write the cache for next launch, failing here just means we import again next time
+	MeshBinView view;
+	MeshBinHeader& header = view.header;
+	header.flags = ImportFlags(options);
+	header.vertexCount = data.vertexCount;
+	header.vertexStride = data.vertexStride;
+	header.indexCount = data.indexCount;
+	header.indexStride = data.indexStride;
+	header.unweldedVertexCount = data.unweldedVertexCount;
+	header.attributeCount = VERTEX_LAYOUT_COUNT;
+	for (uint32_t i = 0; i < VERTEX_LAYOUT_COUNT; i++)
+		header.attributes[i] = GetLayout(data.vertexFormat)[i];
+	memcpy(header.boundsMin, &data.bounds.Min, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, &data.bounds.Max, sizeof(header.boundsMax));
+	memcpy(header.sphereCenter, &data.bounds.Center, sizeof(header.sphereCenter));
+	header.sphereRadius = data.bounds.Radius;
+	header.acmrBefore = data.cacheStatsBefore.acmr;
+	header.atvrBefore = data.cacheStatsBefore.atvr;
+	header.acmrAfter = data.cacheStatsAfter.acmr;
+	header.atvrAfter = data.cacheStatsAfter.atvr;
+	header.positionError = data.quantizationError.position;
+	header.uvError = data.quantizationError.uv;
+	header.normalErrorDegrees = data.quantizationError.normalDegrees;
+	header.lodCount = (uint32_t)data.lods.size();
+	for (uint32_t i = 0; i < header.lodCount; i++)
+		header.lods[i] = { data.lods[i].firstIndex, data.lods[i].indexCount, data.lods[i].error };
+	header.meshletCount = data.meshletCount;
+	header.meshletStride = sizeof(Meshlet);
+	view.vertices = data.vertices;
+	view.indices = data.indices;
+	view.meshlets = data.meshlets;
+	MeshCache::Write(cachePath, view);
+	return true;
+}
+
+void Mesh::initFromData(const MeshData& data)
+{
+	initBuffers(data.vertices, data.vertexCount, data.vertexStride, data.indices, data.indexCount, data.indexStride);
+	m_vertexFormat = data.vertexFormat;
+	m_bounds = data.bounds;
+	m_cacheStatsBefore = data.cacheStatsBefore;
+	m_cacheStatsAfter = data.cacheStatsAfter;
+	m_quantizationError = data.quantizationError;
+	m_lods = data.lods;
+	m_unweldedVertexCount = data.unweldedVertexCount;
+	m_loadedFromCache = data.loadedFromCache;
+	m_loadMilliseconds = data.loadMilliseconds;
+	//GetIndexCount and Draw() talk about the full detail mesh
+	m_indicesCount = m_lods[0].indexCount;
+
+	if (data.meshletCount > 0)
+	{
+		m_meshlets.assign(data.meshlets, data.meshlets + data.meshletCount);
+		MeshletBuilder::GetBounds(m_meshlets.data(), m_meshlets.size(), m_meshletBounds);
+		const unsigned char* lod0 = (const unsigned char*)data.indices;
+		m_meshletIndices.assign(lod0, lod0 + (size_t)m_indicesCount * data.indexStride);
+
+		D3D11_BUFFER_DESC ibd = {};
+		ibd.Usage = D3D11_USAGE_DYNAMIC;
+		ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		ibd.ByteWidth = (UINT)m_meshletIndices.size();
+		ibd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		Graphics::Device->CreateBuffer(&ibd, nullptr, m_culledIndexBuffer.GetAddressOf());
+	}
+}
+
+unsigned int Mesh::SelectLod(float projectedSize, float screenHeight, float maxPixelError)
+{
+	if (m_bounds.Radius <= 0.0f)
+		return 0;
+	//lod errors are in mesh units, the bounding sphere tells us how many pixels one of those covers
+	float pixelsPerUnit = projectedSize * screenHeight / (2.0f * m_bounds.Radius);
+	for (unsigned int lod = (unsigned int)m_lods.size() - 1; lod > 0; lod--)
+		if (m_lods[lod].error * pixelsPerUnit <= maxPixelError)
+			return lod;
+	return 0;
 }
 
 
 //dtor
-Mesh::~Mesh(){}
-
-void Mesh::Draw() {
-	//set buffers in the input assembler stage once per object
-	//like webgpu buffers are set per frame before drawIndexed
-	UINT stride = sizeof(Vertex);
-	UINT offset = 0;
-	Graphics::Context11_1->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
-	Graphics::Context11_1->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+Mesh::~Mesh()
+{
+	if (m_arena)
+		m_arena->Free(m_geometry);
+}
+
+void Mesh::Draw(CommandBuffer& commands, unsigned int lod) {
+	if (lod >= m_lods.size() || !m_arena)
+		return; //failed to load
+	//the arena's buffers stay bound between meshes that share it
+	m_arena->Bind(commands);
+	const GeometryRange& range = m_arena->GetRange(m_geometry);
 	//draw
-	Graphics::Context11_1->DrawIndexed(this->m_indicesCount, 0, 0);
+	commands.DrawIndexed(m_lods[lod].indexCount, range.firstIndex + m_lods[lod].firstIndex, range.baseVertex);
+}
+
+void Mesh::DrawCulled(CommandBuffer& commands, const XMFLOAT4X4& worldViewProjection, XMFLOAT3 viewer)
+{
+	if (m_meshlets.empty() || !m_arena)
+	{
+		Draw(commands);
+		return;
+	}
+
+	// Visibility of every meshlet, 4 at a time
+	Frustum frustum = Culling::ExtractFrustum(worldViewProjection);
+	const MeshletBounds& b = m_meshletBounds;
+	size_t padded = b.centerX.size();
+	meshletVisible.resize(padded);
+	Culling::FrustumCullSpheres(frustum, b.centerX.data(), b.centerY.data(), b.centerZ.data(), b.radius.data(), padded, meshletVisible.data());
+	Culling::ConeCullClusters(viewer, b.centerX.data(), b.centerY.data(), b.centerZ.data(), b.radius.data(),
+		b.axisX.data(), b.axisY.data(), b.axisZ.data(), b.cutoff.data(), padded, meshletVisible.data());
+
+	// Compact the survivors, neighbouring meshlets are neighbours in the index data too so every run
+	// of visible ones is a single copy, they go to the dynamic index buffer with the draw's commands
+	UINT indexStride = m_indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(unsigned int);
+	culledIndices.resize(m_meshletIndices.size());
+	unsigned char* out = culledIndices.data();
+	size_t written = 0;
+	unsigned int visibleMeshlets = 0;
+	for (size_t i = 0; i < m_meshlets.size();)
+	{
+		if (!meshletVisible[i])
+		{
+			i++;
+			continue;
+		}
+		size_t first = m_meshlets[i].firstIndex;
+		size_t count = 0;
+		for (; i < m_meshlets.size() && meshletVisible[i]; i++, visibleMeshlets++)
+			count += (size_t)m_meshlets[i].triangleCount * 3;
+		memcpy(out + written * indexStride, m_meshletIndices.data() + first * indexStride, count * indexStride);
+		written += count;
+	}
+	m_visibleMeshlets = visibleMeshlets;
+	m_culledIndexCount = (unsigned int)written;
+	if (written == 0)
+		return;
+	//discarded per draw, so the same mesh culled twice in a frame still gets each draw its own indices
+	commands.UpdateBuffer(m_culledIndexBuffer.Get(), culledIndices.data(), (uint32_t)(written * indexStride), 0, BufferWrite::Discard);
+
+	//vertices still come from the arena, only the index buffer is swapped out
+	m_arena->Bind(commands);
+	commands.SetIndexBuffer(m_culledIndexBuffer.Get(), m_indexFormat == DXGI_FORMAT_R16_UINT);
+	GeometryArenas::InvalidateBinding();
+	commands.DrawIndexed((uint32_t)written, 0, m_arena->GetRange(m_geometry).baseVertex);
 }
 
-void Mesh::DrawInstanced(int instanceCount)
+void Mesh::DrawInstanced(CommandBuffer& commands, const InstanceRange& instances, unsigned int lod)
 {
-	// Set the vertex buffer (input slot 0)
-	UINT stride = sizeof(Vertex);
-	UINT offset = 0;
-	Graphics::Context11_1->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
-	// Set the instance buffer (input slot 1)
-	UINT instanceStride = sizeof(InstanceData);
-	UINT instanceOffset = 0;
-	Graphics::Context11_1->IASetVertexBuffers(1, 1, SharedBuffers::InstanceBuffer.GetAddressOf(), &instanceStride, &instanceOffset);
-	// Set the index buffer
-	Graphics::Context11_1->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	if (lod >= m_lods.size() || !m_arena || instances.count == 0)
+		return;
+	// Set the vertex and index buffers (input slot 0)
+	m_arena->Bind(commands);
+	// Set the instance buffer (input slot 1), the batch is picked with the start instance
+	SharedBuffers::Instances.Bind(commands, 1);
 	// Draw the mesh with instancing
-	Graphics::Context11_1->DrawIndexedInstanced(m_indicesCount, instanceCount, 0, 0, 0);
+	const GeometryRange& range = m_arena->GetRange(m_geometry);
+	commands.DrawIndexedInstanced(m_lods[lod].indexCount, instances.count, range.firstIndex + m_lods[lod].firstIndex, range.baseVertex, instances.firstInstance);
 }
 
-void Mesh::initBuffers(Vertex* vertices, size_t numVerts, unsigned int* indices, size_t numIndices)
+void Mesh::initBuffers(const void* vertices, size_t numVerts, unsigned int vertexStride, const void* indices, size_t numIndices, unsigned int indexStride)
 {
-	//interleave buffer (x,y,z,color) // vertex buffer this might move later to draw once vertices move due to animation /movement
-	D3D11_BUFFER_DESC vbd = {};
-	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER; //bind as vertex buffer
-	vbd.ByteWidth = sizeof(Vertex) * (UINT)numVerts;
-	vbd.CPUAccessFlags = 0;
-	vbd.MiscFlags = 0;
-	vbd.StructureByteStride = 0;
-	D3D11_SUBRESOURCE_DATA initialVertexData = {};
-	initialVertexData.pSysMem = vertices;
-	Graphics::Device->CreateBuffer(&vbd, &initialVertexData, m_vertexBuffer.GetAddressOf());
+	//vertices and indices go into the arena shared by every mesh with this layout instead of buffers of their own,
+	//so drawing a different mesh is only a different baseVertex / firstIndex
 	this->m_vertexCount = (UINT)numVerts;
-
-	//index buffer so we dont have to store duplicate vertices
-	//since each mesh could have unique structures are not the same shape (like a square) we have to declare a new index buffer for each mesh
-	D3D11_BUFFER_DESC ibd = {};
-	ibd.Usage = D3D11_USAGE_IMMUTABLE;
-	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER; //bind as index buffer
-	ibd.ByteWidth = sizeof(unsigned int) * (UINT)numIndices;
-	ibd.CPUAccessFlags = 0;
-	ibd.MiscFlags = 0;
-	ibd.StructureByteStride = 0;
-	D3D11_SUBRESOURCE_DATA initialIndexData = {};
-	initialIndexData.pSysMem = indices;
-	Graphics::Device->CreateBuffer(&ibd, &initialIndexData, m_indexBuffer.GetAddressOf());
+	this->m_vertexStride = vertexStride;
 	this->m_indicesCount = (UINT)numIndices;
+	this->m_indexFormat = indexStride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	if (numVerts > 0 && numIndices > 0)
+	{
+		m_arena = &GeometryArenas::Get(vertexStride, m_indexFormat);
+		m_geometry = m_arena->Allocate(vertices, (unsigned int)numVerts, indices, (unsigned int)numIndices);
+		//no arena means nothing to draw, same as a failed load
+		if (m_geometry == GeometryArena::INVALID_HANDLE)
+			m_arena = nullptr;
+	}
+}
 
-	D3D11_BUFFER_DESC instanceBufferDesc = {};
-	instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	instanceBufferDesc.ByteWidth = sizeof(InstanceData) * MAX_INSTANCES;
-	instanceBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;  // Not a constant buffer
-	instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	instanceBufferDesc.MiscFlags = 0;
-	Graphics::Device->CreateBuffer(&instanceBufferDesc, nullptr, &SharedBuffers::InstanceBuffer);
+unsigned int Mesh::PackIndices(const unsigned int* indices, size_t numIndices, size_t numVerts, std::vector<unsigned char>& packed)
+{
+	//0xFFFF is a valid index here, strip cut values only matter for strip topologies
+	if (numVerts < 65536)
+	{
+		packed.resize(numIndices * sizeof(uint16_t));
+		uint16_t* out = (uint16_t*)packed.data();
+		for (size_t i = 0; i < numIndices; i++)
+			out[i] = (uint16_t)indices[i];
+		return sizeof(uint16_t);
+	}
+	packed.resize(numIndices * sizeof(unsigned int));
+	memcpy(packed.data(), indices, packed.size());
+	return sizeof(unsigned int);
+}
 
-}
\ No newline at end of file
+Microsoft::WRL::ComPtr<ID3D11InputLayout> Mesh::CreateInputLayout(VertexFormat format, const std::wstring& vertexShaderFile)
+{
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
+	Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob;
+	if (FAILED(D3DReadFileToBlob(vertexShaderFile.c_str(), shaderBlob.GetAddressOf())))
+		return inputLayout;
+
+	const D3D11_INPUT_ELEMENT_DESC* desc = format == VertexFormat::Compact ? COMPACT_VERTEX_INPUT_LAYOUT : VERTEX_INPUT_LAYOUT;
+	Graphics::Device->CreateInputLayout(desc, VERTEX_LAYOUT_COUNT, shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(), inputLayout.GetAddressOf());
+	return inputLayout;
+}
@@ -3,23 +3,111 @@
 #include <d3d11_1.h>
 #include <DirectXMath.h>
 #include <wrl/client.h> //comptr
-#include <fstream>
 #include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
 
 
 #include "Graphics.h"
 #include "Vertex.h"
+#include "MeshOptimizer.h"
+#include "VertexFormats.h"
+#include "MappedFile.h"
+#include "MeshletBuilder.h"
+#include "GeometryArena.h"
+
+constexpr unsigned int MESH_MAX_LODS = 5;
+
+//local space bounds, computed on import and stored in the mesh cache
+struct MeshBounds
+{
+	DirectX::XMFLOAT3 Min;
+	DirectX::XMFLOAT3 Max;
+	DirectX::XMFLOAT3 Center; //bounding sphere
+	float Radius;
+};
+
+//settings for the obj import, they are part of the cache so changing them rebuilds it
+struct MeshImportOptions
+{
+	bool optimize = true; //vertex cache, overdraw and vertex fetch reordering
+	VertexFormat vertexFormat = VertexFormat::Full; //Compact needs a shader that decodes it (CompactVertexShader)
+	unsigned int lodCount = 4; //levels including LOD0, 1 turns simplification off, at most MESH_MAX_LODS
+	bool buildMeshlets = false; //split LOD0 into meshlets so DrawCulled can skip hidden clusters, pays off on big meshes
+};
+
+//one level of detail, a range of the mesh's index buffer (all levels share the vertex buffer)
+struct MeshLod
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	float error; //how far the surface may be from LOD0, in mesh units
+};
+
+//cpu side result of an obj import or cache load, everything the gpu buffers are created from
+//has no d3d objects in it so it can be built off the main thread
+struct MeshData
+{
+	const void* vertices = nullptr; //into vertexStorage or the mapped cache file
+	const void* indices = nullptr; //every lod back to back
+	unsigned int vertexCount = 0;
+	unsigned int vertexStride = 0;
+	unsigned int indexCount = 0;
+	unsigned int indexStride = 0;
+	VertexFormat vertexFormat = VertexFormat::Full;
+	MeshBounds bounds = {};
+	VertexCacheStats cacheStatsBefore;
+	VertexCacheStats cacheStatsAfter;
+	QuantizationError quantizationError;
+	std::vector<MeshLod> lods;
+	const Meshlet* meshlets = nullptr; //ranges of LOD0, into meshletStorage or the mapped cache file
+	unsigned int meshletCount = 0;
+	unsigned int unweldedVertexCount = 0;
+	bool loadedFromCache = false;
+	double loadMilliseconds = 0.0;
+
+	MappedFile cacheFile;
+	std::vector<unsigned char> vertexStorage;
+	std::vector<unsigned char> indexStorage;
+	std::vector<Meshlet> meshletStorage;
+};
 
 class Mesh
 {
  private:
-    Microsoft::WRL::ComPtr<ID3D11Buffer> m_vertexBuffer;
-    Microsoft::WRL::ComPtr<ID3D11Buffer> m_indexBuffer;
+    //vertices and indices live in a shared arena, m_geometry is this mesh's range in it
+    GeometryArena* m_arena = nullptr;
+    unsigned int m_geometry = GeometryArena::INVALID_HANDLE;
     unsigned int m_indicesCount;
     unsigned int m_vertexCount;
+    unsigned int m_vertexStride = sizeof(Vertex);
+    DXGI_FORMAT m_indexFormat = DXGI_FORMAT_R32_UINT; //R16_UINT when every index fits
+    VertexFormat m_vertexFormat = VertexFormat::Full;
+    QuantizationError m_quantizationError; //only filled for compact meshes
+    std::vector<MeshLod> m_lods;
+
+    //meshlet culling, the visible meshlets' indices get copied into m_culledIndexBuffer every DrawCulled
+    std::vector<Meshlet> m_meshlets;
+    MeshletBounds m_meshletBounds;
+    std::vector<unsigned char> m_meshletIndices; //cpu copy of LOD0
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_culledIndexBuffer;
+    //from whichever DrawCulled finished last, several threads can be culling the mesh at once
+    std::atomic<unsigned int> m_visibleMeshlets = 0;
+    std::atomic<unsigned int> m_culledIndexCount = 0;
+    unsigned int m_unweldedVertexCount = 0; //vertex count before obj corners were welded
+    double m_loadMilliseconds = 0.0;
+    bool m_loadedFromCache = false;
+    MeshBounds m_bounds = {};
+    VertexCacheStats m_cacheStatsBefore; //file order after welding
+    VertexCacheStats m_cacheStatsAfter; //what gets uploaded
     const char* name;
+    bool m_ready = true;
+    std::shared_ptr<Mesh> m_placeholder; //drawn instead while a background load is pending (see MeshLoader)
 
-    void initBuffers(Vertex* vertices, size_t numVerts, unsigned int* indexArray, size_t numIndices);
+    //vertices are vertexStride bytes each, indices are 2 or 4 bytes (see PackIndices)
+    void initBuffers(const void* vertices, size_t numVerts, unsigned int vertexStride, const void* indices, size_t numIndices, unsigned int indexStride);
+    void initFromData(const MeshData& data);
 
     //copy ctor
 	//Mesh(const Mesh& mesh);
@@ -30,20 +118,65 @@ class Mesh
 	//mesh needs device and context to create buffers
     Mesh(const char* name, Vertex* vertexBuffer, int, unsigned int* indexBuffer, int);
     //obj ctor
-	Mesh(const char* name, const std::wstring& objFile);
+	Mesh(const char* name, const std::wstring& objFile, const MeshImportOptions& options = MeshImportOptions());
+    //uploads data that was loaded with LoadObj
+    Mesh(const char* name, const MeshData& data);
+    //empty mesh that gets its data later through Upload, placeholder may be null
+    Mesh(const char* name, std::shared_ptr<Mesh> placeholder);
+
+    //cpu half of the obj ctor (cache or import, optimization, lods), thread safe
+    static bool LoadObj(const std::wstring& objFile, const MeshImportOptions& options, MeshData& data);
+    //fills a pending mesh, main thread only
+    void Upload(const MeshData& data);
 
 
     //smart pointers mean destructor can be default
     ~Mesh();
 
-    ID3D11Buffer* GetVertexBuffer() { return m_vertexBuffer.Get(); }
-    ID3D11Buffer* GetIndexBuffer() { return m_indexBuffer.Get(); }
+    //false while a background load is pending, draw GetPlaceholder() instead in the meantime
+    bool IsReady() { return m_ready; }
+    std::shared_ptr<Mesh> GetPlaceholder() { return m_placeholder; }
+    //the arena's buffers, shared with other meshes, draw with GetGeometryRange()
+    ID3D11Buffer* GetVertexBuffer() { return m_arena ? m_arena->GetVertexBuffer() : nullptr; }
+    ID3D11Buffer* GetIndexBuffer() { return m_arena ? m_arena->GetIndexBuffer() : nullptr; }
+    GeometryArena* GetArena() { return m_arena; }
+    const GeometryRange& GetGeometryRange() { return m_arena->GetRange(m_geometry); }
     unsigned int GetIndexCount() { return m_indicesCount; }
     unsigned int GetVertexCount() { return m_vertexCount; }
+    unsigned int GetUnweldedVertexCount() { return m_unweldedVertexCount; }
 	const char* GetName() { return name; }
+    double GetLoadMilliseconds() { return m_loadMilliseconds; }
+    bool WasLoadedFromCache() { return m_loadedFromCache; }
+    const MeshBounds& GetBounds() { return m_bounds; }
+    const VertexCacheStats& GetCacheStatsBefore() { return m_cacheStatsBefore; }
+    const VertexCacheStats& GetCacheStatsAfter() { return m_cacheStatsAfter; }
+    VertexFormat GetVertexFormat() { return m_vertexFormat; }
+    unsigned int GetVertexStride() { return m_vertexStride; }
+    DXGI_FORMAT GetIndexFormat() { return m_indexFormat; }
+    const QuantizationError& GetQuantizationError() { return m_quantizationError; }
+    bool HasMeshlets() { return !m_meshlets.empty(); }
+    unsigned int GetMeshletCount() { return (unsigned int)m_meshlets.size(); }
+    unsigned int GetVisibleMeshletCount() { return m_visibleMeshlets; } //from the last DrawCulled
+    unsigned int GetCulledIndexCount() { return m_culledIndexCount; }
+    unsigned int GetLodCount() { return (unsigned int)m_lods.size(); }
+    const MeshLod& GetLod(unsigned int lod) { return m_lods[lod]; }
+
+    //coarsest lod whose error stays under maxPixelError on screen
+    //projectedSize is the bounding sphere's diameter over the screen height (Camera::GetProjectedSize)
+    unsigned int SelectLod(float projectedSize, float screenHeight, float maxPixelError = 1.0f);
+
+    //input layout matching a vertex format, built against the given compiled vertex shader
+    static Microsoft::WRL::ComPtr<ID3D11InputLayout> CreateInputLayout(VertexFormat format, const std::wstring& vertexShaderFile);
+    //indices narrowed to 16 bits when the mesh has fewer than 65536 vertices, returns the index stride
+    static unsigned int PackIndices(const unsigned int* indices, size_t numIndices, size_t numVerts, std::vector<unsigned char>& packed);
 
-    void Draw();
-    void DrawInstanced(int instanceCount);
+    //the draws are recorded into commands, they reach the gpu when it is executed
+    void Draw(CommandBuffer& commands, unsigned int lod = 0);
+    //draws LOD0 without the meshlets that are outside the frustum or facing away
+    //worldViewProjection puts the frustum into mesh space, viewer is the camera position in mesh space
+    void DrawCulled(CommandBuffer& commands, const DirectX::XMFLOAT4X4& worldViewProjection, DirectX::XMFLOAT3 viewer);
+    //instances were written to SharedBuffers::Instances (Graphics::UpdateInstanceBuffer)
+    void DrawInstanced(CommandBuffer& commands, const InstanceRange& instances, unsigned int lod = 0);
 };
 
 
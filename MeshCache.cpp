@@ -0,0 +1,147 @@
+#include "MeshCache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+	inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	//a bad index would have the gpu read past the vertex buffer, so every one gets checked once at load
+	template<typename Index>
+	bool IndicesInRange(const void* indices, uint32_t indexCount, uint32_t vertexCount)
+	{
+		const Index* index = (const Index*)indices;
+		Index largest = 0;
+		for (uint32_t i = 0; i < indexCount; i++)
+			largest = index[i] > largest ? index[i] : largest;
+		return indexCount == 0 || largest < vertexCount;
+	}
+
+	//meshlet culling copies each meshlet's indices out of lod 0 without looking, so they get checked here instead
+	bool MeshletsInRange(const char* meshlets, uint32_t meshletCount, uint32_t meshletStride, uint32_t lodIndexCount)
+	{
+		for (uint32_t i = 0; i < meshletCount; i++)
+		{
+			MeshBinMeshletRange range;
+			memcpy(&range, meshlets + (size_t)i * meshletStride, sizeof(range));
+			if ((uint64_t)range.firstIndex + (uint64_t)range.triangleCount * 3 > lodIndexCount)
+				return false;
+		}
+		return true;
+	}
+}
+
+std::wstring MeshCache::GetCachePath(const std::wstring& sourceFile, const std::wstring& variant)
+{
+	std::filesystem::path path(sourceFile);
+	path.replace_extension(variant.empty() ? L".meshbin" : L"." + variant + L".meshbin");
+	return path.wstring();
+}
+
+bool MeshCache::IsFresh(const std::wstring& cachePath, const std::wstring& sourceFile)
+{
+	std::error_code error;
+	auto cacheTime = std::filesystem::last_write_time(cachePath, error);
+	if (error)
+		return false;
+	auto sourceTime = std::filesystem::last_write_time(sourceFile, error);
+	if (error)
+		return true; //no source to compare against (shipped cache only), use what we have
+	return cacheTime >= sourceTime;
+}
+
+bool MeshCache::Load(const std::wstring& cachePath, MappedFile& file, MeshBinView& view)
+{
+	if (!file.Open(cachePath) || file.Size() < sizeof(MeshBinHeader))
+		return false;
+
+	const MeshBinHeader& header = *(const MeshBinHeader*)file.Data();
+	if (header.magic != MESHBIN_MAGIC || header.version != MESHBIN_VERSION || header.headerSize != sizeof(MeshBinHeader))
+		return false;
+	if (header.attributeCount > MESHBIN_MAX_ATTRIBUTES || header.lodCount == 0 || header.lodCount > MESHBIN_MAX_LODS)
+		return false;
+	for (uint32_t i = 0; i < header.lodCount; i++)
+		if ((uint64_t)header.lods[i].firstIndex + header.lods[i].indexCount > header.indexCount)
+			return false;
+
+	//never trust sizes read from disk
+	if ((uint64_t)header.vertexCount * header.vertexStride != header.vertexBytes ||
+		(uint64_t)header.indexCount * header.indexStride != header.indexBytes ||
+		(uint64_t)header.meshletCount * header.meshletStride != header.meshletBytes)
+		return false;
+	if (header.vertexOffset % MESHBIN_ALIGNMENT != 0 || header.indexOffset % MESHBIN_ALIGNMENT != 0 || header.meshletOffset % MESHBIN_ALIGNMENT != 0)
+		return false;
+	//written so a huge offset can't wrap around and pass
+	uint64_t fileSize = file.Size();
+	if (header.vertexOffset > fileSize || header.vertexBytes > fileSize - header.vertexOffset ||
+		header.indexOffset > fileSize || header.indexBytes > fileSize - header.indexOffset ||
+		header.meshletOffset > fileSize || header.meshletBytes > fileSize - header.meshletOffset)
+		return false;
+	if (header.indexStride != sizeof(uint16_t) && header.indexStride != sizeof(uint32_t))
+		return false;
+	const void* indices = file.Data() + header.indexOffset;
+	if (header.indexStride == sizeof(uint16_t) ? !IndicesInRange<uint16_t>(indices, header.indexCount, header.vertexCount) :
+		!IndicesInRange<uint32_t>(indices, header.indexCount, header.vertexCount))
+		return false;
+	if (header.meshletCount > 0 && (header.meshletStride < sizeof(MeshBinMeshletRange) ||
+		!MeshletsInRange(file.Data() + header.meshletOffset, header.meshletCount, header.meshletStride, header.lods[0].indexCount)))
+		return false;
+
+	view.header = header;
+	view.vertices = file.Data() + header.vertexOffset;
+	view.indices = indices;
+	view.meshlets = header.meshletCount > 0 ? file.Data() + header.meshletOffset : nullptr;
+	return true;
+}
+
+bool MeshCache::Write(const std::wstring& cachePath, const MeshBinView& view)
+{
+	MeshBinHeader header = view.header;
+	header.magic = MESHBIN_MAGIC;
+	header.version = MESHBIN_VERSION;
+	header.headerSize = sizeof(MeshBinHeader);
+	header.vertexBytes = (uint64_t)header.vertexCount * header.vertexStride;
+	header.indexBytes = (uint64_t)header.indexCount * header.indexStride;
+	header.vertexOffset = AlignUp(sizeof(MeshBinHeader), MESHBIN_ALIGNMENT);
+	header.indexOffset = AlignUp(header.vertexOffset + header.vertexBytes, MESHBIN_ALIGNMENT);
+	header.meshletBytes = (uint64_t)header.meshletCount * header.meshletStride;
+	header.meshletOffset = header.meshletBytes > 0 ? AlignUp(header.indexOffset + header.indexBytes, MESHBIN_ALIGNMENT) : 0;
+
+	std::filesystem::path finalPath(cachePath);
+	std::filesystem::path tempPath = finalPath;
+	tempPath += L".tmp";
+
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return false;
+
+		static const char padding[MESHBIN_ALIGNMENT] = {};
+		out.write((const char*)&header, sizeof(header));
+		out.write(padding, header.vertexOffset - sizeof(header));
+		out.write((const char*)view.vertices, header.vertexBytes);
+		out.write(padding, header.indexOffset - (header.vertexOffset + header.vertexBytes));
+		out.write((const char*)view.indices, header.indexBytes);
+		if (header.meshletBytes > 0)
+		{
+			out.write(padding, header.meshletOffset - (header.indexOffset + header.indexBytes));
+			out.write((const char*)view.meshlets, header.meshletBytes);
+		}
+		if (!out.good())
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, finalPath, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "MappedFile.h"
+
+// Binary mesh cache (.meshbin) written next to a source .obj
+// File layout:
+//  - MeshBinHeader
+//  - vertex blob, 64 byte aligned
+//  - index blob, 64 byte aligned
+//  - meshlet blob (optional), 64 byte aligned
+// The blobs are stored exactly as the gpu buffers want them, so a loaded cache
+// can be handed straight to Mesh::initBuffers out of the memory mapping
+
+constexpr uint32_t MESHBIN_MAGIC = 0x4E42534Du; // "MSBN"
+constexpr uint32_t MESHBIN_VERSION = 6;
+constexpr uint32_t MESHBIN_ALIGNMENT = 64;
+constexpr uint32_t MESHBIN_MAX_ATTRIBUTES = 8;
+constexpr uint32_t MESHBIN_MAX_LODS = 5;
+
+//MeshBinHeader::flags
+constexpr uint32_t MESHBIN_FLAG_OPTIMIZED = 1u << 0; //vertex cache / overdraw / fetch passes were run
+constexpr uint32_t MESHBIN_FLAG_MESHLETS = 1u << 1; //lod 0 is ordered into meshlets and the meshlet blob is present
+constexpr uint32_t MESHBIN_FLAG_LOD_SHIFT = 8; //requested lod count lives in bits 8-11
+
+enum MeshBinSemantic : uint32_t
+{
+	MeshBinPosition = 0,
+	MeshBinTexcoord = 1,
+	MeshBinNormal = 2,
+	MeshBinTangent = 3,
+};
+
+enum MeshBinFormat : uint32_t
+{
+	MeshBinFloat2 = 0,
+	MeshBinFloat3 = 1,
+	MeshBinFloat4 = 2,
+	MeshBinUint1 = 3,
+	MeshBinUnorm16x4 = 4,
+	MeshBinHalf2 = 5,
+	MeshBinSnorm16x2Oct = 6, //octahedral encoded unit vector
+};
+
+//one element of the vertex layout descriptor
+struct MeshBinAttribute
+{
+	uint32_t Semantic;
+	uint32_t Format;
+	uint32_t Offset; //byte offset inside a vertex
+};
+
+//range of the index blob holding one level of detail
+struct MeshBinLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error;
+};
+
+//what every meshlet blob entry starts with (Meshlet in MeshletBuilder.h), enough for Load to check it stays inside lod 0
+struct MeshBinMeshletRange
+{
+	uint32_t firstIndex;
+	uint32_t triangleCount;
+};
+
+struct MeshBinHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t flags; //import options the cache was built with, a mismatch means rebuild
+
+	uint32_t vertexCount;
+	uint32_t vertexStride;
+	uint32_t indexCount;
+	uint32_t indexStride;
+	uint32_t unweldedVertexCount; //obj corners before welding, for the stats
+
+	uint32_t attributeCount;
+	MeshBinAttribute attributes[MESHBIN_MAX_ATTRIBUTES];
+
+	//local space bounds
+	float boundsMin[3];
+	float boundsMax[3];
+	float sphereCenter[3];
+	float sphereRadius;
+
+	//post-transform cache stats from import (acmr/atvr before and after optimization)
+	float acmrBefore;
+	float atvrBefore;
+	float acmrAfter;
+	float atvrAfter;
+
+	//round trip error of a quantized vertex format, 0 for full float vertices
+	float positionError;
+	float uvError;
+	float normalErrorDegrees;
+
+	//lod 0 is the full mesh, the rest come from the simplifier
+	uint32_t lodCount;
+	MeshBinLod lods[MESHBIN_MAX_LODS];
+
+	uint32_t meshletCount;
+	uint32_t meshletStride;
+
+	uint64_t vertexOffset;
+	uint64_t vertexBytes;
+	uint64_t indexOffset;
+	uint64_t indexBytes;
+	uint64_t meshletOffset;
+	uint64_t meshletBytes;
+};
+
+//what a mesh provides to write a cache, and what a loaded cache points at
+struct MeshBinView
+{
+	MeshBinHeader header = {};
+	const void* vertices = nullptr;
+	const void* indices = nullptr;
+	const void* meshlets = nullptr; //only when meshletCount > 0
+};
+
+namespace MeshCache
+{
+	//cube.obj -> cube.meshbin in the same folder, or cube.<variant>.meshbin so different vertex formats don't fight over one file
+	std::wstring GetCachePath(const std::wstring& sourceFile, const std::wstring& variant = L"");
+
+	//true when the cache exists and is at least as new as the source
+	bool IsFresh(const std::wstring& cachePath, const std::wstring& sourceFile);
+
+	//maps the cache and validates it, the view points into file so it must stay open while the data is used
+	bool Load(const std::wstring& cachePath, MappedFile& file, MeshBinView& view);
+
+	//fills in magic/version/offsets and writes atomically (temp file then rename)
+	bool Write(const std::wstring& cachePath, const MeshBinView& view);
+}
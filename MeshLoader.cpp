@@ -0,0 +1,75 @@
+#include "MeshLoader.h"
+#include <chrono>
+
+MeshLoader::MeshLoader(unsigned int threadCount) : pool(threadCount)
+{
+}
+
+MeshLoader::~MeshLoader()
+{
+}
+
+void MeshLoader::SetPlaceholder(VertexFormat format, std::shared_ptr<Mesh> placeholder)
+{
+	placeholders[(int)format] = placeholder;
+}
+
+std::shared_ptr<Mesh> MeshLoader::Load(const char* name, const std::wstring& objFile, const MeshImportOptions& options)
+{
+	std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(name, placeholders[(int)options.vertexFormat]);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending++;
+	}
+	std::weak_ptr<Mesh> target = mesh;
+	pool.Submit([this, target, objFile, options]()
+		{
+			Completed result;
+			result.mesh = target;
+			//a failed load still gets queued so the mesh stops waiting, it just ends up empty
+			if (!target.expired())
+				Mesh::LoadObj(objFile, options, result.data);
+			std::lock_guard<std::mutex> lock(mutex);
+			completed.push_back(std::move(result));
+		});
+	return mesh;
+}
+
+void MeshLoader::Update(double budgetMilliseconds)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	while (true)
+	{
+		Completed result;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (completed.empty())
+				return;
+			result = std::move(completed.back());
+			completed.pop_back();
+		}
+		if (std::shared_ptr<Mesh> mesh = result.mesh.lock())
+			mesh->Upload(result.data);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending--;
+		}
+
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (elapsed >= budgetMilliseconds)
+			return;
+	}
+}
+
+void MeshLoader::Flush()
+{
+	pool.Wait();
+	while (GetPendingCount() > 0)
+		Update(1e30);
+}
+
+unsigned int MeshLoader::GetPendingCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return pending;
+}
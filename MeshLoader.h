@@ -0,0 +1,47 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+// Loads obj meshes in the background
+// - Load hands back an empty Mesh straight away, the obj/cache work runs on the pool
+// - finished meshes wait in a queue until Update uploads them on the main thread (d3d buffer creation)
+// - until then the mesh draws the placeholder registered for its vertex format
+class MeshLoader
+{
+public:
+	explicit MeshLoader(unsigned int threadCount = 0);
+	~MeshLoader();
+	MeshLoader(const MeshLoader&) = delete; // Remove copy constructor
+	MeshLoader& operator=(const MeshLoader&) = delete; // Remove copy-assignment operator
+
+	//stands in for every mesh of that format that is still loading, should be a small mesh loaded up front
+	void SetPlaceholder(VertexFormat format, std::shared_ptr<Mesh> placeholder);
+
+	std::shared_ptr<Mesh> Load(const char* name, const std::wstring& objFile, const MeshImportOptions& options = MeshImportOptions());
+
+	//main thread only, uploads finished meshes until the time budget is spent (at least one per call)
+	void Update(double budgetMilliseconds = 2.0);
+	//blocks until everything queued so far is loaded and uploaded
+	void Flush();
+
+	//queued or uploading
+	unsigned int GetPendingCount();
+
+private:
+	struct Completed
+	{
+		std::weak_ptr<Mesh> mesh; //dropped meshes are not uploaded
+		MeshData data;
+	};
+
+	std::shared_ptr<Mesh> placeholders[2];
+	std::mutex mutex;
+	std::vector<Completed> completed;
+	unsigned int pending = 0;
+	ThreadPool pool; //last so the workers are joined before the queue goes away
+};
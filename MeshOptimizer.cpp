@@ -0,0 +1,352 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	// --- Forsyth scoring, see https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html ---
+	constexpr int CACHE_SIZE = 32;
+	constexpr int MAX_VALENCE_SCORE = 32;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float LAST_TRI_SCORE = 0.75f;
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	struct ScoreTables
+	{
+		float cache[CACHE_SIZE];
+		float valence[MAX_VALENCE_SCORE];
+
+		ScoreTables()
+		{
+			for (int i = 0; i < CACHE_SIZE; i++)
+			{
+				//the 3 most recent vertices belong to the triangle just drawn, so they get a fixed score
+				//to avoid favouring strips that keep reusing them
+				if (i < 3)
+					cache[i] = LAST_TRI_SCORE;
+				else
+					cache[i] = powf(1.0f - (float)(i - 3) / (float)(CACHE_SIZE - 3), CACHE_DECAY_POWER);
+			}
+			valence[0] = 0.0f;
+			for (int i = 1; i < MAX_VALENCE_SCORE; i++)
+				valence[i] = VALENCE_BOOST_SCALE * powf((float)i, -VALENCE_BOOST_POWER);
+		}
+	};
+
+	const ScoreTables& GetScoreTables()
+	{
+		static const ScoreTables tables;
+		return tables;
+	}
+
+	inline float VertexScore(const ScoreTables& tables, int cachePosition, unsigned int liveTriangles)
+	{
+		if (liveTriangles == 0)
+			return -1.0f; //nothing left to draw with this vertex
+		float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+		return score + tables.valence[std::min<unsigned int>(liveTriangles, MAX_VALENCE_SCORE - 1)];
+	}
+
+	//adjacency list of vertex -> triangles
+	struct Adjacency
+	{
+		std::vector<unsigned int> counts;
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> triangles;
+
+		Adjacency(const unsigned int* indices, size_t indexCount, size_t vertexCount)
+			: counts(vertexCount, 0), offsets(vertexCount, 0), triangles(indexCount)
+		{
+			for (size_t i = 0; i < indexCount; i++)
+				counts[indices[i]]++;
+			unsigned int offset = 0;
+			for (size_t v = 0; v < vertexCount; v++)
+			{
+				offsets[v] = offset;
+				offset += counts[v];
+			}
+			std::vector<unsigned int> fill(offsets);
+			for (size_t i = 0; i < indexCount; i++)
+				triangles[fill[indices[i]]++] = (unsigned int)(i / 3);
+		}
+	};
+}
+
+void MeshOptimizer::OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0)
+		return;
+
+	const ScoreTables& tables = GetScoreTables();
+	Adjacency adjacency(indices, indexCount, vertexCount);
+
+	//live triangle count per vertex goes down as triangles are emitted
+	std::vector<unsigned int> liveTriangles(adjacency.counts);
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		vertexScores[v] = VertexScore(tables, -1, liveTriangles[v]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	for (size_t t = 0; t < triangleCount; t++)
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+	std::vector<unsigned int> output;
+	output.reserve(indexCount);
+
+	//lru cache, +3 slots so a new triangle can be pushed before trimming
+	unsigned int cache[CACHE_SIZE + 3];
+	unsigned int cacheCount = 0;
+
+	size_t bestTriangle = 0;
+	for (size_t t = 1; t < triangleCount; t++)
+		if (triangleScores[t] > triangleScores[bestTriangle])
+			bestTriangle = t;
+
+	size_t inputCursor = 0; //for restarting when the cache has no live triangles left
+	for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+	{
+		if (bestTriangle == (size_t)-1)
+		{
+			//dead end, take the next triangle in input order
+			while (emitted[inputCursor])
+				inputCursor++;
+			bestTriangle = inputCursor;
+		}
+
+		const unsigned int* tri = &indices[bestTriangle * 3];
+		output.push_back(tri[0]);
+		output.push_back(tri[1]);
+		output.push_back(tri[2]);
+		emitted[bestTriangle] = true;
+
+		//move the triangle's vertices to the front of the cache
+		unsigned int newCache[CACHE_SIZE + 3];
+		unsigned int newCount = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			newCache[newCount++] = tri[i];
+			liveTriangles[tri[i]]--;
+		}
+		for (unsigned int i = 0; i < cacheCount; i++)
+		{
+			unsigned int v = cache[i];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache[newCount++] = v;
+		}
+
+		//anything pushed past the end falls out of the cache
+		for (unsigned int i = CACHE_SIZE; i < newCount; i++)
+		{
+			cachePosition[newCache[i]] = -1;
+			vertexScores[newCache[i]] = VertexScore(tables, -1, liveTriangles[newCache[i]]);
+		}
+		cacheCount = std::min<unsigned int>(newCount, CACHE_SIZE);
+		memcpy(cache, newCache, cacheCount * sizeof(unsigned int));
+
+		//rescore cached vertices and their triangles, the best of those is the next candidate
+		for (unsigned int i = 0; i < cacheCount; i++)
+		{
+			unsigned int v = cache[i];
+			cachePosition[v] = (int)i;
+			vertexScores[v] = VertexScore(tables, (int)i, liveTriangles[v]);
+		}
+
+		bestTriangle = (size_t)-1;
+		float bestScore = -1.0f;
+		for (unsigned int i = 0; i < cacheCount; i++)
+		{
+			unsigned int v = cache[i];
+			const unsigned int* adjacent = &adjacency.triangles[adjacency.offsets[v]];
+			for (unsigned int a = 0; a < adjacency.counts[v]; a++)
+			{
+				unsigned int t = adjacent[a];
+				if (emitted[t])
+					continue;
+				float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+				triangleScores[t] = score;
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+
+	memcpy(indices, output.data(), indexCount * sizeof(unsigned int));
+}
+
+void MeshOptimizer::OptimizeOverdraw(unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	auto position = [&](unsigned int v) { return (const float*)((const char*)positions + v * positionStride); };
+
+	//split into clusters. A cluster ends where the fifo cache restarts (3 misses, a "hard" boundary)
+	//or where the cluster drawn on its own from a cold cache stays within threshold of the mesh's acmr (a "soft" boundary)
+	//clusters are simulated cold because after sorting they can follow any other cluster
+	const unsigned int fifoSize = 16;
+	const float meshAcmr = AnalyzeVertexCache(indices, indexCount, vertexCount, fifoSize).acmr;
+
+	std::vector<unsigned int> meshStamp(vertexCount, 0);
+	std::vector<unsigned int> clusterStamp(vertexCount, 0);
+	unsigned int meshTime = fifoSize + 1;
+	unsigned int clusterTime = fifoSize + 1;
+	std::vector<size_t> clusterStarts;
+	size_t clusterStart = 0;
+	unsigned int clusterMisses = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		unsigned int meshMisses = 0;
+		for (int c = 0; c < 3; c++)
+		{
+			unsigned int v = indices[t * 3 + c];
+			if (meshTime - meshStamp[v] > fifoSize)
+			{
+				meshStamp[v] = meshTime++;
+				meshMisses++;
+			}
+		}
+
+		size_t clusterTriangles = t - clusterStart;
+		bool hardBoundary = meshMisses == 3 && clusterTriangles > 0;
+		bool softBoundary = clusterTriangles >= 8 && (float)clusterMisses / (float)clusterTriangles <= meshAcmr * threshold;
+		if (t == 0 || hardBoundary || softBoundary)
+		{
+			clusterStarts.push_back(t);
+			clusterStart = t;
+			clusterMisses = 0;
+			clusterTime += fifoSize + 1; //cold cache
+		}
+
+		for (int c = 0; c < 3; c++)
+		{
+			unsigned int v = indices[t * 3 + c];
+			if (clusterTime - clusterStamp[v] > fifoSize)
+			{
+				clusterStamp[v] = clusterTime++;
+				clusterMisses++;
+			}
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+	const size_t clusterCount = clusterStarts.size() - 1;
+	if (clusterCount < 2)
+		return;
+
+	//mesh centroid, then per cluster area weighted centroid and normal
+	double meshCenter[3] = { 0, 0, 0 };
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		const float* p = position(indices[i]);
+		meshCenter[0] += p[0]; meshCenter[1] += p[1]; meshCenter[2] += p[2];
+	}
+	for (double& c : meshCenter)
+		c /= (double)indexCount;
+
+	struct ClusterSort
+	{
+		float key;
+		size_t cluster;
+	};
+	std::vector<ClusterSort> sortData(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		float center[3] = { 0, 0, 0 };
+		float normal[3] = { 0, 0, 0 };
+		float areaSum = 0.0f;
+		for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+		{
+			const float* p0 = position(indices[t * 3]);
+			const float* p1 = position(indices[t * 3 + 1]);
+			const float* p2 = position(indices[t * 3 + 2]);
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (int k = 0; k < 3; k++)
+			{
+				center[k] += (p0[k] + p1[k] + p2[k]) * (area / 3.0f);
+				normal[k] += n[k];
+			}
+			areaSum += area;
+		}
+		float invArea = areaSum > 0.0f ? 1.0f / areaSum : 0.0f;
+		float normalLength = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float invNormal = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+
+		//clusters facing away from the mesh center are the ones most likely to occlude the rest
+		float key = 0.0f;
+		for (int k = 0; k < 3; k++)
+			key += (center[k] * invArea - (float)meshCenter[k]) * normal[k] * invNormal;
+		sortData[c] = { key, c };
+	}
+
+	std::stable_sort(sortData.begin(), sortData.end(), [](const ClusterSort& a, const ClusterSort& b) { return a.key > b.key; });
+
+	std::vector<unsigned int> output;
+	output.reserve(indexCount);
+	for (const ClusterSort& s : sortData)
+		output.insert(output.end(), indices + clusterStarts[s.cluster] * 3, indices + clusterStarts[s.cluster + 1] * 3);
+	memcpy(indices, output.data(), triangleCount * 3 * sizeof(unsigned int));
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch(void* vertices, unsigned int* indices, size_t indexCount, size_t vertexCount, size_t vertexSize)
+{
+	constexpr unsigned int UNUSED = 0xFFFFFFFFu;
+	std::vector<unsigned int> remap(vertexCount, UNUSED);
+	unsigned int nextVertex = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int& target = remap[indices[i]];
+		if (target == UNUSED)
+			target = nextVertex++;
+		indices[i] = target;
+	}
+
+	std::vector<unsigned char> reordered((size_t)nextVertex * vertexSize);
+	for (size_t v = 0; v < vertexCount; v++)
+		if (remap[v] != UNUSED)
+			memcpy(&reordered[remap[v] * vertexSize], (const unsigned char*)vertices + v * vertexSize, vertexSize);
+	memcpy(vertices, reordered.data(), reordered.size());
+	return nextVertex;
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStats stats;
+	if (indexCount < 3 || vertexCount == 0)
+		return stats;
+
+	//fifo via timestamps, a vertex is cached if it was inserted less than cacheSize insertions ago
+	std::vector<unsigned int> stamp(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	unsigned int timestamp = cacheSize + 1;
+	unsigned int uniqueVertices = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int v = indices[i];
+		if (timestamp - stamp[v] > cacheSize)
+		{
+			stamp[v] = timestamp++;
+			stats.transformedVertices++;
+		}
+		if (!referenced[v])
+		{
+			referenced[v] = true;
+			uniqueVertices++;
+		}
+	}
+
+	stats.acmr = (float)stats.transformedVertices / (float)(indexCount / 3);
+	stats.atvr = (float)stats.transformedVertices / (float)uniqueVertices;
+	return stats;
+}
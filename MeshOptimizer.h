@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+
+//post-transform cache efficiency of an index buffer, simulated with a FIFO cache like most gpus use
+struct VertexCacheStats
+{
+	float acmr = 0.0f; //average cache miss ratio, transformed vertices per triangle (0.5 is ideal on big meshes, 3 is worst)
+	float atvr = 0.0f; //average transformed vertex ratio, transformed vertices per unique vertex (1.0 is ideal)
+	unsigned int transformedVertices = 0;
+};
+
+// Index and vertex reordering passes run on imported meshes before they are uploaded
+// Intended order: OptimizeVertexCache -> OptimizeOverdraw -> OptimizeVertexFetch
+// Everything is plain cpu code so the gains can be measured without a gpu (AnalyzeVertexCache)
+namespace MeshOptimizer
+{
+	//Tom Forsyth's linear-speed vertex cache optimisation, reorders triangles in place
+	void OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+	//splits the cache optimized order into clusters and sorts them so outward facing clusters draw first
+	//threshold is how much acmr may grow (1.05 = 5%) to get smaller clusters and better sorting
+	void OptimizeOverdraw(unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold = 1.05f);
+
+	//reorders vertices into first use order and rewrites the indices to match
+	//unreferenced vertices are dropped, returns the new vertex count
+	size_t OptimizeVertexFetch(void* vertices, unsigned int* indices, size_t indexCount, size_t vertexCount, size_t vertexSize);
+
+	VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16);
+}
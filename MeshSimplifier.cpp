@@ -0,0 +1,379 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	enum VertexKind : unsigned char
+	{
+		Manifold,	//interior vertex, can collapse onto any neighbour
+		Border,		//on an open edge, only collapses along the border
+		Seam,		//one of two vertices sharing a position, collapses along the seam with its twin
+		Locked,		//never moves
+	};
+
+	//edge neighbours of a vertex: none yet, or more than one
+	constexpr unsigned int NO_EDGE = ~0u;
+	constexpr unsigned int MANY_EDGES = ~0u - 1;
+
+	//open edges get an extra plane through them, perpendicular to the surface, so borders and seams keep their shape
+	constexpr double BORDER_WEIGHT = 10.0;
+
+	struct Vector3
+	{
+		float x, y, z;
+	};
+
+	inline Vector3 Sub(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline Vector3 Cross(const Vector3& a, const Vector3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+	inline float Dot(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	//symmetric 4x4 matrix of the summed plane equations, w is the summed weight
+	struct Quadric
+	{
+		double a2, b2, c2, ab, ac, bc, ad, bd, cd, d2, w;
+	};
+
+	void AddPlane(Quadric& q, double a, double b, double c, double d, double w)
+	{
+		q.a2 += a * a * w; q.b2 += b * b * w; q.c2 += c * c * w;
+		q.ab += a * b * w; q.ac += a * c * w; q.bc += b * c * w;
+		q.ad += a * d * w; q.bd += b * d * w; q.cd += c * d * w;
+		q.d2 += d * d * w;
+		q.w += w;
+	}
+
+	void AddQuadric(Quadric& q, const Quadric& r)
+	{
+		q.a2 += r.a2; q.b2 += r.b2; q.c2 += r.c2;
+		q.ab += r.ab; q.ac += r.ac; q.bc += r.bc;
+		q.ad += r.ad; q.bd += r.bd; q.cd += r.cd;
+		q.d2 += r.d2;
+		q.w += r.w;
+	}
+
+	//weighted mean squared distance from p to the planes
+	double QuadricError(const Quadric& q, const Vector3& p)
+	{
+		double x = p.x, y = p.y, z = p.z;
+		double r = q.a2 * x * x + q.b2 * y * y + q.c2 * z * z
+			+ 2.0 * (q.ab * x * y + q.ac * x * z + q.bc * y * z)
+			+ 2.0 * (q.ad * x + q.bd * y + q.cd * z)
+			+ q.d2;
+		return q.w > 0.0 ? fabs(r) / q.w : 0.0;
+	}
+
+	struct PositionKey
+	{
+		uint32_t x, y, z;
+		bool operator==(const PositionKey& o) const { return x == o.x && y == o.y && z == o.z; }
+	};
+
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& k) const
+		{
+			uint64_t h = k.x * 73856093ull ^ k.y * 19349663ull ^ k.z * 83492791ull;
+			return (size_t)(h ^ (h >> 29));
+		}
+	};
+
+	//outgoing half edges per vertex (compressed rows)
+	struct EdgeAdjacency
+	{
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> targets;
+	};
+
+	//map is optional, used to build the adjacency of positions instead of vertices
+	void BuildAdjacency(EdgeAdjacency& adjacency, const unsigned int* indices, size_t indexCount, size_t vertexCount, const unsigned int* map)
+	{
+		adjacency.offsets.assign(vertexCount + 1, 0);
+		adjacency.targets.resize(indexCount);
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			unsigned int a = map ? map[indices[i]] : indices[i];
+			adjacency.offsets[a + 1]++;
+		}
+		for (size_t v = 0; v < vertexCount; v++)
+			adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+		std::vector<unsigned int> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int a = indices[i + k];
+				unsigned int b = indices[i + (k + 1) % 3];
+				if (map) { a = map[a]; b = map[b]; }
+				adjacency.targets[cursor[a]++] = b;
+			}
+		}
+	}
+
+	inline bool HasEdge(const EdgeAdjacency& adjacency, unsigned int a, unsigned int b)
+	{
+		for (unsigned int k = adjacency.offsets[a]; k < adjacency.offsets[a + 1]; k++)
+			if (adjacency.targets[k] == b)
+				return true;
+		return false;
+	}
+
+	inline bool SingleEdge(unsigned int e) { return e != NO_EDGE && e != MANY_EDGES; }
+
+	//records the open edges of every vertex (half edges without a twin going the other way)
+	void FindOpenEdges(const EdgeAdjacency& adjacency, size_t vertexCount, std::vector<unsigned int>& openOut, std::vector<unsigned int>& openIn)
+	{
+		openOut.assign(vertexCount, NO_EDGE);
+		openIn.assign(vertexCount, NO_EDGE);
+		for (unsigned int a = 0; a < (unsigned int)vertexCount; a++)
+		{
+			for (unsigned int k = adjacency.offsets[a]; k < adjacency.offsets[a + 1]; k++)
+			{
+				unsigned int b = adjacency.targets[k];
+				if (HasEdge(adjacency, b, a))
+					continue;
+				openOut[a] = openOut[a] == NO_EDGE ? b : MANY_EDGES;
+				openIn[b] = openIn[b] == NO_EDGE ? a : MANY_EDGES;
+			}
+		}
+	}
+
+	struct Collapse
+	{
+		unsigned int v; //vertex that moves
+		unsigned int t; //vertex it snaps to
+		double error;
+	};
+}
+
+size_t MeshSimplifier::Simplify(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionStride,
+	size_t targetIndexCount, float targetError, float* resultError)
+{
+	if (destination != indices)
+		memmove(destination, indices, indexCount * sizeof(unsigned int));
+	size_t count = indexCount;
+	targetIndexCount -= targetIndexCount % 3;
+	if (resultError)
+		*resultError = 0.0f;
+
+	std::vector<Vector3> verts(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		memcpy(&verts[v], (const char*)positions + v * positionStride, sizeof(Vector3));
+
+	// Vertices with the same position (uv/normal seams) map to the first of them,
+	// and every vertex links to the next one at its position (a ring, wedge[v] == v when it's alone)
+	std::vector<unsigned int> remap(vertexCount), wedge(vertexCount), groupSize(vertexCount, 0);
+	{
+		std::unordered_map<PositionKey, unsigned int, PositionKeyHash> firstAtPosition;
+		firstAtPosition.reserve(vertexCount);
+		for (unsigned int v = 0; v < (unsigned int)vertexCount; v++)
+		{
+			PositionKey key;
+			memcpy(&key, &verts[v], sizeof(key));
+			remap[v] = firstAtPosition.emplace(key, v).first->second;
+			wedge[v] = v;
+			if (remap[v] != v)
+			{
+				wedge[v] = wedge[remap[v]];
+				wedge[remap[v]] = v;
+			}
+			groupSize[remap[v]]++;
+		}
+	}
+
+	// Quadrics are per position so seam twins share one
+	EdgeAdjacency adjacency, positionAdjacency;
+	std::vector<unsigned int> openOut, openIn, positionOpenOut, positionOpenIn;
+	BuildAdjacency(adjacency, destination, count, vertexCount, nullptr);
+	std::vector<Quadric> quadrics(vertexCount, Quadric{});
+	for (size_t i = 0; i < count; i += 3)
+	{
+		unsigned int tri[3] = { destination[i], destination[i + 1], destination[i + 2] };
+		Vector3 n = Cross(Sub(verts[tri[1]], verts[tri[0]]), Sub(verts[tri[2]], verts[tri[0]]));
+		float length = sqrtf(Dot(n, n));
+		if (length == 0.0f)
+			continue;
+		n = { n.x / length, n.y / length, n.z / length };
+		double d = -Dot(n, verts[tri[0]]);
+		for (int k = 0; k < 3; k++)
+			AddPlane(quadrics[remap[tri[k]]], n.x, n.y, n.z, d, length * 0.5);
+
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int a = tri[k], b = tri[(k + 1) % 3];
+			if (HasEdge(adjacency, b, a))
+				continue;
+			Vector3 edge = Sub(verts[b], verts[a]);
+			Vector3 en = Cross(edge, n);
+			float enLength = sqrtf(Dot(en, en));
+			if (enLength == 0.0f)
+				continue;
+			en = { en.x / enLength, en.y / enLength, en.z / enLength };
+			double ed = -Dot(en, verts[a]);
+			double weight = Dot(edge, edge) * BORDER_WEIGHT;
+			AddPlane(quadrics[remap[a]], en.x, en.y, en.z, ed, weight);
+			AddPlane(quadrics[remap[b]], en.x, en.y, en.z, ed, weight);
+		}
+	}
+
+	const double maxError = (double)targetError * targetError;
+	double acceptedError = 0.0;
+	std::vector<VertexKind> kinds(vertexCount);
+	std::vector<Collapse> collapses;
+	std::vector<unsigned int> collapseRemap(vertexCount);
+	std::vector<char> collapseLocked(vertexCount);
+	std::vector<unsigned int> triangleOffsets, triangleList;
+
+	while (count > targetIndexCount)
+	{
+		// Classify vertices against the current topology
+		if (count != indexCount)
+			BuildAdjacency(adjacency, destination, count, vertexCount, nullptr);
+		BuildAdjacency(positionAdjacency, destination, count, vertexCount, remap.data());
+		FindOpenEdges(adjacency, vertexCount, openOut, openIn);
+		FindOpenEdges(positionAdjacency, vertexCount, positionOpenOut, positionOpenIn);
+		for (unsigned int v = 0; v < (unsigned int)vertexCount; v++)
+		{
+			unsigned int r = remap[v];
+			bool positionClosed = positionOpenOut[r] == NO_EDGE && positionOpenIn[r] == NO_EDGE;
+			if (groupSize[r] == 1)
+				kinds[v] = positionClosed ? Manifold : (SingleEdge(openOut[v]) && SingleEdge(openIn[v]) ? Border : Locked);
+			else if (groupSize[r] == 2 && positionClosed &&
+				SingleEdge(openOut[v]) && SingleEdge(openIn[v]) && SingleEdge(openOut[wedge[v]]) && SingleEdge(openIn[wedge[v]]))
+				kinds[v] = Seam;
+			else
+				kinds[v] = Locked;
+		}
+
+		auto canCollapse = [&](unsigned int v, unsigned int t)
+		{
+			switch (kinds[v])
+			{
+			case Manifold:
+				return true;
+			case Border:
+				return kinds[t] == Border && (openOut[v] == t || openIn[v] == t);
+			case Seam:
+			{
+				if (kinds[t] != Seam || !(openOut[v] == t || openIn[v] == t))
+					return false;
+				unsigned int v2 = wedge[v], t2 = wedge[t];
+				return openOut[v2] == t2 || openIn[v2] == t2;
+			}
+			default:
+				return false;
+			}
+		};
+
+		// Cheapest direction of every edge
+		collapses.clear();
+		for (size_t i = 0; i < count; i += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int a = destination[i + k], b = destination[i + (k + 1) % 3];
+				if (remap[a] == remap[b] || (a > b && HasEdge(adjacency, b, a)))
+					continue; //same position, or the twin half edge already covers it
+				bool ab = canCollapse(a, b), ba = canCollapse(b, a);
+				if (!ab && !ba)
+					continue;
+				double errorAB = ab ? QuadricError(quadrics[remap[a]], verts[b]) : 0.0;
+				double errorBA = ba ? QuadricError(quadrics[remap[b]], verts[a]) : 0.0;
+				if (ab && (!ba || errorAB <= errorBA))
+					collapses.push_back({ a, b, errorAB });
+				else
+					collapses.push_back({ b, a, errorBA });
+			}
+		}
+		if (collapses.empty())
+			break;
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+		// Triangles around every position, for the flip test
+		triangleOffsets.assign(vertexCount + 1, 0);
+		for (size_t i = 0; i < count; i++)
+			triangleOffsets[remap[destination[i]] + 1]++;
+		for (size_t v = 0; v < vertexCount; v++)
+			triangleOffsets[v + 1] += triangleOffsets[v];
+		triangleList.resize(count);
+		{
+			std::vector<unsigned int> cursor(triangleOffsets.begin(), triangleOffsets.end() - 1);
+			for (size_t i = 0; i < count; i++)
+				triangleList[cursor[remap[destination[i]]]++] = (unsigned int)(i / 3);
+		}
+
+		for (unsigned int v = 0; v < (unsigned int)vertexCount; v++)
+			collapseRemap[v] = v;
+		std::fill(collapseLocked.begin(), collapseLocked.end(), 0);
+
+		// Run the cheapest collapses that don't touch each other, a bit more than needed gets removed per pass at most
+		size_t trianglesToRemove = (count - targetIndexCount) / 3;
+		size_t trianglesRemoved = 0;
+		size_t collapsed = 0;
+		for (const Collapse& c : collapses)
+		{
+			if (c.error > maxError)
+				break;
+			unsigned int rv = remap[c.v], rt = remap[c.t];
+			if (collapseLocked[rv] || collapseLocked[rt])
+				continue;
+
+			//moving v must not flip any triangle that survives the collapse
+			bool flips = false;
+			const Vector3& target = verts[c.t];
+			for (unsigned int k = triangleOffsets[rv]; k < triangleOffsets[rv + 1] && !flips; k++)
+			{
+				const unsigned int* tri = &destination[triangleList[k] * 3];
+				unsigned int corners[3] = { collapseRemap[tri[0]], collapseRemap[tri[1]], collapseRemap[tri[2]] };
+				if (remap[corners[0]] == rt || remap[corners[1]] == rt || remap[corners[2]] == rt)
+					continue; //this one degenerates and is removed
+				Vector3 p[3] = { verts[corners[0]], verts[corners[1]], verts[corners[2]] };
+				Vector3 before = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+				for (int j = 0; j < 3; j++)
+					if (remap[corners[j]] == rv)
+						p[j] = target;
+				Vector3 after = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+				flips = Dot(before, after) <= 0.0f;
+			}
+			if (flips)
+				continue;
+
+			collapseRemap[c.v] = c.t;
+			if (kinds[c.v] == Seam)
+				collapseRemap[wedge[c.v]] = wedge[c.t];
+			AddQuadric(quadrics[rt], quadrics[rv]);
+			collapseLocked[rv] = collapseLocked[rt] = 1;
+			acceptedError = std::max(acceptedError, c.error);
+			collapsed++;
+
+			trianglesRemoved += kinds[c.v] == Border ? 1 : 2;
+			if (trianglesRemoved >= trianglesToRemove)
+				break;
+		}
+		if (collapsed == 0)
+			break;
+
+		// Apply, dropping triangles that lost an edge
+		size_t written = 0;
+		for (size_t i = 0; i < count; i += 3)
+		{
+			unsigned int a = collapseRemap[destination[i]], b = collapseRemap[destination[i + 1]], c = collapseRemap[destination[i + 2]];
+			if (remap[a] == remap[b] || remap[b] == remap[c] || remap[a] == remap[c])
+				continue;
+			destination[written++] = a;
+			destination[written++] = b;
+			destination[written++] = c;
+		}
+		count = written;
+	}
+
+	if (resultError)
+		*resultError = (float)sqrt(acceptedError);
+	return count;
+}
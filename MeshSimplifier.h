@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+
+// Quadric error metric edge collapse simplifier used to build LOD chains at import
+// - vertices are never moved or created, collapses snap one vertex onto a neighbour,
+//   so every LOD indexes the same vertex buffer as LOD0
+// - vertices that share a position but not uv/normal (seams) only collapse along the seam
+//   together with their twin, open borders only collapse along the border, anything more complex is locked
+namespace MeshSimplifier
+{
+	//writes at most indexCount indices to destination and returns how many were written
+	//stops at targetIndexCount or when the next collapse would move the surface further than targetError (mesh units)
+	//resultError receives the largest error that was accepted
+	size_t Simplify(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+		const float* positions, size_t vertexCount, size_t positionStride,
+		size_t targetIndexCount, float targetError, float* resultError = nullptr);
+}
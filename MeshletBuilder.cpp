@@ -0,0 +1,236 @@
+#include "MeshletBuilder.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace
+{
+	struct PositionKey
+	{
+		uint32_t x, y, z;
+		bool operator==(const PositionKey& o) const { return x == o.x && y == o.y && z == o.z; }
+	};
+
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& k) const
+		{
+			uint64_t h = k.x * 73856093ull ^ k.y * 19349663ull ^ k.z * 83492791ull;
+			return (size_t)(h ^ (h >> 29));
+		}
+	};
+
+	inline XMVECTOR LoadPosition(const float* positions, size_t positionStride, unsigned int index)
+	{
+		XMFLOAT3 p;
+		memcpy(&p, (const char*)positions + index * positionStride, sizeof(p));
+		return XMLoadFloat3(&p);
+	}
+
+	void ComputeBounds(Meshlet& meshlet, const unsigned int* indices, const float* positions, size_t positionStride)
+	{
+		const unsigned int* tris = indices + meshlet.firstIndex;
+		size_t indexCount = (size_t)meshlet.triangleCount * 3;
+
+		//sphere around the box center, radius is the farthest corner
+		XMVECTOR minV = LoadPosition(positions, positionStride, tris[0]);
+		XMVECTOR maxV = minV;
+		for (size_t i = 1; i < indexCount; i++)
+		{
+			XMVECTOR p = LoadPosition(positions, positionStride, tris[i]);
+			minV = XMVectorMin(minV, p);
+			maxV = XMVectorMax(maxV, p);
+		}
+		XMVECTOR center = XMVectorScale(XMVectorAdd(minV, maxV), 0.5f);
+		float radiusSq = 0.0f;
+		for (size_t i = 0; i < indexCount; i++)
+			radiusSq = std::max(radiusSq, XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(LoadPosition(positions, positionStride, tris[i]), center))));
+		XMStoreFloat3(&meshlet.center, center);
+		meshlet.radius = sqrtf(radiusSq);
+
+		//cone around the average face normal
+		//front faces are clockwise in a left handed space, so cross(p1 - p0, p2 - p0) points at the viewer
+		XMVECTOR normals[MESHLET_MAX_TRIANGLES];
+		size_t normalCount = 0;
+		XMVECTOR axis = XMVectorZero();
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			XMVECTOR p0 = LoadPosition(positions, positionStride, tris[i]);
+			XMVECTOR n = XMVector3Cross(XMVectorSubtract(LoadPosition(positions, positionStride, tris[i + 1]), p0), XMVectorSubtract(LoadPosition(positions, positionStride, tris[i + 2]), p0));
+			if (XMVectorGetX(XMVector3LengthSq(n)) == 0.0f)
+				continue; //degenerate, it never shows up anyway
+			n = XMVector3Normalize(n);
+			normals[normalCount++] = n;
+			axis = XMVectorAdd(axis, n);
+		}
+
+		meshlet.coneAxis = XMFLOAT3(0, 0, 0);
+		meshlet.coneCutoff = 1.0f;
+		if (normalCount == 0 || XMVectorGetX(XMVector3LengthSq(axis)) < 1e-12f)
+			return;
+		axis = XMVector3Normalize(axis);
+		float minDot = 1.0f;
+		for (size_t i = 0; i < normalCount; i++)
+			minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(axis, normals[i])));
+		XMStoreFloat3(&meshlet.coneAxis, axis);
+		//the cone spans acos(minDot), a viewer has to be more than 90 degrees from every normal so the cutoff is its sine
+		if (minDot > 0.0f)
+			meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+}
+
+void MeshletBuilder::Build(unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+	std::vector<Meshlet>& meshlets, unsigned int maxVertices, unsigned int maxTriangles)
+{
+	meshlets.clear();
+	maxTriangles = std::min(maxTriangles, MESHLET_MAX_TRIANGLES);
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles are connected through shared positions rather than shared vertices,
+	// otherwise every hard edge or uv seam would split the mesh into islands
+	std::vector<unsigned int> remap(vertexCount);
+	{
+		std::unordered_map<PositionKey, unsigned int, PositionKeyHash> firstAtPosition;
+		firstAtPosition.reserve(vertexCount);
+		for (unsigned int v = 0; v < (unsigned int)vertexCount; v++)
+		{
+			PositionKey key;
+			memcpy(&key, (const char*)positions + v * positionStride, sizeof(key));
+			remap[v] = firstAtPosition.emplace(key, v).first->second;
+		}
+	}
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		offsets[remap[indices[i]] + 1]++;
+	for (size_t v = 0; v < vertexCount; v++)
+		offsets[v + 1] += offsets[v];
+	std::vector<unsigned int> adjacentTriangles(triangleCount * 3);
+	{
+		std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+			adjacentTriangles[cursor[remap[indices[i]]]++] = (unsigned int)(i / 3);
+	}
+
+	std::vector<XMFLOAT3> triangleNormals(triangleCount), triangleCentroids(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		XMVECTOR p0 = LoadPosition(positions, positionStride, indices[t * 3]);
+		XMVECTOR p1 = LoadPosition(positions, positionStride, indices[t * 3 + 1]);
+		XMVECTOR p2 = LoadPosition(positions, positionStride, indices[t * 3 + 2]);
+		XMStoreFloat3(&triangleNormals[t], XMVector3Normalize(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0))));
+		XMStoreFloat3(&triangleCentroids[t], XMVectorScale(XMVectorAdd(XMVectorAdd(p0, p1), p2), 1.0f / 3.0f));
+	}
+
+	std::vector<unsigned int> ordered;
+	ordered.reserve(triangleCount * 3);
+	std::vector<char> used(triangleCount, 0);
+	std::vector<unsigned int> lastMeshlet(vertexCount, ~0u); //which meshlet last took each vertex
+	std::vector<unsigned int> meshletPositions;
+	unsigned int meshletId = 0;
+	size_t seed = 0;
+
+	auto newVertexCount = [&](size_t t)
+	{
+		const unsigned int* tri = &indices[t * 3];
+		unsigned int count = 0;
+		for (int k = 0; k < 3; k++)
+			count += lastMeshlet[tri[k]] != meshletId && (k == 0 || tri[k] != tri[0]) && (k < 2 || tri[k] != tri[1]);
+		return count;
+	};
+
+	while (ordered.size() < triangleCount * 3)
+	{
+		// Each meshlet starts at the first free triangle in the incoming (cache optimized) order
+		// and grows over its neighbours, preferring triangles that add no vertices, then ones that
+		// are close by and face the same way so the bounding sphere and normal cone stay tight
+		while (used[seed])
+			seed++;
+		Meshlet meshlet = {};
+		meshlet.firstIndex = (unsigned int)ordered.size();
+		unsigned int vertices = 0;
+		XMVECTOR axisSum = XMVectorZero();
+		XMVECTOR centroidSum = XMVectorZero();
+		meshletPositions.clear();
+		size_t next = seed;
+
+		while (next != SIZE_MAX)
+		{
+			const unsigned int* tri = &indices[next * 3];
+			vertices += newVertexCount(next);
+			for (int k = 0; k < 3; k++)
+			{
+				if (lastMeshlet[tri[k]] != meshletId)
+					meshletPositions.push_back(remap[tri[k]]);
+				lastMeshlet[tri[k]] = meshletId;
+				ordered.push_back(tri[k]);
+			}
+			used[next] = 1;
+			meshlet.triangleCount++;
+			axisSum = XMVectorAdd(axisSum, XMLoadFloat3(&triangleNormals[next]));
+			centroidSum = XMVectorAdd(centroidSum, XMLoadFloat3(&triangleCentroids[next]));
+			if (meshlet.triangleCount == maxTriangles)
+				break;
+
+			XMVECTOR axis = XMVector3Normalize(axisSum);
+			XMVECTOR center = XMVectorScale(centroidSum, 1.0f / meshlet.triangleCount);
+			next = SIZE_MAX;
+			unsigned int bestExtra = 4;
+			float bestScore = FLT_MAX;
+			for (unsigned int position : meshletPositions)
+			{
+				for (unsigned int k = offsets[position]; k < offsets[position + 1]; k++)
+				{
+					unsigned int t = adjacentTriangles[k];
+					if (used[t])
+						continue;
+					unsigned int extra = newVertexCount(t);
+					if (vertices + extra > maxVertices || extra > bestExtra)
+						continue;
+					float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&triangleCentroids[t]), center)));
+					float score = distance * (2.0f - XMVectorGetX(XMVector3Dot(XMLoadFloat3(&triangleNormals[t]), axis)));
+					if (extra < bestExtra || score < bestScore)
+					{
+						next = t;
+						bestExtra = extra;
+						bestScore = score;
+					}
+				}
+			}
+		}
+
+		ComputeBounds(meshlet, ordered.data(), positions, positionStride);
+		meshlets.push_back(meshlet);
+		meshletId++;
+	}
+
+	memcpy(indices, ordered.data(), ordered.size() * sizeof(unsigned int));
+}
+
+void MeshletBuilder::GetBounds(const Meshlet* meshlets, size_t count, MeshletBounds& bounds)
+{
+	size_t padded = (count + 3) & ~(size_t)3;
+	bounds.count = count;
+	for (std::vector<float>* column : { &bounds.centerX, &bounds.centerY, &bounds.centerZ, &bounds.radius, &bounds.axisX, &bounds.axisY, &bounds.axisZ })
+		column->assign(padded, 0.0f);
+	bounds.cutoff.assign(padded, 2.0f); //padding lanes are ignored, a cutoff over 1 just keeps them out of the cone test
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const Meshlet& m = meshlets[i];
+		bounds.centerX[i] = m.center.x;
+		bounds.centerY[i] = m.center.y;
+		bounds.centerZ[i] = m.center.z;
+		bounds.radius[i] = m.radius;
+		bounds.axisX[i] = m.coneAxis.x;
+		bounds.axisY[i] = m.coneAxis.y;
+		bounds.axisZ[i] = m.coneAxis.z;
+		bounds.cutoff[i] = m.coneCutoff;
+	}
+}
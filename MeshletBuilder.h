@@ -0,0 +1,40 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <vector>
+
+constexpr unsigned int MESHLET_MAX_VERTICES = 64;
+constexpr unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+// A small cluster of triangles, a contiguous range of the mesh's index buffer
+// The bounds are in mesh space:
+// - center/radius: bounding sphere for frustum culling
+// - coneAxis/coneCutoff: every triangle normal is within the cone, when the viewer is behind it
+//   (dot(normalize(center - viewer), coneAxis) >= coneCutoff + radius / distance) the whole cluster faces away
+struct Meshlet
+{
+	unsigned int firstIndex;
+	unsigned int triangleCount;
+	DirectX::XMFLOAT3 center;
+	float radius;
+	DirectX::XMFLOAT3 coneAxis;
+	float coneCutoff; //1 or more means the cone is too wide to ever cull
+};
+
+//meshlet bounds split into arrays for the simd culling pass, padded to a multiple of 4
+struct MeshletBounds
+{
+	std::vector<float> centerX, centerY, centerZ, radius;
+	std::vector<float> axisX, axisY, axisZ, cutoff;
+	size_t count = 0; //real meshlets, the rest is padding
+};
+
+namespace MeshletBuilder
+{
+	//groups neighbouring triangles into meshlets and reorders the index buffer so each one is a contiguous range
+	//meshlets are started in the incoming triangle order, so run it after the vertex cache optimization
+	void Build(unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+		std::vector<Meshlet>& meshlets, unsigned int maxVertices = MESHLET_MAX_VERTICES, unsigned int maxTriangles = MESHLET_MAX_TRIANGLES);
+
+	void GetBounds(const Meshlet* meshlets, size_t count, MeshletBounds& bounds);
+}
@@ -0,0 +1,343 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+using namespace DirectX;
+
+namespace
+{
+	//chunks smaller than this are not worth a thread
+	constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+
+	//per thread output, merged in file order once every chunk is done
+	struct ObjChunk
+	{
+		const char* begin = nullptr;
+		const char* end = nullptr;
+
+		std::vector<XMFLOAT3> positions;
+		std::vector<XMFLOAT2> uvs;
+		std::vector<XMFLOAT3> normals;
+		std::vector<ObjIndex> faces;
+
+		//negative indices are relative to the attributes read so far, which depends on the chunks before this one
+		//they are stored chunk local and listed here so the merge can add the base offsets (corner * 3 + attribute)
+		std::vector<size_t> relativeSlots;
+	};
+
+	//exact powers of ten a double can hold
+	constexpr double POW10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	inline bool IsSpace(char c) { return c == ' ' || c == '\t'; }
+	inline bool IsDigit(char c) { return (unsigned char)(c - '0') < 10; }
+
+	inline const char* SkipSpaces(const char* p, const char* end)
+	{
+		while (p < end && IsSpace(*p)) ++p;
+		return p;
+	}
+
+	inline const char* SkipLine(const char* p, const char* end)
+	{
+		const char* newline = (const char*)memchr(p, '\n', end - p);
+		return newline ? newline + 1 : end;
+	}
+
+	//decimal float with optional sign, fraction and exponent, good to within an ulp of a float
+	const char* ParseFloat(const char* p, const char* end, float& out)
+	{
+		p = SkipSpaces(p, end);
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			++p;
+		}
+
+		uint64_t mantissa = 0;
+		int exponent = 0;
+		int digits = 0;
+		while (p < end && IsDigit(*p))
+		{
+			if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); ++digits; }
+			else ++exponent; //too many digits to hold, just keep the magnitude
+			++p;
+		}
+		if (p < end && *p == '.')
+		{
+			++p;
+			while (p < end && IsDigit(*p))
+			{
+				if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); ++digits; --exponent; }
+				++p;
+			}
+		}
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			++p;
+			bool negativeExponent = false;
+			if (p < end && (*p == '-' || *p == '+'))
+			{
+				negativeExponent = *p == '-';
+				++p;
+			}
+			int e = 0;
+			while (p < end && IsDigit(*p))
+			{
+				if (e < 10000) e = e * 10 + (*p - '0');
+				++p;
+			}
+			exponent += negativeExponent ? -e : e;
+		}
+
+		double value = (double)mantissa;
+		if (exponent < 0)
+			value = exponent >= -22 ? value / POW10[-exponent] : value * std::pow(10.0, exponent);
+		else if (exponent > 0)
+			value = exponent <= 22 ? value * POW10[exponent] : value * std::pow(10.0, exponent);
+
+		out = (float)(negative ? -value : value);
+		return p;
+	}
+
+	inline const char* ParseInt(const char* p, const char* end, int& out)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			++p;
+		}
+		int value = 0;
+		while (p < end && IsDigit(*p))
+		{
+			value = value * 10 + (*p - '0');
+			++p;
+		}
+		out = negative ? -value : value;
+		return p;
+	}
+
+	//turns a 1 based (or negative relative) obj index into a 0 based one
+	//returns true when the index was relative and needs the chunk base offset added later
+	inline bool ResolveIndex(int raw, size_t localCount, int& out)
+	{
+		if (raw > 0) { out = raw - 1; return false; }
+		if (raw < 0) { out = (int)localCount + raw; return true; }
+		out = -1; //0 is not a valid obj index, treat it as missing
+		return false;
+	}
+
+	void ParseChunk(ObjChunk& chunk)
+	{
+		const char* p = chunk.begin;
+		const char* end = chunk.end;
+
+		//rough guess so the common case does not reallocate much, assumes ~30 bytes a line
+		size_t lineEstimate = (end - p) / 30;
+		chunk.positions.reserve(lineEstimate / 4);
+		chunk.normals.reserve(lineEstimate / 4);
+		chunk.uvs.reserve(lineEstimate / 4);
+		chunk.faces.reserve(lineEstimate / 2 * 3);
+
+		//corners of the polygon on the current line
+		std::vector<ObjIndex> polygon;
+		std::vector<unsigned char> polygonRelative; //bit per attribute
+
+		while (p < end)
+		{
+			p = SkipSpaces(p, end);
+			if (p >= end) break;
+
+			if (p[0] == 'v' && p + 1 < end)
+			{
+				if (IsSpace(p[1]))
+				{
+					XMFLOAT3 pos;
+					p = ParseFloat(p + 1, end, pos.x);
+					p = ParseFloat(p, end, pos.y);
+					p = ParseFloat(p, end, pos.z);
+					chunk.positions.push_back(pos);
+				}
+				else if (p[1] == 't' && p + 2 < end && IsSpace(p[2]))
+				{
+					XMFLOAT2 uv;
+					p = ParseFloat(p + 2, end, uv.x);
+					p = ParseFloat(p, end, uv.y);
+					chunk.uvs.push_back(uv);
+				}
+				else if (p[1] == 'n' && p + 2 < end && IsSpace(p[2]))
+				{
+					XMFLOAT3 norm;
+					p = ParseFloat(p + 2, end, norm.x);
+					p = ParseFloat(p, end, norm.y);
+					p = ParseFloat(p, end, norm.z);
+					chunk.normals.push_back(norm);
+				}
+			}
+			else if (p[0] == 'f' && p + 1 < end && IsSpace(p[1]))
+			{
+				polygon.clear();
+				polygonRelative.clear();
+				++p;
+				while (true)
+				{
+					p = SkipSpaces(p, end);
+					if (p >= end || !(IsDigit(*p) || *p == '-' || *p == '+'))
+						break;
+
+					int raw[3] = { 0, 0, 0 };
+					p = ParseInt(p, end, raw[0]);
+					if (p < end && *p == '/')
+					{
+						++p;
+						if (p < end && *p != '/') p = ParseInt(p, end, raw[1]); //v/vt
+						if (p < end && *p == '/') p = ParseInt(p + 1, end, raw[2]); //v//vn or v/vt/vn
+					}
+
+					ObjIndex corner;
+					unsigned char relative = 0;
+					if (ResolveIndex(raw[0], chunk.positions.size(), corner.Position)) relative |= 1;
+					if (ResolveIndex(raw[1], chunk.uvs.size(), corner.UV)) relative |= 2;
+					if (ResolveIndex(raw[2], chunk.normals.size(), corner.Normal)) relative |= 4;
+					polygon.push_back(corner);
+					polygonRelative.push_back(relative);
+				}
+
+				//fan triangulate, quads become (0,1,2) (0,2,3) like the old loader
+				for (size_t i = 2; i < polygon.size(); i++)
+				{
+					const size_t corners[3] = { 0, i - 1, i };
+					for (size_t c : corners)
+					{
+						if (polygonRelative[c])
+						{
+							size_t slot = chunk.faces.size() * 3;
+							if (polygonRelative[c] & 1) chunk.relativeSlots.push_back(slot + 0);
+							if (polygonRelative[c] & 2) chunk.relativeSlots.push_back(slot + 1);
+							if (polygonRelative[c] & 4) chunk.relativeSlots.push_back(slot + 2);
+						}
+						chunk.faces.push_back(polygon[c]);
+					}
+				}
+			}
+
+			//anything else (comments, groups, materials) or the rest of a parsed line is skipped
+			p = SkipLine(p, end);
+		}
+	}
+}
+
+bool ObjParser::Parse(const std::wstring& objFile, ObjData& out, unsigned int threadCount)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	MappedFile file(objFile);
+	if (!file.IsOpen())
+		return false;
+
+	bool result = ParseMemory(file.Data(), file.Size(), out, threadCount);
+
+	//include the mapping cost in the reported time
+	out.parseMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return result;
+}
+
+bool ObjParser::ParseMemory(const char* data, size_t size, ObjData& out, unsigned int threadCount)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	out = ObjData();
+
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+	size_t maxChunks = size / MIN_CHUNK_BYTES + 1;
+	if (threadCount > maxChunks)
+		threadCount = (unsigned int)maxChunks;
+
+	//split into roughly equal chunks, moving each boundary forward to the start of the next line
+	std::vector<ObjChunk> chunks(threadCount);
+	const char* end = data + size;
+	const char* cursor = data;
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		chunks[i].begin = cursor;
+		if (i == threadCount - 1)
+			cursor = end;
+		else
+		{
+			const char* target = data + size / threadCount * (i + 1);
+			cursor = target < cursor ? cursor : SkipLine(target, end);
+		}
+		chunks[i].end = cursor;
+	}
+
+	if (threadCount == 1)
+		ParseChunk(chunks[0]);
+	else
+	{
+		std::vector<std::thread> workers;
+		workers.reserve(threadCount - 1);
+		for (unsigned int i = 1; i < threadCount; i++)
+			workers.emplace_back(ParseChunk, std::ref(chunks[i]));
+		ParseChunk(chunks[0]); //main thread does its share too
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	//merge in file order
+	size_t positionCount = 0, uvCount = 0, normalCount = 0, cornerCount = 0;
+	for (auto& chunk : chunks)
+	{
+		positionCount += chunk.positions.size();
+		uvCount += chunk.uvs.size();
+		normalCount += chunk.normals.size();
+		cornerCount += chunk.faces.size();
+	}
+	out.positions.reserve(positionCount);
+	out.uvs.reserve(uvCount);
+	out.normals.reserve(normalCount);
+	out.faces.reserve(cornerCount);
+
+	for (auto& chunk : chunks)
+	{
+		size_t firstCorner = out.faces.size();
+		const int bases[3] = { (int)out.positions.size(), (int)out.uvs.size(), (int)out.normals.size() };
+
+		out.positions.insert(out.positions.end(), chunk.positions.begin(), chunk.positions.end());
+		out.uvs.insert(out.uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+		out.normals.insert(out.normals.end(), chunk.normals.begin(), chunk.normals.end());
+		out.faces.insert(out.faces.end(), chunk.faces.begin(), chunk.faces.end());
+
+		//absolute indices are already global, only relative ones depend on earlier chunks
+		for (size_t slot : chunk.relativeSlots)
+		{
+			ObjIndex& corner = out.faces[firstCorner + slot / 3];
+			int attribute = (int)(slot % 3);
+			int* index = attribute == 0 ? &corner.Position : attribute == 1 ? &corner.UV : &corner.Normal;
+			*index += bases[attribute];
+		}
+	}
+
+	//drop corners that point outside the file's data rather than crashing later
+	const size_t counts[3] = { out.positions.size(), out.uvs.size(), out.normals.size() };
+	for (auto& corner : out.faces)
+	{
+		if (corner.Position < 0 || (size_t)corner.Position >= counts[0]) corner.Position = -1;
+		if (corner.UV < 0 || (size_t)corner.UV >= counts[1]) corner.UV = -1;
+		if (corner.Normal < 0 || (size_t)corner.Normal >= counts[2]) corner.Normal = -1;
+	}
+
+	out.threadsUsed = threadCount;
+	out.parseMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return true;
+}
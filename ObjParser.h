@@ -0,0 +1,39 @@
+#pragma once
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+//one corner of a face, indices are 0 based and -1 when the file did not provide that attribute
+struct ObjIndex
+{
+	int Position;
+	int UV;
+	int Normal;
+};
+
+//raw attribute streams of an .obj file
+//faces are already triangulated (fan) and keep the winding of the file, 3 corners per triangle
+struct ObjData
+{
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<DirectX::XMFLOAT2> uvs;
+	std::vector<DirectX::XMFLOAT3> normals;
+	std::vector<ObjIndex> faces;
+
+	double parseMilliseconds = 0.0;
+	unsigned int threadsUsed = 0;
+
+	size_t TriangleCount() const { return faces.size() / 3; }
+};
+
+// Memory mapped, multi-threaded .obj reader
+// - the file is split into line aligned chunks that are parsed in parallel
+// - numbers are read with hand written parsers instead of sscanf
+// - supports v, vt, vn and f with v, v/vt, v//vn and v/vt/vn corners, negative (relative) indices and n-gons
+// - no windows or d3d dependencies so it can run headless
+namespace ObjParser
+{
+	//threadCount of 0 picks std::thread::hardware_concurrency()
+	bool Parse(const std::wstring& objFile, ObjData& out, unsigned int threadCount = 0);
+	bool ParseMemory(const char* data, size_t size, ObjData& out, unsigned int threadCount = 0);
+}
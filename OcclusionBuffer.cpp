@@ -0,0 +1,371 @@
+#include "OcclusionBuffer.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr uint32_t FULL_COVERAGE = 0xFFFFFFFFu;
+
+	//clip space to pixels (y down) and z/w
+	inline XMFLOAT3 ToScreen(const XMFLOAT4& clip, float width, float height)
+	{
+		float invW = 1.0f / clip.w;
+		return XMFLOAT3((clip.x * invW * 0.5f + 0.5f) * width, (0.5f - clip.y * invW * 0.5f) * height, clip.z * invW);
+	}
+
+	inline XMFLOAT4 Lerp(const XMFLOAT4& a, const XMFLOAT4& b, float t)
+	{
+		return XMFLOAT4(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t);
+	}
+
+	//first and last pixel whose center is in [min, max], clamped to [0, size - 1], first > last when there are none
+	//(clamped as floats first, clip space can get huge close to the near plane)
+	inline void PixelRange(float min, float max, unsigned int size, int& first, int& last)
+	{
+		first = (int)std::ceil(std::clamp(min - 0.5f, -1.0f, (float)size));
+		last = (int)std::floor(std::clamp(max - 0.5f, -1.0f, (float)size));
+		first = std::max(first, 0);
+		last = std::min(last, (int)size - 1);
+	}
+}
+
+OccluderMesh OccluderMesh::Box(XMFLOAT3 min, XMFLOAT3 max)
+{
+	OccluderMesh box;
+	//corner i takes max on x for bit 0, y for bit 1, z for bit 2
+	for (unsigned int i = 0; i < 8; i++)
+		box.positions.push_back(XMFLOAT3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z));
+	//each face clockwise seen from outside: bottom left, top left, top right, bottom right
+	const uint32_t faces[6][4] =
+	{
+		{ 0, 2, 3, 1 }, //-z
+		{ 5, 7, 6, 4 }, //+z
+		{ 4, 6, 2, 0 }, //-x
+		{ 1, 3, 7, 5 }, //+x
+		{ 1, 5, 4, 0 }, //-y
+		{ 2, 6, 7, 3 }, //+y
+	};
+	for (const uint32_t* face : faces)
+	{
+		box.indices.insert(box.indices.end(), { face[0], face[1], face[2] });
+		box.indices.insert(box.indices.end(), { face[0], face[2], face[3] });
+	}
+	return box;
+}
+
+OcclusionBuffer::OcclusionBuffer(unsigned int width, unsigned int height)
+{
+	tilesX = std::max((width + TILE_WIDTH - 1) / TILE_WIDTH, 1u);
+	tilesY = std::max((height + TILE_HEIGHT - 1) / TILE_HEIGHT, 1u);
+	this->width = tilesX * TILE_WIDTH;
+	this->height = tilesY * TILE_HEIGHT;
+	blocksX = this->width / BLOCK_WIDTH;
+	blocksY = this->height / BLOCK_HEIGHT;
+
+	zMax0.resize(blocksX * blocksY);
+	zMax1.resize(blocksX * blocksY);
+	coverage.resize(blocksX * blocksY);
+	tileZMax.resize(tilesX * tilesY);
+	bins.resize(tilesX * tilesY);
+	Clear();
+}
+
+void OcclusionBuffer::Clear()
+{
+	std::fill(zMax0.begin(), zMax0.end(), 1.0f);
+	std::fill(zMax1.begin(), zMax1.end(), 0.0f);
+	std::fill(coverage.begin(), coverage.end(), 0u);
+	std::fill(tileZMax.begin(), tileZMax.end(), 1.0f);
+	triangles.clear();
+	for (std::vector<uint32_t>& bin : bins)
+		bin.clear();
+	triangleCount = 0;
+}
+
+void OcclusionBuffer::RenderOccluder(const OccluderMesh& mesh, const XMFLOAT4X4& worldViewProjection)
+{
+	XMMATRIX matrix = XMLoadFloat4x4(&worldViewProjection);
+	clipVertices.resize(mesh.positions.size());
+	for (size_t i = 0; i < mesh.positions.size(); i++)
+		XMStoreFloat4(&clipVertices[i], XMVector3Transform(XMLoadFloat3(&mesh.positions[i]), matrix));
+
+	float w = (float)width;
+	float h = (float)height;
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		const XMFLOAT4* corners[3] = { &clipVertices[mesh.indices[i]], &clipVertices[mesh.indices[i + 1]], &clipVertices[mesh.indices[i + 2]] };
+		unsigned int inFront = (corners[0]->z >= 0.0f) + (corners[1]->z >= 0.0f) + (corners[2]->z >= 0.0f);
+		if (inFront == 0)
+			continue;
+		//past the far plane entirely, nothing behind it is drawn either
+		if (corners[0]->z > corners[0]->w && corners[1]->z > corners[1]->w && corners[2]->z > corners[2]->w)
+			continue;
+		if (inFront == 3)
+		{
+			AddTriangle(ToScreen(*corners[0], w, h), ToScreen(*corners[1], w, h), ToScreen(*corners[2], w, h));
+			continue;
+		}
+
+		//crosses the near plane (z = 0 in d3d clip space), cut it there, leaves a triangle or a quad
+		XMFLOAT3 polygon[4];
+		unsigned int count = 0;
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			const XMFLOAT4& a = *corners[j];
+			const XMFLOAT4& b = *corners[(j + 1) % 3];
+			if (a.z >= 0.0f)
+				polygon[count++] = ToScreen(a, w, h);
+			if ((a.z >= 0.0f) != (b.z >= 0.0f))
+				polygon[count++] = ToScreen(Lerp(a, b, a.z / (a.z - b.z)), w, h);
+		}
+		for (unsigned int j = 2; j < count; j++)
+			AddTriangle(polygon[0], polygon[j - 1], polygon[j]);
+	}
+}
+
+void OcclusionBuffer::AddTriangle(XMFLOAT3 v0, XMFLOAT3 v1, XMFLOAT3 v2)
+{
+	//clockwise on screen (y down) is positive, anything else faces away or is edge on
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+	if (!(area > 0.0f))
+		return;
+
+	Triangle triangle;
+	PixelRange(std::min({ v0.x, v1.x, v2.x }), std::max({ v0.x, v1.x, v2.x }), width, triangle.minX, triangle.maxX);
+	PixelRange(std::min({ v0.y, v1.y, v2.y }), std::max({ v0.y, v1.y, v2.y }), height, triangle.minY, triangle.maxY);
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		return;
+
+	const XMFLOAT3* vertices[3] = { &v0, &v1, &v2 };
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		const XMFLOAT3& from = *vertices[i];
+		const XMFLOAT3& to = *vertices[(i + 1) % 3];
+		triangle.edgeA[i] = from.y - to.y;
+		triangle.edgeB[i] = to.x - from.x;
+		triangle.edgeC[i] = -(triangle.edgeA[i] * from.x + triangle.edgeB[i] * from.y);
+	}
+	triangle.depthA = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	triangle.depthB = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+	triangle.depthC = v0.z - triangle.depthA * v0.x - triangle.depthB * v0.y;
+	triangle.zMin = std::clamp(std::min({ v0.z, v1.z, v2.z }), 0.0f, 1.0f);
+	triangle.zMax = std::clamp(std::max({ v0.z, v1.z, v2.z }), 0.0f, 1.0f);
+
+	uint32_t index = (uint32_t)triangles.size();
+	triangles.push_back(triangle);
+	triangleCount++;
+	for (unsigned int y = triangle.minY / TILE_HEIGHT; y <= triangle.maxY / TILE_HEIGHT; y++)
+		for (unsigned int x = triangle.minX / TILE_WIDTH; x <= triangle.maxX / TILE_WIDTH; x++)
+			bins[y * tilesX + x].push_back(index);
+}
+
+void OcclusionBuffer::Flush(ThreadPool* pool)
+{
+	for (unsigned int tile = 0; tile < tilesX * tilesY; tile++)
+	{
+		if (bins[tile].empty())
+			continue;
+		//tiles share nothing, so each one is a job of its own
+		if (pool)
+			pool->Submit([this, tile]() { RasterizeTile(tile); });
+		else
+			RasterizeTile(tile);
+	}
+	if (pool)
+		pool->Wait();
+
+	triangles.clear();
+	for (std::vector<uint32_t>& bin : bins)
+		bin.clear();
+}
+
+void OcclusionBuffer::RasterizeTile(unsigned int tile)
+{
+	int tileX = (int)(tile % tilesX * TILE_WIDTH);
+	int tileY = (int)(tile / tilesX * TILE_HEIGHT);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 columns = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+	for (uint32_t index : bins[tile])
+	{
+		const Triangle& triangle = triangles[index];
+		int firstBlockX = std::max(triangle.minX, tileX) / (int)BLOCK_WIDTH;
+		int lastBlockX = std::min(triangle.maxX, tileX + (int)TILE_WIDTH - 1) / (int)BLOCK_WIDTH;
+		int firstBlockY = std::max(triangle.minY, tileY) / (int)BLOCK_HEIGHT;
+		int lastBlockY = std::min(triangle.maxY, tileY + (int)TILE_HEIGHT - 1) / (int)BLOCK_HEIGHT;
+
+		//the edge functions step by a per pixel across and b per row, these are the 4 lane steps
+		__m128 edgeStepX[3], edgeStepX4[3], edgeStepY[3];
+		for (unsigned int e = 0; e < 3; e++)
+		{
+			edgeStepX[e] = _mm_mul_ps(_mm_set1_ps(triangle.edgeA[e]), columns);
+			edgeStepX4[e] = _mm_set1_ps(triangle.edgeA[e] * 4.0f);
+			edgeStepY[e] = _mm_set1_ps(triangle.edgeB[e]);
+		}
+
+		for (int blockY = firstBlockY; blockY <= lastBlockY; blockY++)
+		{
+			for (int blockX = firstBlockX; blockX <= lastBlockX; blockX++)
+			{
+				unsigned int block = blockY * blocksX + blockX;
+				//plane is linear, so its range over the block's pixel centers is at the corners
+				float left = blockX * BLOCK_WIDTH + 0.5f;
+				float top = blockY * BLOCK_HEIGHT + 0.5f;
+				float right = left + (BLOCK_WIDTH - 1);
+				float bottom = top + (BLOCK_HEIGHT - 1);
+				float nearest = triangle.depthC + triangle.depthA * (triangle.depthA > 0.0f ? left : right) + triangle.depthB * (triangle.depthB > 0.0f ? top : bottom);
+				float farthest = triangle.depthC + triangle.depthA * (triangle.depthA > 0.0f ? right : left) + triangle.depthB * (triangle.depthB > 0.0f ? bottom : top);
+				nearest = std::max(nearest, triangle.zMin);
+				farthest = std::min(farthest, triangle.zMax);
+				//behind everything already in the block, can't make it any nearer
+				if (nearest >= zMax0[block])
+					continue;
+
+				__m128 rowStart[3];
+				for (unsigned int e = 0; e < 3; e++)
+					rowStart[e] = _mm_add_ps(_mm_set1_ps(triangle.edgeA[e] * left + triangle.edgeB[e] * top + triangle.edgeC[e]), edgeStepX[e]);
+				uint32_t mask = 0;
+				for (unsigned int row = 0; row < BLOCK_HEIGHT; row++)
+				{
+					__m128 leftHalf = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(rowStart[0], zero), _mm_cmpge_ps(rowStart[1], zero)), _mm_cmpge_ps(rowStart[2], zero));
+					__m128 rightHalf = _mm_and_ps(_mm_and_ps(
+						_mm_cmpge_ps(_mm_add_ps(rowStart[0], edgeStepX4[0]), zero),
+						_mm_cmpge_ps(_mm_add_ps(rowStart[1], edgeStepX4[1]), zero)),
+						_mm_cmpge_ps(_mm_add_ps(rowStart[2], edgeStepX4[2]), zero));
+					mask |= (uint32_t)(_mm_movemask_ps(leftHalf) | _mm_movemask_ps(rightHalf) << 4) << (row * BLOCK_WIDTH);
+					for (unsigned int e = 0; e < 3; e++)
+						rowStart[e] = _mm_add_ps(rowStart[e], edgeStepY[e]);
+				}
+				if (!mask)
+					continue;
+
+				//the covered pixels end up at this depth or nearer, whichever of the triangle and the block is in front
+				float triangleZ = std::min(farthest, zMax0[block]);
+				if (mask == FULL_COVERAGE)
+				{
+					zMax0[block] = triangleZ;
+					zMax1[block] = 0.0f;
+					coverage[block] = 0;
+					continue;
+				}
+				//a triangle much nearer than the working layer starts a new one instead of dragging it back
+				if (zMax1[block] - triangleZ > zMax0[block] - zMax1[block])
+				{
+					zMax1[block] = 0.0f;
+					coverage[block] = 0;
+				}
+				zMax1[block] = std::max(zMax1[block], triangleZ);
+				coverage[block] |= mask;
+				if (coverage[block] == FULL_COVERAGE)
+				{
+					zMax0[block] = zMax1[block];
+					zMax1[block] = 0.0f;
+					coverage[block] = 0;
+				}
+			}
+		}
+	}
+
+	float farthest = 0.0f;
+	unsigned int firstBlockX = tileX / BLOCK_WIDTH;
+	unsigned int firstBlockY = tileY / BLOCK_HEIGHT;
+	for (unsigned int y = firstBlockY; y < firstBlockY + TILE_HEIGHT / BLOCK_HEIGHT; y++)
+		for (unsigned int x = firstBlockX; x < firstBlockX + TILE_WIDTH / BLOCK_WIDTH; x++)
+			farthest = std::max(farthest, zMax0[y * blocksX + x]);
+	tileZMax[tile] = farthest;
+}
+
+bool OcclusionBuffer::IsOccluded(const Aabb& box, const XMFLOAT4X4& viewProjection) const
+{
+	XMMATRIX matrix = XMLoadFloat4x4(&viewProjection);
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	float nearest = FLT_MAX;
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		XMVECTOR corner = XMVectorSet(i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z, 1.0f);
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector3Transform(corner, matrix));
+		if (clip.z < 0.0f)
+			return false;
+		XMFLOAT3 screen = ToScreen(clip, (float)width, (float)height);
+		minX = std::min(minX, screen.x);
+		maxX = std::max(maxX, screen.x);
+		minY = std::min(minY, screen.y);
+		maxY = std::max(maxY, screen.y);
+		nearest = std::min(nearest, screen.z);
+	}
+
+	int firstX, lastX, firstY, lastY;
+	PixelRange(minX, maxX, width, firstX, lastX);
+	PixelRange(minY, maxY, height, firstY, lastY);
+	//off screen (or between pixel centers), that's for frustum culling to decide
+	if (firstX > lastX || firstY > lastY)
+		return false;
+
+	for (int tileY = firstY / (int)TILE_HEIGHT; tileY <= lastY / (int)TILE_HEIGHT; tileY++)
+	{
+		for (int tileX = firstX / (int)TILE_WIDTH; tileX <= lastX / (int)TILE_WIDTH; tileX++)
+		{
+			if (nearest > tileZMax[tileY * tilesX + tileX])
+				continue;
+
+			int firstBlockX = std::max(firstX, tileX * (int)TILE_WIDTH) / (int)BLOCK_WIDTH;
+			int lastBlockX = std::min(lastX, (tileX + 1) * (int)TILE_WIDTH - 1) / (int)BLOCK_WIDTH;
+			int firstBlockY = std::max(firstY, tileY * (int)TILE_HEIGHT) / (int)BLOCK_HEIGHT;
+			int lastBlockY = std::min(lastY, (tileY + 1) * (int)TILE_HEIGHT - 1) / (int)BLOCK_HEIGHT;
+			for (int blockY = firstBlockY; blockY <= lastBlockY; blockY++)
+			{
+				for (int blockX = firstBlockX; blockX <= lastBlockX; blockX++)
+				{
+					unsigned int block = blockY * blocksX + blockX;
+					if (nearest > zMax0[block])
+						continue;
+					//still hidden if the working layer covers every pixel of the box in this block and is in front of it
+					int columnFrom = std::max(firstX - blockX * (int)BLOCK_WIDTH, 0);
+					int columnTo = std::min(lastX - blockX * (int)BLOCK_WIDTH, (int)BLOCK_WIDTH - 1);
+					int rowFrom = std::max(firstY - blockY * (int)BLOCK_HEIGHT, 0);
+					int rowTo = std::min(lastY - blockY * (int)BLOCK_HEIGHT, (int)BLOCK_HEIGHT - 1);
+					uint32_t rowMask = ((1u << (columnTo + 1)) - 1) & ~((1u << columnFrom) - 1);
+					uint32_t boxMask = 0;
+					for (int row = rowFrom; row <= rowTo; row++)
+						boxMask |= rowMask << (row * BLOCK_WIDTH);
+					if ((boxMask & ~coverage[block]) == 0 && nearest > zMax1[block])
+						continue;
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void OcclusionBuffer::GetDepthImage(std::vector<uint8_t>& pixels) const
+{
+	pixels.resize(width * height);
+	std::vector<float> depths(width * height);
+	float nearest = 1.0f, farthest = 0.0f;
+	for (unsigned int y = 0; y < height; y++)
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			unsigned int block = (y / BLOCK_HEIGHT) * blocksX + x / BLOCK_WIDTH;
+			unsigned int bit = (y % BLOCK_HEIGHT) * BLOCK_WIDTH + x % BLOCK_WIDTH;
+			float depth = (coverage[block] >> bit & 1) ? zMax1[block] : zMax0[block];
+			depths[y * width + x] = depth;
+			if (depth < 1.0f)
+			{
+				nearest = std::min(nearest, depth);
+				farthest = std::max(farthest, depth);
+			}
+		}
+	}
+	//z/w bunches up near 1, so stretch whatever range is actually in there
+	float scale = farthest > nearest ? 191.0f / (farthest - nearest) : 0.0f;
+	for (size_t i = 0; i < depths.size(); i++)
+		pixels[i] = depths[i] < 1.0f ? (uint8_t)(255.0f - (depths[i] - nearest) * scale) : 0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+#include "Culling.h"
+
+class ThreadPool;
+
+//simplified stand in for a mesh that gets drawn into the OcclusionBuffer, it has to stay inside the real mesh
+//or things behind it get culled while they're still visible around its edges
+struct OccluderMesh
+{
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<uint32_t> indices; //clockwise triangles like the real meshes
+	//the 12 triangles of a box, only right for meshes that fill their bounds (cubes, walls, floors)
+	static OccluderMesh Box(DirectX::XMFLOAT3 min, DirectX::XMFLOAT3 max);
+};
+
+// Low resolution depth buffer for CPU occlusion culling, occluders get rasterized into it and bounds get tested against it
+// - no per pixel depth, each 8x4 block keeps a far depth for all its pixels (zMax0) and a nearer one (zMax1) for the pixels
+//   in its 32 bit coverage mask, once the mask fills up it becomes the new zMax0 (masked occlusion culling, Andersson et al. 2015)
+// - blocks are grouped into tiles, the tiles are what gets rasterized in parallel and keep the farthest depth of their blocks
+//   so tests can skip a whole tile at once
+// depth is z/w like d3d, 0 near 1 far. everything is conservative: the buffer only ever says something is hidden when it is
+class OcclusionBuffer
+{
+public:
+	static constexpr unsigned int BLOCK_WIDTH = 8;
+	static constexpr unsigned int BLOCK_HEIGHT = 4;
+	static constexpr unsigned int TILE_WIDTH = 64; //8x8 blocks
+	static constexpr unsigned int TILE_HEIGHT = 32;
+
+	//rounded up to whole tiles
+	explicit OcclusionBuffer(unsigned int width = 320, unsigned int height = 192);
+
+	void Clear();
+	//transforms, near clips and bins the occluder's triangles, they get rasterized in Flush
+	void RenderOccluder(const OccluderMesh& mesh, const DirectX::XMFLOAT4X4& worldViewProjection);
+	//rasterizes everything binned since the last flush, one job per tile on pool (can be null), blocks until done
+	void Flush(ThreadPool* pool = nullptr);
+	//true only when every pixel the box covers is behind the occluders, boxes crossing the near plane never are
+	bool IsOccluded(const Aabb& box, const DirectX::XMFLOAT4X4& viewProjection) const;
+
+	//one byte per pixel (width * height), black where nothing was drawn, brighter the nearer, for looking at it in the ui
+	void GetDepthImage(std::vector<uint8_t>& pixels) const;
+
+	unsigned int GetWidth() const { return width; }
+	unsigned int GetHeight() const { return height; }
+	//front facing triangles that made it into the bins since the last Clear
+	unsigned int GetTriangleCount() const { return triangleCount; }
+
+private:
+	//edge functions are inside when >= 0, a * x + b * y + c at pixel centers
+	struct Triangle
+	{
+		float edgeA[3], edgeB[3], edgeC[3];
+		float depthA, depthB, depthC; //depth plane, same form
+		float zMin, zMax; //of the vertices, clamps the plane
+		int minX, minY, maxX, maxY; //pixels whose centers might be inside, already clamped to the buffer
+	};
+
+	unsigned int width, height;
+	unsigned int blocksX, blocksY;
+	unsigned int tilesX, tilesY;
+	unsigned int triangleCount = 0;
+
+	//per block, structure of arrays
+	std::vector<float> zMax0;
+	std::vector<float> zMax1;
+	std::vector<uint32_t> coverage;
+	std::vector<float> tileZMax; //farthest zMax0 in the tile, kept by Flush
+
+	std::vector<Triangle> triangles; //since the last flush
+	std::vector<DirectX::XMFLOAT4> clipVertices; //RenderOccluder's scratch
+	std::vector<std::vector<uint32_t>> bins; //triangles touching each tile, in submission order
+
+	//screen space (pixels, y down) triangle, culls back faces
+	void AddTriangle(DirectX::XMFLOAT3 v0, DirectX::XMFLOAT3 v1, DirectX::XMFLOAT3 v2);
+	void RasterizeTile(unsigned int tile);
+};
@@ -0,0 +1,96 @@
+#include "OffsetAllocator.h"
+
+OffsetAllocator::OffsetAllocator(unsigned int capacity) : capacity(capacity)
+{
+	if (capacity > 0)
+		AddFreeBlock(0, capacity);
+}
+
+unsigned int OffsetAllocator::Allocate(unsigned int size)
+{
+	if (size == 0)
+		return INVALID_OFFSET;
+	//smallest block that fits, the lowest offset among equal sizes
+	auto best = freeBySize.lower_bound({ size, 0 });
+	if (best == freeBySize.end())
+		return INVALID_OFFSET;
+
+	unsigned int offset = best->second;
+	unsigned int blockSize = best->first;
+	RemoveFreeBlock(freeByOffset.find(offset));
+	if (blockSize > size)
+		AddFreeBlock(offset + size, blockSize - size);
+	used += size;
+	return offset;
+}
+
+void OffsetAllocator::Free(unsigned int offset, unsigned int size)
+{
+	if (offset == INVALID_OFFSET || size == 0)
+		return;
+	used -= size;
+
+	//merge with the free blocks right after and right before
+	auto next = freeByOffset.find(offset + size);
+	if (next != freeByOffset.end())
+	{
+		size += next->second;
+		RemoveFreeBlock(next);
+	}
+	auto previous = freeByOffset.lower_bound(offset);
+	if (previous != freeByOffset.begin())
+	{
+		--previous;
+		if (previous->first + previous->second == offset)
+		{
+			offset = previous->first;
+			size += previous->second;
+			RemoveFreeBlock(previous);
+		}
+	}
+	AddFreeBlock(offset, size);
+}
+
+void OffsetAllocator::Grow(unsigned int newCapacity)
+{
+	if (newCapacity <= capacity)
+		return;
+	unsigned int oldCapacity = capacity;
+	capacity = newCapacity;
+	//goes through Free so a free block at the old end gets extended
+	used += newCapacity - oldCapacity;
+	Free(oldCapacity, newCapacity - oldCapacity);
+}
+
+void OffsetAllocator::Reset(unsigned int used)
+{
+	freeByOffset.clear();
+	freeBySize.clear();
+	this->used = used;
+	if (used < capacity)
+		AddFreeBlock(used, capacity - used);
+}
+
+OffsetAllocatorStats OffsetAllocator::GetStats() const
+{
+	OffsetAllocatorStats stats = {};
+	stats.capacity = capacity;
+	stats.used = used;
+	stats.freeBlocks = (unsigned int)freeByOffset.size();
+	stats.largestFreeBlock = freeBySize.empty() ? 0 : freeBySize.rbegin()->first;
+	unsigned int freeSpace = capacity - used;
+	stats.fragmentation = freeSpace > 0 ? 1.0f - (float)stats.largestFreeBlock / freeSpace : 0.0f;
+	return stats;
+}
+
+void OffsetAllocator::AddFreeBlock(unsigned int offset, unsigned int size)
+{
+	freeByOffset[offset] = size;
+	freeBySize.insert({ size, offset });
+}
+
+void OffsetAllocator::RemoveFreeBlock(std::map<unsigned int, unsigned int>::iterator block)
+{
+	freeBySize.erase({ block->second, block->first });
+	freeByOffset.erase(block);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <map>
+#include <set>
+#include <utility>
+
+struct OffsetAllocatorStats
+{
+	unsigned int capacity;
+	unsigned int used;
+	unsigned int freeBlocks;
+	unsigned int largestFreeBlock;
+	float fragmentation; //1 - largest free block / total free, 0 means all the free space is in one piece
+};
+
+// Hands out ranges of [0, capacity) in whatever units the caller uses (vertices, indices, bytes)
+// - best fit from a free list, neighbouring free blocks are merged on Free
+// - it only does the bookkeeping, moving the data for Compact is up to the owner of the memory
+class OffsetAllocator
+{
+public:
+	static constexpr unsigned int INVALID_OFFSET = ~0u;
+
+	explicit OffsetAllocator(unsigned int capacity = 0);
+
+	//INVALID_OFFSET when no free block is big enough
+	unsigned int Allocate(unsigned int size);
+	void Free(unsigned int offset, unsigned int size);
+
+	//adds the new space at the end
+	void Grow(unsigned int newCapacity);
+	//forgets every allocation and marks [0, used) as taken, for after the owner packed everything to the front
+	void Reset(unsigned int used);
+
+	unsigned int GetCapacity() const { return capacity; }
+	unsigned int GetUsed() const { return used; }
+	OffsetAllocatorStats GetStats() const;
+
+private:
+	unsigned int capacity;
+	unsigned int used = 0;
+	std::map<unsigned int, unsigned int> freeByOffset; //offset -> size, for merging neighbours
+	std::set<std::pair<unsigned int, unsigned int>> freeBySize; //(size, offset), for best fit
+
+	void AddFreeBlock(unsigned int offset, unsigned int size);
+	void RemoveFreeBlock(std::map<unsigned int, unsigned int>::iterator block);
+};
@@ -0,0 +1,102 @@
+#include "RenderQueue.h"
+#include <algorithm>
+
+void RenderQueue::Clear()
+{
+	items.clear();
+	keys.clear();
+}
+
+uint32_t RenderQueue::GetId(std::unordered_map<const void*, uint32_t>& ids, const void* object)
+{
+	auto found = ids.find(object);
+	if (found != ids.end())
+		return found->second;
+	uint32_t id = (uint32_t)ids.size();
+	ids.emplace(object, id);
+	return id;
+}
+
+void RenderQueue::Submit(const Item& item, float viewDepth, float farClip)
+{
+	constexpr uint64_t depthMax = (1ull << DEPTH_BITS) - 1;
+	float depth = std::clamp(viewDepth / farClip, 0.0f, 1.0f);
+	uint64_t shader = GetId(shaderIds, item.vertexShader) & ((1ull << SHADER_BITS) - 1);
+	uint64_t material = GetId(materialIds, item.material) & ((1ull << MATERIAL_BITS) - 1);
+	uint64_t mesh = GetId(meshIds, item.mesh) & ((1ull << MESH_BITS) - 1);
+
+	uint64_t key = shader << (MATERIAL_BITS + MESH_BITS + DEPTH_BITS)
+		| material << (MESH_BITS + DEPTH_BITS)
+		| mesh << DEPTH_BITS
+		| (uint64_t)(depth * depthMax);
+	keys.push_back({ key, (uint32_t)items.size() });
+	items.push_back(item);
+}
+
+void RenderQueue::Sort()
+{
+	unsortedChanges = CountChanges(keys);
+	RadixSort(keys, scratch);
+	sortedChanges = CountChanges(keys);
+}
+
+StateChangeCounts RenderQueue::CountChanges(const std::vector<Entry>& order) const
+{
+	StateChangeCounts counts;
+	const Item* previous = nullptr;
+	for (const Entry& entry : order)
+	{
+		const Item& item = items[entry.item];
+		counts.shaders += !previous || item.vertexShader != previous->vertexShader;
+		counts.materials += !previous || item.material != previous->material;
+		counts.meshes += !previous || item.mesh != previous->mesh;
+		previous = &item;
+	}
+	return counts;
+}
+
+void RenderQueue::RadixSort(std::vector<Entry>& entries, std::vector<Entry>& scratch, size_t comparisonSortKeys)
+{
+	size_t count = entries.size();
+	if (count == 0)
+		return;
+	if (count < comparisonSortKeys)
+	{
+		std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+		return;
+	}
+	scratch.resize(count);
+
+	//every histogram in one pass over the keys
+	uint32_t histograms[8][256] = {};
+	for (const Entry& entry : entries)
+		for (unsigned int pass = 0; pass < 8; pass++)
+			histograms[pass][(entry.key >> (pass * 8)) & 0xFF]++;
+
+	Entry* from = entries.data();
+	Entry* to = scratch.data();
+	for (unsigned int pass = 0; pass < 8; pass++)
+	{
+		uint32_t* histogram = histograms[pass];
+		//all keys share this byte (unused id bits, one shader...), the pass wouldn't move anything
+		if (histogram[(from[0].key >> (pass * 8)) & 0xFF] == count)
+			continue;
+
+		uint32_t offset = 0;
+		for (unsigned int bucket = 0; bucket < 256; bucket++)
+		{
+			uint32_t size = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += size;
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			const Entry& entry = from[i];
+			to[histogram[(entry.key >> (pass * 8)) & 0xFF]++] = entry;
+		}
+		std::swap(from, to);
+	}
+	//odd number of passes ran, the result is sitting in scratch
+	if (from != entries.data())
+		entries.swap(scratch);
+}
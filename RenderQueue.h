@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Transform;
+class Mesh;
+class Material;
+class ISimpleShader;
+struct RenderState;
+
+//state changes between consecutive draws, a change of shader also counts for material and mesh if those differ
+struct StateChangeCounts
+{
+	unsigned int shaders = 0;
+	unsigned int materials = 0;
+	unsigned int meshes = 0;
+};
+
+// Draws for one frame, each one tagged with a 64 bit key and radix sorted before they're issued
+// key, high to low: vertex shader (8 bits) | material (12) | mesh (16) | view depth (28)
+// - sorting on it groups draws by the most expensive state first, depth last so each group goes front to back for early z
+// - ids are handed out the first time a shader/material/mesh shows up, past the field width they wrap,
+//   which only costs some grouping (the draws still compare the real pointers)
+class RenderQueue
+{
+public:
+	struct Item
+	{
+		Transform* transform;
+		Mesh* mesh; //what actually gets drawn (placeholder while loading)
+		Material* material;
+		ISimpleShader* vertexShader;
+		RenderState* state;
+	};
+
+	void Clear();
+	//viewDepth is the distance along the view direction, farClip maps to the largest depth key
+	void Submit(const Item& item, float viewDepth, float farClip);
+	//radix sorts the keys, also counts state changes in submission order for comparison
+	void Sort();
+
+	size_t GetCount() const { return items.size(); }
+	//i-th draw after Sort
+	const Item& GetSorted(size_t i) const { return items[keys[i].item]; }
+
+	const StateChangeCounts& GetUnsortedChanges() const { return unsortedChanges; }
+	const StateChangeCounts& GetSortedChanges() const { return sortedChanges; }
+
+	//sorts entries by key (stable) with 8 bit lsd passes, passes where every key has the same byte are skipped
+	//queues shorter than comparisonSortKeys use a comparison sort instead (0 always radix sorts, for the tests and benchmark)
+	//the result ends up back in entries, scratch is just working space
+	struct Entry
+	{
+		uint64_t key;
+		uint32_t item;
+	};
+	//8 histogram passes don't pay for themselves on short queues, with random keys stable_sort is faster up to about 1.5k (RenderQueueBench)
+	static constexpr size_t COMPARISON_SORT_KEYS = 1536;
+	static void RadixSort(std::vector<Entry>& entries, std::vector<Entry>& scratch, size_t comparisonSortKeys = COMPARISON_SORT_KEYS);
+
+private:
+	static constexpr unsigned int SHADER_BITS = 8;
+	static constexpr unsigned int MATERIAL_BITS = 12;
+	static constexpr unsigned int MESH_BITS = 16;
+	static constexpr unsigned int DEPTH_BITS = 28;
+
+	std::vector<Item> items;
+	std::vector<Entry> keys; //submission order until Sort
+	std::vector<Entry> scratch;
+
+	std::unordered_map<const void*, uint32_t> shaderIds;
+	std::unordered_map<const void*, uint32_t> materialIds;
+	std::unordered_map<const void*, uint32_t> meshIds;
+
+	StateChangeCounts unsortedChanges;
+	StateChangeCounts sortedChanges;
+
+	static uint32_t GetId(std::unordered_map<const void*, uint32_t>& ids, const void* object);
+	StateChangeCounts CountChanges(const std::vector<Entry>& order) const;
+};
@@ -0,0 +1,427 @@
+#include "RenderSystem.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "Window.h"
+#include "SharedBuffers.h"
+#include "Culling.h"
+#include "ThreadPool.h"
+#include "ShaderCommands.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+using namespace DirectX;
+
+namespace
+{
+	//every drawable entity this frame and its world bounding sphere (structure of arrays for the culling kernel)
+	std::vector<RenderQueue::Item> candidates;
+	std::vector<float> boundsX, boundsY, boundsZ, boundsRadius;
+	std::vector<uint32_t> visibleCandidates;
+	std::vector<uint64_t> spatialResults;
+
+	//meshes still loading in the background show their placeholder
+	Mesh* GetDrawableMesh(Mesh* mesh)
+	{
+		return mesh->IsReady() ? mesh : mesh->GetPlaceholder().get();
+	}
+
+	//picks the lod from how big the mesh's bounding sphere is on screen this frame
+	void SelectLod(Transform& transform, Mesh& target, RenderState& state, Camera& camera)
+	{
+		RenderSystem::UpdateWorldBounds(transform, target, state);
+		state.lod = target.SelectLod(camera.GetProjectedSize(state.worldBoundsCenter, state.worldBoundsRadius), (float)Window::Height());
+	}
+
+	//meshlet culling works in mesh space, so the frustum and the camera position get brought there instead of moving every meshlet
+	//runs on the recording threads, so the camera position comes in from Draw (copying the camera's Transform allocates in the pool)
+	void DrawCulled(CommandBuffer& commands, const Transform& transform, Mesh& target, Camera& camera, XMFLOAT3 cameraPosition)
+	{
+		XMFLOAT4X4 world = transform.readWorldMatrix();
+		XMFLOAT4X4 view = camera.getViewMatrix();
+		XMFLOAT4X4 proj = camera.getProjectionMatrix();
+		XMMATRIX worldMatrix = XMLoadFloat4x4(&world);
+		XMFLOAT4X4 worldViewProjection;
+		XMStoreFloat4x4(&worldViewProjection, worldMatrix * XMLoadFloat4x4(&view) * XMLoadFloat4x4(&proj));
+
+		XMFLOAT3 viewer;
+		XMStoreFloat3(&viewer, XMVector3Transform(XMLoadFloat3(&cameraPosition), XMMatrixInverse(nullptr, worldMatrix)));
+		target.DrawCulled(commands, worldViewProjection, viewer);
+	}
+
+	//one draw call's worth of the sorted queue, planned in order by Draw and recorded by RecordPackets on any thread
+	struct DrawPacket
+	{
+		uint32_t first; //into the sorted queue
+		uint32_t count; //items it covers, more than one only for an instanced batch
+		bool instanced = false;
+		InstanceRange instances = { 0, 0 }; //allocated in the ring for instanced batches
+		unsigned int objectIndex = 0; //LessSimple slot
+		bool lessSimple = false;
+		bool dirty = false; //the slot has to be uploaded
+	};
+	std::vector<DrawPacket> packets;
+
+	//what each LessSimple shader's per object slots were last filled with, the object alone isn't enough as its version changes
+	//the slots belong to the shader, so every material using it sees what the others put there (only used while planning)
+	struct SlotContents
+	{
+		const void* object = nullptr;
+		uint64_t version = 0;
+	};
+	std::unordered_map<const ISimpleShader*, std::array<SlotContents, MAX_OBJECTS>> lessSimpleSlots;
+
+	//true (and remembers it) when the slot doesn't hold this version of object yet, objectIndex has to be below MAX_OBJECTS
+	bool CheckAndSetSlot(const ISimpleShader* shader, unsigned int objectIndex, const void* object, uint64_t version)
+	{
+		SlotContents& slot = lessSimpleSlots[shader][objectIndex];
+		if (slot.object == object && slot.version == version)
+			return false;
+		slot = { object, version };
+		return true;
+	}
+
+	//packets [begin, end) into commands, only reads shared state (shaders, materials, transforms) so the pieces can run in parallel
+	//every piece starts from nothing bound, so the first shader, material and arena of each gets bound again
+	//transforms are only read through the read* getters, they can't rebuild anything here
+	void RecordPackets(const RenderQueue& queue, std::shared_ptr<Camera>& camera, XMFLOAT3 cameraPosition, CommandBuffer& commands, size_t begin, size_t end)
+	{
+		GeometryArenas::InvalidateBinding();
+		ISimpleShader* boundShader = nullptr;
+		Material* boundMaterial = nullptr;
+		auto bind = [&](ISimpleShader* vertexShader, Material* material)
+		{
+			if (vertexShader != boundShader)
+			{
+				ShaderCommands::RecordShader(commands, *vertexShader);
+				boundShader = vertexShader;
+			}
+			if (material != boundMaterial)
+			{
+				material->PreparePixelShader(commands);
+				boundMaterial = material;
+			}
+		};
+
+		for (size_t p = begin; p < end; p++)
+		{
+			const DrawPacket& packet = packets[p];
+			const RenderQueue::Item& item = queue.GetSorted(packet.first);
+			if (packet.instanced)
+			{
+				bind(item.material->GetInstancedVertexShader().get(), item.material);
+				//the batch's world matrices go straight into the command that uploads them
+				if (InstanceData* instances = (InstanceData*)SharedBuffers::Instances.Write(commands, packet.instances))
+				{
+					for (uint32_t j = 0; j < packet.instances.count; j++)
+					{
+						const Transform& transform = *queue.GetSorted(packet.first + j).transform;
+						instances[j] = { transform.readWorldMatrix(), transform.readWorldInverseTransposeMatrix() };
+					}
+				}
+				item.mesh->DrawInstanced(commands, packet.instances, item.state->lod);
+				continue;
+			}
+
+			ISimpleShader* vertexShader = item.vertexShader;
+			bind(vertexShader, item.material);
+			if (packet.lessSimple)
+				item.material->PrepareLesserMaterial(commands, *item.transform, camera, packet.objectIndex, packet.dirty);
+			else
+			{
+				RecordedConstantBuffer perObjectData = item.material->PrepareMaterial(commands, *item.transform, camera);
+				//compact meshes store positions relative to their bounds, the shader needs them to decode
+				if (item.mesh->GetVertexFormat() == VertexFormat::Compact)
+				{
+					const MeshBounds& bounds = item.mesh->GetBounds();
+					ShaderCommands::SetFloat3(*vertexShader, perObjectData, "positionOffset", bounds.Min);
+					ShaderCommands::SetFloat3(*vertexShader, perObjectData, "positionScale", XMFLOAT3(bounds.Max.x - bounds.Min.x, bounds.Max.y - bounds.Min.y, bounds.Max.z - bounds.Min.z));
+				}
+			}
+
+			if (item.state->lod == 0 && item.mesh->HasMeshlets())
+				DrawCulled(commands, *item.transform, *item.mesh, *camera, cameraPosition);
+			else
+				item.mesh->Draw(commands, item.state->lod);
+		}
+	}
+}
+
+//the sphere goes through the world matrix, the radius grows by the biggest axis scale (taken from the matrix so parents count too)
+void RenderSystem::UpdateWorldBounds(Transform& transform, Mesh& target, RenderState& state)
+{
+	uint64_t version = transform.getVersion();
+	if (version == state.boundsVersion && &target == state.boundsMesh)
+		return;
+	state.boundsVersion = version;
+	state.boundsMesh = &target;
+
+	const MeshBounds& bounds = target.GetBounds();
+	XMFLOAT4X4 world = transform.getWorldMatrix();
+	XMMATRIX worldMatrix = XMLoadFloat4x4(&world);
+	XMStoreFloat3(&state.worldBoundsCenter, XMVector3Transform(XMLoadFloat3(&bounds.Center), worldMatrix));
+	float maxScale = std::max({
+		XMVectorGetX(XMVector3Length(worldMatrix.r[0])),
+		XMVectorGetX(XMVector3Length(worldMatrix.r[1])),
+		XMVectorGetX(XMVector3Length(worldMatrix.r[2])) });
+	state.worldBoundsRadius = bounds.Radius * maxScale;
+}
+
+bool RenderSystem::UpdateSpatialIndex(EntityWorld& world, DynamicBvh& spatialIndex, ThreadPool* pool)
+{
+	world.Each<Transform, MeshRef, SpatialProxy>([&](Entity entity, Transform& transform, MeshRef& meshRef, SpatialProxy& proxy)
+	{
+		Mesh* target = GetDrawableMesh(meshRef.mesh);
+		if (!target)
+			return;
+		uint64_t version = transform.getVersion();
+		if (proxy.proxy != DynamicBvh::NULL_NODE && version == proxy.version && target == proxy.mesh)
+			return;
+		proxy.version = version;
+		proxy.mesh = target;
+
+		const MeshBounds& bounds = target->GetBounds();
+		Aabb box = Culling::TransformAabb({ bounds.Min, bounds.Max }, transform.getWorldMatrix());
+		if (proxy.proxy == DynamicBvh::NULL_NODE)
+			proxy.proxy = spatialIndex.Insert(box, entity.ToBits());
+		else
+			spatialIndex.Move(proxy.proxy, box);
+	});
+
+	if (spatialIndex.GetRefitRatio() < REBUILD_REFIT_RATIO)
+		return false;
+	spatialIndex.Rebuild(pool);
+	return true;
+}
+
+unsigned int RenderSystem::RenderOccluders(EntityWorld& world, Camera& camera, OcclusionBuffer& occlusion, ThreadPool* pool)
+{
+	XMFLOAT4X4 view = camera.getViewMatrix();
+	XMFLOAT4X4 projection = camera.getProjectionMatrix();
+	XMMATRIX viewProjection = XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&projection));
+
+	occlusion.Clear();
+	unsigned int count = 0;
+	world.Each<Transform, Occluder>([&](Entity, Transform& transform, Occluder& occluder)
+	{
+		if (!occluder.mesh)
+			return;
+		XMFLOAT4X4 worldMatrix = transform.getWorldMatrix();
+		XMFLOAT4X4 worldViewProjection;
+		XMStoreFloat4x4(&worldViewProjection, XMMatrixMultiply(XMLoadFloat4x4(&worldMatrix), viewProjection));
+		occlusion.RenderOccluder(*occluder.mesh, worldViewProjection);
+		count++;
+	});
+	occlusion.Flush(pool);
+	return count;
+}
+
+RenderSystem::DrawStats RenderSystem::Draw(EntityWorld& world, std::shared_ptr<Camera> camera, RenderQueue& queue, std::vector<CommandBuffer>& commandLists,
+	const DynamicBvh* spatialIndex, const OcclusionBuffer* occlusion, ThreadPool* pool, unsigned int maxJobs)
+{
+	//depth along the view direction is the third column of the view matrix
+	XMFLOAT4X4 view = camera->getViewMatrix();
+	float farClip = camera->GetFarClip();
+
+	candidates.clear();
+	boundsX.clear();
+	boundsY.clear();
+	boundsZ.clear();
+	boundsRadius.clear();
+	auto addCandidate = [&](Transform& transform, MeshRef& meshRef, MaterialRef& materialRef, RenderState& state)
+	{
+		Mesh* target = GetDrawableMesh(meshRef.mesh);
+		if (!target)
+			return;
+		UpdateWorldBounds(transform, *target, state);
+		candidates.push_back({ &transform, target, materialRef.material, materialRef.material->GetVertexShader().get(), &state });
+		boundsX.push_back(state.worldBoundsCenter.x);
+		boundsY.push_back(state.worldBoundsCenter.y);
+		boundsZ.push_back(state.worldBoundsCenter.z);
+		boundsRadius.push_back(state.worldBoundsRadius);
+	};
+	if (spatialIndex)
+	{
+		//the bvh skips whole branches off screen, what it returns was only tested with fat boxes
+		spatialResults.clear();
+		spatialIndex->QueryFrustum(camera->GetFrustum(), spatialResults);
+		for (uint64_t bits : spatialResults)
+		{
+			Entity entity = Entity::FromBits(bits);
+			Transform* transform = world.Get<Transform>(entity);
+			MeshRef* meshRef = world.Get<MeshRef>(entity);
+			MaterialRef* materialRef = world.Get<MaterialRef>(entity);
+			RenderState* state = world.Get<RenderState>(entity);
+			if (transform && meshRef && materialRef && state)
+				addCandidate(*transform, *meshRef, *materialRef, *state);
+		}
+	}
+	else
+	{
+		world.Each<Transform, MeshRef, MaterialRef, RenderState>([&](Entity, Transform& transform, MeshRef& meshRef, MaterialRef& materialRef, RenderState& state)
+		{
+			addCandidate(transform, meshRef, materialRef, state);
+		});
+	}
+
+	//only what touches the frustum goes in the queue
+	size_t candidateCount = candidates.size();
+	size_t padded = (candidateCount + Culling::COMPACT_PADDING - 1) / Culling::COMPACT_PADDING * Culling::COMPACT_PADDING;
+	boundsX.resize(padded);
+	boundsY.resize(padded);
+	boundsZ.resize(padded);
+	boundsRadius.resize(padded);
+	visibleCandidates.resize(padded);
+	size_t visibleCount = Culling::FrustumCullSpheresCompact(camera->GetFrustum(), boundsX.data(), boundsY.data(), boundsZ.data(), boundsRadius.data(),
+		candidateCount, visibleCandidates.data());
+
+	XMFLOAT4X4 viewProjection;
+	if (occlusion)
+	{
+		XMFLOAT4X4 projection = camera->getProjectionMatrix();
+		XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&projection)));
+	}
+	unsigned int occluded = 0;
+
+	queue.Clear();
+	for (size_t i = 0; i < visibleCount; i++)
+	{
+		const RenderQueue::Item& item = candidates[visibleCandidates[i]];
+		if (occlusion)
+		{
+			//the box is tighter than the sphere on screen, occluders themselves always pass (their box is in front of their own depth)
+			const MeshBounds& bounds = item.mesh->GetBounds();
+			if (occlusion->IsOccluded(Culling::TransformAabb({ bounds.Min, bounds.Max }, item.transform->getWorldMatrix()), viewProjection))
+			{
+				occluded++;
+				continue;
+			}
+		}
+		SelectLod(*item.transform, *item.mesh, *item.state, *camera);
+		XMFLOAT3 center = item.state->worldBoundsCenter;
+		float viewDepth = center.x * view._13 + center.y * view._23 + center.z * view._33 + view._43;
+		queue.Submit(item, viewDepth, farClip);
+	}
+	queue.Sort();
+
+	CommandBuffer& commands = commandLists[0];
+	DrawStats stats;
+	stats.culled = (unsigned int)(candidateCount - visibleCount);
+	stats.occluded = occluded;
+	auto recordStart = std::chrono::steady_clock::now();
+
+	//everything that has to happen in order is planned here: runs, ring allocations (a wrap discards what came before),
+	//LessSimple slots and their version checks, and the instanced shaders' per frame data, recorded ahead of every draw
+	packets.clear();
+	bool lessSimple = false;
+	//per object slots of the LessSimple shaders, sorting keeps each shader's draws together so the count restarts with it
+	//(instanced runs in between don't use slots, so they don't restart it)
+	ISimpleShader* slotShader = nullptr;
+	unsigned int objectIndex = 0;
+	//instanced shaders aren't in Material::sharedVertexShaders, they get the camera the first time they're used each frame
+	std::vector<ISimpleShader*> instancedShadersReady;
+
+	size_t count = queue.GetCount();
+	for (size_t i = 0; i < count;)
+	{
+		const RenderQueue::Item& item = queue.GetSorted(i);
+		//the sort leaves equal mesh/material next to each other, those runs become one instanced draw
+		//(meshlet culled and compact meshes need per object constants, so they stay single draws)
+		size_t runEnd = i + 1;
+		SimpleVertexShader* instancedShader = item.material->GetInstancedVertexShader().get();
+		bool canInstance = instancedShader && item.mesh->GetVertexFormat() == VertexFormat::Full && !(item.state->lod == 0 && item.mesh->HasMeshlets());
+		if (canInstance)
+		{
+			while (runEnd < count)
+			{
+				const RenderQueue::Item& next = queue.GetSorted(runEnd);
+				if (next.mesh != item.mesh || next.material != item.material || next.state->lod != item.state->lod)
+					break;
+				runEnd++;
+			}
+		}
+
+		if (runEnd - i >= MIN_INSTANCES)
+		{
+			if (std::find(instancedShadersReady.begin(), instancedShadersReady.end(), instancedShader) == instancedShadersReady.end())
+			{
+				instancedShader->SetMatrix4x4("view", camera->getViewMatrix());
+				instancedShader->SetMatrix4x4("projection", camera->getProjectionMatrix());
+				ShaderCommands::RecordBufferData(commands, *instancedShader, "PerFrameData");
+				instancedShadersReady.push_back(instancedShader);
+			}
+			//a batch takes whatever is left before the ring wraps, so a run is only split where the ring starts over
+			//(or when it is longer than the whole ring)
+			for (size_t first = i, batch = 0; first < runEnd; first += batch)
+			{
+				unsigned int room = SharedBuffers::Instances.GetSpaceLeft();
+				if (room == 0)
+					room = std::max(SharedBuffers::Instances.GetCapacity(), 1u); //wraps, at least 1 so a ring that was never created still moves on (its batches come back empty)
+				batch = std::min<size_t>(room, runEnd - first);
+				DrawPacket packet = { (uint32_t)first, (uint32_t)batch, true };
+				packet.instances = SharedBuffers::Instances.Allocate((unsigned int)batch);
+				packets.push_back(packet);
+				stats.instancedDrawCalls++;
+			}
+			stats.instances += (unsigned int)(runEnd - i);
+			i = runEnd;
+			continue;
+		}
+
+		ISimpleShader* vertexShader = item.vertexShader;
+		if (vertexShader != slotShader)
+		{
+			slotShader = vertexShader;
+			lessSimple = dynamic_cast<LessSimpleVertexShader*>(vertexShader) != nullptr;
+			objectIndex = 0;
+		}
+		DrawPacket packet = { (uint32_t)i, 1 };
+		if (lessSimple)
+		{
+			//the shader only has MAX_OBJECTS slots, the rest of its draws are dropped here rather than failing one by one while recording
+			if (objectIndex >= MAX_OBJECTS)
+			{
+				static bool warned = false;
+				if (!warned)
+					printf("More than %d objects use one LessSimple shader, the ones past that aren't drawn\n", MAX_OBJECTS);
+				warned = true;
+				stats.slotOverflow++;
+				i++;
+				continue;
+			}
+			packet.lessSimple = true;
+			packet.objectIndex = objectIndex++;
+			//versions instead of isDirty, the dirty flag is gone by the time anything is drawn (and reading it doesn't say whether we saw it)
+			//keyed by the shader's slot, materials sharing the shader overwrite each other's slots
+			packet.dirty = CheckAndSetSlot(vertexShader, packet.objectIndex, item.transform, item.transform->getVersion());
+		}
+		packets.push_back(packet);
+		stats.drawCalls++;
+		i++;
+	}
+
+	//then the packets get recorded in contiguous pieces, the first into commandLists[0] on this thread, the rest into
+	//the lists after it on the pool, executing them in order is the same as recording them all here (without copying them together)
+	size_t jobs = 1;
+	if (pool && pool->GetThreadCount() > 0)
+	{
+		size_t threads = maxJobs ? std::min<size_t>(maxJobs, pool->GetThreadCount() + 1) : pool->GetThreadCount() + 1;
+		jobs = std::max<size_t>(1, std::min(threads, packets.size() / MIN_PACKETS_PER_JOB));
+	}
+	commandLists.resize(jobs);
+	XMFLOAT3 cameraPosition = camera->getTransform().getPosition();
+	auto recordJob = [&](size_t job)
+	{
+		RecordPackets(queue, camera, cameraPosition, commandLists[job], packets.size() * job / jobs, packets.size() * (job + 1) / jobs);
+	};
+	for (size_t job = 1; job < jobs; job++)
+		pool->Submit([&, job]() { commandLists[job].Reset(); recordJob(job); });
+	recordJob(0);
+	if (jobs > 1)
+		pool->Wait();
+
+	stats.recordJobs = (unsigned int)jobs;
+	stats.recordMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+	return stats;
+}
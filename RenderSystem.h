@@ -0,0 +1,57 @@
+#pragma once
+#include <memory>
+
+#include "EntityWorld.h"
+#include "Components.h"
+#include "Transform.h"
+#include "Camera.h"
+#include "RenderQueue.h"
+#include "DynamicBvh.h"
+#include "OcclusionBuffer.h"
+#include "CommandBuffer.h"
+
+//draws every entity with a Transform, MeshRef, MaterialRef and RenderState
+namespace RenderSystem
+{
+	//runs shorter than this are drawn one by one
+	constexpr unsigned int MIN_INSTANCES = 2;
+	//draw calls below this many per thread aren't worth handing to the pool
+	constexpr unsigned int MIN_PACKETS_PER_JOB = 128;
+
+	struct DrawStats
+	{
+		unsigned int drawCalls = 0; //single objects
+		unsigned int instancedDrawCalls = 0;
+		unsigned int instances = 0; //objects drawn by the instanced calls
+		unsigned int culled = 0; //outside the camera's frustum, never queued
+		unsigned int occluded = 0; //in the frustum but behind the occluders, never queued
+		unsigned int slotOverflow = 0; //LessSimple draws past the shader's MAX_OBJECTS slots, not drawn
+		unsigned int recordJobs = 0; //pieces the draws were recorded in, in parallel
+		double recordMilliseconds = 0.0; //planning, recording and merging the draws (not culling or sorting)
+	};
+
+	//rebuild the bvh once this many of its proxies (as a fraction) have been refit since the last build
+	constexpr float REBUILD_REFIT_RATIO = 0.25f;
+
+	//candidates come from the bvh's frustum query when there is one (only entities with a SpatialProxy get drawn then),
+	//a linear walk over the world's columns otherwise, their bounds are culled again exactly, the survivors fill the queue
+	//with an occlusion buffer (filled by RenderOccluders) anything whose bounds are hidden behind the occluders is dropped as well,
+	//then the sorted draws get recorded into commandLists (nothing reaches the gpu until they're executed, in order)
+	//state is only rebound when it differs from the draw before, runs of the same mesh + material (+ lod) become instanced draws
+	//with a pool the draws are recorded by up to maxJobs threads (0 for all of them plus this one), each into its own list,
+	//commandLists is resized to one per thread, [0] keeps what was already in it and gets the first piece of the sort order
+	//transforms have to be up to date (UpdateDirty, UpdateNormals), they're only read
+	DrawStats Draw(EntityWorld& world, std::shared_ptr<Camera> camera, RenderQueue& queue, std::vector<CommandBuffer>& commandLists,
+		const DynamicBvh* spatialIndex = nullptr, const OcclusionBuffer* occlusion = nullptr, ThreadPool* pool = nullptr, unsigned int maxJobs = 0);
+
+	//clears occlusion and draws the OccluderMesh of every entity with an Occluder from camera, rasterized by tile on pool (can be null)
+	//returns the number of occluders
+	unsigned int RenderOccluders(EntityWorld& world, Camera& camera, OcclusionBuffer& occlusion, ThreadPool* pool);
+
+	//inserts/moves the SpatialProxy of every entity whose transform or mesh changed, rebuilds the bvh on pool once it has degraded
+	//returns true when it rebuilt
+	bool UpdateSpatialIndex(EntityWorld& world, DynamicBvh& spatialIndex, ThreadPool* pool);
+
+	//world space bounding sphere of target, cached in state until the transform or the mesh changes
+	void UpdateWorldBounds(Transform& transform, Mesh& target, RenderState& state);
+}
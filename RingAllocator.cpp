@@ -0,0 +1,38 @@
+#include "RingAllocator.h"
+
+RingAllocator::RingAllocator(size_t capacity) : capacity(capacity)
+{
+}
+
+RingAllocation RingAllocator::Allocate(size_t size, size_t alignment)
+{
+	if (size > capacity)
+		return { INVALID_OFFSET, false };
+
+	size_t offset = (head + alignment - 1) / alignment * alignment;
+	bool wrapped = !started || offset + size > capacity;
+	if (wrapped)
+	{
+		offset = 0;
+		started = true;
+		frameWraps++;
+		totalWraps++;
+	}
+	frameBytes += offset + size - (wrapped ? 0 : head);
+	head = offset + size;
+	return { offset, wrapped };
+}
+
+size_t RingAllocator::GetSpaceLeft(size_t alignment) const
+{
+	if (!started)
+		return capacity;
+	size_t offset = (head + alignment - 1) / alignment * alignment;
+	return offset < capacity ? capacity - offset : 0;
+}
+
+void RingAllocator::BeginFrame()
+{
+	frameBytes = 0;
+	frameWraps = 0;
+}
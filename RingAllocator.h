@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+
+struct RingAllocation
+{
+	size_t offset;
+	bool wrapped; //the ring started over, the whole buffer has to be discarded before writing
+};
+
+// Bookkeeping for a streaming buffer that is only ever appended to
+// - allocations go one after the other and never overwrite anything since the last wrap,
+//   which is what makes D3D11_MAP_WRITE_NO_OVERWRITE safe
+// - when the rest doesn't fit it starts again at 0 and reports a wrap so the buffer is mapped with
+//   D3D11_MAP_WRITE_DISCARD, the driver then hands out fresh memory while the gpu finishes with the old one
+// - no d3d in here, the buffer side is in InstanceRing
+class RingAllocator
+{
+public:
+	static constexpr size_t INVALID_OFFSET = ~(size_t)0;
+
+	explicit RingAllocator(size_t capacity = 0);
+
+	//offset is INVALID_OFFSET when size is bigger than the whole ring, offset is a multiple of alignment
+	RingAllocation Allocate(size_t size, size_t alignment = 1);
+
+	//the most an aligned allocation can take without wrapping, the whole ring before the first allocation (which wraps anyway)
+	size_t GetSpaceLeft(size_t alignment = 1) const;
+
+	//only resets the per frame stats, the ring itself doesn't care about frames
+	void BeginFrame();
+
+	size_t GetCapacity() const { return capacity; }
+	size_t GetHead() const { return head; }
+	size_t GetFrameBytes() const { return frameBytes; } //allocated since BeginFrame, including alignment
+	unsigned int GetFrameWraps() const { return frameWraps; }
+	unsigned int GetTotalWraps() const { return totalWraps; }
+
+private:
+	size_t capacity;
+	size_t head = 0;
+	bool started = false; //the very first allocation also counts as a wrap so the buffer gets its first discard
+	size_t frameBytes = 0;
+	unsigned int frameWraps = 0;
+	unsigned int totalWraps = 0;
+};
@@ -0,0 +1,101 @@
+#include "ShaderCommands.h"
+#include <cstring>
+
+namespace
+{
+	//a LessSimple shader binds PerObjectData one slot at a time, so only PerFrameData goes with the shader
+	void RecordConstantBuffers(CommandBuffer& commands, ISimpleShader& shader, ShaderStage stage, bool perFrameOnly)
+	{
+		for (unsigned int i = 0; i < shader.GetBufferCount(); i++)
+		{
+			const SimpleConstantBuffer* cb = shader.GetBufferInfo(i);
+			if (cb->Type != D3D11_CT_CBUFFER || (perFrameOnly && cb->Name != "PerFrameData"))
+				continue;
+			commands.SetConstantBuffer(stage, cb->BindIndex, cb->ConstantBuffer.Get());
+		}
+	}
+}
+
+void ShaderCommands::RecordShader(CommandBuffer& commands, ISimpleShader& shader)
+{
+	if (!shader.IsShaderValid())
+		return;
+	if (SimpleVertexShader* vertexShader = dynamic_cast<SimpleVertexShader*>(&shader))
+	{
+		commands.SetVertexShader(vertexShader->GetDirectXShader().Get(), vertexShader->GetInputLayout().Get());
+		RecordConstantBuffers(commands, shader, ShaderStage::Vertex, false);
+	}
+	else if (LessSimpleVertexShader* lessSimple = dynamic_cast<LessSimpleVertexShader*>(&shader))
+	{
+		commands.SetVertexShader(lessSimple->GetDirectXShader().Get(), lessSimple->GetInputLayout().Get());
+		RecordConstantBuffers(commands, shader, ShaderStage::Vertex, true);
+	}
+	else if (SimplePixelShader* pixelShader = dynamic_cast<SimplePixelShader*>(&shader))
+	{
+		commands.SetPixelShader(pixelShader->GetDirectXShader().Get());
+		RecordConstantBuffers(commands, shader, ShaderStage::Pixel, false);
+	}
+}
+
+void ShaderCommands::RecordBufferData(CommandBuffer& commands, ISimpleShader& shader, const std::string& bufferName)
+{
+	const SimpleConstantBuffer* cb = shader.IsShaderValid() ? shader.GetBufferInfo(bufferName) : nullptr;
+	if (cb)
+		commands.UpdateBuffer(cb->ConstantBuffer.Get(), cb->LocalDataBuffer, cb->Size);
+}
+
+RecordedConstantBuffer ShaderCommands::RecordBufferCopy(CommandBuffer& commands, ISimpleShader& shader, unsigned int index)
+{
+	const SimpleConstantBuffer* cb = shader.IsShaderValid() ? shader.GetBufferInfo(index) : nullptr;
+	if (!cb)
+		return {};
+	unsigned char* data = (unsigned char*)commands.WriteBuffer(cb->ConstantBuffer.Get(), cb->Size);
+	memcpy(data, cb->LocalDataBuffer, cb->Size);
+	return { index, data };
+}
+
+RecordedConstantBuffer ShaderCommands::RecordBufferCopy(CommandBuffer& commands, ISimpleShader& shader, const std::string& bufferName)
+{
+	//SimpleShader looks buffers up by name but the copy needs the index, the variables refer to their buffer by it
+	for (unsigned int i = 0; i < shader.GetBufferCount(); i++)
+		if (shader.GetBufferInfo(i)->Name == bufferName)
+			return RecordBufferCopy(commands, shader, i);
+	return {};
+}
+
+bool ShaderCommands::SetData(ISimpleShader& shader, RecordedConstantBuffer& buffer, const std::string& name, const void* data, unsigned int size)
+{
+	if (!buffer.data)
+		return false;
+	const SimpleShaderVariable* variable = shader.GetVariableInfo(name);
+	if (!variable || variable->ConstantBufferIndex != buffer.index || size > variable->Size)
+		return false;
+	memcpy(buffer.data + variable->ByteOffset, data, size);
+	return true;
+}
+
+bool ShaderCommands::SetFloat3(ISimpleShader& shader, RecordedConstantBuffer& buffer, const std::string& name, DirectX::XMFLOAT3 data)
+{
+	return SetData(shader, buffer, name, &data, sizeof(data));
+}
+
+bool ShaderCommands::SetMatrix4x4(ISimpleShader& shader, RecordedConstantBuffer& buffer, const std::string& name, const DirectX::XMFLOAT4X4& data)
+{
+	return SetData(shader, buffer, name, &data, sizeof(data));
+}
+
+bool ShaderCommands::RecordPerObjectData(CommandBuffer& commands, LessSimpleVertexShader& shader, unsigned int objectIndex, const DirectX::XMFLOAT4X4* matrices)
+{
+	const SimpleConstantBuffer* cb = shader.GetBufferInfo(1); //PerObjectData
+	if (!cb || !cb->isPoolBuffer || objectIndex >= MAX_OBJECTS)
+		return false;
+
+	//the pool holds MAX_OBJECTS equal slots, 256 bytes each so a slot can be bound as its own range
+	uint32_t slotSize = cb->Size / MAX_OBJECTS;
+	uint32_t offset = objectIndex * slotSize;
+	//the matrices go into the command itself, the shader's LocalDataBuffer is shared by every recording thread
+	if (matrices)
+		memcpy(commands.WriteBuffer(cb->ConstantBuffer.Get(), sizeof(DirectX::XMFLOAT4X4) * 2, offset, BufferWrite::NoOverwrite), matrices, sizeof(DirectX::XMFLOAT4X4) * 2);
+	commands.SetConstantBuffer(ShaderStage::Vertex, cb->BindIndex, cb->ConstantBuffer.Get(), offset / 16, slotSize / 16);
+	return true;
+}
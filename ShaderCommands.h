@@ -0,0 +1,38 @@
+#pragma once
+#include <DirectXMath.h>
+#include <string>
+
+#include "SimpleShader/SimpleShader.h"
+#include "CommandBuffer.h"
+
+//a shader's constant buffer copied into a CommandBuffer by RecordBufferCopy, only valid until the next command is recorded
+struct RecordedConstantBuffer
+{
+	unsigned int index = 0; //of the buffer in its shader
+	unsigned char* data = nullptr; //null when nothing was recorded
+};
+
+// SimpleShader's SetShader and Copy*BufferData, recorded into a CommandBuffer instead of going to the context right away
+// - SimpleShader itself isn't changed, everything it needs is read through GetBufferInfo/GetVariableInfo and the shader getters
+// - nothing in here writes to a shader, so several threads can record with the same one as long as nobody calls its
+//   plain Set* methods meanwhile (per object values go into the recorded copies with the Set* functions below)
+namespace ShaderCommands
+{
+	//binds the shader and its constant buffers, a LessSimple shader only binds PerFrameData (RecordPerObjectData does the rest)
+	void RecordShader(CommandBuffer& commands, ISimpleShader& shader);
+	//uploads the buffer's local data as it is now
+	void RecordBufferData(CommandBuffer& commands, ISimpleShader& shader, const std::string& bufferName);
+
+	//same upload, the Set* functions then change variables in the recorded copy only
+	RecordedConstantBuffer RecordBufferCopy(CommandBuffer& commands, ISimpleShader& shader, unsigned int index);
+	RecordedConstantBuffer RecordBufferCopy(CommandBuffer& commands, ISimpleShader& shader, const std::string& bufferName);
+	//false when the variable lives in another buffer than the copy (so every buffer can be tried) or doesn't exist
+	bool SetData(ISimpleShader& shader, RecordedConstantBuffer& buffer, const std::string& name, const void* data, unsigned int size);
+	bool SetFloat3(ISimpleShader& shader, RecordedConstantBuffer& buffer, const std::string& name, DirectX::XMFLOAT3 data);
+	bool SetMatrix4x4(ISimpleShader& shader, RecordedConstantBuffer& buffer, const std::string& name, const DirectX::XMFLOAT4X4& data);
+
+	//LessSimpleVertexShader::CopyPerObjectData recorded: uploads matrices (world, worldInvTrans) into the slot's part of the pool buffer,
+	//then binds that part, matrices is null when the slot already holds them
+	//false when objectIndex is past MAX_OBJECTS, the caller is expected to have planned around that
+	bool RecordPerObjectData(CommandBuffer& commands, LessSimpleVertexShader& shader, unsigned int objectIndex, const DirectX::XMFLOAT4X4* matrices);
+}
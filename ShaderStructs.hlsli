@@ -1,8 +1,6 @@
 #ifndef __GGP_SHADER_STRUCTS__
 #define __GPP_SHADER_STRUCTS__
 
-#define MAX_INSTANCES 1000
-
 // Structs for various shaders
 // Basic VS input for a standard Pos/UV/Normal vertex
 struct VertexShaderInput
@@ -14,14 +12,23 @@ struct VertexShaderInput
     //float3 tangent : TANGENT;
 };
 
-struct InstanceData
+// VS input for CompactVertex (see VertexFormats.h), the input layout does the unorm/half/snorm conversion
+struct CompactVertexShaderInput
 {
-    matrix world;
+    float3 localPosition : POSITION; // 0-1 inside the mesh bounds
+    float2 uv : TEXCOORD;
+    float2 octNormal : NORMAL; // octahedral encoded
 };
 
-cbuffer PerInstanceData : register(b2)
+// VS input for instanced draws, the matrices come from the per instance stream in slot 1 (SharedBuffers::Instances)
+// anything ending in _PER_INSTANCE gets put there by SimpleShader's input layout, so there's no cap on the count
+struct InstancedVertexShaderInput
 {
-    InstanceData instances[MAX_INSTANCES];
+    float3 localPosition : POSITION;
+    float2 uv : TEXCOORD;
+    float3 normal : NORMAL;
+    matrix world : WORLD_PER_INSTANCE;
+    matrix worldInvTrans : WORLDINVTRANS_PER_INSTANCE;
 };
 
 // VS Output / PS Input struct for basic lighting
@@ -2,5 +2,5 @@
 
 namespace SharedBuffers
 {
-    Microsoft::WRL::ComPtr<ID3D11Buffer> InstanceBuffer; // Define the variable
+    InstanceRing Instances; // Define the variable
 }
\ No newline at end of file
@@ -5,7 +5,9 @@
 #include <vector>
 #include <memory>
 
-#define MAX_INSTANCES 1000
+#include "InstanceRing.h"
+
+#define INSTANCE_RING_CAPACITY 16384 //instances, room for several frames of batches before a wrap (and the most one draw can take)
 
 struct MaterialBuffer
 {
@@ -13,12 +15,14 @@ struct MaterialBuffer
 	DirectX::XMFLOAT4X4 projection;
 };
 
+//one vertex of the per instance stream, matches WORLD_PER_INSTANCE / WORLDINVTRANS_PER_INSTANCE in ShaderStructs.hlsli
 struct InstanceData
 {
 	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 worldInvTrans;
 };
 
 namespace SharedBuffers
 {
-	extern Microsoft::WRL::ComPtr<ID3D11Buffer> InstanceBuffer; // Declare as extern
+	extern InstanceRing Instances; // per instance data of every instanced draw, created in Graphics::Initialize
 }
@@ -0,0 +1,184 @@
+// CommandBuffer recorded and walked back field by field over 10k draws, replayed through NullCommandExecutor clean,
+// then broken frames (zero size, unknown type, draws with nothing bound) that the executor has to report without running off
+#include "CommandBuffer.h"
+#include "TestCheck.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace
+{
+	//never dereferenced, the executor only compares them
+	template<typename T>
+	T* Handle(uintptr_t id)
+	{
+		return (T*)(id * 0x1000);
+	}
+
+	const int DRAWS = 10000;
+
+	void RecordFrame(CommandBuffer& commands)
+	{
+		commands.Reset();
+		float perFrame[32] = {};
+		commands.SetVertexShader(Handle<ID3D11VertexShader>(1), Handle<ID3D11InputLayout>(2));
+		commands.UpdateBuffer(Handle<ID3D11Buffer>(3), perFrame, sizeof(perFrame));
+		commands.SetConstantBuffer(ShaderStage::Vertex, 0, Handle<ID3D11Buffer>(3));
+		commands.SetVertexBuffer(0, Handle<ID3D11Buffer>(4), 32);
+		commands.SetIndexBuffer(Handle<ID3D11Buffer>(5), true);
+		for (int i = 0; i < DRAWS; i++)
+		{
+			if (i % 100 == 0)
+			{
+				commands.SetPixelShader(Handle<ID3D11PixelShader>(6 + (i / 100) % 4));
+				commands.SetConstantBuffer(ShaderStage::Pixel, 0, Handle<ID3D11Buffer>(20)); //same every time, so redundant after the first
+			}
+			float* perObject = (float*)commands.WriteBuffer(Handle<ID3D11Buffer>(30), 256, (i % 64) * 256, BufferWrite::NoOverwrite);
+			for (int j = 0; j < 64; j++)
+				perObject[j] = (float)(i + j);
+			commands.SetConstantBuffer(ShaderStage::Vertex, 1, Handle<ID3D11Buffer>(30), (i % 64) * 16, 16);
+			commands.DrawIndexed(36 + i % 7, i * 3, -i);
+		}
+	}
+
+	//the commands of a recorded buffer as bytes the test is allowed to break, the way a bad write from elsewhere would
+	uint8_t* Corrupt(CommandBuffer& commands)
+	{
+		return const_cast<uint8_t*>(commands.GetData());
+	}
+
+	bool HasError(const NullCommandExecutor& executor, const char* text)
+	{
+		for (const std::string& error : executor.GetErrors())
+			if (error.find(text) != std::string::npos)
+				return true;
+		return false;
+	}
+}
+
+int main()
+{
+	CommandBuffer commands;
+	RecordFrame(commands);
+	const unsigned int expectedCommands = 5 + DRAWS * 3 + DRAWS / 100 * 2;
+	CHECK(commands.GetCommandCount() == expectedCommands);
+	CHECK(commands.GetSize() % 8 == 0);
+
+	//walked back, every command is where and what it was recorded as
+	unsigned int walked = 0;
+	int draw = 0;
+	size_t bytes = 0;
+	for (const CommandHeader* command = commands.First(); command; command = commands.Next(command))
+	{
+		CHECK((const uint8_t*)command == commands.GetData() + bytes);
+		CHECK(command->size % 8 == 0 && command->size > 0);
+		bytes += command->size;
+		walked++;
+		if (command->type == CommandType::UpdateBuffer && static_cast<const UpdateBufferCommand*>(command)->buffer == Handle<ID3D11Buffer>(30))
+		{
+			const UpdateBufferCommand* update = static_cast<const UpdateBufferCommand*>(command);
+			CHECK(update->dataSize == 256 && update->offset == (uint32_t)(draw % 64) * 256 && update->mode == BufferWrite::NoOverwrite);
+			const float* data = (const float*)update->GetData();
+			CHECK(data[0] == (float)draw && data[63] == (float)(draw + 63));
+		}
+		else if (command->type == CommandType::DrawIndexed)
+		{
+			const DrawIndexedCommand* drawCommand = static_cast<const DrawIndexedCommand*>(command);
+			CHECK(drawCommand->indexCount == (uint32_t)(36 + draw % 7) && drawCommand->firstIndex == (uint32_t)draw * 3 && drawCommand->baseVertex == -draw);
+			draw++;
+		}
+	}
+	CHECK(walked == expectedCommands && draw == DRAWS && bytes == commands.GetSize());
+
+	NullCommandExecutor executor;
+	executor.Execute(commands);
+	const CommandStats& stats = executor.GetStats();
+	std::printf("%u commands, %zu bytes, %u errors, %u redundant binds\n", commands.GetCommandCount(), commands.GetSize(), executor.GetErrorCount(), stats.redundantBinds);
+	CHECK(executor.GetErrorCount() == 0 && executor.GetErrors().empty());
+	CHECK(stats.drawCalls == DRAWS && stats.commands[(size_t)CommandType::DrawIndexed] == DRAWS);
+	CHECK(stats.commands[(size_t)CommandType::SetPixelShader] == DRAWS / 100);
+	CHECK(stats.uploadedBytes == 128 + (uint64_t)DRAWS * 256);
+	CHECK(stats.redundantBinds == DRAWS / 100 - 1);
+	uint64_t indices = 0;
+	for (int i = 0; i < DRAWS; i++)
+		indices += 36 + i % 7;
+	CHECK(stats.indices == indices);
+
+	//stats add up over Execute calls until Reset
+	executor.Execute(commands);
+	CHECK(executor.GetStats().drawCalls == DRAWS * 2);
+	executor.Reset();
+	CHECK(executor.GetStats().drawCalls == 0 && executor.GetErrorCount() == 0);
+
+	//recording the same frame again reuses the storage
+	const uint8_t* storage = commands.GetData();
+	RecordFrame(commands);
+	CHECK(commands.GetData() == storage && commands.GetCommandCount() == expectedCommands);
+
+	//nothing recorded is a valid, empty frame
+	CommandBuffer empty;
+	CHECK(empty.First() == nullptr && empty.GetSize() == 0);
+	executor.Execute(empty);
+	CHECK(executor.GetErrorCount() == 0);
+
+	//draws with nothing bound: every missing binding is its own error, and the draw still counts
+	CommandBuffer unbound;
+	unbound.DrawIndexed(3, 0, 0);
+	unbound.DrawIndexedInstanced(3, 2, 0, 0, 0);
+	executor.Reset();
+	executor.Execute(unbound);
+	CHECK(executor.GetStats().drawCalls == 2);
+	CHECK(executor.GetErrorCount() == 5 + 6);
+	CHECK(HasError(executor, "without a vertex shader") && HasError(executor, "without a pixel shader") && HasError(executor, "without an input layout"));
+	CHECK(HasError(executor, "without an index buffer") && HasError(executor, "vertex buffer in slot 0") && HasError(executor, "instance buffer in slot 1"));
+	CHECK(executor.GetErrors()[0].find("byte 0:") == 0);
+
+	//a zero size: walking stops instead of spinning in place, the executor reports it and stops
+	CommandBuffer zeroSize;
+	zeroSize.SetPixelShader(Handle<ID3D11PixelShader>(6));
+	zeroSize.SetIndexBuffer(Handle<ID3D11Buffer>(5), false);
+	zeroSize.DrawIndexed(3, 0, 0);
+	const CommandHeader* second = zeroSize.Next(zeroSize.First());
+	size_t secondOffset = (const uint8_t*)second - zeroSize.GetData();
+	((CommandHeader*)(Corrupt(zeroSize) + secondOffset))->size = 0;
+	CHECK(zeroSize.Next(second) == nullptr);
+	executor.Reset();
+	executor.Execute(zeroSize);
+	CHECK(executor.GetErrorCount() == 1 && HasError(executor, "bad command size"));
+	CHECK(executor.GetErrors()[0].find("byte " + std::to_string(secondOffset) + ":") == 0);
+	CHECK(executor.GetStats().commands[(size_t)CommandType::SetPixelShader] == 1 && executor.GetStats().drawCalls == 0);
+
+	//a size running past the end, and one too small for its type
+	((CommandHeader*)(Corrupt(zeroSize) + secondOffset))->size = (uint32_t)zeroSize.GetSize();
+	executor.Reset();
+	executor.Execute(zeroSize);
+	CHECK(executor.GetErrorCount() == 1 && HasError(executor, "bad command size"));
+	((CommandHeader*)(Corrupt(zeroSize) + secondOffset))->size = 8;
+	executor.Reset();
+	executor.Execute(zeroSize);
+	CHECK(executor.GetErrorCount() == 1 && HasError(executor, "bad command size"));
+
+	//an unknown type stops the replay right there, what came before it still ran
+	CommandBuffer unknownType;
+	unknownType.SetPixelShader(Handle<ID3D11PixelShader>(6));
+	unknownType.SetPixelShader(Handle<ID3D11PixelShader>(7));
+	unknownType.DrawIndexed(3, 0, 0);
+	const CommandHeader* last = unknownType.Next(unknownType.Next(unknownType.First()));
+	((CommandHeader*)(Corrupt(unknownType) + ((const uint8_t*)last - unknownType.GetData())))->type = (CommandType)200;
+	executor.Reset();
+	executor.Execute(unknownType);
+	CHECK(executor.GetErrorCount() == 1 && HasError(executor, "unknown command type"));
+	CHECK(executor.GetStats().commands[(size_t)CommandType::SetPixelShader] == 2 && executor.GetStats().drawCalls == 0);
+	CHECK(std::strcmp(GetCommandName(last->type), "Unknown") == 0);
+	CHECK(std::strcmp(GetCommandName(CommandType::DrawIndexed), "DrawIndexed") == 0);
+
+	//errors past MAX_ERRORS are counted but not kept
+	CommandBuffer manyErrors;
+	for (int i = 0; i < 20; i++)
+		manyErrors.DrawIndexed(0, 0, 0);
+	executor.Reset();
+	executor.Execute(manyErrors);
+	CHECK(executor.GetErrorCount() == 20 * 6 && executor.GetErrors().size() == NullCommandExecutor::MAX_ERRORS);
+	return 0;
+}
@@ -0,0 +1,83 @@
+// Frustum culling 100k spheres: a scalar loop, the byte mask plus a compaction loop, and the compacting SSE and AVX2 kernels
+#include "Culling.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	template<typename Run>
+	double Best(Run run)
+	{
+		double best = 1e9;
+		for (int repeat = 0; repeat < 50; repeat++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			run();
+			best = std::min(best, std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		return best;
+	}
+}
+
+int main()
+{
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixLookToLH(XMVectorSet(0, 0, -15, 1), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)) *
+		XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.01f, 1000.0f));
+	Frustum frustum = Culling::ExtractFrustum(viewProjection);
+
+	const size_t count = 100000;
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> position(-200, 200), radius(0.1f, 3);
+	std::vector<float> x(count), y(count), z(count), r(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		x[i] = position(random);
+		y[i] = position(random) * 0.3f;
+		z[i] = position(random) + 200;
+		r[i] = radius(random);
+	}
+	std::vector<uint32_t> indices(count);
+	std::vector<unsigned char> visible(count);
+	volatile size_t sink = 0;
+
+	double scalar = Best([&]
+	{
+		size_t found = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			bool inside = true;
+			for (const XMFLOAT4& plane : frustum.planes)
+				inside &= plane.x * x[i] + plane.y * y[i] + plane.z * z[i] + plane.w > -r[i];
+			indices[found] = (uint32_t)i;
+			found += inside;
+		}
+		sink = found;
+	});
+	double mask = Best([&]
+	{
+		Culling::FrustumCullSpheres(frustum, x.data(), y.data(), z.data(), r.data(), count, visible.data());
+		size_t found = 0;
+		for (size_t i = 0; i < count; i++)
+			if (visible[i])
+				indices[found++] = (uint32_t)i;
+		sink = found;
+	});
+	double sse = Best([&] { sink = Culling::FrustumCullSpheresCompactSSE(frustum, x.data(), y.data(), z.data(), r.data(), count, indices.data()); });
+	std::printf("%zu spheres, %zu visible\n", count, (size_t)sink);
+	std::printf("scalar %.1f us, byte mask + compaction loop %.1f us, SSE compact %.1f us", scalar, mask, sse);
+
+	if (Culling::HasAVX2())
+	{
+		double avx2 = Best([&] { sink = Culling::FrustumCullSpheresCompactAVX2(frustum, x.data(), y.data(), z.data(), r.data(), count, indices.data()); });
+		std::printf(", AVX2 compact %.1f us", avx2);
+	}
+	std::printf("\n");
+	return 0;
+}
@@ -0,0 +1,104 @@
+// Culling kernels against a scalar plane loop, plus the box helpers
+#include "Culling.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	//how far inside the worst plane the sphere is, > 0 means visible
+	float Margin(const Frustum& frustum, float x, float y, float z, float radius)
+	{
+		float margin = 1e30f;
+		for (const XMFLOAT4& plane : frustum.planes)
+			margin = std::min(margin, plane.x * x + plane.y * y + plane.z * z + plane.w + radius);
+		return margin;
+	}
+}
+
+int main()
+{
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixLookToLH(XMVectorSet(0, 0, -15, 1), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)) *
+		XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.01f, 1000.0f));
+	Frustum frustum = Culling::ExtractFrustum(viewProjection);
+	CHECK(Margin(frustum, 0, 0, 0, 0) > 0 && Margin(frustum, 0, 0, -20, 0) < 0 && Margin(frustum, 0, 0, 2000, 0) < 0);
+	for (const XMFLOAT4& plane : frustum.planes)
+		CHECK(std::fabs(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z - 1) < 1e-5f);
+
+	bool hasAVX2 = Culling::HasAVX2();
+
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> position(-200, 200), radius(0.1f, 3);
+	for (size_t count : { 0, 1, 7, 9, 1000, 100000 })
+	{
+		size_t padded = (count + Culling::COMPACT_PADDING - 1) / Culling::COMPACT_PADDING * Culling::COMPACT_PADDING;
+		std::vector<float> x(padded, 0), y(padded, 0), z(padded, 10), r(padded, 1); //the padding is visible and must never be listed
+		for (size_t i = 0; i < count; i++)
+		{
+			x[i] = position(random);
+			y[i] = position(random) * 0.3f;
+			z[i] = position(random) + 200;
+			r[i] = radius(random);
+		}
+		std::vector<uint32_t> expected;
+		for (size_t i = 0; i < count; i++)
+			if (Margin(frustum, x[i], y[i], z[i], r[i]) > 0)
+				expected.push_back((uint32_t)i);
+
+		std::vector<unsigned char> visible(padded);
+		Culling::FrustumCullSpheres(frustum, x.data(), y.data(), z.data(), r.data(), padded, visible.data());
+		for (size_t i = 0; i < count; i++)
+			CHECK(visible[i] == (std::binary_search(expected.begin(), expected.end(), (uint32_t)i) ? 1 : 0));
+
+		std::vector<uint32_t> indices(padded);
+		size_t found = Culling::FrustumCullSpheresCompactSSE(frustum, x.data(), y.data(), z.data(), r.data(), count, indices.data());
+		CHECK(found == expected.size() && std::equal(expected.begin(), expected.end(), indices.begin()));
+
+		//the dispatch has to run the same kernel the checks below pick
+		std::vector<uint32_t> dispatched(padded);
+		size_t dispatchedFound = Culling::FrustumCullSpheresCompact(frustum, x.data(), y.data(), z.data(), r.data(), count, dispatched.data());
+		if (!hasAVX2)
+		{
+			CHECK(dispatchedFound == found && std::equal(dispatched.begin(), dispatched.begin() + found, indices.begin()));
+			continue;
+		}
+		//fma rounds differently, so spheres sitting exactly on a plane may land on the other side, nothing else may differ
+		found = Culling::FrustumCullSpheresCompactAVX2(frustum, x.data(), y.data(), z.data(), r.data(), count, indices.data());
+		CHECK(std::is_sorted(indices.begin(), indices.begin() + found));
+		CHECK(dispatchedFound == found && std::equal(dispatched.begin(), dispatched.begin() + found, indices.begin()));
+		std::vector<uint32_t> difference;
+		std::set_symmetric_difference(expected.begin(), expected.end(), indices.begin(), indices.begin() + found, std::back_inserter(difference));
+		for (uint32_t i : difference)
+			CHECK(i < count && std::fabs(Margin(frustum, x[i], y[i], z[i], r[i])) < 1e-3f);
+	}
+
+	//a box turned 45 degrees about y, then moved: the world box has to hold every transformed corner and no more
+	Aabb local = { { -1, -2, -3 }, { 1, 2, 3 } };
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixRotationY(XM_PIDIV4) * XMMatrixTranslation(10, 0, 0));
+	Aabb box = Culling::TransformAabb(local, world);
+	Aabb corners = { { 1e30f, 1e30f, 1e30f }, { -1e30f, -1e30f, -1e30f } };
+	for (int corner = 0; corner < 8; corner++)
+	{
+		XMFLOAT3 p(corner & 1 ? local.max.x : local.min.x, corner & 2 ? local.max.y : local.min.y, corner & 4 ? local.max.z : local.min.z);
+		XMFLOAT3 t;
+		XMStoreFloat3(&t, XMVector3Transform(XMLoadFloat3(&p), XMLoadFloat4x4(&world)));
+		corners.min = { std::min(corners.min.x, t.x), std::min(corners.min.y, t.y), std::min(corners.min.z, t.z) };
+		corners.max = { std::max(corners.max.x, t.x), std::max(corners.max.y, t.y), std::max(corners.max.z, t.z) };
+	}
+	CHECK(std::fabs(box.min.x - corners.min.x) < 1e-5f && std::fabs(box.max.x - corners.max.x) < 1e-5f);
+	CHECK(std::fabs(box.min.y - corners.min.y) < 1e-5f && std::fabs(box.max.y - corners.max.y) < 1e-5f);
+	CHECK(std::fabs(box.min.z - corners.min.z) < 1e-5f && std::fabs(box.max.z - corners.max.z) < 1e-5f);
+
+	CHECK(Culling::TestAabb(frustum, { { -1, -1, 0 }, { 1, 1, 2 } }) == CullResult::Inside);
+	CHECK(Culling::TestAabb(frustum, { { -1, -1, -30 }, { 1, 1, 2 } }) == CullResult::Intersecting); //reaches behind the camera
+	CHECK(Culling::TestAabb(frustum, { { 500, -1, 0 }, { 501, 1, 2 } }) == CullResult::Outside);
+	CHECK(Culling::TestAabb(frustum, { { -1, -1, -30 }, { 1, 1, -20 } }) == CullResult::Outside);
+	return 0;
+}
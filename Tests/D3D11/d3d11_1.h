@@ -0,0 +1,65 @@
+#pragma once
+// Stand-in for the part of d3d11_1.h that D3D11StateCache and D3D11CommandExecutor use, so what they send to the context can be
+// checked without a device (CMakeLists.txt always puts this folder on the headless include path, the real header is Windows only)
+// - same names and signatures, the context is an abstract class the tests implement to see which calls reach it
+// - nothing else of d3d11 is here, the interfaces that are only passed around are empty
+#include <cstdint>
+
+typedef unsigned int UINT;
+typedef int INT;
+typedef long HRESULT;
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT 14
+#define D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT 32
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R16_UINT = 57,
+};
+
+enum D3D11_MAP
+{
+	D3D11_MAP_READ = 1,
+	D3D11_MAP_WRITE = 2,
+	D3D11_MAP_READ_WRITE = 3,
+	D3D11_MAP_WRITE_DISCARD = 4,
+	D3D11_MAP_WRITE_NO_OVERWRITE = 5,
+};
+
+struct D3D11_MAPPED_SUBRESOURCE
+{
+	void* pData;
+	UINT RowPitch;
+	UINT DepthPitch;
+};
+
+struct D3D11_BOX;
+struct ID3D11ClassInstance;
+struct ID3D11Resource {};
+struct ID3D11Buffer : ID3D11Resource {};
+struct ID3D11InputLayout {};
+struct ID3D11VertexShader {};
+struct ID3D11PixelShader {};
+
+struct ID3D11DeviceContext1
+{
+	virtual ~ID3D11DeviceContext1() = default;
+
+	virtual void IASetInputLayout(ID3D11InputLayout* pInputLayout) = 0;
+	virtual void IASetVertexBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppVertexBuffers, const UINT* pStrides, const UINT* pOffsets) = 0;
+	virtual void IASetIndexBuffer(ID3D11Buffer* pIndexBuffer, DXGI_FORMAT Format, UINT Offset) = 0;
+	virtual void VSSetShader(ID3D11VertexShader* pVertexShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances) = 0;
+	virtual void PSSetShader(ID3D11PixelShader* pPixelShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances) = 0;
+	virtual void VSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers) = 0;
+	virtual void PSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers) = 0;
+	virtual void VSSetConstantBuffers1(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers, const UINT* pFirstConstant, const UINT* pNumConstants) = 0;
+	virtual void PSSetConstantBuffers1(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers, const UINT* pFirstConstant, const UINT* pNumConstants) = 0;
+	virtual void UpdateSubresource(ID3D11Resource* pDstResource, UINT DstSubresource, const D3D11_BOX* pDstBox, const void* pSrcData, UINT SrcRowPitch, UINT SrcDepthPitch) = 0;
+	virtual HRESULT Map(ID3D11Resource* pResource, UINT Subresource, D3D11_MAP MapType, UINT MapFlags, D3D11_MAPPED_SUBRESOURCE* pMappedResource) = 0;
+	virtual void Unmap(ID3D11Resource* pResource, UINT Subresource) = 0;
+	virtual void DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation) = 0;
+	virtual void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation) = 0;
+};
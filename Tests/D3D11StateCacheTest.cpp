@@ -0,0 +1,127 @@
+// CommandBuffers full of repeated binds replayed through D3D11CommandExecutor into a context that counts what reaches it:
+// binds that change nothing stop at the D3D11StateCache (within a buffer, across buffers, not across frames), uploads and draws never do
+#include "D3D11CommandExecutor.h"
+#include "TestCheck.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	//never dereferenced, only compared (same as CommandBufferTest)
+	template<typename T>
+	T* Handle(uintptr_t id)
+	{
+		return (T*)(id * 0x1000);
+	}
+
+	//every call the executor can make, counted, maps hand out scratch memory
+	class CountingContext : public ID3D11DeviceContext1
+	{
+	public:
+		unsigned int inputLayouts = 0, vertexShaders = 0, pixelShaders = 0, constantBuffers = 0, constantRanges = 0;
+		unsigned int vertexBuffers = 0, indexBuffers = 0, replaces = 0, maps = 0, draws = 0;
+		std::vector<uint8_t> mapped = std::vector<uint8_t>(1 << 16);
+
+		void IASetInputLayout(ID3D11InputLayout*) override { inputLayouts++; }
+		void IASetVertexBuffers(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) override { vertexBuffers++; }
+		void IASetIndexBuffer(ID3D11Buffer*, DXGI_FORMAT, UINT) override { indexBuffers++; }
+		void VSSetShader(ID3D11VertexShader*, ID3D11ClassInstance* const*, UINT) override { vertexShaders++; }
+		void PSSetShader(ID3D11PixelShader*, ID3D11ClassInstance* const*, UINT) override { pixelShaders++; }
+		void VSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) override { constantBuffers++; }
+		void PSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) override { constantBuffers++; }
+		void VSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) override { constantRanges++; }
+		void PSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) override { constantRanges++; }
+		void UpdateSubresource(ID3D11Resource*, UINT, const D3D11_BOX*, const void*, UINT, UINT) override { replaces++; }
+		HRESULT Map(ID3D11Resource*, UINT, D3D11_MAP, UINT, D3D11_MAPPED_SUBRESOURCE* resource) override
+		{
+			maps++;
+			*resource = { mapped.data(), 0, 0 };
+			return 0;
+		}
+		void Unmap(ID3D11Resource*, UINT) override {}
+		void DrawIndexed(UINT, UINT, INT) override { draws++; }
+		void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) override { draws++; }
+
+		unsigned int Binds() const { return inputLayouts + vertexShaders + pixelShaders + constantBuffers + constantRanges + vertexBuffers + indexBuffers; }
+	};
+
+	const int DRAWS = 100;
+
+	//a careless recorder: every draw binds everything again, only the per object range and every 10th pixel shader differ
+	void RecordFrame(CommandBuffer& commands)
+	{
+		commands.Reset();
+		float perFrame[32] = {};
+		commands.UpdateBuffer(Handle<ID3D11Buffer>(3), perFrame, sizeof(perFrame));
+		for (int i = 0; i < DRAWS; i++)
+		{
+			commands.SetVertexShader(Handle<ID3D11VertexShader>(1), Handle<ID3D11InputLayout>(2));
+			commands.SetPixelShader(Handle<ID3D11PixelShader>(6 + i / 10));
+			commands.SetConstantBuffer(ShaderStage::Vertex, 0, Handle<ID3D11Buffer>(3));
+			commands.SetConstantBuffer(ShaderStage::Pixel, 0, Handle<ID3D11Buffer>(3));
+			commands.SetVertexBuffer(0, Handle<ID3D11Buffer>(4), 32);
+			commands.SetIndexBuffer(Handle<ID3D11Buffer>(5), true);
+			commands.WriteBuffer(Handle<ID3D11Buffer>(30), 256, (i % 64) * 256, BufferWrite::NoOverwrite);
+			commands.SetConstantBuffer(ShaderStage::Vertex, 1, Handle<ID3D11Buffer>(30), (i % 64) * 16, 16);
+			commands.DrawIndexed(36, 0, 0);
+		}
+	}
+}
+
+int main()
+{
+	CommandBuffer commands;
+	RecordFrame(commands);
+	CountingContext context;
+	D3D11CommandExecutor executor;
+	executor.BeginFrame(&context);
+	executor.Execute(commands);
+
+	//only the first of each repeated bind gets through, the changing ones all do
+	const StateCacheStats& stats = executor.GetStateCache().GetStats();
+	std::printf("%u binds recorded, %u issued, %u elided\n", stats.GetIssued() + stats.GetElided(), stats.GetIssued(), stats.GetElided());
+	CHECK(context.inputLayouts == 1 && context.vertexShaders == 1 && context.vertexBuffers == 1 && context.indexBuffers == 1);
+	CHECK(context.pixelShaders == DRAWS / 10);
+	CHECK(context.constantBuffers == 2); //PerFrameData in both stages
+	CHECK(context.constantRanges == DRAWS); //the per object range moves every draw
+	CHECK(context.Binds() == stats.GetIssued());
+	CHECK(stats.elided[(size_t)StateCall::VertexShader] == DRAWS - 1 && stats.elided[(size_t)StateCall::InputLayout] == DRAWS - 1);
+	CHECK(stats.elided[(size_t)StateCall::PixelShader] == DRAWS - DRAWS / 10);
+	CHECK(stats.elided[(size_t)StateCall::ConstantBuffer] == 2 * (DRAWS - 1));
+	CHECK(stats.elided[(size_t)StateCall::VertexBuffer] == DRAWS - 1 && stats.elided[(size_t)StateCall::IndexBuffer] == DRAWS - 1);
+	//uploads and draws aren't the cache's business
+	CHECK(context.replaces == 1 && context.maps == DRAWS && context.draws == DRAWS);
+
+	//NullCommandExecutor spots the same redundant binds, it counts a shader and its layout as one
+	NullCommandExecutor validator;
+	validator.Execute(commands);
+	CHECK(validator.GetErrorCount() == 0);
+	CHECK(validator.GetStats().redundantBinds == stats.GetElided() - stats.elided[(size_t)StateCall::InputLayout]);
+
+	//a second buffer in the same frame starts from what the first left bound, so its repeats are dropped too
+	unsigned int bindsBefore = context.Binds();
+	CommandBuffer more;
+	more.SetVertexShader(Handle<ID3D11VertexShader>(1), Handle<ID3D11InputLayout>(2));
+	more.SetIndexBuffer(Handle<ID3D11Buffer>(5), true);
+	more.SetVertexBuffer(0, Handle<ID3D11Buffer>(4), 32);
+	more.DrawIndexed(36, 0, 0);
+	executor.Execute(more);
+	CHECK(context.Binds() == bindsBefore && context.draws == DRAWS + 1);
+	//anything that differs in the slightest goes through: format, offset, stride, range
+	more.Reset();
+	more.SetIndexBuffer(Handle<ID3D11Buffer>(5), false);
+	more.SetVertexBuffer(0, Handle<ID3D11Buffer>(4), 32, 64);
+	more.SetVertexBuffer(0, Handle<ID3D11Buffer>(4), 16, 64);
+	more.SetConstantBuffer(ShaderStage::Vertex, 1, Handle<ID3D11Buffer>(30), 0, 32);
+	executor.Execute(more);
+	CHECK(context.indexBuffers == 2 && context.vertexBuffers == 3 && context.constantRanges == DRAWS + 1);
+
+	//a new frame forgets everything (something else may have touched the context), the first binds go through again
+	executor.BeginFrame(&context);
+	CHECK(executor.GetStateCache().GetStats().GetIssued() == 0 && executor.GetStateCache().GetStats().GetElided() == 0);
+	bindsBefore = context.Binds();
+	executor.Execute(commands);
+	CHECK(context.Binds() - bindsBefore == stats.GetIssued() && context.vertexShaders == 2);
+	return 0;
+}
@@ -0,0 +1,469 @@
+#pragma once
+// Stand-in for the part of DirectXMath the headless targets use, for machines without the real library
+// (CMakeLists.txt only puts this folder on the include path when find_package(directxmath) fails)
+// - same names, layouts and conventions (row vectors, left handed, XMQuaternionMultiply(q1, q2) = q1 then q2)
+// - plain scalar code on top of __m128, correct rather than fast, so don't benchmark the math itself with it
+#include <cmath>
+#include <cstdint>
+#include <xmmintrin.h>
+
+#define XM_CALLCONV
+
+namespace DirectX
+{
+	constexpr float XM_PI = 3.141592654f;
+	constexpr float XM_2PI = 6.283185307f;
+	constexpr float XM_1DIV2PI = 0.159154943f;
+	constexpr float XM_PIDIV2 = 1.570796327f;
+	constexpr float XM_PIDIV4 = 0.785398163f;
+
+	inline constexpr float XMConvertToRadians(float degrees) { return degrees * (XM_PI / 180.0f); }
+	inline constexpr float XMConvertToDegrees(float radians) { return radians * (180.0f / XM_PI); }
+
+	struct XMFLOAT2
+	{
+		float x, y;
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float x, float y) : x(x), y(y) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x, y, z;
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {}
+		explicit XMFLOAT3(const float* array) : x(array[0]), y(array[1]), z(array[2]) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	};
+
+	struct XMFLOAT3X3
+	{
+		union
+		{
+			struct { float _11, _12, _13, _21, _22, _23, _31, _32, _33; };
+			float m[3][3];
+		};
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct { float _11, _12, _13, _14, _21, _22, _23, _24, _31, _32, _33, _34, _41, _42, _43, _44; };
+			float m[4][4];
+		};
+	};
+
+	typedef __m128 XMVECTOR;
+	typedef const XMVECTOR& FXMVECTOR;
+	typedef const XMVECTOR& GXMVECTOR;
+	typedef const XMVECTOR& HXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+	};
+	typedef const XMMATRIX& FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	namespace StandIn
+	{
+		union Lanes
+		{
+			XMVECTOR v;
+			float f[4];
+		};
+
+		inline float Get(FXMMATRIX m, int row, int column)
+		{
+			Lanes lanes{ m.r[row] };
+			return lanes.f[column];
+		}
+
+		inline XMMATRIX Make(const float f[4][4])
+		{
+			XMMATRIX m;
+			for (int row = 0; row < 4; row++)
+				m.r[row] = _mm_setr_ps(f[row][0], f[row][1], f[row][2], f[row][3]);
+			return m;
+		}
+	}
+
+	// Vectors
+
+	inline float XMVectorGetX(FXMVECTOR v) { StandIn::Lanes l{ v }; return l.f[0]; }
+	inline float XMVectorGetY(FXMVECTOR v) { StandIn::Lanes l{ v }; return l.f[1]; }
+	inline float XMVectorGetZ(FXMVECTOR v) { StandIn::Lanes l{ v }; return l.f[2]; }
+	inline float XMVectorGetW(FXMVECTOR v) { StandIn::Lanes l{ v }; return l.f[3]; }
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+	inline XMVECTOR XMVectorReplicate(float value) { return _mm_set1_ps(value); }
+	inline XMVECTOR XMVectorZero() { return _mm_setzero_ps(); }
+	inline XMVECTOR XMVectorSplatX(FXMVECTOR v) { return _mm_set1_ps(XMVectorGetX(v)); }
+	inline XMVECTOR XMVectorSplatY(FXMVECTOR v) { return _mm_set1_ps(XMVectorGetY(v)); }
+	inline XMVECTOR XMVectorSplatZ(FXMVECTOR v) { return _mm_set1_ps(XMVectorGetZ(v)); }
+	inline XMVECTOR XMVectorSplatW(FXMVECTOR v) { return _mm_set1_ps(XMVectorGetW(v)); }
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b) { return _mm_add_ps(a, b); }
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) { return _mm_sub_ps(a, b); }
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b) { return _mm_mul_ps(a, b); }
+	inline XMVECTOR XMVectorDivide(FXMVECTOR a, FXMVECTOR b) { return _mm_div_ps(a, b); }
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	inline XMVECTOR XMVectorScale(FXMVECTOR v, float scale) { return _mm_mul_ps(v, _mm_set1_ps(scale)); }
+	inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b) { return _mm_min_ps(a, b); }
+	inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b) { return _mm_max_ps(a, b); }
+	inline XMVECTOR XMVectorNegate(FXMVECTOR v) { return _mm_sub_ps(_mm_setzero_ps(), v); }
+	inline XMVECTOR XMVectorAbs(FXMVECTOR v) { return _mm_max_ps(v, XMVectorNegate(v)); }
+	inline XMVECTOR XMVectorLerp(FXMVECTOR a, FXMVECTOR b, float t) { return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t))); }
+
+	inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b)
+	{
+		StandIn::Lanes x{ a }, y{ b };
+		return _mm_set1_ps(x.f[0] * y.f[0] + x.f[1] * y.f[1] + x.f[2] * y.f[2]);
+	}
+
+	inline XMVECTOR XMVector4Dot(FXMVECTOR a, FXMVECTOR b)
+	{
+		StandIn::Lanes x{ a }, y{ b };
+		return _mm_set1_ps(x.f[0] * y.f[0] + x.f[1] * y.f[1] + x.f[2] * y.f[2] + x.f[3] * y.f[3]);
+	}
+
+	inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+	{
+		StandIn::Lanes x{ a }, y{ b };
+		return XMVectorSet(x.f[1] * y.f[2] - x.f[2] * y.f[1], x.f[2] * y.f[0] - x.f[0] * y.f[2], x.f[0] * y.f[1] - x.f[1] * y.f[0], 0);
+	}
+
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR v) { return XMVector3Dot(v, v); }
+	inline XMVECTOR XMVector3Length(FXMVECTOR v) { return _mm_sqrt_ps(XMVector3Dot(v, v)); }
+	inline XMVECTOR XMVector4Length(FXMVECTOR v) { return _mm_sqrt_ps(XMVector4Dot(v, v)); }
+
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v)
+	{
+		float length = XMVectorGetX(XMVector3Length(v));
+		return length > 0 ? _mm_div_ps(v, _mm_set1_ps(length)) : v;
+	}
+
+	inline XMVECTOR XMVector4Normalize(FXMVECTOR v)
+	{
+		float length = XMVectorGetX(XMVector4Length(v));
+		return length > 0 ? _mm_div_ps(v, _mm_set1_ps(length)) : v;
+	}
+
+	//normalizes by the xyz length, w scales along with it
+	inline XMVECTOR XMPlaneNormalize(FXMVECTOR plane) { return XMVector3Normalize(plane); }
+
+	// Loads and stores
+
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* source) { return XMVectorSet(source->x, source->y, source->z, 0); }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* source) { return XMVectorSet(source->x, source->y, source->z, source->w); }
+
+	inline void XMStoreFloat3(XMFLOAT3* destination, FXMVECTOR v)
+	{
+		StandIn::Lanes l{ v };
+		*destination = XMFLOAT3(l.f[0], l.f[1], l.f[2]);
+	}
+
+	inline void XMStoreFloat4(XMFLOAT4* destination, FXMVECTOR v)
+	{
+		StandIn::Lanes l{ v };
+		*destination = XMFLOAT4(l.f[0], l.f[1], l.f[2], l.f[3]);
+	}
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* source) { return StandIn::Make(source->m); }
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* destination, FXMMATRIX m)
+	{
+		for (int row = 0; row < 4; row++)
+			for (int column = 0; column < 4; column++)
+				destination->m[row][column] = StandIn::Get(m, row, column);
+	}
+
+	inline void XMStoreFloat3x3(XMFLOAT3X3* destination, FXMMATRIX m)
+	{
+		for (int row = 0; row < 3; row++)
+			for (int column = 0; column < 3; column++)
+				destination->m[row][column] = StandIn::Get(m, row, column);
+	}
+
+	// Matrices
+
+	inline XMMATRIX XMMatrixIdentity()
+	{
+		const float f[4][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+		return StandIn::Make(f);
+	}
+
+	inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b)
+	{
+		float f[4][4];
+		for (int row = 0; row < 4; row++)
+			for (int column = 0; column < 4; column++)
+			{
+				float sum = 0;
+				for (int k = 0; k < 4; k++)
+					sum += StandIn::Get(a, row, k) * StandIn::Get(b, k, column);
+				f[row][column] = sum;
+			}
+		return StandIn::Make(f);
+	}
+
+	inline XMMATRIX operator*(FXMMATRIX a, CXMMATRIX b) { return XMMatrixMultiply(a, b); }
+
+	inline XMMATRIX XMMatrixTranspose(FXMMATRIX m)
+	{
+		float f[4][4];
+		for (int row = 0; row < 4; row++)
+			for (int column = 0; column < 4; column++)
+				f[row][column] = StandIn::Get(m, column, row);
+		return StandIn::Make(f);
+	}
+
+	//gauss-jordan in double, a singular matrix comes back unchanged with a zero determinant
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* determinant, FXMMATRIX m)
+	{
+		double a[4][8];
+		for (int row = 0; row < 4; row++)
+			for (int column = 0; column < 8; column++)
+				a[row][column] = column < 4 ? StandIn::Get(m, row, column) : (column - 4 == row);
+
+		double det = 1;
+		for (int column = 0; column < 4; column++)
+		{
+			int pivot = column;
+			for (int row = column + 1; row < 4; row++)
+				if (std::fabs(a[row][column]) > std::fabs(a[pivot][column]))
+					pivot = row;
+			if (pivot != column)
+			{
+				for (int j = 0; j < 8; j++)
+				{
+					double swap = a[column][j];
+					a[column][j] = a[pivot][j];
+					a[pivot][j] = swap;
+				}
+				det = -det;
+			}
+
+			double value = a[column][column];
+			det *= value;
+			if (value == 0)
+			{
+				if (determinant)
+					*determinant = _mm_setzero_ps();
+				return m;
+			}
+			for (int j = 0; j < 8; j++)
+				a[column][j] /= value;
+			for (int row = 0; row < 4; row++)
+				if (row != column)
+				{
+					double factor = a[row][column];
+					for (int j = 0; j < 8; j++)
+						a[row][j] -= factor * a[column][j];
+				}
+		}
+
+		if (determinant)
+			*determinant = _mm_set1_ps((float)det);
+		float f[4][4];
+		for (int row = 0; row < 4; row++)
+			for (int column = 0; column < 4; column++)
+				f[row][column] = (float)a[row][column + 4];
+		return StandIn::Make(f);
+	}
+
+	inline XMMATRIX XMMatrixTranslation(float x, float y, float z)
+	{
+		const float f[4][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { x, y, z, 1 } };
+		return StandIn::Make(f);
+	}
+
+	inline XMMATRIX XMMatrixScaling(float x, float y, float z)
+	{
+		const float f[4][4] = { { x, 0, 0, 0 }, { 0, y, 0, 0 }, { 0, 0, z, 0 }, { 0, 0, 0, 1 } };
+		return StandIn::Make(f);
+	}
+
+	inline XMMATRIX XMMatrixTranslationFromVector(FXMVECTOR v) { return XMMatrixTranslation(XMVectorGetX(v), XMVectorGetY(v), XMVectorGetZ(v)); }
+	inline XMMATRIX XMMatrixScalingFromVector(FXMVECTOR v) { return XMMatrixScaling(XMVectorGetX(v), XMVectorGetY(v), XMVectorGetZ(v)); }
+
+	inline XMMATRIX XMMatrixRotationX(float angle)
+	{
+		float c = std::cos(angle), s = std::sin(angle);
+		const float f[4][4] = { { 1, 0, 0, 0 }, { 0, c, s, 0 }, { 0, -s, c, 0 }, { 0, 0, 0, 1 } };
+		return StandIn::Make(f);
+	}
+
+	inline XMMATRIX XMMatrixRotationY(float angle)
+	{
+		float c = std::cos(angle), s = std::sin(angle);
+		const float f[4][4] = { { c, 0, -s, 0 }, { 0, 1, 0, 0 }, { s, 0, c, 0 }, { 0, 0, 0, 1 } };
+		return StandIn::Make(f);
+	}
+
+	inline XMMATRIX XMMatrixRotationZ(float angle)
+	{
+		float c = std::cos(angle), s = std::sin(angle);
+		const float f[4][4] = { { c, s, 0, 0 }, { -s, c, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+		return StandIn::Make(f);
+	}
+
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float fovAngleY, float aspectRatio, float nearZ, float farZ)
+	{
+		float height = 1.0f / std::tan(fovAngleY * 0.5f);
+		float width = height / aspectRatio;
+		float range = farZ / (farZ - nearZ);
+		const float f[4][4] = { { width, 0, 0, 0 }, { 0, height, 0, 0 }, { 0, 0, range, 1 }, { 0, 0, -range * nearZ, 0 } };
+		return StandIn::Make(f);
+	}
+
+	inline XMMATRIX XMMatrixLookToLH(FXMVECTOR eyePosition, FXMVECTOR eyeDirection, FXMVECTOR upDirection)
+	{
+		XMVECTOR z = XMVector3Normalize(eyeDirection);
+		XMVECTOR x = XMVector3Normalize(XMVector3Cross(upDirection, z));
+		XMVECTOR y = XMVector3Cross(z, x);
+		const float f[4][4] =
+		{
+			{ XMVectorGetX(x), XMVectorGetX(y), XMVectorGetX(z), 0 },
+			{ XMVectorGetY(x), XMVectorGetY(y), XMVectorGetY(z), 0 },
+			{ XMVectorGetZ(x), XMVectorGetZ(y), XMVectorGetZ(z), 0 },
+			{ -XMVectorGetX(XMVector3Dot(x, eyePosition)), -XMVectorGetX(XMVector3Dot(y, eyePosition)), -XMVectorGetX(XMVector3Dot(z, eyePosition)), 1 },
+		};
+		return StandIn::Make(f);
+	}
+
+	inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m)
+	{
+		StandIn::Lanes l{ v };
+		float out[4];
+		for (int column = 0; column < 4; column++)
+		{
+			out[column] = 0;
+			for (int k = 0; k < 4; k++)
+				out[column] += l.f[k] * StandIn::Get(m, k, column);
+		}
+		return XMVectorSet(out[0], out[1], out[2], out[3]);
+	}
+
+	inline XMVECTOR XMVector3Transform(FXMVECTOR v, FXMMATRIX m)
+	{
+		StandIn::Lanes l{ v };
+		l.f[3] = 1;
+		return XMVector4Transform(l.v, m);
+	}
+
+	inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = XMVector3Transform(v, m);
+		return _mm_div_ps(result, _mm_set1_ps(XMVectorGetW(result)));
+	}
+
+	inline XMVECTOR XMVector3TransformNormal(FXMVECTOR v, FXMMATRIX m)
+	{
+		StandIn::Lanes l{ v };
+		l.f[3] = 0;
+		return XMVector4Transform(l.v, m);
+	}
+
+	// Quaternions
+
+	inline XMVECTOR XMQuaternionIdentity() { return XMVectorSet(0, 0, 0, 1); }
+	inline XMVECTOR XMQuaternionNormalize(FXMVECTOR q) { return XMVector4Normalize(q); }
+
+	inline XMVECTOR XMQuaternionConjugate(FXMVECTOR q)
+	{
+		StandIn::Lanes l{ q };
+		return XMVectorSet(-l.f[0], -l.f[1], -l.f[2], l.f[3]);
+	}
+
+	//rotation q1 followed by rotation q2 (the product q2 * q1)
+	inline XMVECTOR XMQuaternionMultiply(FXMVECTOR q1, FXMVECTOR q2)
+	{
+		StandIn::Lanes a{ q2 }, b{ q1 };
+		return XMVectorSet(
+			a.f[3] * b.f[0] + a.f[0] * b.f[3] + a.f[1] * b.f[2] - a.f[2] * b.f[1],
+			a.f[3] * b.f[1] - a.f[0] * b.f[2] + a.f[1] * b.f[3] + a.f[2] * b.f[0],
+			a.f[3] * b.f[2] + a.f[0] * b.f[1] - a.f[1] * b.f[0] + a.f[2] * b.f[3],
+			a.f[3] * b.f[3] - a.f[0] * b.f[0] - a.f[1] * b.f[1] - a.f[2] * b.f[2]);
+	}
+
+	//roll about z, then pitch about x, then yaw about y
+	inline XMVECTOR XMQuaternionRotationRollPitchYaw(float pitch, float yaw, float roll)
+	{
+		float cp = std::cos(pitch * 0.5f), sp = std::sin(pitch * 0.5f);
+		float cy = std::cos(yaw * 0.5f), sy = std::sin(yaw * 0.5f);
+		float cr = std::cos(roll * 0.5f), sr = std::sin(roll * 0.5f);
+		return XMVectorSet(
+			sp * cy * cr + cp * sy * sr,
+			cp * sy * cr - sp * cy * sr,
+			cp * cy * sr - sp * sy * cr,
+			cp * cy * cr + sp * sy * sr);
+	}
+
+	inline XMVECTOR XMQuaternionRotationRollPitchYawFromVector(FXMVECTOR angles)
+	{
+		return XMQuaternionRotationRollPitchYaw(XMVectorGetX(angles), XMVectorGetY(angles), XMVectorGetZ(angles));
+	}
+
+	inline XMVECTOR XMQuaternionRotationNormal(FXMVECTOR normalAxis, float angle)
+	{
+		float s = std::sin(angle * 0.5f);
+		return XMVectorSet(XMVectorGetX(normalAxis) * s, XMVectorGetY(normalAxis) * s, XMVectorGetZ(normalAxis) * s, std::cos(angle * 0.5f));
+	}
+
+	inline XMVECTOR XMQuaternionRotationAxis(FXMVECTOR axis, float angle) { return XMQuaternionRotationNormal(XMVector3Normalize(axis), angle); }
+
+	inline XMVECTOR XMQuaternionSlerp(FXMVECTOR q0, FXMVECTOR q1, float t)
+	{
+		XMVECTOR end = q1;
+		float cosOmega = XMVectorGetX(XMVector4Dot(q0, end));
+		if (cosOmega < 0)
+		{
+			end = XMVectorNegate(end);
+			cosOmega = -cosOmega;
+		}
+		if (cosOmega > 0.9995f)
+			return XMVector4Normalize(XMVectorLerp(q0, end, t));
+		float omega = std::acos(cosOmega);
+		float sinOmega = std::sin(omega);
+		return _mm_add_ps(XMVectorScale(q0, std::sin((1 - t) * omega) / sinOmega), XMVectorScale(end, std::sin(t * omega) / sinOmega));
+	}
+
+	inline XMMATRIX XMMatrixRotationQuaternion(FXMVECTOR q)
+	{
+		StandIn::Lanes l{ q };
+		float x = l.f[0], y = l.f[1], z = l.f[2], w = l.f[3];
+		const float f[4][4] =
+		{
+			{ 1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0 },
+			{ 2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0 },
+			{ 2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0 },
+			{ 0, 0, 0, 1 },
+		};
+		return StandIn::Make(f);
+	}
+
+	inline XMMATRIX XMMatrixRotationRollPitchYaw(float pitch, float yaw, float roll)
+	{
+		return XMMatrixRotationQuaternion(XMQuaternionRotationRollPitchYaw(pitch, yaw, roll));
+	}
+
+	inline XMMATRIX XMMatrixRotationRollPitchYawFromVector(FXMVECTOR angles)
+	{
+		return XMMatrixRotationQuaternion(XMQuaternionRotationRollPitchYawFromVector(angles));
+	}
+
+	inline XMVECTOR XMVector3Rotate(FXMVECTOR v, FXMVECTOR q)
+	{
+		XMVECTOR pure = XMVectorSet(XMVectorGetX(v), XMVectorGetY(v), XMVectorGetZ(v), 0);
+		return XMQuaternionMultiply(XMQuaternionMultiply(XMQuaternionConjugate(q), pure), q);
+	}
+}
@@ -0,0 +1,105 @@
+// DynamicBvh at 1k/10k/100k proxies: building it, refitting 10% moved, and the queries against a linear frustum test
+#include "DynamicBvh.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	double Since(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	template<typename Run>
+	double Best(Run run)
+	{
+		double best = 1e9;
+		for (int repeat = 0; repeat < 10; repeat++)
+		{
+			Clock::time_point start = Clock::now();
+			run();
+			best = std::min(best, Since(start));
+		}
+		return best;
+	}
+
+	Aabb BoxAt(XMFLOAT3 center, float halfSize)
+	{
+		return { { center.x - halfSize, center.y - halfSize, center.z - halfSize }, { center.x + halfSize, center.y + halfSize, center.z + halfSize } };
+	}
+}
+
+int main()
+{
+	std::mt19937 random(9);
+	std::uniform_real_distribution<float> unit(-1, 1);
+	ThreadPool pool;
+
+	std::printf("%8s %9s %9s %9s %10s %9s %9s %9s %9s\n", "proxies", "insert", "build 1t", "build mt", "refit 10%", "frustum", "linear", "ray", "aabb");
+	for (int count : { 1000, 10000, 100000 })
+	{
+		float worldSize = std::cbrt((float)count) * 4; //same density at every size
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixLookToLH(XMVectorSet(0, 0, -50, 1), XMVectorSet(0.3f, 0, 1, 0), XMVectorSet(0, 1, 0, 0)) *
+			XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 300.0f));
+		Frustum frustum = Culling::ExtractFrustum(viewProjection);
+
+		DynamicBvh bvh(0.2f);
+		std::vector<XMFLOAT3> positions(count);
+		std::vector<int> proxies(count);
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			positions[i] = { unit(random) * worldSize, unit(random) * worldSize, unit(random) * worldSize };
+			proxies[i] = bvh.Insert(BoxAt(positions[i], 0.5f), i);
+		}
+		double insert = Since(start);
+		float incrementalCost = bvh.GetCost();
+		start = Clock::now();
+		bvh.Rebuild();
+		double build = Since(start);
+		float rebuiltCost = bvh.GetCost();
+		start = Clock::now();
+		bvh.Rebuild(&pool);
+		double buildParallel = Since(start);
+
+		//a full unit, out of the fat boxes
+		start = Clock::now();
+		for (int i = 0; i < count / 10; i++)
+		{
+			int moved = random() % count;
+			positions[moved].x += 1.0f;
+			bvh.Move(proxies[moved], BoxAt(positions[moved], 0.5f));
+		}
+		double refit = Since(start);
+
+		std::vector<uint64_t> results;
+		volatile size_t sink = 0;
+		double frustumQuery = Best([&] { results.clear(); bvh.QueryFrustum(frustum, results); sink = results.size(); });
+		size_t visible = results.size();
+		double linear = Best([&]
+		{
+			size_t found = 0;
+			for (int proxy : proxies)
+				found += Culling::TestAabb(frustum, bvh.GetFatAabb(proxy)) != CullResult::Outside;
+			sink = found;
+		});
+		double ray = Best([&] { results.clear(); bvh.QueryRay({ -worldSize * 2, 0.1f, 0.2f }, { 1, 0.01f, -0.02f }, worldSize * 4, results); });
+		double box = Best([&] { results.clear(); bvh.QueryAabb(BoxAt({ 0, 0, 0 }, worldSize * 0.1f), results); });
+
+		std::printf("%8d %7.2fms %7.2fms %7.2fms %8.2fms %7.3fms %7.3fms %7.3fms %7.3fms  (%zu in frustum, cost %.1f incremental %.1f rebuilt, height %u)\n",
+			count, insert, build, buildParallel, refit, frustumQuery, linear, ray, box, visible, incrementalCost, rebuiltCost, bvh.GetHeight());
+	}
+	std::printf("%u pool threads\n", pool.GetThreadCount());
+	return 0;
+}
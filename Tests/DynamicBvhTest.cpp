@@ -0,0 +1,138 @@
+// DynamicBvh queries against brute force over the fat boxes, through inserts, rebuilds (1 and n threads), moves and removals
+#include "DynamicBvh.h"
+#include "TestCheck.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	Aabb BoxAt(XMFLOAT3 center, float halfSize)
+	{
+		return { { center.x - halfSize, center.y - halfSize, center.z - halfSize }, { center.x + halfSize, center.y + halfSize, center.z + halfSize } };
+	}
+
+	bool Overlaps(const Aabb& a, const Aabb& b)
+	{
+		return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y && a.min.z <= b.max.z && a.max.z >= b.min.z;
+	}
+
+	bool RayHits(const Aabb& box, XMFLOAT3 origin, XMFLOAT3 direction, float maxDistance)
+	{
+		const float o[3] = { origin.x, origin.y, origin.z }, d[3] = { direction.x, direction.y, direction.z };
+		const float lo[3] = { box.min.x, box.min.y, box.min.z }, hi[3] = { box.max.x, box.max.y, box.max.z };
+		float near = 0, far = maxDistance;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float t1 = (lo[axis] - o[axis]) / d[axis], t2 = (hi[axis] - o[axis]) / d[axis];
+			near = std::max(near, std::min(t1, t2));
+			far = std::min(far, std::max(t1, t2));
+		}
+		return near <= far;
+	}
+
+	//every live proxy whose fat box passes, as userData, sorted
+	template<typename Passes>
+	std::vector<uint64_t> BruteForce(const DynamicBvh& bvh, const std::vector<int>& proxies, Passes passes)
+	{
+		std::vector<uint64_t> expected;
+		for (int proxy : proxies)
+			if (proxy >= 0 && passes(bvh.GetFatAabb(proxy)))
+				expected.push_back(bvh.GetUserData(proxy));
+		std::sort(expected.begin(), expected.end());
+		return expected;
+	}
+
+	std::vector<uint64_t> Sorted(std::vector<uint64_t> results)
+	{
+		std::sort(results.begin(), results.end());
+		return results;
+	}
+
+	void CheckQueries(const DynamicBvh& bvh, const std::vector<int>& proxies, float worldSize)
+	{
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixLookToLH(XMVectorSet(0, 0, -worldSize, 1), XMVectorSet(0.3f, 0, 1, 0), XMVectorSet(0, 1, 0, 0)) *
+			XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, worldSize * 1.5f));
+		Frustum frustum = Culling::ExtractFrustum(viewProjection);
+		std::vector<uint64_t> results;
+		bvh.QueryFrustum(frustum, results);
+		std::vector<uint64_t> expected = BruteForce(bvh, proxies, [&](const Aabb& box) { return Culling::TestAabb(frustum, box) != CullResult::Outside; });
+		CHECK(!expected.empty() && Sorted(results) == expected); //equal sorted also means nothing was reported twice
+
+		Aabb region = BoxAt({ 0, 0, 0 }, worldSize * 0.2f);
+		results.clear();
+		bvh.QueryAabb(region, results);
+		CHECK(Sorted(results) == BruteForce(bvh, proxies, [&](const Aabb& box) { return Overlaps(box, region); }));
+
+		XMFLOAT3 origin(-worldSize * 2, 0.1f, 0.2f), direction(1, 0.01f, -0.02f);
+		results.clear();
+		bvh.QueryRay(origin, direction, worldSize * 4, results);
+		CHECK(Sorted(results) == BruteForce(bvh, proxies, [&](const Aabb& box) { return RayHits(box, origin, direction, worldSize * 4); }));
+	}
+}
+
+int main()
+{
+	const int count = 10000;
+	const float worldSize = 90;
+	std::mt19937 random(9);
+	std::uniform_real_distribution<float> unit(-1, 1);
+
+	DynamicBvh bvh(0.2f);
+	std::vector<XMFLOAT3> positions(count);
+	std::vector<int> proxies(count);
+	for (int i = 0; i < count; i++)
+	{
+		positions[i] = { unit(random) * worldSize, unit(random) * worldSize, unit(random) * worldSize };
+		proxies[i] = bvh.Insert(BoxAt(positions[i], 0.5f), 1000 + i);
+		CHECK(bvh.GetUserData(proxies[i]) == (uint64_t)(1000 + i));
+	}
+	CHECK(bvh.GetProxyCount() == count);
+	CheckQueries(bvh, proxies, worldSize);
+
+	float incremental = bvh.GetCost();
+	bvh.Rebuild();
+	float rebuilt = bvh.GetCost();
+	std::printf("cost incremental %.1f, rebuilt %.1f, height %u\n", incremental, rebuilt, bvh.GetHeight());
+	CHECK(rebuilt <= incremental);
+	CHECK(bvh.GetHeight() < 40);
+	CheckQueries(bvh, proxies, worldSize);
+
+	ThreadPool pool;
+	bvh.Rebuild(&pool);
+	CHECK(std::fabs(bvh.GetCost() - rebuilt) < rebuilt * 0.01f); //same splits, only the order nodes were allocated in differs
+	CheckQueries(bvh, proxies, worldSize);
+
+	//moves inside the fat box are free, ones out of it refit and count towards the next rebuild
+	CHECK(!bvh.Move(proxies[0], BoxAt({ positions[0].x + 0.1f, positions[0].y, positions[0].z }, 0.5f)));
+	CHECK(bvh.GetRefitRatio() == 0);
+	for (int i = 0; i < count / 10; i++)
+	{
+		int moved = random() % count;
+		positions[moved].x += 1.0f;
+		CHECK(bvh.Move(proxies[moved], BoxAt(positions[moved], 0.5f)));
+	}
+	CHECK(bvh.GetRefitRatio() > 0);
+	CheckQueries(bvh, proxies, worldSize);
+
+	//remove every other one, queries must not see them, then put them back
+	for (int i = 0; i < count; i += 2)
+	{
+		bvh.Remove(proxies[i]);
+		proxies[i] = -1;
+	}
+	CHECK(bvh.GetProxyCount() == count / 2);
+	CheckQueries(bvh, proxies, worldSize);
+	for (int i = 0; i < count; i += 2)
+		proxies[i] = bvh.Insert(BoxAt(positions[i], 0.5f), 1000 + i);
+	CHECK(bvh.GetProxyCount() == count);
+	CheckQueries(bvh, proxies, worldSize);
+	return 0;
+}
@@ -0,0 +1,94 @@
+// 100k entities in EntityWorld against the old shared_ptr GameObject list: spawning, the per frame walk, and churn
+#include "Components.h"
+#include "EntityWorld.h"
+#include "Transform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+	//what Game kept before EntityWorld, every part its own allocation
+	struct GameObject
+	{
+		std::shared_ptr<int> mesh;
+		std::shared_ptr<Transform> transform;
+		std::shared_ptr<int> material;
+	};
+
+	double Since(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+int main()
+{
+	const int count = 100000;
+	std::mt19937 random(1);
+	Mesh* mesh = (Mesh*)0x10;
+	Material* material = (Material*)0x20;
+	TransformPool& pool = TransformPool::Get();
+
+	EntityWorld world;
+	std::vector<Entity> entities;
+	entities.reserve(count);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < count; i++)
+		entities.push_back(world.Create(Transform(), MeshRef{ mesh }, MaterialRef{ material }));
+	double spawn = Since(start);
+
+	std::vector<std::shared_ptr<GameObject>> objects;
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < count; i++)
+	{
+		auto object = std::make_shared<GameObject>();
+		object->mesh = std::make_shared<int>(1);
+		object->transform = std::make_shared<Transform>();
+		object->material = std::make_shared<int>(2);
+		objects.push_back(object);
+	}
+	double spawnObjects = Since(start);
+	std::shuffle(objects.begin(), objects.end(), random); //heap order no longer matches list order, like after a session of spawning and despawning
+	pool.UpdateDirty();
+
+	double walk = 1e9, walkObjects = 1e9;
+	volatile float sink = 0;
+	for (int repeat = 0; repeat < 5; repeat++)
+	{
+		float sum = 0;
+		start = std::chrono::high_resolution_clock::now();
+		world.Each<Transform, MeshRef, MaterialRef>([&](Entity, Transform& transform, MeshRef& meshRef, MaterialRef& materialRef)
+		{
+			sum += pool.GetWorldMatrix(transform.getPoolIndex())._41 + (meshRef.mesh != nullptr) + (materialRef.material != nullptr);
+		});
+		walk = std::min(walk, Since(start));
+		sink = sum;
+
+		sum = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for (auto& object : objects)
+			sum += pool.GetWorldMatrix(object->transform->getPoolIndex())._41 + *object->mesh + *object->material;
+		walkObjects = std::min(walkObjects, Since(start));
+		sink = sum;
+	}
+	objects.clear();
+
+	//despawn half at random, then spawn them again
+	std::shuffle(entities.begin(), entities.end(), random);
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < count / 2; i++)
+		world.Destroy(entities[i]);
+	for (int i = 0; i < count / 2; i++)
+		entities[i] = world.Create(Transform(), MeshRef{ mesh }, MaterialRef{ material });
+	double churn = Since(start);
+
+	//the sums get printed so the walks can't be optimized away
+	std::printf("%d entities: walk %.2f ms (shared_ptr list %.2f ms), spawn %.2f ms (shared_ptr list %.2f ms), %d despawn + respawn %.2f ms, sum %g\n",
+		count, walk, walkObjects, spawn, spawnObjects, count / 2, churn, (double)sink);
+	return 0;
+}
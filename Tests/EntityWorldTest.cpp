@@ -0,0 +1,81 @@
+// EntityWorld: components surviving archetype moves, stale handles, slot reuse and queries
+#include "Components.h"
+#include "EntityWorld.h"
+#include "TestCheck.h"
+#include "Transform.h"
+
+#include <vector>
+
+namespace
+{
+	struct Tag
+	{
+		int value;
+	};
+}
+
+int main()
+{
+	EntityWorld world;
+	Mesh* mesh = (Mesh*)0x10; //never dereferenced, only compared
+	Material* material = (Material*)0x20;
+
+	Entity a = world.Create(Transform(), MeshRef{ mesh }, MaterialRef{ material });
+	Entity b = world.Create(Transform(), MeshRef{ mesh }, MaterialRef{ material });
+	world.Get<Transform>(a)->setPosition(1, 2, 3);
+	world.Get<Transform>(b)->setPosition(4, 5, 6);
+	unsigned int poolIndex = world.Get<Transform>(a)->getPoolIndex();
+	CHECK(world.GetCount() == 2 && world.GetArchetypeCount() == 1);
+
+	//adding a component moves a to a new archetype, everything it had comes along and b is untouched
+	world.Add(a, Tag{ 7 });
+	CHECK(world.Get<Tag>(a)->value == 7);
+	CHECK(world.Get<Transform>(a)->getPosition().x == 1 && world.Get<Transform>(a)->getPoolIndex() == poolIndex);
+	CHECK(world.Get<MeshRef>(a)->mesh == mesh && world.Get<MaterialRef>(a)->material == material);
+	CHECK(world.Get<Transform>(b)->getPosition().x == 4 && !world.Get<Tag>(b));
+	CHECK(world.GetArchetypeCount() == 2);
+
+	int matches = 0;
+	world.Each<Transform, MeshRef>([&](Entity, Transform&, MeshRef&) { matches++; });
+	CHECK(matches == 2);
+	matches = 0;
+	world.Each<Tag>([&](Entity entity, Tag& tag) { matches++; CHECK(entity == a && tag.value == 7); });
+	CHECK(matches == 1);
+
+	world.Remove<Tag>(a);
+	CHECK(!world.Get<Tag>(a) && world.Get<Transform>(a)->getPosition().z == 3);
+
+	//destroying gives the transform back to the pool, the old handle stays dead after its slot is reused
+	unsigned int transforms = TransformPool::Get().GetCount();
+	world.Destroy(a);
+	CHECK(!world.IsAlive(a) && TransformPool::Get().GetCount() == transforms - 1);
+	Entity c = world.Create(Transform(), MeshRef{ mesh }, MaterialRef{ material });
+	CHECK(c.index == a.index && c.generation != a.generation);
+	CHECK(!world.IsAlive(a) && world.IsAlive(c) && !world.Get<Transform>(a));
+	CHECK(Entity::FromBits(c.ToBits()) == c);
+	CHECK(world.Get<Transform>(b)->getPosition().y == 5);
+
+	//destroying in the middle of a column swaps the last row in, its handle has to follow
+	std::vector<Entity> many;
+	for (int i = 0; i < 100; i++)
+	{
+		many.push_back(world.Create(Transform(), MeshRef{ mesh }, MaterialRef{ material }));
+		world.Get<Transform>(many.back())->setPosition((float)i, 0, 0);
+	}
+	for (int i = 0; i < 100; i += 3)
+		world.Destroy(many[i]);
+	for (int i = 0; i < 100; i++)
+	{
+		CHECK(world.IsAlive(many[i]) == (i % 3 != 0));
+		if (i % 3 != 0)
+			CHECK(world.Get<Transform>(many[i])->getPosition().x == (float)i);
+	}
+
+	world.Destroy(b);
+	world.Destroy(c);
+	for (int i = 0; i < 100; i++)
+		if (i % 3 != 0)
+			world.Destroy(many[i]);
+	CHECK(world.GetCount() == 0);
+	return 0;
+}
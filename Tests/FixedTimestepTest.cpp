@@ -0,0 +1,56 @@
+// FixedTimestep: whole steps out of frame deltas, the MaxSteps cap and the dropped step count, and alpha staying in [0, 1)
+#include "FixedTimestep.h"
+#include "TestCheck.h"
+
+#include <cmath>
+#include <random>
+
+int main()
+{
+	//a quarter of a step per frame steps every fourth frame, alpha walks up in quarters in between
+	FixedTimestep quarters(0.25f, 5);
+	float deltas[] = { 0.0625f, 0.0625f, 0.0625f, 0.0625f };
+	unsigned int total = 0;
+	for (int frame = 0; frame < 16; frame++)
+	{
+		unsigned int steps = quarters.Advance(deltas[frame % 4]);
+		CHECK(steps == (frame % 4 == 3 ? 1u : 0u));
+		total += steps;
+		CHECK(quarters.GetAlpha() == (float)((frame + 1) % 4) / 4);
+	}
+	CHECK(total == 4 && quarters.GetStepCount() == 4 && quarters.GetTime() == 1.0 && quarters.GetDroppedSteps() == 0);
+
+	//negative and zero deltas add nothing
+	CHECK(quarters.Advance(-1.0f) == 0 && quarters.Advance(0.0f) == 0 && quarters.GetAlpha() == 0.0f);
+
+	//a long frame (breakpoint): MaxSteps run, the rest of the whole steps are dropped, the fraction is kept
+	FixedTimestep capped(0.25f, 3);
+	CHECK(capped.Advance(2.375f) == 3); //9.5 steps
+	CHECK(capped.GetDroppedSteps() == 6 && capped.GetStepCount() == 3 && capped.GetTime() == 0.75);
+	CHECK(capped.GetAlpha() == 0.5f);
+	//and the next normal frame carries on from that fraction
+	CHECK(capped.Advance(0.125f) == 1 && capped.GetAlpha() == 0.0f && capped.GetDroppedSteps() == 6);
+	//exactly MaxSteps fits without dropping anything
+	CHECK(capped.Advance(0.75f) == 3 && capped.GetDroppedSteps() == 6);
+
+	//random frame times, hitches included: alpha never leaves [0, 1), every step is either simulated or dropped,
+	//and simulated plus dropped plus what's left adds up to the time that went in
+	FixedTimestep timestep(1.0f / 60.0f, 5);
+	std::mt19937 random(17);
+	std::uniform_real_distribution<float> frameTime(0.0f, 1.0f / 30.0f);
+	double fed = 0.0;
+	for (int frame = 0; frame < 100000; frame++)
+	{
+		float delta = frame % 1000 == 999 ? 0.5f + frameTime(random) * 30 : frameTime(random); //a hitch now and then
+		fed += delta;
+		unsigned int steps = timestep.Advance(delta);
+		CHECK(steps <= 5);
+		float alpha = timestep.GetAlpha();
+		CHECK(alpha >= 0.0f && alpha < 1.0f);
+	}
+	CHECK(timestep.GetDroppedSteps() > 0);
+	CHECK(std::fabs(timestep.GetTime() - timestep.GetStepCount() * (double)timestep.GetStep()) < 1e-6);
+	double accounted = (timestep.GetStepCount() + timestep.GetDroppedSteps() + timestep.GetAlpha()) * (double)timestep.GetStep();
+	CHECK(std::fabs(accounted - fed) < 1e-3);
+	return 0;
+}
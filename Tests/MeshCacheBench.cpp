@@ -0,0 +1,85 @@
+// Opening a .meshbin (map + validate) against parsing the .obj it replaces, for a ~1M triangle grid
+#include "MeshCache.h"
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const int GRID = 700;
+
+	template<typename Run>
+	double Best(Run run)
+	{
+		double best = 1e9;
+		for (int repeat = 0; repeat < 5; repeat++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			run();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		return best;
+	}
+}
+
+int main()
+{
+	std::filesystem::path folder = std::filesystem::temp_directory_path();
+	std::wstring objPath = (folder / L"MeshCacheBench.obj").wstring();
+	std::wstring cachePath = MeshCache::GetCachePath(objPath);
+
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+	{
+		std::ofstream obj(std::filesystem::path(objPath), std::ios::binary | std::ios::trunc);
+		char line[128];
+		for (int y = 0; y <= GRID; y++)
+			for (int x = 0; x <= GRID; x++)
+			{
+				float position[3] = { x * 0.1f, 0.0f, y * 0.1f };
+				vertices.insert(vertices.end(), position, position + 3);
+				obj.write(line, std::snprintf(line, sizeof(line), "v %f %f %f\n", position[0], position[1], position[2]));
+			}
+		for (int y = 0; y < GRID; y++)
+			for (int x = 0; x < GRID; x++)
+			{
+				uint32_t a = y * (GRID + 1) + x, b = a + 1, c = a + GRID + 2, d = a + GRID + 1;
+				uint32_t quad[6] = { a, b, c, a, c, d };
+				indices.insert(indices.end(), quad, quad + 6);
+				obj.write(line, std::snprintf(line, sizeof(line), "f %u %u %u %u\n", a + 1, b + 1, c + 1, d + 1));
+			}
+	}
+
+	MeshBinView view;
+	view.header.vertexCount = (uint32_t)vertices.size() / 3;
+	view.header.vertexStride = sizeof(float) * 3;
+	view.header.indexCount = (uint32_t)indices.size();
+	view.header.indexStride = sizeof(uint32_t);
+	view.header.attributeCount = 1;
+	view.header.attributes[0] = { MeshBinPosition, MeshBinFloat3, 0 };
+	view.header.lodCount = 1;
+	view.header.lods[0] = { 0, view.header.indexCount, 0.0f };
+	view.vertices = vertices.data();
+	view.indices = indices.data();
+	if (!MeshCache::Write(cachePath, view))
+		return 1;
+
+	double parse = Best([&] { ObjData data; ObjParser::Parse(objPath, data); });
+	double load = Best([&]
+	{
+		MappedFile file;
+		MeshBinView loaded;
+		MeshCache::Load(cachePath, file, loaded);
+	});
+	std::printf("%u triangles: parse .obj %.2f ms, load .meshbin %.2f ms (%.0fx)\n", view.header.indexCount / 3, parse, load, parse / load);
+
+	std::filesystem::remove(std::filesystem::path(objPath));
+	std::filesystem::remove(std::filesystem::path(cachePath));
+	return 0;
+}
@@ -0,0 +1,136 @@
+// .meshbin write/load round trip, and the files Load has to turn down
+#include "MeshCache.h"
+#include "TestCheck.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+	const std::wstring CACHE_PATH = (std::filesystem::temp_directory_path() / L"MeshCacheTest.meshbin").wstring();
+
+	struct TestVertex
+	{
+		float position[3];
+		float uv[2];
+	};
+
+	//laid out like Meshlet, only the range in front matters to the cache
+	struct TestMeshlet
+	{
+		MeshBinMeshletRange range;
+		float bounds[8];
+	};
+
+	std::vector<char> ReadAll()
+	{
+		std::ifstream in(std::filesystem::path(CACHE_PATH), std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+
+	void WriteAll(const std::vector<char>& bytes)
+	{
+		std::ofstream out(std::filesystem::path(CACHE_PATH), std::ios::binary | std::ios::trunc);
+		out.write(bytes.data(), bytes.size());
+	}
+
+	bool Loads()
+	{
+		MappedFile file;
+		MeshBinView view;
+		return MeshCache::Load(CACHE_PATH, file, view);
+	}
+
+	//writes the good file, lets edit break a copy of its bytes and checks Load turns it down
+	template<typename Edit>
+	void CheckRejected(const MeshBinView& good, Edit edit)
+	{
+		CHECK(MeshCache::Write(CACHE_PATH, good));
+		std::vector<char> bytes = ReadAll();
+		edit(bytes, *(MeshBinHeader*)bytes.data());
+		WriteAll(bytes);
+		CHECK(!Loads());
+	}
+}
+
+int main()
+{
+	TestVertex vertices[4] = { { { 0, 0, 0 }, { 0, 0 } }, { { 1, 0, 0 }, { 1, 0 } }, { { 1, 1, 0 }, { 1, 1 } }, { { 0, 1, 0 }, { 0, 1 } } };
+	uint16_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+
+	MeshBinView source;
+	source.header.vertexCount = 4;
+	source.header.vertexStride = sizeof(TestVertex);
+	source.header.indexCount = 6;
+	source.header.indexStride = sizeof(uint16_t);
+	source.header.unweldedVertexCount = 6;
+	source.header.attributeCount = 2;
+	source.header.attributes[0] = { MeshBinPosition, MeshBinFloat3, 0 };
+	source.header.attributes[1] = { MeshBinTexcoord, MeshBinFloat2, 12 };
+	source.header.lodCount = 2;
+	source.header.lods[0] = { 0, 6, 0.0f };
+	source.header.lods[1] = { 0, 3, 0.5f };
+	source.vertices = vertices;
+	source.indices = indices;
+	CHECK(MeshCache::Write(CACHE_PATH, source));
+
+	{
+		MappedFile file;
+		MeshBinView loaded;
+		CHECK(MeshCache::Load(CACHE_PATH, file, loaded));
+		CHECK(loaded.header.vertexCount == 4 && loaded.header.indexCount == 6 && loaded.header.lodCount == 2);
+		CHECK(loaded.header.unweldedVertexCount == 6);
+		CHECK(loaded.header.lods[1].indexCount == 3 && loaded.header.lods[1].error == 0.5f);
+		CHECK(loaded.header.attributes[1].Semantic == MeshBinTexcoord && loaded.header.attributes[1].Offset == 12);
+		//zero copy: the blobs are read straight out of the mapping, aligned for the gpu upload
+		CHECK((const char*)loaded.vertices >= file.Data() && (const char*)loaded.vertices < file.Data() + file.Size());
+		CHECK((uintptr_t)loaded.vertices % MESHBIN_ALIGNMENT == 0 && (uintptr_t)loaded.indices % MESHBIN_ALIGNMENT == 0);
+		CHECK(std::memcmp(loaded.vertices, vertices, sizeof(vertices)) == 0);
+		CHECK(std::memcmp(loaded.indices, indices, sizeof(indices)) == 0);
+		CHECK(loaded.meshlets == nullptr);
+	}
+
+	CheckRejected(source, [](std::vector<char>& bytes, MeshBinHeader&) { bytes.resize(sizeof(MeshBinHeader) - 1); });
+	CheckRejected(source, [](std::vector<char>& bytes, MeshBinHeader&) { bytes.resize(bytes.size() - 1); });
+	CheckRejected(source, [](std::vector<char>&, MeshBinHeader& header) { header.magic++; });
+	CheckRejected(source, [](std::vector<char>&, MeshBinHeader& header) { header.version++; });
+	CheckRejected(source, [](std::vector<char>&, MeshBinHeader& header) { header.attributeCount = MESHBIN_MAX_ATTRIBUTES + 1; });
+	CheckRejected(source, [](std::vector<char>&, MeshBinHeader& header) { header.lods[1].firstIndex = 4; });
+	CheckRejected(source, [](std::vector<char>&, MeshBinHeader& header) { header.vertexCount = 5; });
+	CheckRejected(source, [](std::vector<char>&, MeshBinHeader& header) { header.indexOffset++; });
+	//aligned, and offset + bytes wraps around to something smaller than the file
+	CheckRejected(source, [](std::vector<char>&, MeshBinHeader& header) { header.indexOffset = 0 - (uint64_t)MESHBIN_ALIGNMENT; });
+	CheckRejected(source, [](std::vector<char>&, MeshBinHeader& header) { header.indexStride = 3; header.indexCount = 4; header.indexBytes = 12; });
+	//sizes all agree, one index points past the last vertex
+	CheckRejected(source, [](std::vector<char>& bytes, MeshBinHeader& header) { ((uint16_t*)(bytes.data() + header.indexOffset))[5] = 4; });
+
+	//meshlets have to stay inside lod 0, culling copies their indices without looking
+	TestMeshlet meshlets[2] = { { { 0, 1 }, {} }, { { 3, 1 }, {} } };
+	MeshBinView withMeshlets = source;
+	withMeshlets.header.meshletCount = 2;
+	withMeshlets.header.meshletStride = sizeof(TestMeshlet);
+	withMeshlets.meshlets = meshlets;
+	CHECK(MeshCache::Write(CACHE_PATH, withMeshlets));
+	{
+		MappedFile file;
+		MeshBinView loaded;
+		CHECK(MeshCache::Load(CACHE_PATH, file, loaded));
+		CHECK(loaded.meshlets && ((const TestMeshlet*)loaded.meshlets)[1].range.firstIndex == 3);
+	}
+	auto meshlet = [](std::vector<char>& bytes, MeshBinHeader& header, uint32_t i) { return (MeshBinMeshletRange*)(bytes.data() + header.meshletOffset + i * header.meshletStride); };
+	CheckRejected(withMeshlets, [&](std::vector<char>& bytes, MeshBinHeader& header) { meshlet(bytes, header, 1)->triangleCount = 2; });
+	CheckRejected(withMeshlets, [&](std::vector<char>& bytes, MeshBinHeader& header) { meshlet(bytes, header, 0)->firstIndex = 6; });
+	//would wrap around in 32 bits
+	CheckRejected(withMeshlets, [&](std::vector<char>& bytes, MeshBinHeader& header) { *meshlet(bytes, header, 1) = { 0xFFFFFFFFu, 0x55555556u }; });
+	//fits the whole index blob but not lod 0
+	CheckRejected(withMeshlets, [&](std::vector<char>& bytes, MeshBinHeader& header) { header.lods[0].indexCount = 3; meshlet(bytes, header, 1)->firstIndex = 2; });
+	CheckRejected(withMeshlets, [&](std::vector<char>&, MeshBinHeader& header) { header.meshletStride = 4; header.meshletCount = 4; header.meshletBytes = 16; });
+
+	//and the same file with the index put back loads again
+	CHECK(MeshCache::Write(CACHE_PATH, source));
+	CHECK(Loads());
+	std::filesystem::remove(std::filesystem::path(CACHE_PATH));
+	return 0;
+}
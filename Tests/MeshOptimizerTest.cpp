@@ -0,0 +1,118 @@
+// MeshOptimizer's cache -> overdraw -> fetch pipeline on a bumpy grid, in row order and shuffled: acmr never gets worse,
+// overdraw stays within its threshold of the cache order, and the triangles (winding included) are the same ones afterwards
+#include "MeshOptimizer.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	//id says which vertex it was before OptimizeVertexFetch moved it
+	struct TestVertex
+	{
+		float x, y, z;
+		unsigned int id;
+	};
+
+	struct Grid
+	{
+		std::vector<TestVertex> vertices;
+		std::vector<unsigned int> indices;
+	};
+
+	Grid MakeGrid(int size)
+	{
+		Grid grid;
+		for (int y = 0; y <= size; y++)
+			for (int x = 0; x <= size; x++)
+			{
+				float px = (float)x / size, pz = (float)y / size;
+				grid.vertices.push_back({ px, 0.1f * std::sin(px * 17) * std::cos(pz * 13), pz, (unsigned int)grid.vertices.size() });
+			}
+		for (int y = 0; y < size; y++)
+			for (int x = 0; x < size; x++)
+			{
+				unsigned int a = y * (size + 1) + x, b = a + 1, c = a + size + 2, d = a + size + 1;
+				grid.indices.insert(grid.indices.end(), { a, d, c, a, c, b });
+			}
+		return grid;
+	}
+
+	//every triangle by the ids of its corners, rotated so the smallest comes first (keeps the winding), then sorted
+	std::vector<std::array<unsigned int, 3>> Triangles(const std::vector<TestVertex>& vertices, const std::vector<unsigned int>& indices)
+	{
+		std::vector<std::array<unsigned int, 3>> triangles;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			CHECK(indices[i] < vertices.size() && indices[i + 1] < vertices.size() && indices[i + 2] < vertices.size());
+			std::array<unsigned int, 3> t = { vertices[indices[i]].id, vertices[indices[i + 1]].id, vertices[indices[i + 2]].id };
+			std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+			triangles.push_back(t);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	//returns the acmr it ended up with
+	float CheckPipeline(const Grid& grid, const char* name)
+	{
+		std::vector<TestVertex> vertices = grid.vertices;
+		std::vector<unsigned int> indices = grid.indices;
+		std::vector<std::array<unsigned int, 3>> expected = Triangles(vertices, indices);
+		VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+		MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+		VertexCacheStats cached = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		CHECK(cached.acmr <= before.acmr);
+		CHECK(Triangles(vertices, indices) == expected);
+
+		const float threshold = 1.05f;
+		MeshOptimizer::OptimizeOverdraw(indices.data(), indices.size(), &vertices[0].x, vertices.size(), sizeof(TestVertex), threshold);
+		VertexCacheStats sorted = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		CHECK(sorted.acmr <= cached.acmr * threshold + 1e-6f);
+		CHECK(Triangles(vertices, indices) == expected);
+
+		//fetch order renames the vertices, the ids still have to make up the same triangles
+		size_t vertexCount = MeshOptimizer::OptimizeVertexFetch(vertices.data(), indices.data(), indices.size(), vertices.size(), sizeof(TestVertex));
+		CHECK(vertexCount == grid.vertices.size()); //a grid uses every vertex
+		vertices.resize(vertexCount);
+		CHECK(Triangles(vertices, indices) == expected);
+		//first use order: each index is at most one past the highest seen so far
+		unsigned int next = 0;
+		for (unsigned int index : indices)
+		{
+			CHECK(index <= next);
+			next = std::max(next, index + 1);
+		}
+		VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+		CHECK(std::fabs(after.acmr - sorted.acmr) < 1e-6f); //renaming vertices doesn't change which ones hit the cache
+		CHECK(after.acmr <= before.acmr);
+		std::printf("%s: acmr %.3f -> %.3f (cache order %.3f), atvr %.3f -> %.3f\n", name, before.acmr, after.acmr, cached.acmr, before.atvr, after.atvr);
+		return after.acmr;
+	}
+}
+
+int main()
+{
+	Grid grid = MakeGrid(64);
+	CheckPipeline(grid, "row order");
+
+	//shuffled triangles are close to the worst case, the pipeline has to win most of it back
+	Grid shuffled = grid;
+	std::vector<unsigned int> order(shuffled.indices.size() / 3);
+	for (unsigned int i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::shuffle(order.begin(), order.end(), std::mt19937(19));
+	for (size_t t = 0; t < order.size(); t++)
+		for (int corner = 0; corner < 3; corner++)
+			shuffled.indices[t * 3 + corner] = grid.indices[order[t] * 3 + corner];
+	VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(shuffled.indices.data(), shuffled.indices.size(), shuffled.vertices.size());
+	CHECK(before.acmr > 2.0f);
+	CHECK(CheckPipeline(shuffled, "shuffled") < 1.0f);
+	return 0;
+}
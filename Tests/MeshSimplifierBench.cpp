@@ -0,0 +1,43 @@
+// Time to build a LOD chain for a 500k triangle heightfield, the way the importer does it (each level halves the one before)
+#include "MeshSimplifier.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+int main()
+{
+	const int size = 512;
+	std::vector<float> positions;
+	std::vector<unsigned int> indices;
+	for (int y = 0; y <= size; y++)
+		for (int x = 0; x <= size; x++)
+		{
+			float px = (float)x / size, pz = (float)y / size;
+			positions.insert(positions.end(), { px, 0.05f * std::sin(px * 40.0f) * std::cos(pz * 31.0f), pz });
+		}
+	for (int y = 0; y < size; y++)
+		for (int x = 0; x < size; x++)
+		{
+			unsigned int a = y * (size + 1) + x, b = a + 1, c = a + size + 2, d = a + size + 1;
+			indices.insert(indices.end(), { a, d, c, a, c, b });
+		}
+
+	std::vector<unsigned int> level = indices;
+	std::vector<unsigned int> next(indices.size());
+	double total = 0;
+	for (int lod = 1; lod < 5; lod++)
+	{
+		float error = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+		size_t count = MeshSimplifier::Simplify(next.data(), level.data(), level.size(), positions.data(), positions.size() / 3,
+			sizeof(float) * 3, level.size() / 2, 1.0f, &error);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		total += ms;
+		std::printf("lod %d: %zu -> %zu triangles, %.1f ms, error %.2e\n", lod, level.size() / 3, count / 3, ms, error);
+		level.assign(next.begin(), next.begin() + count);
+	}
+	std::printf("chain: %.1f ms\n", total);
+	return 0;
+}
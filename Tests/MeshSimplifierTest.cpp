@@ -0,0 +1,97 @@
+// MeshSimplifier on a flat grid (free to collapse, area and border must survive) and a bumpy one (error budget must hold)
+#include "MeshSimplifier.h"
+#include "TestCheck.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	struct Grid
+	{
+		std::vector<float> positions;
+		std::vector<unsigned int> indices;
+	};
+
+	template<typename Height>
+	Grid MakeGrid(int size, Height height)
+	{
+		Grid grid;
+		for (int y = 0; y <= size; y++)
+			for (int x = 0; x <= size; x++)
+			{
+				float px = (float)x / size, pz = (float)y / size;
+				grid.positions.insert(grid.positions.end(), { px, height(px, pz), pz });
+			}
+		for (int y = 0; y < size; y++)
+			for (int x = 0; x < size; x++)
+			{
+				unsigned int a = y * (size + 1) + x, b = a + 1, c = a + size + 2, d = a + size + 1;
+				grid.indices.insert(grid.indices.end(), { a, d, c, a, c, b });
+			}
+		return grid;
+	}
+
+	//also checks every triangle indexes a real vertex and none collapsed to a sliver
+	double Area(const Grid& grid, const std::vector<unsigned int>& indices)
+	{
+		double area = 0;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const float* p[3];
+			for (int c = 0; c < 3; c++)
+			{
+				CHECK(indices[i + c] < grid.positions.size() / 3);
+				p[c] = &grid.positions[indices[i + c] * 3];
+			}
+			CHECK(indices[i] != indices[i + 1] && indices[i + 1] != indices[i + 2] && indices[i] != indices[i + 2]);
+			double e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+			double e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+			double cross[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			area += 0.5 * std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+			CHECK(cross[1] >= 0); //nothing folded over (collapses along the border can leave upright slivers with y exactly 0)
+		}
+		return area;
+	}
+
+	std::vector<unsigned int> Simplify(const Grid& grid, size_t targetIndexCount, float targetError, float& resultError)
+	{
+		std::vector<unsigned int> result(grid.indices.size());
+		size_t count = MeshSimplifier::Simplify(result.data(), grid.indices.data(), grid.indices.size(), grid.positions.data(),
+			grid.positions.size() / 3, sizeof(float) * 3, targetIndexCount, targetError, &resultError);
+		CHECK(count % 3 == 0 && count <= grid.indices.size());
+		result.resize(count);
+		return result;
+	}
+}
+
+int main()
+{
+	Grid flat = MakeGrid(64, [](float, float) { return 0.0f; });
+	float error = -1;
+	std::vector<unsigned int> reduced = Simplify(flat, flat.indices.size() / 10, 1e-3f, error);
+	std::printf("flat: %zu -> %zu triangles, error %g\n", flat.indices.size() / 3, reduced.size() / 3, error);
+	CHECK(reduced.size() <= flat.indices.size() / 10);
+	CHECK(error >= 0 && error < 1e-5f);
+	CHECK(std::fabs(Area(flat, reduced) - 1.0) < 1e-4); //border vertices stay put, so the outline and the area do too
+
+	//with a budget the chain stops where the surface would move too far, each level smaller than the last
+	Grid bumpy = MakeGrid(64, [](float x, float z) { return 0.05f * std::sin(x * 12.0f) * std::cos(z * 9.0f); });
+	double fullArea = Area(bumpy, bumpy.indices);
+	size_t previous = bumpy.indices.size();
+	for (float budget : { 0.0005f, 0.002f, 0.01f })
+	{
+		std::vector<unsigned int> level = Simplify(bumpy, 0, budget, error);
+		std::printf("bumpy, budget %g: %zu triangles, error %g\n", budget, level.size() / 3, error);
+		CHECK(error <= budget);
+		CHECK(level.size() < previous && !level.empty());
+		CHECK(std::fabs(Area(bumpy, level) - fullArea) < fullArea * 0.05);
+		previous = level.size();
+	}
+
+	//a target above the input is a copy
+	std::vector<unsigned int> same = Simplify(bumpy, bumpy.indices.size(), 1.0f, error);
+	CHECK(same.size() == bumpy.indices.size());
+	return 0;
+}
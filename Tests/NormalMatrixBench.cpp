@@ -0,0 +1,70 @@
+// Normal matrices for 100k moved roots: the batch (AVX2 and SSE), building them one at a time on read, and the general inverse
+// (that last one only means something against the real DirectXMath, the stand-in's inverse is plain scalar code)
+#include "Transform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+int main()
+{
+	TransformPool& pool = TransformPool::Get();
+	pool.SetUseAVX2(true);
+	bool hasAVX2 = pool.UsesAVX2();
+
+	std::mt19937 random(9);
+	std::uniform_real_distribution<float> position(-50, 50), angle(-3.1f, 3.1f), exponent(-2, 2);
+	std::vector<std::unique_ptr<Transform>> transforms;
+	for (int i = 0; i < 100000; i++)
+	{
+		transforms.emplace_back(new Transform);
+		transforms.back()->setPosition(position(random), position(random), position(random));
+		transforms.back()->setRotation(angle(random), angle(random), angle(random));
+		transforms.back()->setScale(std::pow(10.0f, exponent(random)), std::pow(10.0f, exponent(random)), std::pow(10.0f, exponent(random)));
+	}
+	pool.UpdateDirty();
+
+	const char* names[] = { "UpdateNormals AVX2", "UpdateNormals SSE", "lazy, one at a time", "general XMMatrixInverse" };
+	for (int mode = 0; mode < 4; mode++)
+	{
+		if (mode == 0 && !hasAVX2)
+			continue;
+		double best = 1e9;
+		for (int repeat = 0; repeat < 5; repeat++)
+		{
+			for (auto& transform : transforms)
+				transform->moveAbsolute(0.01f, 0, 0);
+			pool.SetUseAVX2(mode != 1);
+			pool.UpdateDirty();
+
+			volatile float sink = 0;
+			auto start = std::chrono::high_resolution_clock::now();
+			if (mode < 2)
+				pool.UpdateNormals();
+			else if (mode == 2)
+			{
+				for (auto& transform : transforms)
+					sink = sink + transform->getWorldInverseTransposeMatrix()._11;
+			}
+			else
+			{
+				for (auto& transform : transforms)
+				{
+					XMFLOAT4X4 world = transform->getWorldMatrix();
+					XMFLOAT4X4 normal;
+					XMStoreFloat4x4(&normal, XMMatrixTranspose(XMMatrixInverse(nullptr, XMLoadFloat4x4(&world))));
+					sink = sink + normal._11;
+				}
+			}
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		std::printf("%s: %.2f ns per transform\n", names[mode], best * 1e6 / transforms.size());
+	}
+	return 0;
+}
@@ -0,0 +1,93 @@
+// Normal matrices from the pool (batched and lazy) against the general inverse transpose of the pool's own world matrix
+#include "Transform.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	double Error(const XMFLOAT4X4& world, const XMFLOAT4X4& normal)
+	{
+		XMFLOAT4X4 expected;
+		XMStoreFloat4x4(&expected, XMMatrixTranspose(XMMatrixInverse(nullptr, XMLoadFloat4x4(&world))));
+		double error = 0;
+		for (int row = 0; row < 4; row++)
+			for (int column = 0; column < 4; column++)
+				error = std::max(error, (double)std::fabs(expected.m[row][column] - normal.m[row][column]) / (1 + std::fabs(expected.m[row][column])));
+		return error;
+	}
+
+	void CheckKernel(bool useAVX2)
+	{
+		TransformPool& pool = TransformPool::Get();
+		pool.SetUseAVX2(useAVX2);
+
+		std::mt19937 random(9);
+		std::uniform_real_distribution<float> position(-50, 50), angle(-3.1f, 3.1f), exponent(-2, 2), tame(0.8f, 1.2f);
+		std::vector<std::unique_ptr<Transform>> transforms;
+		for (int i = 0; i < 4000; i++)
+		{
+			transforms.emplace_back(new Transform);
+			Transform& transform = *transforms.back();
+			transform.setPosition(position(random), position(random), position(random));
+			transform.setRotation(angle(random), angle(random), angle(random));
+			transform.setScale(std::pow(10.0f, exponent(random)), std::pow(10.0f, exponent(random)), std::pow(10.0f, exponent(random)));
+			//leaf roots keep scales from 0.01 to 100, anything in a hierarchy gets a tame one: non uniform extremes
+			//under a rotated child make the world matrix too ill conditioned for the general inverse to be a fair reference
+			if (i > 0 && random() % 3 == 0)
+			{
+				Transform& parent = *transforms[random() % i];
+				transform.setScale(tame(random), tame(random), tame(random));
+				parent.setScale(tame(random), tame(random), tame(random));
+				transform.setParent(&parent);
+			}
+		}
+		pool.UpdateDirty();
+		pool.UpdateNormals();
+		CHECK(pool.GetLastNormalCount() == transforms.size());
+
+		double batch = 0;
+		for (auto& transform : transforms)
+			batch = std::max(batch, Error(transform->readWorldMatrix(), transform->readWorldInverseTransposeMatrix()));
+
+		//nothing moved, nothing to build
+		pool.UpdateDirty();
+		pool.UpdateNormals();
+		CHECK(pool.GetLastNormalCount() == 0);
+
+		//lazy: move and rotate some, then read without UpdateNormals (and for the rotated ones without UpdateDirty either)
+		for (int i = 0; i < 500; i++)
+			transforms[random() % transforms.size()]->setPosition(position(random), position(random), position(random));
+		pool.UpdateDirty();
+		for (int i = 0; i < 500; i++)
+			transforms[random() % transforms.size()]->Rotate(0.3f, 0, 0);
+		double lazy = 0;
+		for (auto& transform : transforms)
+		{
+			XMFLOAT4X4 world = transform->getWorldMatrix();
+			lazy = std::max(lazy, Error(world, transform->getWorldInverseTransposeMatrix()));
+		}
+		std::printf("%s: batch %.2e, lazy %.2e\n", pool.UsesAVX2() ? "AVX2" : "SSE", batch, lazy);
+		//float rounding through deep chains lands around 1e-4, a wrong matrix is off by O(1)
+		CHECK(batch < 1e-3);
+		CHECK(lazy < 1e-3);
+
+		//everything was just built on demand, so the batch has nothing left to do
+		pool.UpdateNormals();
+		CHECK(pool.GetLastNormalCount() == 0);
+	}
+}
+
+int main()
+{
+	CheckKernel(true);
+	CheckKernel(false);
+	return 0;
+}
@@ -0,0 +1,114 @@
+// ObjParser against the old line by line sscanf loop, on a generated ~1M triangle file
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	std::string MakeObj(int size)
+	{
+		std::mt19937 random(5);
+		std::uniform_real_distribution<float> jitter(-0.01f, 0.01f);
+		std::string obj;
+		char line[512]; //room for 8 floats printed with %f at their longest, or 12 ints, so snprintf never cuts a line short
+		for (int y = 0; y <= size; y++)
+			for (int x = 0; x <= size; x++)
+			{
+				std::snprintf(line, sizeof(line), "v %f %f %f\nvt %f %f\nvn %f %f %f\n", x * 0.1f, jitter(random), y * 0.1f,
+					(float)x / size, (float)y / size, jitter(random), 1.0f, jitter(random));
+				obj += line;
+			}
+		for (int y = 0; y < size; y++)
+			for (int x = 0; x < size; x++)
+			{
+				int a = y * (size + 1) + x + 1, b = a + 1, c = a + size + 2, d = a + size + 1;
+				std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c, d, d, d);
+				obj += line;
+			}
+		return obj;
+	}
+
+	//what Mesh did before ObjParser, minus the vertex building
+	size_t ParseWithSscanf(const std::string& obj, ObjData& out)
+	{
+		size_t position = 0;
+		std::string line;
+		while (position < obj.size())
+		{
+			size_t end = obj.find('\n', position);
+			if (end == std::string::npos)
+				end = obj.size();
+			line.assign(obj, position, end - position);
+			position = end + 1;
+
+			if (line[0] == 'v' && line[1] == 'n')
+			{
+				XMFLOAT3 normal;
+				std::sscanf(line.c_str(), "vn %f %f %f", &normal.x, &normal.y, &normal.z);
+				out.normals.push_back(normal);
+			}
+			else if (line[0] == 'v' && line[1] == 't')
+			{
+				XMFLOAT2 uv;
+				std::sscanf(line.c_str(), "vt %f %f", &uv.x, &uv.y);
+				out.uvs.push_back(uv);
+			}
+			else if (line[0] == 'v')
+			{
+				XMFLOAT3 pos;
+				std::sscanf(line.c_str(), "v %f %f %f", &pos.x, &pos.y, &pos.z);
+				out.positions.push_back(pos);
+			}
+			else if (line[0] == 'f')
+			{
+				int i[12] = {};
+				int read = std::sscanf(line.c_str(), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
+					&i[0], &i[1], &i[2], &i[3], &i[4], &i[5], &i[6], &i[7], &i[8], &i[9], &i[10], &i[11]);
+				for (int corner : { 0, 1, 2 })
+					out.faces.push_back({ i[corner * 3] - 1, i[corner * 3 + 1] - 1, i[corner * 3 + 2] - 1 });
+				if (read == 12)
+					for (int corner : { 0, 2, 3 })
+						out.faces.push_back({ i[corner * 3] - 1, i[corner * 3 + 1] - 1, i[corner * 3 + 2] - 1 });
+			}
+		}
+		return out.TriangleCount();
+	}
+
+	template<typename Parse>
+	double Best(Parse parse)
+	{
+		double best = 1e9;
+		for (int repeat = 0; repeat < 3; repeat++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			parse();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		return best;
+	}
+}
+
+int main()
+{
+	std::string obj = MakeObj(700);
+	std::printf("%.1f MB, %d triangles\n", obj.size() / 1048576.0, 700 * 700 * 2);
+
+	double baseline = Best([&] { ObjData data; ParseWithSscanf(obj, data); });
+	std::printf("sscanf per line: %.1f ms\n", baseline);
+
+	unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int threads = 1; threads <= hardwareThreads; threads *= 2)
+	{
+		double parser = Best([&] { ObjData data; ObjParser::ParseMemory(obj.data(), obj.size(), data, threads); });
+		std::printf("ObjParser, %u threads: %.1f ms (%.1fx)\n", threads, parser, baseline / parser);
+	}
+	return 0;
+}
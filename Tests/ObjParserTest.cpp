@@ -0,0 +1,87 @@
+// ObjParser on a hand written file, then a file big enough to split into chunks parsed with 1 and 4 threads
+#include "ObjParser.h"
+#include "TestCheck.h"
+
+#include <cstdio>
+#include <string>
+
+namespace
+{
+	bool SameCorner(const ObjIndex& a, const ObjIndex& b)
+	{
+		return a.Position == b.Position && a.UV == b.UV && a.Normal == b.Normal;
+	}
+
+	//a grid of quads, every other row of faces uses relative indices so chunks have to be stitched back together
+	std::string MakeGrid(int size)
+	{
+		std::string obj;
+		for (int y = 0; y <= size; y++)
+			for (int x = 0; x <= size; x++)
+				obj += "v " + std::to_string(x * 0.5f) + " " + std::to_string(y * -0.25f) + " 1.5e-1\n";
+		obj += "vt 0.25 0.75\nvn 0 0 -1\n";
+		for (int y = 0; y < size; y++)
+			for (int x = 0; x < size; x++)
+			{
+				int corner = y * (size + 1) + x + 1;
+				int corners[4] = { corner, corner + 1, corner + size + 2, corner + size + 1 };
+				obj += "f";
+				for (int c : corners)
+				{
+					//appended piece by piece, " " + std::to_string(...) trips a false -Wrestrict in gcc 12 at -O3
+					obj += ' ';
+					obj += std::to_string(y % 2 ? c - (size + 1) * (size + 1) - 1 : c);
+					obj += "/1/1";
+				}
+				obj += "\n";
+			}
+		return obj;
+	}
+}
+
+int main()
+{
+	const char small[] =
+		"# comment\r\n"
+		"o cube\n"
+		"v 1 2 3\n"
+		"v -1.5 0.25 -3e2\n"
+		"v 0 0 0\n"
+		"v 4 5 6\n"
+		"vt 0.5 1\n"
+		"vn 0 1 0\n"
+		"s off\n"
+		"f 1 2 3\n"
+		"f 1/1/1 2/1/1 3/1/1 4/1/1\n" //quad, fanned into 2 triangles
+		"f -1//-1 -2//-1 -3//-1\n"
+		"usemtl nothing\n"
+		"f 1/1 2/1 3/1"; //no newline at the end
+	ObjData data;
+	CHECK(ObjParser::ParseMemory(small, sizeof(small) - 1, data, 1));
+	CHECK(data.positions.size() == 4 && data.uvs.size() == 1 && data.normals.size() == 1);
+	CHECK(data.positions[1].x == -1.5f && data.positions[1].y == 0.25f && data.positions[1].z == -300.0f);
+	CHECK(data.uvs[0].x == 0.5f && data.uvs[0].y == 1.0f && data.normals[0].y == 1.0f);
+	CHECK(data.TriangleCount() == 5);
+	CHECK(SameCorner(data.faces[0], { 0, -1, -1 }) && SameCorner(data.faces[2], { 2, -1, -1 }));
+	CHECK(SameCorner(data.faces[3], { 0, 0, 0 }) && SameCorner(data.faces[4], { 1, 0, 0 }) && SameCorner(data.faces[5], { 2, 0, 0 }));
+	CHECK(SameCorner(data.faces[6], { 0, 0, 0 }) && SameCorner(data.faces[7], { 2, 0, 0 }) && SameCorner(data.faces[8], { 3, 0, 0 }));
+	CHECK(SameCorner(data.faces[9], { 3, -1, 0 }) && SameCorner(data.faces[10], { 2, -1, 0 }) && SameCorner(data.faces[11], { 1, -1, 0 }));
+	CHECK(SameCorner(data.faces[12], { 0, 0, -1 }));
+
+	//several MB so it gets more than one chunk
+	std::string grid = MakeGrid(300);
+	ObjData serial, parallel;
+	CHECK(ObjParser::ParseMemory(grid.data(), grid.size(), serial, 1));
+	CHECK(ObjParser::ParseMemory(grid.data(), grid.size(), parallel, 4));
+	std::printf("%zu bytes, %zu triangles, %u threads used\n", grid.size(), parallel.TriangleCount(), parallel.threadsUsed);
+	CHECK(parallel.threadsUsed > 1);
+	CHECK(serial.positions.size() == 301 * 301 && serial.TriangleCount() == 300 * 300 * 2);
+	CHECK(parallel.positions.size() == serial.positions.size() && parallel.faces.size() == serial.faces.size());
+	for (size_t i = 0; i < serial.positions.size(); i++)
+		CHECK(parallel.positions[i].x == serial.positions[i].x && parallel.positions[i].y == serial.positions[i].y && parallel.positions[i].z == serial.positions[i].z);
+	for (size_t i = 0; i < serial.faces.size(); i++)
+		CHECK(SameCorner(parallel.faces[i], serial.faces[i]));
+	//relative rows resolve to the same corners as absolute rows would
+	CHECK(SameCorner(serial.faces[300 * 2 * 3], { 301, 0, 0 }));
+	return 0;
+}
@@ -0,0 +1,76 @@
+// OcclusionBuffer on the street scene from OcclusionBufferTest: rasterizing the occluders serial and on a pool, then testing 20k boxes
+#include "OcclusionBuffer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	template<typename Run>
+	double Best(Run run)
+	{
+		double best = 1e9;
+		for (int repeat = 0; repeat < 50; repeat++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			run();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		return best;
+	}
+}
+
+int main()
+{
+	const int width = 320, height = 192;
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixLookToLH(XMVectorSet(0, 1.5f, 0, 1), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)) *
+		XMMatrixPerspectiveFovLH(XM_PIDIV4 * 1.3f, (float)width / height, 0.1f, 100.0f));
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unitRandom(0, 1);
+	std::vector<OccluderMesh> occluders;
+	for (int i = 0; i < 40; i++)
+	{
+		float x = (unitRandom(random) - 0.5f) * 40, z = 4 + unitRandom(random) * 30, halfWidth = 1 + unitRandom(random) * 5, wallHeight = 1 + unitRandom(random) * 4;
+		occluders.push_back(OccluderMesh::Box({ x - halfWidth, 0, z }, { x + halfWidth, wallHeight, z + 0.5f }));
+	}
+	occluders.push_back(OccluderMesh::Box({ -3, 0, -1 }, { -1, 3, 8 }));
+	occluders.push_back(OccluderMesh::Box({ -50, -1, -5 }, { 50, 0, 80 }));
+	std::vector<Aabb> boxes;
+	for (int i = 0; i < 20000; i++)
+	{
+		float x = (unitRandom(random) - 0.5f) * 60, y = unitRandom(random) * 3, z = 1 + unitRandom(random) * 70, size = 0.1f + unitRandom(random) * 0.6f;
+		boxes.push_back({ { x - size, y, z - size }, { x + size, y + size * 2, z + size } });
+	}
+
+	OcclusionBuffer buffer(width, height);
+	ThreadPool pool(4);
+	for (ThreadPool* flushPool : { (ThreadPool*)nullptr, &pool })
+	{
+		double raster = Best([&]
+		{
+			buffer.Clear();
+			for (const OccluderMesh& occluder : occluders)
+				buffer.RenderOccluder(occluder, viewProjection);
+			buffer.Flush(flushPool);
+		});
+		std::printf("rasterize %u triangles, %s: %.3f ms\n", buffer.GetTriangleCount(), flushPool ? "4 pool threads" : "serial", raster);
+	}
+
+	int culled = 0;
+	double test = Best([&]
+	{
+		culled = 0;
+		for (const Aabb& box : boxes)
+			culled += buffer.IsOccluded(box, viewProjection);
+	});
+	std::printf("test %zu boxes: %.3f ms (%.1f ns each), %d culled\n", boxes.size(), test, test * 1e6 / boxes.size(), culled);
+	return 0;
+}
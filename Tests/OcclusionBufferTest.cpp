@@ -0,0 +1,198 @@
+// OcclusionBuffer against a plain per pixel reference rasterizer: it may cull less than the reference but never more,
+// serial and pooled flushes must agree, and every face of a box has to be wound the right way
+#include "OcclusionBuffer.h"
+#include "TestCheck.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	//full resolution depth per pixel, sampled at pixel centers, near clipped against z = 0 like the real one
+	class ReferenceRasterizer
+	{
+	public:
+		ReferenceRasterizer(int width, int height) : width(width), height(height), depth(width * height, 1.0f) {}
+
+		void RenderOccluder(const OccluderMesh& mesh, const XMFLOAT4X4& worldViewProjection)
+		{
+			XMMATRIX matrix = XMLoadFloat4x4(&worldViewProjection);
+			std::vector<XMFLOAT4> clip(mesh.positions.size());
+			for (size_t i = 0; i < clip.size(); i++)
+				XMStoreFloat4(&clip[i], XMVector3Transform(XMLoadFloat3(&mesh.positions[i]), matrix));
+			for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+			{
+				XMFLOAT4 corners[3] = { clip[mesh.indices[i]], clip[mesh.indices[i + 1]], clip[mesh.indices[i + 2]] };
+				XMFLOAT3 polygon[4];
+				int count = 0;
+				for (int j = 0; j < 3; j++)
+				{
+					const XMFLOAT4& a = corners[j];
+					const XMFLOAT4& b = corners[(j + 1) % 3];
+					if (a.z >= 0)
+						polygon[count++] = ToScreen(a);
+					if ((a.z >= 0) != (b.z >= 0))
+					{
+						float t = a.z / (a.z - b.z);
+						polygon[count++] = ToScreen({ a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t });
+					}
+				}
+				for (int j = 2; j < count; j++)
+					RasterizeTriangle(polygon[0], polygon[j - 1], polygon[j]);
+			}
+		}
+
+		bool IsOccluded(const Aabb& box, const XMFLOAT4X4& viewProjection) const
+		{
+			XMMATRIX matrix = XMLoadFloat4x4(&viewProjection);
+			float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearest = FLT_MAX;
+			for (int corner = 0; corner < 8; corner++)
+			{
+				XMFLOAT4 clip;
+				XMStoreFloat4(&clip, XMVector3Transform(XMVectorSet(corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y,
+					corner & 4 ? box.max.z : box.min.z, 1), matrix));
+				if (clip.z < 0)
+					return false;
+				XMFLOAT3 screen = ToScreen(clip);
+				minX = std::min(minX, screen.x);
+				maxX = std::max(maxX, screen.x);
+				minY = std::min(minY, screen.y);
+				maxY = std::max(maxY, screen.y);
+				nearest = std::min(nearest, screen.z);
+			}
+			int firstX = std::max(0, (int)std::ceil(minX - 0.5f)), lastX = std::min(width - 1, (int)std::floor(maxX - 0.5f));
+			int firstY = std::max(0, (int)std::ceil(minY - 0.5f)), lastY = std::min(height - 1, (int)std::floor(maxY - 0.5f));
+			if (firstX > lastX || firstY > lastY)
+				return false;
+			for (int y = firstY; y <= lastY; y++)
+				for (int x = firstX; x <= lastX; x++)
+					if (!(nearest > depth[y * width + x]))
+						return false;
+			return true;
+		}
+
+	private:
+		int width, height;
+		std::vector<float> depth;
+
+		XMFLOAT3 ToScreen(XMFLOAT4 clip) const
+		{
+			float inverseW = 1.0f / clip.w;
+			return { (clip.x * inverseW * 0.5f + 0.5f) * width, (0.5f - clip.y * inverseW * 0.5f) * height, clip.z * inverseW };
+		}
+
+		//clockwise on screen (y down) is front facing
+		void RasterizeTriangle(XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 c)
+		{
+			double area = (double)(b.x - a.x) * (c.y - a.y) - (double)(c.x - a.x) * (b.y - a.y);
+			if (!(area > 0))
+				return;
+			for (int y = 0; y < height; y++)
+				for (int x = 0; x < width; x++)
+				{
+					double px = x + 0.5, py = y + 0.5;
+					double edgeAB = (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+					double edgeBC = (c.x - b.x) * (py - b.y) - (c.y - b.y) * (px - b.x);
+					double edgeCA = (a.x - c.x) * (py - c.y) - (a.y - c.y) * (px - c.x);
+					if (edgeAB < 0 || edgeBC < 0 || edgeCA < 0)
+						continue;
+					double z = std::clamp((edgeBC * a.z + edgeCA * b.z + edgeAB * c.z) / area, 0.0, 1.0);
+					depth[y * width + x] = std::min(depth[y * width + x], (float)z);
+				}
+		}
+	};
+
+	Aabb BoxAround(XMFLOAT3 center, float halfSize)
+	{
+		return { { center.x - halfSize, center.y - halfSize, center.z - halfSize }, { center.x + halfSize, center.y + halfSize, center.z + halfSize } };
+	}
+}
+
+int main()
+{
+	const int width = 320, height = 192;
+	XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4 * 1.3f, (float)width / height, 0.1f, 100.0f);
+
+	//a unit box seen from all 6 sides: every face it shows has to be front facing and hide what's behind it
+	XMFLOAT3 directions[6] = { { 0, 0, 1 }, { 0, 0, -1 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0.001f }, { 0, -1, 0.001f } };
+	OccluderMesh unit = OccluderMesh::Box({ -1, -1, -1 }, { 1, 1, 1 });
+	for (XMFLOAT3 d : directions)
+	{
+		XMVECTOR direction = XMLoadFloat3(&d);
+		XMVECTOR up = std::fabs(d.z) > 0.5f ? XMVectorSet(0, 1, 0, 0) : XMVectorSet(0, 0, 1, 0);
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixLookToLH(XMVectorScale(direction, -4.0f), direction, up) * projection);
+		OcclusionBuffer buffer(width, height);
+		buffer.RenderOccluder(unit, viewProjection);
+		buffer.Flush();
+		CHECK(buffer.GetTriangleCount() >= 2);
+		CHECK(buffer.IsOccluded(BoxAround({ d.x * 3, d.y * 3, d.z * 3 }, 0.2f), viewProjection));
+		CHECK(!buffer.IsOccluded(BoxAround({ -d.x * 2.5f, -d.y * 2.5f, -d.z * 2.5f }, 0.2f), viewProjection));
+	}
+
+	//a street of walls, one wall crossing the near plane and a floor, then 20k small boxes around them
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unitRandom(0, 1);
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixLookToLH(XMVectorSet(0, 1.5f, 0, 1), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)) * projection);
+	std::vector<OccluderMesh> occluders;
+	for (int i = 0; i < 40; i++)
+	{
+		float x = (unitRandom(random) - 0.5f) * 40, z = 4 + unitRandom(random) * 30, halfWidth = 1 + unitRandom(random) * 5, wallHeight = 1 + unitRandom(random) * 4;
+		occluders.push_back(OccluderMesh::Box({ x - halfWidth, 0, z }, { x + halfWidth, wallHeight, z + 0.5f }));
+	}
+	occluders.push_back(OccluderMesh::Box({ -3, 0, -1 }, { -1, 3, 8 }));
+	occluders.push_back(OccluderMesh::Box({ -50, -1, -5 }, { 50, 0, 80 }));
+	std::vector<Aabb> boxes;
+	for (int i = 0; i < 20000; i++)
+	{
+		float x = (unitRandom(random) - 0.5f) * 60, y = unitRandom(random) * 3, z = 1 + unitRandom(random) * 70, size = 0.1f + unitRandom(random) * 0.6f;
+		boxes.push_back({ { x - size, y, z - size }, { x + size, y + size * 2, z + size } });
+	}
+
+	ReferenceRasterizer reference(width, height);
+	for (const OccluderMesh& occluder : occluders)
+		reference.RenderOccluder(occluder, viewProjection);
+
+	OcclusionBuffer serial(width, height), pooled(width, height);
+	ThreadPool pool(4);
+	for (const OccluderMesh& occluder : occluders)
+	{
+		serial.RenderOccluder(occluder, viewProjection);
+		pooled.RenderOccluder(occluder, viewProjection);
+	}
+	serial.Flush();
+	pooled.Flush(&pool);
+	CHECK(serial.GetTriangleCount() == pooled.GetTriangleCount());
+
+	int culled = 0, referenceCulled = 0;
+	for (const Aabb& box : boxes)
+	{
+		bool occluded = serial.IsOccluded(box, viewProjection);
+		bool expected = reference.IsOccluded(box, viewProjection);
+		CHECK(!occluded || expected); //conservative: hiding something the reference can see is a visible bug
+		CHECK(pooled.IsOccluded(box, viewProjection) == occluded);
+		culled += occluded;
+		referenceCulled += expected;
+	}
+	std::printf("%zu boxes: culled %d of the %d the reference culls\n", boxes.size(), culled, referenceCulled);
+	CHECK(culled >= referenceCulled * 19 / 20); //the coarse depth may give a few up along occluder edges, not more
+
+	//the floor is under the camera, so anything crossing the near plane must stay visible
+	CHECK(!serial.IsOccluded({ { -0.5f, 1, -1 }, { 0.5f, 2, 1 } }, viewProjection));
+
+	//nothing drawn, nothing hidden
+	serial.Clear();
+	serial.Flush();
+	CHECK(serial.GetTriangleCount() == 0);
+	for (size_t i = 0; i < boxes.size(); i += 100)
+		CHECK(!serial.IsOccluded(boxes[i], viewProjection));
+	return 0;
+}
@@ -0,0 +1,104 @@
+// OffsetAllocator: best fit, merging on free from both sides, running out of space, Grow and Reset, then random traffic against a map of taken units
+#include "OffsetAllocator.h"
+#include "TestCheck.h"
+
+#include <random>
+#include <vector>
+
+int main()
+{
+	OffsetAllocator allocator(100);
+	unsigned int a = allocator.Allocate(10), b = allocator.Allocate(20), c = allocator.Allocate(30), d = allocator.Allocate(40);
+	CHECK(a == 0 && b == 10 && c == 30 && d == 60);
+	CHECK(allocator.GetUsed() == 100 && allocator.GetStats().freeBlocks == 0);
+
+	//full, and nothing asks for nothing
+	CHECK(allocator.Allocate(1) == OffsetAllocator::INVALID_OFFSET);
+	CHECK(allocator.Allocate(0) == OffsetAllocator::INVALID_OFFSET);
+
+	//two holes, the smaller one that fits wins even though it comes later
+	allocator.Free(b, 20);
+	allocator.Free(d, 40);
+	CHECK(allocator.GetUsed() == 40 && allocator.GetStats().freeBlocks == 2 && allocator.GetStats().largestFreeBlock == 40);
+	CHECK(allocator.GetStats().fragmentation == 1.0f - 40.0f / 60.0f);
+	unsigned int small = allocator.Allocate(15);
+	CHECK(small == 10);
+	//too big for either hole although there is enough space in total
+	CHECK(allocator.Allocate(41) == OffsetAllocator::INVALID_OFFSET && allocator.GetUsed() == 55);
+	allocator.Free(small, 15);
+
+	//c sits between two free blocks, freeing it merges all three into one
+	allocator.Free(c, 30);
+	OffsetAllocatorStats stats = allocator.GetStats();
+	CHECK(stats.freeBlocks == 1 && stats.largestFreeBlock == 90 && stats.fragmentation == 0.0f);
+	CHECK(allocator.Allocate(90) == 10);
+	allocator.Free(10, 90);
+	allocator.Free(a, 10);
+	CHECK(allocator.GetUsed() == 0 && allocator.GetStats().freeBlocks == 1 && allocator.GetStats().largestFreeBlock == 100);
+
+	//growing extends the free block at the end instead of adding one
+	CHECK(allocator.Allocate(100) == 0);
+	allocator.Free(50, 50);
+	allocator.Grow(150);
+	CHECK(allocator.GetCapacity() == 150 && allocator.GetUsed() == 50);
+	CHECK(allocator.GetStats().freeBlocks == 1 && allocator.GetStats().largestFreeBlock == 100);
+	CHECK(allocator.Allocate(100) == 50);
+	allocator.Grow(100); //never shrinks
+	CHECK(allocator.GetCapacity() == 150);
+
+	//after the owner packed everything to the front
+	allocator.Reset(70);
+	CHECK(allocator.GetUsed() == 70 && allocator.GetStats().freeBlocks == 1 && allocator.Allocate(80) == 70);
+	allocator.Reset(150);
+	CHECK(allocator.GetStats().freeBlocks == 0 && allocator.Allocate(1) == OffsetAllocator::INVALID_OFFSET);
+
+	//random traffic: allocations never overlap or leave the range, the books add up, and freeing everything leaves one block
+	const unsigned int capacity = 4096;
+	OffsetAllocator traffic(capacity);
+	std::vector<bool> taken(capacity);
+	struct Allocation { unsigned int offset, size; };
+	std::vector<Allocation> live;
+	std::mt19937 generator(13);
+	unsigned int used = 0, failures = 0;
+	for (int i = 0; i < 20000; i++)
+	{
+		if (live.empty() || generator() % 3 != 0)
+		{
+			unsigned int size = 1 + generator() % 64;
+			unsigned int offset = traffic.Allocate(size);
+			if (offset == OffsetAllocator::INVALID_OFFSET)
+			{
+				//only when no free block is big enough
+				CHECK(traffic.GetStats().largestFreeBlock < size);
+				failures++;
+				continue;
+			}
+			CHECK(offset + size <= capacity);
+			for (unsigned int u = offset; u < offset + size; u++)
+			{
+				CHECK(!taken[u]);
+				taken[u] = true;
+			}
+			live.push_back({ offset, size });
+			used += size;
+		}
+		else
+		{
+			size_t pick = generator() % live.size();
+			Allocation allocation = live[pick];
+			live[pick] = live.back();
+			live.pop_back();
+			traffic.Free(allocation.offset, allocation.size);
+			for (unsigned int u = allocation.offset; u < allocation.offset + allocation.size; u++)
+				taken[u] = false;
+			used -= allocation.size;
+		}
+		CHECK(traffic.GetUsed() == used);
+	}
+	CHECK(failures > 0); //the traffic did fill it up at some point
+	for (const Allocation& allocation : live)
+		traffic.Free(allocation.offset, allocation.size);
+	stats = traffic.GetStats();
+	CHECK(stats.used == 0 && stats.freeBlocks == 1 && stats.largestFreeBlock == capacity);
+	return 0;
+}
@@ -0,0 +1,96 @@
+// Recording 10k synthetic draws split into 1 to 4 pieces the way RenderSystem::Draw does, the first on this thread and the rest on a ThreadPool
+#include "CommandBuffer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	template<typename T>
+	T* Handle(uintptr_t id)
+	{
+		return (T*)(id * 0x1000);
+	}
+
+	float matrices[10000][32];
+
+	//same shape as ParallelRecordingTest's, with two matrices per object like PrepareMaterial uploads
+	void RecordPackets(CommandBuffer& commands, size_t begin, size_t end)
+	{
+		uintptr_t boundShader = 0;
+		size_t boundMaterial = ~(size_t)0;
+		for (size_t i = begin; i < end; i++)
+		{
+			uintptr_t shader = 1 + i / 2500;
+			if (shader != boundShader)
+			{
+				commands.SetVertexShader(Handle<ID3D11VertexShader>(shader), Handle<ID3D11InputLayout>(2));
+				commands.SetConstantBuffer(ShaderStage::Vertex, 0, Handle<ID3D11Buffer>(3));
+				boundShader = shader;
+			}
+			if (i / 100 != boundMaterial)
+			{
+				boundMaterial = i / 100;
+				commands.SetPixelShader(Handle<ID3D11PixelShader>(6 + boundMaterial % 3));
+				float* material = (float*)commands.WriteBuffer(Handle<ID3D11Buffer>(20), 256);
+				std::memset(material, 0, 256);
+				material[0] = (float)boundMaterial;
+				commands.SetConstantBuffer(ShaderStage::Pixel, 0, Handle<ID3D11Buffer>(20));
+			}
+			if (i == begin)
+			{
+				commands.SetVertexBuffer(0, Handle<ID3D11Buffer>(4), 32);
+				commands.SetIndexBuffer(Handle<ID3D11Buffer>(5), true);
+			}
+			float* perObject = (float*)commands.WriteBuffer(Handle<ID3D11Buffer>(30), 256);
+			std::memcpy(perObject, matrices[i], sizeof(matrices[i]));
+			std::memset(perObject + 32, 0, 128);
+			commands.SetConstantBuffer(ShaderStage::Vertex, 1, Handle<ID3D11Buffer>(30));
+			commands.DrawIndexed(36, 0, 0);
+		}
+	}
+}
+
+int main()
+{
+	const size_t draws = 10000;
+	ThreadPool pool(3);
+	std::vector<CommandBuffer> lists(4);
+	for (size_t jobs = 1; jobs <= 4; jobs++)
+	{
+		auto record = [&]
+		{
+			lists[0].Reset();
+			for (size_t job = 1; job < jobs; job++)
+				pool.Submit([&, job]() { lists[job].Reset(); RecordPackets(lists[job], draws * job / jobs, draws * (job + 1) / jobs); });
+			RecordPackets(lists[0], 0, draws / jobs);
+			if (jobs > 1)
+				pool.Wait();
+		};
+		record(); //grows every list once, the timed ones reuse them
+		double best = 1e9;
+		for (int repeat = 0; repeat < 30; repeat++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			record();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+
+		NullCommandExecutor executor;
+		size_t bytes = 0;
+		for (size_t job = 0; job < jobs; job++)
+		{
+			executor.Execute(lists[job]);
+			bytes += lists[job].GetSize();
+		}
+		std::printf("%zu jobs: %.3f ms, %.1f KB, %u draws, %u redundant binds, %u errors\n", jobs, best, bytes / 1024.0,
+			executor.GetStats().drawCalls, executor.GetStats().redundantBinds, executor.GetErrorCount());
+	}
+	std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+	return 0;
+}
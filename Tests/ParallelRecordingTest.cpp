@@ -0,0 +1,109 @@
+// Draws recorded in contiguous pieces on a ThreadPool the way RenderSystem::Draw splits them: executed in order the pieces
+// have to give the same draws, in the same order, with the same per object data as recording everything on one thread
+#include "CommandBuffer.h"
+#include "TestCheck.h"
+#include "ThreadPool.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	template<typename T>
+	T* Handle(uintptr_t id)
+	{
+		return (T*)(id * 0x1000);
+	}
+
+	const size_t DRAWS = 10000;
+
+	//a stand in for RenderSystem's RecordPackets: every piece starts with nothing bound, shaders change every 2500 draws,
+	//materials every 100, and each draw uploads its own per object data (its index, read back below)
+	void RecordPackets(CommandBuffer& commands, size_t begin, size_t end)
+	{
+		uintptr_t boundShader = 0;
+		size_t boundMaterial = ~(size_t)0;
+		for (size_t i = begin; i < end; i++)
+		{
+			uintptr_t shader = 1 + i / 2500;
+			if (shader != boundShader)
+			{
+				commands.SetVertexShader(Handle<ID3D11VertexShader>(shader), Handle<ID3D11InputLayout>(2));
+				commands.SetConstantBuffer(ShaderStage::Vertex, 0, Handle<ID3D11Buffer>(3));
+				boundShader = shader;
+			}
+			if (i / 100 != boundMaterial)
+			{
+				boundMaterial = i / 100;
+				commands.SetPixelShader(Handle<ID3D11PixelShader>(6 + boundMaterial % 3));
+				float* material = (float*)commands.WriteBuffer(Handle<ID3D11Buffer>(20), 64);
+				std::memset(material, 0, 64);
+				material[0] = (float)boundMaterial;
+				commands.SetConstantBuffer(ShaderStage::Pixel, 0, Handle<ID3D11Buffer>(20));
+			}
+			if (i == begin)
+			{
+				commands.SetVertexBuffer(0, Handle<ID3D11Buffer>(4), 32);
+				commands.SetIndexBuffer(Handle<ID3D11Buffer>(5), true);
+			}
+			uint32_t* perObject = (uint32_t*)commands.WriteBuffer(Handle<ID3D11Buffer>(30), 128);
+			std::memset(perObject, 0, 128);
+			perObject[0] = (uint32_t)i;
+			commands.SetConstantBuffer(ShaderStage::Vertex, 1, Handle<ID3D11Buffer>(30));
+			commands.DrawIndexed(36, 0, 0);
+		}
+	}
+
+	//the per object index uploaded before each draw, over the lists in order
+	std::vector<uint32_t> DrawOrder(const std::vector<CommandBuffer>& lists)
+	{
+		std::vector<uint32_t> order;
+		uint32_t last = ~0u;
+		for (const CommandBuffer& commands : lists)
+			for (const CommandHeader* command = commands.First(); command; command = commands.Next(command))
+			{
+				if (command->type == CommandType::UpdateBuffer && static_cast<const UpdateBufferCommand*>(command)->buffer == Handle<ID3D11Buffer>(30))
+					last = *(const uint32_t*)static_cast<const UpdateBufferCommand*>(command)->GetData();
+				else if (command->type == CommandType::DrawIndexed)
+					order.push_back(last);
+			}
+		return order;
+	}
+}
+
+int main()
+{
+	std::vector<CommandBuffer> serial(1);
+	RecordPackets(serial[0], 0, DRAWS);
+	NullCommandExecutor serialExecutor;
+	serialExecutor.Execute(serial[0]);
+	CHECK(serialExecutor.GetErrorCount() == 0);
+	std::vector<uint32_t> serialOrder = DrawOrder(serial);
+	CHECK(serialOrder.size() == DRAWS);
+
+	ThreadPool pool(3);
+	std::vector<CommandBuffer> lists;
+	for (size_t jobs : { 1, 2, 3, 4, 7 })
+	{
+		//the same split as RenderSystem::Draw: the first piece on this thread, the rest on the pool, one list each
+		lists.resize(jobs);
+		lists[0].Reset();
+		for (size_t job = 1; job < jobs; job++)
+			pool.Submit([&, job]() { lists[job].Reset(); RecordPackets(lists[job], DRAWS * job / jobs, DRAWS * (job + 1) / jobs); });
+		RecordPackets(lists[0], 0, DRAWS / jobs);
+		pool.Wait();
+
+		NullCommandExecutor executor;
+		for (const CommandBuffer& commands : lists)
+			executor.Execute(commands);
+		const CommandStats& stats = executor.GetStats();
+		std::printf("%zu jobs: %u errors, %u draws, %u redundant binds\n", jobs, executor.GetErrorCount(), stats.drawCalls, stats.redundantBinds);
+		CHECK(executor.GetErrorCount() == 0);
+		CHECK(stats.drawCalls == DRAWS && stats.indices == serialExecutor.GetStats().indices);
+		CHECK(DrawOrder(lists) == serialOrder);
+		//each piece past the first binds again what the one before it left bound, nothing else is added
+		CHECK(stats.redundantBinds <= serialExecutor.GetStats().redundantBinds + (jobs - 1) * 6);
+	}
+	return 0;
+}
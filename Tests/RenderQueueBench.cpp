@@ -0,0 +1,54 @@
+// RenderQueue::RadixSort against std::stable_sort on random 64 bit keys at growing queue sizes, to see where COMPARISON_SORT_KEYS belongs
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	template<typename Run>
+	double Best(Run run)
+	{
+		double best = 1e9;
+		for (int repeat = 0; repeat < 50; repeat++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			run();
+			best = std::min(best, std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		return best;
+	}
+}
+
+int main()
+{
+	using Entry = RenderQueue::Entry;
+	std::mt19937_64 random(9);
+	std::printf("cutoff at %zu keys\n", RenderQueue::COMPARISON_SORT_KEYS);
+	for (size_t count : { 256, 512, 1024, 1536, 2048, 4096, 16384, 65536 })
+	{
+		std::vector<Entry> input(count);
+		for (size_t i = 0; i < count; i++)
+			input[i] = { random(), (uint32_t)i };
+
+		//every run sorts a fresh copy, the copy is timed for both so it cancels out
+		std::vector<Entry> entries, scratch;
+		entries.reserve(count);
+		scratch.reserve(count);
+		double radix = Best([&]
+		{
+			entries.assign(input.begin(), input.end());
+			RenderQueue::RadixSort(entries, scratch, 0);
+		});
+		double comparison = Best([&]
+		{
+			entries.assign(input.begin(), input.end());
+			std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+		});
+		std::printf("%6zu keys: radix %8.1f us, stable_sort %8.1f us (%s)\n", count, radix, comparison, radix < comparison ? "radix" : "stable_sort");
+	}
+	return 0;
+}
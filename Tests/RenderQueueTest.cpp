@@ -0,0 +1,59 @@
+// RenderQueue::RadixSort against std::sort/std::stable_sort on random 64 bit keys, on both sides of the comparison sort cutoff,
+// plus keys that share bytes (skipped passes) and lots of ties (stability)
+#include "RenderQueue.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using Entry = RenderQueue::Entry;
+
+	//sorts a copy both ways and compares: same keys as std::sort, and the same order as std::stable_sort for ties
+	void CheckSort(const std::vector<Entry>& input, size_t comparisonSortKeys)
+	{
+		std::vector<Entry> sorted = input, scratch;
+		RenderQueue::RadixSort(sorted, scratch, comparisonSortKeys);
+
+		std::vector<Entry> expected = input;
+		std::sort(expected.begin(), expected.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+		CHECK(sorted.size() == expected.size());
+		for (size_t i = 0; i < sorted.size(); i++)
+			CHECK(sorted[i].key == expected[i].key);
+
+		expected = input;
+		std::stable_sort(expected.begin(), expected.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+		for (size_t i = 0; i < sorted.size(); i++)
+			CHECK(sorted[i].item == expected[i].item);
+	}
+}
+
+int main()
+{
+	std::mt19937_64 random(3);
+	const size_t cutoff = RenderQueue::COMPARISON_SORT_KEYS;
+	for (size_t count : { (size_t)0, (size_t)1, (size_t)2, (size_t)100, cutoff - 1, cutoff, cutoff + 1, (size_t)20000 })
+	{
+		std::vector<Entry> input(count);
+
+		//full 64 bit keys, every pass runs
+		for (size_t i = 0; i < count; i++)
+			input[i] = { random(), (uint32_t)i };
+		CheckSort(input, RenderQueue::COMPARISON_SORT_KEYS);
+		CheckSort(input, 0);
+
+		//like the real keys: one shader, a few materials and meshes, so the top bytes are shared and many keys tie
+		for (size_t i = 0; i < count; i++)
+			input[i] = { (uint64_t)(random() % 4) << 44 | (uint64_t)(random() % 8) << 28 | (random() % 64), (uint32_t)i };
+		CheckSort(input, RenderQueue::COMPARISON_SORT_KEYS);
+		CheckSort(input, 0);
+
+		//all the same, every pass gets skipped
+		for (size_t i = 0; i < count; i++)
+			input[i] = { 0x0123456789ABCDEFull, (uint32_t)i };
+		CheckSort(input, 0);
+	}
+	return 0;
+}
@@ -0,0 +1,60 @@
+// RingAllocator: the no-overwrite rule between wraps, alignment, oversize requests and the frame stats
+#include "RingAllocator.h"
+#include "TestCheck.h"
+
+#include <random>
+
+int main()
+{
+	RingAllocator ring(1024);
+	CHECK(ring.GetCapacity() == 1024 && ring.GetSpaceLeft() == 1024);
+
+	//the first allocation wraps so the buffer gets its first discard
+	RingAllocation first = ring.Allocate(100);
+	CHECK(first.offset == 0 && first.wrapped);
+	RingAllocation second = ring.Allocate(64, 64);
+	CHECK(second.offset == 128 && !second.wrapped);
+	CHECK(ring.GetHead() == 192 && ring.GetFrameBytes() == 192);
+	CHECK(ring.GetSpaceLeft() == 832 && ring.GetSpaceLeft(256) == 768);
+
+	RingAllocation rest = ring.Allocate(832);
+	CHECK(rest.offset == 192 && !rest.wrapped && ring.GetHead() == 1024 && ring.GetSpaceLeft() == 0);
+	RingAllocation again = ring.Allocate(1);
+	CHECK(again.offset == 0 && again.wrapped);
+	CHECK(ring.GetFrameWraps() == 2 && ring.GetTotalWraps() == 2);
+
+	//bigger than the whole ring never fits, and doesn't disturb it
+	RingAllocation tooBig = ring.Allocate(1025);
+	CHECK(tooBig.offset == RingAllocator::INVALID_OFFSET && !tooBig.wrapped);
+	CHECK(ring.GetHead() == 1 && ring.GetTotalWraps() == 2);
+
+	ring.BeginFrame();
+	CHECK(ring.GetFrameBytes() == 0 && ring.GetFrameWraps() == 0 && ring.GetTotalWraps() == 2);
+
+	//random traffic: every allocation is aligned, inside the ring, and after everything handed out since the last wrap
+	std::mt19937 random(7);
+	std::uniform_int_distribution<size_t> size(1, 300);
+	size_t alignments[] = { 1, 4, 16, 256 };
+	size_t end = ring.GetHead();
+	unsigned int wraps = 0;
+	for (int i = 0; i < 100000; i++)
+	{
+		size_t bytes = size(random);
+		size_t alignment = alignments[random() % 4];
+		bool fits = bytes <= ring.GetSpaceLeft(alignment);
+		RingAllocation allocation = ring.Allocate(bytes, alignment);
+		CHECK(allocation.wrapped != fits);
+		CHECK(allocation.offset % alignment == 0);
+		CHECK(allocation.offset + bytes <= ring.GetCapacity());
+		if (allocation.wrapped)
+		{
+			CHECK(allocation.offset == 0);
+			wraps++;
+		}
+		else
+			CHECK(allocation.offset >= end);
+		end = allocation.offset + bytes;
+	}
+	CHECK(ring.GetFrameWraps() == wraps && ring.GetTotalWraps() == wraps + 2);
+	return 0;
+}
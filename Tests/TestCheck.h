@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+
+// assert disappears in release builds and the benchmarks want those, so the tests check with this instead
+// - prints the failed condition and exits with 1, which is all ctest needs
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::fprintf(stderr, "%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			std::exit(1); \
+		} \
+	} while (0)
@@ -0,0 +1,59 @@
+// World matrix rebuilds per frame: the batched AVX2 and SSE kernels against reading every transform one at a time
+#include "Transform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+int main()
+{
+	TransformPool& pool = TransformPool::Get();
+	pool.SetUseAVX2(true);
+	bool hasAVX2 = pool.UsesAVX2();
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> position(-20, 20), angle(-3.1f, 3.1f), scale(0.2f, 3);
+
+	for (size_t count : { 10000, 100000, 1000000 })
+	{
+		std::vector<Transform> transforms(count);
+		for (Transform& transform : transforms)
+		{
+			transform.setPosition(position(random), position(random), position(random));
+			transform.setRotation(angle(random), angle(random), angle(random));
+			transform.setScale(scale(random), scale(random), scale(random));
+		}
+		pool.UpdateDirty();
+
+		const char* names[] = { "AVX2 batch", "SSE batch", "one at a time" };
+		for (int mode = 0; mode < 3; mode++)
+		{
+			if (mode == 0 && !hasAVX2)
+				continue;
+			double best = 1e9;
+			for (int repeat = 0; repeat < 5; repeat++)
+			{
+				for (Transform& transform : transforms)
+					transform.moveAbsolute(0.001f, 0, 0);
+				volatile float sink = 0;
+				auto start = std::chrono::high_resolution_clock::now();
+				if (mode == 2)
+				{
+					for (Transform& transform : transforms)
+						sink = sink + transform.getWorldMatrix()._41;
+				}
+				else
+				{
+					pool.SetUseAVX2(mode == 0);
+					pool.UpdateDirty();
+				}
+				best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+			}
+			std::printf("%zu transforms, %s: %.3f ms (%.1f ns each)\n", count, names[mode], best, best * 1e6 / count);
+		}
+	}
+	return 0;
+}
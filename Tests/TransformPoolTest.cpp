@@ -0,0 +1,182 @@
+// TransformPool batch updates against matrices built the slow way, once per kernel the cpu can run, then the hierarchy bookkeeping and versions
+#include "Transform.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	double RelativeError(const XMFLOAT4X4& expected, const XMFLOAT4X4& actual)
+	{
+		double error = 0;
+		for (int row = 0; row < 4; row++)
+			for (int column = 0; column < 4; column++)
+				error = std::max(error, (double)std::fabs(expected.m[row][column] - actual.m[row][column]) / (1 + std::fabs(expected.m[row][column])));
+		return error;
+	}
+
+	//scale, roll, pitch, yaw, translate, one matrix at a time
+	XMFLOAT4X4 ReferenceWorld(XMFLOAT3 position, XMFLOAT3 rotation, XMFLOAT3 scale)
+	{
+		XMFLOAT4X4 world;
+		XMStoreFloat4x4(&world, XMMatrixScaling(scale.x, scale.y, scale.z) * XMMatrixRotationZ(rotation.z) * XMMatrixRotationX(rotation.x) *
+			XMMatrixRotationY(rotation.y) * XMMatrixTranslation(position.x, position.y, position.z));
+		return world;
+	}
+
+	XMFLOAT4X4 ReferenceInverseTranspose(const XMFLOAT4X4& world)
+	{
+		XMFLOAT4X4 inverseTranspose;
+		XMStoreFloat4x4(&inverseTranspose, XMMatrixTranspose(XMMatrixInverse(nullptr, XMLoadFloat4x4(&world))));
+		return inverseTranspose;
+	}
+
+	void CheckKernel(bool useAVX2)
+	{
+		TransformPool& pool = TransformPool::Get();
+		pool.SetUseAVX2(useAVX2);
+
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> position(-20, 20), angle(-3.1f, 3.1f), scale(0.2f, 3);
+		std::vector<XMFLOAT3> positions, rotations, scales;
+		std::vector<Transform> transforms(1000);
+		for (Transform& transform : transforms)
+		{
+			positions.push_back({ position(random), position(random), position(random) });
+			rotations.push_back({ angle(random), angle(random), angle(random) });
+			scales.push_back({ scale(random), scale(random), scale(random) });
+			transform.setPosition(positions.back());
+			transform.setRotation(rotations.back());
+			transform.setScale(scales.back());
+		}
+		pool.UpdateDirty();
+		CHECK(pool.GetLastUpdateCount() == transforms.size());
+		pool.UpdateNormals();
+		CHECK(pool.GetLastNormalCount() == transforms.size());
+
+		double worldError = 0;
+		double normalError = 0;
+		for (size_t i = 0; i < transforms.size(); i++)
+		{
+			XMFLOAT4X4 world = ReferenceWorld(positions[i], rotations[i], scales[i]);
+			worldError = std::max(worldError, RelativeError(world, transforms[i].readWorldMatrix()));
+			normalError = std::max(normalError, RelativeError(ReferenceInverseTranspose(world), transforms[i].readWorldInverseTransposeMatrix()));
+		}
+		std::printf("%s: world %.2e, inverse transpose %.2e\n", pool.UsesAVX2() ? "AVX2" : "SSE", worldError, normalError);
+		CHECK(worldError < 1e-5);
+		CHECK(normalError < 1e-4);
+
+		//only what moved gets rebuilt, and an idle frame rebuilds nothing
+		for (size_t i = 0; i < transforms.size(); i += 10)
+			transforms[i].moveAbsolute(1, 0, 0);
+		pool.UpdateDirty();
+		CHECK(pool.GetLastUpdateCount() == transforms.size() / 10);
+		CHECK(transforms[0].readWorldMatrix()._41 == positions[0].x + 1);
+		pool.UpdateDirty();
+		CHECK(pool.GetLastUpdateCount() == 0);
+	}
+}
+
+int main()
+{
+	CheckKernel(true); //falls back to SSE without AVX2, then this is the same check twice
+	CheckKernel(false);
+
+	//reading before the batch runs builds the one matrix on the spot
+	Transform transform;
+	transform.setPosition(1, 2, 3);
+	transform.setRotation(0.3f, 1.2f, -0.4f);
+	transform.setScale(2, 1, 0.5f);
+	CHECK(transform.isDirty());
+	XMFLOAT4X4 world = ReferenceWorld({ 1, 2, 3 }, { 0.3f, 1.2f, -0.4f }, { 2, 1, 0.5f });
+	CHECK(RelativeError(world, transform.getWorldMatrix()) < 1e-5);
+
+	//hierarchy: reparenting moves the whole subtree between depth buckets, cycles are turned down,
+	//and freeing a parent leaves its children as roots (the rest of the pool may hold children too, so counts are relative)
+	TransformPool& pool = TransformPool::Get();
+	{
+		unsigned int childrenBefore = pool.GetChildCount();
+		unsigned int maxDepthBefore = pool.GetMaxDepth();
+		unsigned int a = pool.Allocate(), b = pool.Allocate(), c = pool.Allocate(), d = pool.Allocate();
+		CHECK(pool.SetParent(b, a) && pool.SetParent(c, b) && pool.SetParent(d, c));
+		pool.SetPosition(a, XMFLOAT3(1, 0, 0));
+		pool.SetPosition(b, XMFLOAT3(10, 0, 0));
+		pool.SetPosition(c, XMFLOAT3(100, 0, 0));
+		pool.SetPosition(d, XMFLOAT3(1000, 0, 0));
+		pool.UpdateDirty();
+		CHECK(pool.GetDepth(d) == 3 && pool.GetMaxDepth() == std::max(maxDepthBefore, 3u));
+		CHECK(pool.GetChildCount() == childrenBefore + 3);
+		CHECK(pool.GetWorldMatrix(d)._41 == 1111);
+
+		//c (and d with it) skips b
+		CHECK(pool.SetParent(c, a));
+		CHECK(pool.GetParent(c) == a && pool.GetDepth(c) == 1 && pool.GetDepth(d) == 2);
+		CHECK(pool.GetChildCount() == childrenBefore + 3);
+		CHECK(pool.IsWorldDirty(d));
+		pool.UpdateDirty();
+		CHECK(pool.GetWorldMatrix(c)._41 == 101 && pool.GetWorldMatrix(d)._41 == 1101);
+
+		//anything below a transform (or itself) can't become its parent, nothing changes
+		CHECK(!pool.SetParent(a, d) && !pool.SetParent(c, d) && !pool.SetParent(a, a));
+		CHECK(pool.GetParent(a) == TransformPool::NO_PARENT && pool.GetParent(c) == a && pool.GetParent(d) == c);
+		CHECK(pool.GetDepth(a) == 0 && pool.GetDepth(d) == 2);
+		CHECK(pool.SetParent(c, a)); //already its parent
+
+		//freeing a: b and c become roots and keep their local values, d stays under c one level up
+		pool.Free(a);
+		CHECK(pool.GetParent(b) == TransformPool::NO_PARENT && pool.GetParent(c) == TransformPool::NO_PARENT && pool.GetParent(d) == c);
+		CHECK(pool.GetDepth(b) == 0 && pool.GetDepth(c) == 0 && pool.GetDepth(d) == 1);
+		CHECK(pool.GetChildCount() == childrenBefore + 1 && pool.GetMaxDepth() == std::max(maxDepthBefore, 1u));
+		pool.UpdateDirty();
+		CHECK(pool.GetWorldMatrix(c)._41 == 100 && pool.GetWorldMatrix(d)._41 == 1100);
+		//a's slot gets handed out again as a root with no children
+		unsigned int reused = pool.Allocate();
+		CHECK(reused == a && pool.GetParent(reused) == TransformPool::NO_PARENT && pool.GetChildCount() == childrenBefore + 1);
+		pool.Free(reused);
+		pool.Free(d);
+		pool.Free(c);
+		pool.Free(b);
+		CHECK(pool.GetChildCount() == childrenBefore && pool.GetMaxDepth() == maxDepthBefore);
+	}
+
+	//versions between sweeps: a child read twice after its parent moved is composed once and keeps its version,
+	//reading something above it first must not leave the child's matrix behind
+	Transform parent, child, grandchild;
+	child.setParent(&parent);
+	grandchild.setParent(&child);
+	child.setPosition(0, 1, 0);
+	grandchild.setPosition(0, 0, 1);
+	pool.UpdateDirty();
+	uint64_t settled = grandchild.getVersion();
+	CHECK(!grandchild.isDirty() && grandchild.getVersion() == settled);
+	pool.UpdateDirty();
+	CHECK(grandchild.getVersion() == settled); //an idle sweep changes nothing
+	parent.setPosition(5, 0, 0);
+	CHECK(child.isDirty() && grandchild.isDirty());
+	uint64_t moved = child.getVersion();
+	CHECK(moved != settled && child.getVersion() == moved);
+	CHECK(!child.isDirty() && grandchild.isDirty()); //composing the child leaves the grandchild to compose
+	CHECK(grandchild.getWorldMatrix()._41 == 5 && grandchild.getWorldMatrix()._42 == 1 && grandchild.getWorldMatrix()._43 == 1);
+	uint64_t grandchildMoved = grandchild.getVersion();
+	CHECK(grandchildMoved > moved && grandchild.getVersion() == grandchildMoved);
+	parent.setPosition(6, 0, 0);
+	parent.getVersion();
+	CHECK(grandchild.isDirty() && grandchild.getWorldMatrix()._41 == 6);
+	pool.UpdateDirty();
+	CHECK(!grandchild.isDirty() && grandchild.readWorldMatrix()._41 == 6);
+	uint64_t swept = grandchild.getVersion();
+	CHECK(grandchild.getVersion() == swept && child.getVersion() == child.getVersion());
+
+	//copies get their own slot
+	Transform copy = transform;
+	CHECK(copy.getPoolIndex() != transform.getPoolIndex());
+	copy.moveAbsolute(1, 0, 0);
+	CHECK(copy.getPosition().x == 2 && transform.getPosition().x == 1);
+	return 0;
+}
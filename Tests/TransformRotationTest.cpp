@@ -0,0 +1,83 @@
+// Quaternion orientation in Transform: euler/quaternion round trips, the cached basis rows, and reads staying trig free
+#include "Transform.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	float Distance(XMFLOAT3 a, XMFLOAT3 b)
+	{
+		return std::fabs(a.x - b.x) + std::fabs(a.y - b.y) + std::fabs(a.z - b.z);
+	}
+
+	XMFLOAT3 Rotated(XMFLOAT3 direction, XMFLOAT3 pitchYawRoll)
+	{
+		XMFLOAT3 result;
+		XMStoreFloat3(&result, XMVector3Rotate(XMLoadFloat3(&direction), XMQuaternionRotationRollPitchYaw(pitchYawRoll.x, pitchYawRoll.y, pitchYawRoll.z)));
+		return result;
+	}
+}
+
+int main()
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> pitch(-1.5f, 1.5f), angle(-3.1f, 3.1f);
+	double roundTrip = 0;
+	double basis = 0;
+	for (int i = 0; i < 1000; i++)
+	{
+		XMFLOAT3 pitchYawRoll(pitch(random), angle(random), angle(random));
+		Transform a, b;
+		a.setRotation(pitchYawRoll);
+		b.setRotation(a.getQuaternion());
+
+		//angles come back out of the quaternion (pitch stays inside +-90 so they're unique)
+		roundTrip = std::max(roundTrip, (double)Distance(a.getPitchYawRoll(), pitchYawRoll));
+		roundTrip = std::max(roundTrip, (double)Distance(b.getPitchYawRoll(), pitchYawRoll));
+
+		//the cached rows are the axes rotated by the orientation, and stay an orthonormal left handed basis
+		XMFLOAT3 right = b.getRight(), up = b.getUp(), forward = b.getForward();
+		basis = std::max(basis, (double)Distance(forward, Rotated({ 0, 0, 1 }, pitchYawRoll)));
+		basis = std::max(basis, (double)Distance(up, Rotated({ 0, 1, 0 }, pitchYawRoll)));
+		basis = std::max(basis, (double)Distance(right, Rotated({ 1, 0, 0 }, pitchYawRoll)));
+		XMFLOAT3 cross;
+		XMStoreFloat3(&cross, XMVector3Cross(XMLoadFloat3(&right), XMLoadFloat3(&up)));
+		basis = std::max(basis, (double)Distance(cross, forward));
+	}
+	std::printf("round trip %.2e, basis %.2e\n", roundTrip, basis);
+	CHECK(roundTrip < 1e-4);
+	CHECK(basis < 1e-5);
+
+	//quaternions are normalized on the way in
+	Transform scaled;
+	scaled.setRotation(XMFLOAT4(0, 2, 0, 2)); //90 degrees of yaw, twice too long
+	XMFLOAT4 q = scaled.getQuaternion();
+	CHECK(std::fabs(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w - 1) < 1e-6f);
+	CHECK(Distance(scaled.getForward(), { 1, 0, 0 }) < 1e-6f);
+
+	//moving and reading basis vectors or matrices costs no trig, only rotation setters do
+	TransformPool& pool = TransformPool::Get();
+	Transform camera;
+	camera.setRotation(0.2f, 0.4f, 0);
+	pool.UpdateDirty();
+	unsigned long long before = pool.GetTotalTrigCount();
+	for (int frame = 0; frame < 100; frame++)
+	{
+		camera.moveRelative(0, 0, 0.1f);
+		XMFLOAT3 forward = camera.getForward();
+		camera.getWorldMatrix();
+		camera.getWorldInverseTransposeMatrix();
+		pool.UpdateDirty();
+		CHECK(forward.z > 0);
+	}
+	CHECK(pool.GetTotalTrigCount() == before);
+	camera.Rotate(0.01f, 0, 0);
+	CHECK(pool.GetTotalTrigCount() > before);
+	return 0;
+}
@@ -0,0 +1,99 @@
+// VertexQuantization round trip: random vertices through the SSE2 encoder and decoder stay within what 16 bit positions,
+// half uvs and 16 bit octahedral normals can hold, MeasureError reports the same worst case, and the tail doesn't spill
+#include "VertexFormats.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	double AngleDegrees(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		double dot = (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z;
+		double lengths = std::sqrt(((double)a.x * a.x + (double)a.y * a.y + (double)a.z * a.z) * ((double)b.x * b.x + (double)b.y * b.y + (double)b.z * b.z));
+		return std::acos(std::clamp(dot / lengths, -1.0, 1.0)) * (180.0 / 3.14159265358979);
+	}
+}
+
+int main()
+{
+	CHECK(VertexQuantization::GetStride(VertexFormat::Compact) == 16 && VertexQuantization::GetStride(VertexFormat::Full) == sizeof(Vertex));
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> position(-50, 50), uv(-4, 4), axis(-1, 1);
+	//not a multiple of 4 so the padded tail gets exercised, and a flat axis (a quad has no depth) on top
+	for (size_t count : { 1, 3, 1003 })
+		for (bool flat : { false, true })
+		{
+			std::vector<Vertex> vertices(count);
+			XMFLOAT3 boundsMin(1e30f, 1e30f, 1e30f), boundsMax(-1e30f, -1e30f, -1e30f);
+			for (Vertex& v : vertices)
+			{
+				v.Position = XMFLOAT3(position(random), position(random), flat ? 2.5f : position(random));
+				v.UV = XMFLOAT2(uv(random), uv(random));
+				XMFLOAT3 n;
+				float length;
+				do
+				{
+					n = XMFLOAT3(axis(random), axis(random), axis(random));
+					length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+				} while (length < 0.1f || length > 1.0f);
+				v.Normal = XMFLOAT3(n.x / length, n.y / length, n.z / length);
+				v.InstanceID = 0;
+				boundsMin = XMFLOAT3(std::min(boundsMin.x, v.Position.x), std::min(boundsMin.y, v.Position.y), std::min(boundsMin.z, v.Position.z));
+				boundsMax = XMFLOAT3(std::max(boundsMax.x, v.Position.x), std::max(boundsMax.y, v.Position.y), std::max(boundsMax.z, v.Position.z));
+			}
+
+			//one past the end is a sentinel, the tail is encoded and decoded 4 at a time but only count may be written
+			std::vector<CompactVertex> encoded(count + 1);
+			memset(&encoded[count], 0xAB, sizeof(CompactVertex));
+			VertexQuantization::Encode(vertices.data(), count, boundsMin, boundsMax, encoded.data());
+			const unsigned char* encodedSentinel = (const unsigned char*)&encoded[count];
+			CHECK(std::all_of(encodedSentinel, encodedSentinel + sizeof(CompactVertex), [](unsigned char b) { return b == 0xAB; }));
+
+			std::vector<Vertex> decoded(count + 1);
+			memset(&decoded[count], 0xCD, sizeof(Vertex));
+			VertexQuantization::Decode(encoded.data(), count, boundsMin, boundsMax, decoded.data());
+			const unsigned char* decodedSentinel = (const unsigned char*)&decoded[count];
+			CHECK(std::all_of(decodedSentinel, decodedSentinel + sizeof(Vertex), [](unsigned char b) { return b == 0xCD; }));
+
+			//a whole 1/65535 step of the extent per axis, round to nearest is half that and the rest covers float rounding
+			float extentX = boundsMax.x - boundsMin.x, extentY = boundsMax.y - boundsMin.y, extentZ = boundsMax.z - boundsMin.z;
+			float positionBound = std::sqrt(extentX * extentX + extentY * extentY + extentZ * extentZ) / 65535.0f;
+			double positionWorst = 0, uvWorst = 0, normalWorst = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				const Vertex& a = vertices[i];
+				const Vertex& b = decoded[i];
+				double dx = a.Position.x - b.Position.x, dy = a.Position.y - b.Position.y, dz = a.Position.z - b.Position.z;
+				double positionError = std::sqrt(dx * dx + dy * dy + dz * dz);
+				CHECK(positionError <= positionBound);
+				if (flat)
+					CHECK(b.Position.z == 2.5f);
+				//halves keep 11 significant bits, round to nearest is half a step of that
+				auto uvClose = [](float original, float back) { return std::fabs(original - back) <= std::fabs(original) / 2048.0f + 1e-7f; };
+				CHECK(uvClose(a.UV.x, b.UV.x) && uvClose(a.UV.y, b.UV.y));
+				//16 bit octahedral normals are good to a few hundredths of a degree
+				double normalError = AngleDegrees(a.Normal, b.Normal);
+				CHECK(normalError < 0.02);
+				CHECK(std::fabs(b.Normal.x * b.Normal.x + b.Normal.y * b.Normal.y + b.Normal.z * b.Normal.z - 1) < 1e-5f);
+
+				positionWorst = std::max(positionWorst, positionError);
+				uvWorst = std::max(uvWorst, (double)std::max(std::fabs(a.UV.x - b.UV.x), std::fabs(a.UV.y - b.UV.y)));
+				normalWorst = std::max(normalWorst, normalError);
+			}
+
+			//MeasureError decodes on its own and has to land on the same worst case (its normal angle is float acos, so looser)
+			QuantizationError error = VertexQuantization::MeasureError(vertices.data(), encoded.data(), count, boundsMin, boundsMax);
+			CHECK(error.position <= positionBound && std::fabs(error.position - positionWorst) < 1e-5);
+			CHECK(std::fabs(error.uv - uvWorst) < 1e-7);
+			CHECK(error.normalDegrees < 0.1f && std::fabs(error.normalDegrees - normalWorst) < 0.1);
+		}
+	return 0;
+}
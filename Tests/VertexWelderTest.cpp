@@ -0,0 +1,59 @@
+// VertexWelder: corners with the same (position, uv, normal) triplet become one vertex, a different uv or normal keeps them apart,
+// then a big random corner list against a std::map doing the same job
+#include "VertexWelder.h"
+#include "TestCheck.h"
+
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
+
+int main()
+{
+	std::vector<ObjIndex> unique;
+	std::vector<unsigned int> indices;
+
+	//a quad as two triangles sharing an edge, the shared corners merge
+	ObjIndex quad[] = {
+		{ 0, 0, 0 }, { 1, 1, 0 }, { 2, 2, 0 },
+		{ 0, 0, 0 }, { 2, 2, 0 }, { 3, 3, 0 },
+	};
+	CHECK(VertexWelder::Weld(quad, 6, unique, indices) == 4);
+	CHECK(indices.size() == 6 && indices[0] == 0 && indices[1] == 1 && indices[2] == 2 && indices[3] == 0 && indices[4] == 2 && indices[5] == 3);
+	for (size_t i = 0; i < 6; i++)
+	{
+		const ObjIndex& welded = unique[indices[i]];
+		CHECK(welded.Position == quad[i].Position && welded.UV == quad[i].UV && welded.Normal == quad[i].Normal);
+	}
+
+	//a cube edge: same position, but a hard normal on each face, and a uv seam; none of these may merge
+	ObjIndex seams[] = {
+		{ 5, 0, 0 }, { 5, 0, 1 }, //normal differs
+		{ 5, 1, 0 },             //uv differs
+		{ 5, 0, 0 },             //same as the first
+		{ 6, 0, 0 },             //position differs
+		{ 5, 1, 1 },             //both differ
+	};
+	CHECK(VertexWelder::Weld(seams, 6, unique, indices) == 5);
+	CHECK(indices[0] == 0 && indices[1] == 1 && indices[2] == 2 && indices[3] == 0 && indices[4] == 3 && indices[5] == 4);
+
+	//nothing in, nothing out, and the outputs are replaced rather than appended to
+	CHECK(VertexWelder::Weld(nullptr, 0, unique, indices) == 0 && unique.empty() && indices.empty());
+
+	//lots of corners with few distinct values so most repeat, plus -1 (missing) uv and normal indices like objs without them
+	std::mt19937 random(23);
+	std::vector<ObjIndex> corners(100000);
+	for (ObjIndex& corner : corners)
+		corner = { (int)(random() % 2000), (int)(random() % 4) - 1, (int)(random() % 3) - 1 };
+	size_t count = VertexWelder::Weld(corners.data(), corners.size(), unique, indices);
+	std::map<std::tuple<int, int, int>, unsigned int> reference;
+	for (size_t i = 0; i < corners.size(); i++)
+	{
+		auto key = std::make_tuple(corners[i].Position, corners[i].UV, corners[i].Normal);
+		auto found = reference.emplace(key, (unsigned int)reference.size()).first;
+		//first use order, so the ids line up exactly
+		CHECK(indices[i] == found->second);
+	}
+	CHECK(count == reference.size() && unique.size() == count);
+	return 0;
+}
@@ -0,0 +1,62 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	if (threadCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		threadCount = cores > 1 ? cores - 1 : 1;
+	}
+	workers.reserve(threadCount);
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		jobs.clear();
+	}
+	jobAvailable.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	jobAvailable.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this]() { return jobs.empty() && running == 0; });
+}
+
+void ThreadPool::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+		if (stopping)
+			return;
+		std::function<void()> job = std::move(jobs.front());
+		jobs.pop_front();
+		running++;
+
+		lock.unlock();
+		job();
+		lock.lock();
+
+		running--;
+		if (jobs.empty() && running == 0)
+			idle.notify_all();
+	}
+}
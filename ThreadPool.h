@@ -0,0 +1,36 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//fixed set of worker threads pulling jobs from one queue
+//jobs still queued when the pool is destroyed are dropped, the ones already running are finished first
+class ThreadPool
+{
+public:
+	//0 threads means one per core minus the main thread, at least 1
+	explicit ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete; // Remove copy constructor
+	ThreadPool& operator=(const ThreadPool&) = delete; // Remove copy-assignment operator
+
+	void Submit(std::function<void()> job);
+	//blocks until the queue is empty and every worker is idle
+	void Wait();
+
+	unsigned int GetThreadCount() const { return (unsigned int)workers.size(); }
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable idle;
+	unsigned int running = 0;
+	bool stopping = false;
+
+	void WorkerLoop();
+};
@@ -1,4 +1,5 @@
 #include "Transform.h"
+#include <cassert>
 
 using namespace DirectX;
 
@@ -6,119 +7,154 @@ using namespace DirectX;
 
 Transform::Transform()
 {
-	XMStoreFloat3(&positionVector, { 0,0,0 });
-	XMStoreFloat3(&pitchYawRoll, { 0,0,0 });
-	XMStoreFloat3(&scaleVector, { 1,1,1 });
-	XMStoreFloat3(&up, { 0,1,0 });
-	XMStoreFloat3(&forward, { 0,0,1 });
-	XMStoreFloat3(&right, { 1,0,0 });
-	//set world matrix as identity matrix
-	XMStoreFloat4x4(&worldMatrix, XMMatrixIdentity());
-	XMStoreFloat4x4(&worldInverseTransposeMatrix, XMMatrixIdentity());
+	//the pool starts every slot at the origin, unrotated, scale 1 with identity matrices
+	index = TransformPool::Get().Allocate();
+}
+Transform::~Transform()
+{
+	if (index != MOVED_FROM)
+		TransformPool::Get().Free(index);
+}
+
+Transform::Transform(const Transform& other)
+{
+	index = TransformPool::Get().Allocate();
+	*this = other;
+	//a copy hangs under the same parent, the children stay with the original
+	TransformPool::Get().SetParent(index, TransformPool::Get().GetParent(other.index));
+}
+
+Transform& Transform::operator=(const Transform& other)
+{
+	//copies the values into our own slot, the handles stay separate
+	TransformPool::Get().CopyValues(index, other.index);
+	return *this;
+}
+
+Transform::Transform(Transform&& other) noexcept : index(other.index)
+{
+	other.index = MOVED_FROM;
+}
+
+Transform& Transform::operator=(Transform&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (index != MOVED_FROM)
+			TransformPool::Get().Free(index);
+		index = other.index;
+		other.index = MOVED_FROM;
+	}
+	return *this;
 }
-Transform::~Transform(){}
 
 
 //R
 
 XMFLOAT3 Transform::getPitchYawRoll()
 {
-	return pitchYawRoll;
+	return TransformPool::Get().GetPitchYawRoll(index);
 }
 
 XMFLOAT3 Transform::getRotation()
 {
-	return pitchYawRoll;
+	return TransformPool::Get().GetPitchYawRoll(index);
 }
 
 void Transform::setRotation(float pitch, float yaw, float roll)
 {
-	shouldUpdateWorldMatrix = true;
-	shouldUpdateCameraVectors = true;
-	XMStoreFloat3(&pitchYawRoll, { pitch, yaw, roll });
+	TransformPool::Get().SetPitchYawRoll(index, XMFLOAT3(pitch, yaw, roll));
 }
 
 void Transform::setRotation(XMFLOAT3 rotation)
 {
-	shouldUpdateWorldMatrix = true;
-	shouldUpdateCameraVectors = true;
-	pitchYawRoll = rotation;
+	TransformPool::Get().SetPitchYawRoll(index, rotation);
+}
+
+void Transform::setRotation(XMFLOAT4 quaternion)
+{
+	TransformPool::Get().SetQuaternion(index, quaternion);
+}
+
+XMFLOAT4 Transform::getQuaternion()
+{
+	return TransformPool::Get().GetQuaternion(index);
 }
 
 void Transform::Rotate(float pitch, float yaw, float roll)
 {
-	shouldUpdateCameraVectors = true;
-	shouldUpdateWorldMatrix = true;
-	//take objects current rotation
-	XMVECTOR currentPitchYawRoll = XMLoadFloat3(&pitchYawRoll);
-	//if we are doing float math we need to convert to xmvector
-	XMVECTOR deltaPitchYawRoll = XMVectorSet(pitch, yaw, roll, 0);
-	currentPitchYawRoll = XMVectorAdd(currentPitchYawRoll, deltaPitchYawRoll);
-	// Store the result back into the pitchYawRoll member
-	XMStoreFloat3(&pitchYawRoll, currentPitchYawRoll);
+	Rotate(XMFLOAT3(pitch, yaw, roll));
 }
 
 //both rotate and moveAbsolute should add according to notes
 void Transform::Rotate(XMFLOAT3 rotation)
 {
-	shouldUpdateCameraVectors = true;
-	shouldUpdateWorldMatrix = true;
+	XMFLOAT3 pitchYawRoll = getPitchYawRoll();
 	XMVECTOR currentPitchYawRoll = XMLoadFloat3(&pitchYawRoll);
 	XMVECTOR deltaPitchYawRoll = XMLoadFloat3(&rotation); 
 	currentPitchYawRoll = XMVectorAdd(currentPitchYawRoll, deltaPitchYawRoll);
 	XMStoreFloat3(&pitchYawRoll, currentPitchYawRoll);
+	setRotation(pitchYawRoll);
 }
 
 //camera stuff related to R sorta..
+//the pool keeps the rotation rows next to the quaternion, so these are just reads
 XMFLOAT3 Transform::getForward()
 {
-	if (shouldUpdateCameraVectors)
-	{
-		updateRelativeVectors();
-	}
-	return forward;
+	return TransformPool::Get().GetForward(index);
 }
 
 XMFLOAT3 Transform::getRight()
 {
-	if (shouldUpdateCameraVectors)
-	{
-		updateRelativeVectors();
-	}
-	return right;
+	return TransformPool::Get().GetRight(index);
 }
 
 XMFLOAT3 Transform::getUp()
 {
-	if (shouldUpdateCameraVectors)
+	return TransformPool::Get().GetUp(index);
+}
+
+bool Transform::isDirty()
+{
+	return TransformPool::Get().IsWorldDirty(index); //indicates if world matrix needs to be updated, parents included
+}
+
+uint64_t Transform::getVersion()
+{
+	//brought up to date first so the version always belongs to the matrix getWorldMatrix would return
+	TransformPool& pool = TransformPool::Get();
+	if (pool.IsWorldDirty(index))
 	{
-		updateRelativeVectors();
+		pool.UpdateOne(index);
 	}
-	return up;
+	return pool.GetVersion(index);
 }
 
-bool Transform::isDirty()
+//hierarchy
+bool Transform::setParent(Transform* parent)
 {
-	return shouldUpdateWorldMatrix; //indicates if world matrix needs to be updated
+	return TransformPool::Get().SetParent(index, parent ? parent->index : TransformPool::NO_PARENT);
+}
+
+bool Transform::hasParent()
+{
+	return TransformPool::Get().GetParent(index) != TransformPool::NO_PARENT;
 }
 
 //P
 XMFLOAT3 Transform::getPosition()
 {
-	return positionVector;
+	return TransformPool::Get().GetPosition(index);
 }
 
 void Transform::setPosition(float x, float y, float z)
 {
-	//XMStoreFloat3 does not modify the original vector, it returns a new one in a thread safe manner
-	shouldUpdateWorldMatrix = true;
-	XMStoreFloat3(&positionVector, { x,y,z });
+	TransformPool::Get().SetPosition(index, XMFLOAT3(x, y, z));
 }
 
 void Transform::setPosition(XMFLOAT3 position)
 {
-	shouldUpdateWorldMatrix = true;
-	positionVector = position;
+	TransformPool::Get().SetPosition(index, position);
 }
 
 //moves only position  
@@ -131,42 +167,32 @@ void Transform::moveAbsolute(float x, float y, float z)
 		as much as you can at this step
 		For this particular calculation
 		Store result(s) back into XMFLOATs when done*/
-	shouldUpdateWorldMatrix = true;
-
-
-	XMVECTOR position = XMLoadFloat3(&positionVector);
-	XMVECTOR translation = XMVectorSet(x, y, z, 0);
-	position = XMVectorAdd(position, translation);
-	XMStoreFloat3(&positionVector, position);
+	moveAbsolute(XMFLOAT3(x, y, z));
 }
 
 //means only transformation is done
 void Transform::moveAbsolute(XMFLOAT3 translation)
 {
-	shouldUpdateWorldMatrix = true;
+	XMFLOAT3 positionVector = getPosition();
 	XMVECTOR position = XMLoadFloat3(&positionVector);
 	XMVECTOR translationVector = XMLoadFloat3(&translation);
 	position = XMVectorAdd(position, translationVector);
 	XMStoreFloat3(&positionVector, position);
+	setPosition(positionVector);
 }
 
 
 //move relative
 void Transform::moveRelative(float x, float y, float z)
 {
-	shouldUpdateWorldMatrix = true;
-	XMVECTOR quat = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&pitchYawRoll));
-	XMVECTOR relativeMovement = XMVectorSet(x, y, z, 0.0f);
-	XMVECTOR existingPosition = XMLoadFloat3(&positionVector);
-
-	XMVECTOR direction = XMVector3Rotate(relativeMovement, quat);
-	direction = XMVectorAdd(direction, existingPosition);
-	XMStoreFloat3(&positionVector, direction);
+	XMFLOAT3 positionVector = getPosition();
+	XMFLOAT3 direction = rotateVector(XMFLOAT3(x, y, z));
+	XMStoreFloat3(&positionVector, XMVectorAdd(XMLoadFloat3(&direction), XMLoadFloat3(&positionVector)));
+	setPosition(positionVector);
 }
 
 void Transform::moveRelative(XMFLOAT3 offset)
 {
-	shouldUpdateWorldMatrix = true; //just to be safe..
 	moveRelative(offset.x, offset.y, offset.z);
 }
 
@@ -174,78 +200,83 @@ void Transform::moveRelative(XMFLOAT3 offset)
 //S
 XMFLOAT3 Transform::getScale()
 {
-	return scaleVector;
+	return TransformPool::Get().GetScale(index);
 }
 
 void Transform::setScale(float x, float y, float z)
 {
-	shouldUpdateWorldMatrix = true;
-	XMStoreFloat3(&scaleVector, { x,y,z });
+	TransformPool::Get().SetScale(index, XMFLOAT3(x, y, z));
 }
 
 void Transform::setScale(XMFLOAT3 scale)
 {
-	shouldUpdateWorldMatrix = true;
-	XMStoreFloat3(&scaleVector, XMLoadFloat3(&scale));
+	TransformPool::Get().SetScale(index, scale);
 }
 
 //scale should multiply 
 void Transform::Scale(float x, float y, float z)
 {
-	shouldUpdateWorldMatrix = true;
-	XMVECTOR currentScale = XMLoadFloat3(&scaleVector);
-	XMVECTOR scalingFactor = XMVectorSet(x, y, z, 0);
-	currentScale = XMVectorMultiply(currentScale, scalingFactor);
-	XMStoreFloat3(&scaleVector, currentScale);
+	Scale(XMFLOAT3(x, y, z));
 }
 
 void Transform::Scale(XMFLOAT3 scale)
 {
-	shouldUpdateWorldMatrix = true;
+	XMFLOAT3 scaleVector = getScale();
 	XMVECTOR currentScale = XMLoadFloat3(&scaleVector);
 	XMVECTOR scalingFactor = XMLoadFloat3(&scale);
 	currentScale = XMVectorMultiply(currentScale, scalingFactor);
 	XMStoreFloat3(&scaleVector, currentScale);
+	setScale(scaleVector);
 }
 
 
 
+//normally TransformPool::UpdateDirty already rebuilt it this frame, reads in between update just this one
 XMFLOAT4X4 Transform::getWorldMatrix()
 {
-	if (shouldUpdateWorldMatrix)
+	TransformPool& pool = TransformPool::Get();
+	if (pool.IsWorldDirty(index))
 	{
-		updateWorldMatrix();
+		pool.UpdateOne(index);
 	}
-	return worldMatrix;
+	return pool.GetWorldMatrix(index);
 }
 
 XMFLOAT4X4 Transform::getWorldInverseTransposeMatrix()
 {
-	return worldInverseTransposeMatrix;
+	TransformPool& pool = TransformPool::Get();
+	if (pool.IsWorldDirty(index))
+	{
+		pool.UpdateOne(index);
+	}
+	return pool.GetWorldInverseTransposeMatrix(index);
 }
 
-void Transform::updateRelativeVectors() {
-
-	XMStoreFloat3(&forward, XMVector3Rotate(XMVectorSet(0, 0, 1, 0), XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&pitchYawRoll))));
-	XMStoreFloat3(&right, XMVector3Rotate(XMVectorSet(1, 0, 0, 0), XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&pitchYawRoll))));
-	XMStoreFloat3(&up, XMVector3Cross(XMLoadFloat3(&forward), XMLoadFloat3(&right)));
-	shouldUpdateCameraVectors = false;
+const XMFLOAT4X4& Transform::readWorldMatrix() const
+{
+	const TransformPool& pool = TransformPool::Get();
+	assert(!pool.IsWorldDirty(index));
+	return pool.GetWorldMatrix(index);
 }
 
+const XMFLOAT4X4& Transform::readWorldInverseTransposeMatrix() const
+{
+	const TransformPool& pool = TransformPool::Get();
+	assert(!pool.IsWorldDirty(index) && !pool.IsNormalStale(index));
+	return pool.GetBuiltWorldInverseTransposeMatrix(index);
+}
 
-void Transform::updateWorldMatrix()
+//rotates a local direction by the current orientation, x/y/z along right/up/forward
+XMFLOAT3 Transform::rotateVector(XMFLOAT3 direction)
 {
-	//create translation matrix
-	XMMATRIX translationMatrix = XMMatrixTranslationFromVector(XMLoadFloat3(&positionVector));
-	//create rotation matrix
-	XMMATRIX rotationMatrix = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&pitchYawRoll));
-	//create scale matrix
-	XMMATRIX scaleMatrix = XMMatrixScalingFromVector(XMLoadFloat3(&scaleVector));
-	//create world matrix column major is gpu , row major is cpu friendly
-	XMMATRIX world = scaleMatrix * rotationMatrix * translationMatrix;
-	//store world matrix
-	XMStoreFloat4x4(&worldMatrix, world);
-	//store inverse transpose matrix
-	XMStoreFloat4x4(&worldInverseTransposeMatrix, XMMatrixInverse(0, XMMatrixTranspose(world)));
-	shouldUpdateWorldMatrix = false;
-}
\ No newline at end of file
+	TransformPool& pool = TransformPool::Get();
+	XMFLOAT3 right = pool.GetRight(index);
+	XMFLOAT3 up = pool.GetUp(index);
+	XMFLOAT3 forward = pool.GetForward(index);
+	XMVECTOR rotated = XMVectorScale(XMLoadFloat3(&right), direction.x);
+	rotated = XMVectorMultiplyAdd(XMLoadFloat3(&up), XMVectorReplicate(direction.y), rotated);
+	rotated = XMVectorMultiplyAdd(XMLoadFloat3(&forward), XMVectorReplicate(direction.z), rotated);
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, rotated);
+	return result;
+}
@@ -1,11 +1,19 @@
 #pragma once
 #include <DirectXMath.h>
+#include "TransformPool.h"
 
+//handle to a slot in the TransformPool, the data itself lives there as structure of arrays
+//copies get a slot of their own with the same values, so it still behaves like a plain value
 class Transform
 {
 public:
 	Transform();
 	~Transform();
+	Transform(const Transform& other);
+	Transform& operator=(const Transform& other);
+	//moves hand the slot over, so the pool index (and any children pointing at it) stays the same
+	Transform(Transform&& other) noexcept;
+	Transform& operator=(Transform&& other) noexcept;
 
 	//position
 	DirectX::XMFLOAT3 getPosition();
@@ -21,6 +29,8 @@ public:
 	DirectX::XMFLOAT3 getRotation();
 	void setRotation(float pitch, float yaw, float roll);
 	void setRotation(DirectX::XMFLOAT3 rotation);
+	void setRotation(DirectX::XMFLOAT4 quaternion); //pitch/yaw/roll gets worked out from it for the sliders
+	DirectX::XMFLOAT4 getQuaternion();
 	void Rotate(float pitch, float yaw, float roll);
 	void Rotate(DirectX::XMFLOAT3 rotation); //not doing the xmfloat4 version but i have a rough idea as to how
 
@@ -35,30 +45,28 @@ public:
 	//world matrix 
 	DirectX::XMFLOAT4X4 getWorldMatrix();
 	DirectX::XMFLOAT4X4 getWorldInverseTransposeMatrix();
+	//same without ever rebuilding (asserts there's nothing to rebuild), for threads reading while others read too,
+	//only right after TransformPool::UpdateDirty and UpdateNormals
+	const DirectX::XMFLOAT4X4& readWorldMatrix() const;
+	const DirectX::XMFLOAT4X4& readWorldInverseTransposeMatrix() const;
 	bool isDirty();
+	//bumped every time the world matrix changes, keep the last one you saw instead of relying on isDirty
+	uint64_t getVersion();
+	unsigned int getPoolIndex() { return index; }
 
-	//camera stuff
+	//hierarchy, position/rotation/scale become relative to the parent and the world matrix follows it
+	//false if it would make a cycle, nullptr detaches
+	bool setParent(Transform* parent);
+	bool hasParent();
+
+	//camera stuff, local space (ignores the parent)
 	DirectX::XMFLOAT3 getForward();
 	DirectX::XMFLOAT3 getRight();
 	DirectX::XMFLOAT3 getUp();
 
 private:
-	DirectX::XMFLOAT3 positionVector;
-	DirectX::XMFLOAT3 scaleVector;
-	DirectX::XMFLOAT3 pitchYawRoll;
-	DirectX::XMFLOAT4X4 worldMatrix;
-
-    DirectX::XMFLOAT4X4 worldInverseTransposeMatrix;
-
-	//camera stuff
-	DirectX::XMFLOAT3 up;
-	DirectX::XMFLOAT3 forward;
-	DirectX::XMFLOAT3 right;
+	static constexpr unsigned int MOVED_FROM = ~0u;
+	unsigned int index;
 
-	void updateRelativeVectors(); //updates rotation vectors only when needed
-	void updateWorldMatrix();
-
-	bool shouldUpdateWorldMatrix = false;
-	bool shouldUpdateCameraVectors = false;
+	DirectX::XMFLOAT3 rotateVector(DirectX::XMFLOAT3 direction);
 };
-
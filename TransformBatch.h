@@ -0,0 +1,104 @@
+#pragma once
+
+// Lane width independent body of the TransformPool batch update, shared by the SSE and AVX2 kernels
+// V wraps one register type: T, LANES, Load/Store/Set, arithmetic, Sqrt, And/Xor and StoreRows, which transposes 4 registers (one matrix row over every lane) into that row of LANES matrices
+// include inside an anonymous namespace after TransformPool.h, each kernel gets its own copy compiled for its instruction set
+
+template<class V>
+inline void LoadRotation(const TransformArrays& a, unsigned int first, typename V::T r[3][3])
+{
+	//rotation rows were built when the rotation was set, so nothing in here needs trig
+	for (int row = 0; row < 3; row++)
+		for (int column = 0; column < 3; column++)
+			r[row][column] = V::Load(a.rotation[row * 3 + column] + first);
+}
+
+//local = scale * rotation * translation for transforms [first, first + LANES), every rotation row gets scaled by its axis
+template<class V>
+inline void UpdateBlock(const TransformArrays& a, unsigned int first)
+{
+	using T = typename V::T;
+	T zero = V::Set(0.0f);
+	T r[3][3];
+	LoadRotation<V>(a, first, r);
+	for (int row = 0; row < 3; row++)
+	{
+		T s = V::Load(a.scale[row] + first);
+		T localRow[4] = { V::Mul(r[row][0], s), V::Mul(r[row][1], s), V::Mul(r[row][2], s), zero };
+		V::StoreRows(a.local + first, row, localRow);
+	}
+	T translationRow[4] = { V::Load(a.position[0] + first), V::Load(a.position[1] + first), V::Load(a.position[2] + first), V::Set(1.0f) };
+	V::StoreRows(a.local + first, 3, translationRow);
+}
+
+// Normal matrix = (local^-1)^T for transforms [first, first + LANES), straight from the TRS parts instead of a general inverse
+// local^-1 = T^-1 * R^T * S^-1, transposed that is rows R_i / s_i with -dot(t, R_i) / s_i in the last column
+template<class V>
+inline void UpdateNormalBlock(const TransformArrays& a, unsigned int first)
+{
+	using T = typename V::T;
+	T one = V::Set(1.0f);
+	T zero = V::Set(0.0f);
+	T r[3][3];
+	LoadRotation<V>(a, first, r);
+	T t[3] = { V::Load(a.position[0] + first), V::Load(a.position[1] + first), V::Load(a.position[2] + first) };
+	for (int row = 0; row < 3; row++)
+	{
+		T invS = V::Div(one, V::Load(a.scale[row] + first));
+		T d = V::Add(V::Add(V::Mul(t[0], r[row][0]), V::Mul(t[1], r[row][1])), V::Mul(t[2], r[row][2]));
+		T inverseRow[4] = { V::Mul(r[row][0], invS), V::Mul(r[row][1], invS), V::Mul(r[row][2], invS), V::Sub(zero, V::Mul(d, invS)) };
+		V::StoreRows(a.localInverseTranspose + first, row, inverseRow);
+	}
+	T lastRow[4] = { zero, zero, zero, one };
+	V::StoreRows(a.localInverseTranspose + first, 3, lastRow);
+}
+
+//render state for transforms [first, first + LANES): position and scale lerped, the quaternion nlerped on the short way round
+template<class V>
+inline void InterpolateBlock(const InterpolationArrays& a, unsigned int first, float alphaValue)
+{
+	using T = typename V::T;
+	T alpha = V::Set(alphaValue);
+	T one = V::Set(1.0f);
+	T two = V::Set(2.0f);
+	for (int i = 0; i < 3; i++)
+	{
+		T from = V::Load(a.previousPosition[i] + first);
+		V::Store(a.renderPosition[i] + first, V::Add(from, V::Mul(V::Sub(V::Load(a.position[i] + first), from), alpha)));
+		from = V::Load(a.previousScale[i] + first);
+		V::Store(a.renderScale[i] + first, V::Add(from, V::Mul(V::Sub(V::Load(a.scale[i] + first), from), alpha)));
+	}
+
+	// q and -q are the same rotation, flip the previous one onto the current one's side so the blend doesn't go the long way
+	T from[4], to[4];
+	T dot = V::Set(0.0f);
+	for (int i = 0; i < 4; i++)
+	{
+		from[i] = V::Load(a.previousQuaternion[i] + first);
+		to[i] = V::Load(a.quaternion[i] + first);
+		dot = V::Add(dot, V::Mul(from[i], to[i]));
+	}
+	T flip = V::And(dot, V::Set(-0.0f));
+	T q[4];
+	T lengthSquared = V::Set(0.0f);
+	for (int i = 0; i < 4; i++)
+	{
+		T flipped = V::Xor(from[i], flip);
+		q[i] = V::Add(flipped, V::Mul(V::Sub(to[i], flipped), alpha));
+		lengthSquared = V::Add(lengthSquared, V::Mul(q[i], q[i]));
+	}
+	T inverseLength = V::Div(one, V::Sqrt(lengthSquared));
+	T qx = V::Mul(q[0], inverseLength), qy = V::Mul(q[1], inverseLength), qz = V::Mul(q[2], inverseLength), qw = V::Mul(q[3], inverseLength);
+
+	// Rotation rows, same as XMMatrixRotationQuaternion
+	T xx = V::Mul(qx, qx), yy = V::Mul(qy, qy), zz = V::Mul(qz, qz);
+	T xy = V::Mul(qx, qy), xz = V::Mul(qx, qz), yz = V::Mul(qy, qz);
+	T xw = V::Mul(qx, qw), yw = V::Mul(qy, qw), zw = V::Mul(qz, qw);
+	T r[9] = {
+		V::Sub(one, V::Mul(two, V::Add(yy, zz))), V::Mul(two, V::Add(xy, zw)), V::Mul(two, V::Sub(xz, yw)),
+		V::Mul(two, V::Sub(xy, zw)), V::Sub(one, V::Mul(two, V::Add(xx, zz))), V::Mul(two, V::Add(yz, xw)),
+		V::Mul(two, V::Add(xz, yw)), V::Mul(two, V::Sub(yz, xw)), V::Sub(one, V::Mul(two, V::Add(xx, yy))),
+	};
+	for (int i = 0; i < 9; i++)
+		V::Store(a.renderRotation[i] + first, r[i]);
+}
@@ -0,0 +1,643 @@
+#include "TransformPool.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	//4 lanes, SSE2 only so it runs everywhere x64 does
+	struct SSE
+	{
+		using T = __m128;
+		static constexpr unsigned int LANES = 4;
+		static T Load(const float* p) { return _mm_loadu_ps(p); }
+		static void Store(float* p, T v) { _mm_storeu_ps(p, v); }
+		static T Set(float f) { return _mm_set1_ps(f); }
+		static T Add(T a, T b) { return _mm_add_ps(a, b); }
+		static T Sub(T a, T b) { return _mm_sub_ps(a, b); }
+		static T Mul(T a, T b) { return _mm_mul_ps(a, b); }
+		static T Div(T a, T b) { return _mm_div_ps(a, b); }
+		static T Sqrt(T a) { return _mm_sqrt_ps(a); }
+		static T And(T a, T b) { return _mm_and_ps(a, b); }
+		static T Xor(T a, T b) { return _mm_xor_ps(a, b); }
+		static void StoreRows(XMFLOAT4X4* out, int row, T v[4])
+		{
+			_MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+			for (int i = 0; i < 4; i++)
+				_mm_storeu_ps(out[i].m[row], v[i]);
+		}
+	};
+
+#include "TransformBatch.h"
+
+	unsigned int CountTrailingZeros(uint64_t bits)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return (unsigned int)index;
+#else
+		return (unsigned int)__builtin_ctzll(bits);
+#endif
+	}
+
+	bool CpuHasAVX2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		bool osxsave = (info[2] >> 27) & 1;
+		bool avx = (info[2] >> 28) & 1;
+		bool fma = (info[2] >> 12) & 1;
+		//the os has to save the ymm registers on context switches too
+		if (!osxsave || !avx || !fma || (_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] >> 5) & 1;
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+}
+
+void TransformBatch::UpdateBlocksSSE(const TransformArrays& arrays, const unsigned int* blockStarts, size_t blockCount)
+{
+	for (size_t i = 0; i < blockCount; i++)
+		UpdateBlock<SSE>(arrays, blockStarts[i]);
+}
+
+void TransformBatch::UpdateNormalBlocksSSE(const TransformArrays& arrays, const unsigned int* blockStarts, size_t blockCount)
+{
+	for (size_t i = 0; i < blockCount; i++)
+		UpdateNormalBlock<SSE>(arrays, blockStarts[i]);
+}
+
+void TransformBatch::InterpolateBlocksSSE(const InterpolationArrays& arrays, const unsigned int* blockStarts, size_t blockCount, float alpha)
+{
+	for (size_t i = 0; i < blockCount; i++)
+		InterpolateBlock<SSE>(arrays, blockStarts[i], alpha);
+}
+
+TransformPool& TransformPool::Get()
+{
+	static TransformPool pool;
+	return pool;
+}
+
+TransformPool::TransformPool()
+{
+	hasAVX2 = CpuHasAVX2();
+	useAVX2 = hasAVX2;
+}
+
+unsigned int TransformPool::Allocate()
+{
+	if (freeList.empty())
+		Grow();
+	unsigned int index = freeList.back();
+	freeList.pop_back();
+	count++;
+
+	parent[index] = NO_PARENT;
+	firstChild[index] = NO_PARENT;
+	nextSibling[index] = NO_PARENT;
+	previousSibling[index] = NO_PARENT;
+	depth[index] = 0;
+
+	//a new transform shows up where it is put even mid step, there is nothing to blend from
+	if (inFixedStep)
+	{
+		SetBit(spawned, index);
+		anySpawned = true;
+	}
+
+	//identity, same defaults the Transform constructor always had
+	SetPosition(index, XMFLOAT3(0, 0, 0));
+	SetPitchYawRoll(index, XMFLOAT3(0, 0, 0));
+	SetScale(index, XMFLOAT3(1, 1, 1));
+	UpdateOne(index);
+	return index;
+}
+
+void TransformPool::Free(unsigned int index)
+{
+	while (firstChild[index] != NO_PARENT)
+		SetParent(firstChild[index], NO_PARENT);
+	SetParent(index, NO_PARENT);
+
+	//the slot keeps its values, dirty or not doesn't matter, it just gets rebuilt along with its block
+	freeList.push_back(index);
+	count--;
+}
+
+bool TransformPool::IsWorldDirty(unsigned int index) const
+{
+	//stale when anything on the way up has new local values, or a child on it wasn't composed since it or its parent changed
+	for (unsigned int p = index; p != NO_PARENT; p = parent[p])
+		if (IsDirty(p) || (parent[p] != NO_PARENT && !GetBit(composed, p)))
+			return true;
+	return false;
+}
+
+bool TransformPool::SetParent(unsigned int index, unsigned int newParent)
+{
+	if (parent[index] == newParent)
+		return true;
+	for (unsigned int p = newParent; p != NO_PARENT; p = parent[p])
+		if (p == index)
+			return false;
+
+	Unlink(index);
+	if (newParent != NO_PARENT)
+	{
+		parent[index] = newParent;
+		nextSibling[index] = firstChild[newParent];
+		if (firstChild[newParent] != NO_PARENT)
+			previousSibling[firstChild[newParent]] = index;
+		firstChild[newParent] = index;
+	}
+
+	//only this subtree moves between buckets, nothing else in the pool gets touched
+	SetDepth(index, newParent == NO_PARENT ? 0 : depth[newParent] + 1);
+	//same local values, but the world matrix (and so everything below it) is different now
+	MarkDirty(index);
+	ClearComposed(index);
+	return true;
+}
+
+unsigned int TransformPool::GetChildCount() const
+{
+	size_t children = 0;
+	for (const std::vector<unsigned int>& bucket : depthBuckets)
+		children += bucket.size();
+	return (unsigned int)children;
+}
+
+void TransformPool::Unlink(unsigned int index)
+{
+	unsigned int p = parent[index];
+	if (p == NO_PARENT)
+		return;
+	if (previousSibling[index] != NO_PARENT)
+		nextSibling[previousSibling[index]] = nextSibling[index];
+	else
+		firstChild[p] = nextSibling[index];
+	if (nextSibling[index] != NO_PARENT)
+		previousSibling[nextSibling[index]] = previousSibling[index];
+	parent[index] = NO_PARENT;
+	nextSibling[index] = NO_PARENT;
+	previousSibling[index] = NO_PARENT;
+}
+
+void TransformPool::SetDepth(unsigned int index, unsigned int newDepth)
+{
+	if (depth[index] == newDepth)
+		return;
+
+	// Walk the subtree, every node moves down (or up) by the same amount
+	// swap and pop out of the old bucket, the order inside a bucket doesn't matter
+	int shift = (int)newDepth - (int)depth[index];
+	std::vector<unsigned int> stack = { index };
+	while (!stack.empty())
+	{
+		unsigned int node = stack.back();
+		stack.pop_back();
+		unsigned int oldDepth = depth[node];
+		if (oldDepth > 0)
+		{
+			std::vector<unsigned int>& bucket = depthBuckets[oldDepth - 1];
+			unsigned int moved = bucket.back();
+			bucket[bucketSlot[node]] = moved;
+			bucketSlot[moved] = bucketSlot[node];
+			bucket.pop_back();
+		}
+		depth[node] = (unsigned int)((int)oldDepth + shift);
+		if (depth[node] > 0)
+		{
+			if (depthBuckets.size() < depth[node])
+				depthBuckets.resize(depth[node]);
+			std::vector<unsigned int>& bucket = depthBuckets[depth[node] - 1];
+			bucketSlot[node] = (unsigned int)bucket.size();
+			bucket.push_back(node);
+		}
+		for (unsigned int child = firstChild[node]; child != NO_PARENT; child = nextSibling[child])
+			stack.push_back(child);
+	}
+
+	while (!depthBuckets.empty() && depthBuckets.back().empty())
+		depthBuckets.pop_back();
+}
+
+void TransformPool::Compose(unsigned int index)
+{
+	XMStoreFloat4x4(&world[index], XMMatrixMultiply(XMLoadFloat4x4(&local[index]), XMLoadFloat4x4(&GetWorldMatrix(parent[index]))));
+	SetBit(normalStale, index);
+}
+
+void TransformPool::WorldChanged(unsigned int index)
+{
+	Touch(index);
+	SetBit(normalStale, index);
+	for (unsigned int child = firstChild[index]; child != NO_PARENT; child = nextSibling[child])
+		ClearComposed(child);
+}
+
+void TransformPool::ComposeNormal(unsigned int index)
+{
+	//(local * parent)^-T = local^-T * parent^-T, so the inverse transposes compose the same way, the parent's has to be fresh
+	unsigned int p = parent[index];
+	const XMFLOAT4X4& parentNormal = parent[p] == NO_PARENT ? localInverseTranspose[p] : worldInverseTranspose[p];
+	XMStoreFloat4x4(&worldInverseTranspose[index], XMMatrixMultiply(XMLoadFloat4x4(&localInverseTranspose[index]), XMLoadFloat4x4(&parentNormal)));
+}
+
+const XMFLOAT4X4& TransformPool::GetWorldInverseTransposeMatrix(unsigned int index)
+{
+	if (GetBit(normalStale, index))
+	{
+		if (parent[index] != NO_PARENT)
+			GetWorldInverseTransposeMatrix(parent[index]);
+
+		//the SSE block around it, only this one counts as done though, the others may still need composing
+		unsigned int first = index & ~3u;
+		TransformBatch::UpdateNormalBlocksSSE(GetArrays(), &first, 1);
+		if (parent[index] != NO_PARENT)
+			ComposeNormal(index);
+		normalStale[index >> 6] &= ~(1ull << (index & 63));
+	}
+	return parent[index] == NO_PARENT ? localInverseTranspose[index] : worldInverseTranspose[index];
+}
+
+void TransformPool::SetPosition(unsigned int index, XMFLOAT3 value)
+{
+	position[0][index] = value.x;
+	position[1][index] = value.y;
+	position[2][index] = value.z;
+	Commit(index);
+}
+
+void TransformPool::SetPitchYawRoll(unsigned int index, XMFLOAT3 value)
+{
+	pitchYawRoll[0][index] = value.x;
+	pitchYawRoll[1][index] = value.y;
+	pitchYawRoll[2][index] = value.z;
+	StoreOrientation(index, XMQuaternionRotationRollPitchYaw(value.x, value.y, value.z));
+	CountTrig(3);
+	Commit(index);
+}
+
+void TransformPool::SetQuaternion(unsigned int index, XMFLOAT4 value)
+{
+	XMVECTOR q = XMQuaternionNormalize(XMLoadFloat4(&value));
+	StoreOrientation(index, q);
+
+	// Euler angles back out of the rows, the matrix is roll * pitch * yaw
+	// row 2 = (cos p sin y, -sin p, cos p cos y), column 1 of rows 0 and 1 = (sin r cos p, cos r cos p)
+	float sinPitch = -rotation[7][index];
+	sinPitch = sinPitch > 1.0f ? 1.0f : (sinPitch < -1.0f ? -1.0f : sinPitch);
+	pitchYawRoll[0][index] = asinf(sinPitch);
+	pitchYawRoll[1][index] = atan2f(rotation[6][index], rotation[8][index]);
+	pitchYawRoll[2][index] = atan2f(rotation[1][index], rotation[4][index]);
+	CountTrig(3);
+	Commit(index);
+}
+
+void TransformPool::StoreOrientation(unsigned int index, FXMVECTOR q)
+{
+	XMFLOAT4 stored;
+	XMStoreFloat4(&stored, q);
+	quaternion[0][index] = stored.x;
+	quaternion[1][index] = stored.y;
+	quaternion[2][index] = stored.z;
+	quaternion[3][index] = stored.w;
+
+	XMFLOAT3X3 rows;
+	XMStoreFloat3x3(&rows, XMMatrixRotationQuaternion(q));
+	for (int row = 0; row < 3; row++)
+		for (int column = 0; column < 3; column++)
+			rotation[row * 3 + column][index] = rows.m[row][column];
+}
+
+void TransformPool::CopyValues(unsigned int index, unsigned int source)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		position[i][index] = position[i][source];
+		pitchYawRoll[i][index] = pitchYawRoll[i][source];
+		scale[i][index] = scale[i][source];
+	}
+	for (int i = 0; i < 4; i++)
+		quaternion[i][index] = quaternion[i][source];
+	for (int i = 0; i < 9; i++)
+		rotation[i][index] = rotation[i][source];
+	Commit(index);
+}
+
+void TransformPool::SetScale(unsigned int index, XMFLOAT3 value)
+{
+	scale[0][index] = value.x;
+	scale[1][index] = value.y;
+	scale[2][index] = value.z;
+	Commit(index);
+}
+
+void TransformPool::Commit(unsigned int index)
+{
+	if (inFixedStep && !GetBit(spawned, index))
+	{
+		SetBit(moving, index);
+		return;
+	}
+
+	//outside a step (or in the step it was created in) nothing gets blended, previous and render jump straight to the new values
+	for (int i = 0; i < 3; i++)
+	{
+		previousPosition[i][index] = renderPosition[i][index] = position[i][index];
+		previousScale[i][index] = renderScale[i][index] = scale[i][index];
+	}
+	for (int i = 0; i < 4; i++)
+		previousQuaternion[i][index] = quaternion[i][index];
+	for (int i = 0; i < 9; i++)
+		renderRotation[i][index] = rotation[i][index];
+	MarkDirty(index);
+}
+
+void TransformPool::BeginFixedStep()
+{
+	//what moved last step starts this one from where it ended, it still has to be blended into the render state
+	for (size_t word = 0; word < moving.size(); word++)
+	{
+		uint64_t bits = moving[word];
+		if (!bits)
+			continue;
+		interpolating[word] |= bits;
+		for (; bits; bits &= bits - 1)
+		{
+			unsigned int index = (unsigned int)(word * 64 + CountTrailingZeros(bits));
+			for (int i = 0; i < 3; i++)
+			{
+				previousPosition[i][index] = position[i][index];
+				previousScale[i][index] = scale[i][index];
+			}
+			for (int i = 0; i < 4; i++)
+				previousQuaternion[i][index] = quaternion[i][index];
+		}
+		moving[word] = 0;
+	}
+	if (anySpawned)
+	{
+		std::fill(spawned.begin(), spawned.end(), 0);
+		anySpawned = false;
+	}
+	inFixedStep = true;
+}
+
+void TransformPool::Interpolate(float alpha)
+{
+	// Everything still moving plus whatever stopped since the last frame (it gets blended to exactly where it ended)
+	// lanes that aren't moving have previous == current so a block can be blended as a whole
+	for (size_t word = 0; word < moving.size(); word++)
+		interpolating[word] |= moving[word];
+	lastInterpolateCount = GatherBlocks(interpolating);
+	if (!lastInterpolateCount)
+		return;
+
+	if (useAVX2)
+		TransformBatch::InterpolateBlocksAVX2(GetInterpolationArrays(), dirtyBlocks.data(), dirtyBlocks.size(), alpha);
+	else
+		TransformBatch::InterpolateBlocksSSE(GetInterpolationArrays(), dirtyBlocks.data(), dirtyBlocks.size(), alpha);
+	for (size_t word = 0; word < moving.size(); word++)
+	{
+		dirty[word] |= interpolating[word];
+		interpolating[word] = moving[word];
+	}
+}
+
+void TransformPool::SetUseAVX2(bool use)
+{
+	useAVX2 = use && hasAVX2;
+}
+
+unsigned int TransformPool::GatherBlocks(const std::vector<uint64_t>& bits)
+{
+	// Every block with at least one bit set, a block is rebuilt as a whole
+	// (recomputing a clean lane gives the same matrices, so that is cheaper than masking)
+	unsigned int lanes = useAVX2 ? 8 : 4;
+	uint64_t laneMask = (1ull << lanes) - 1;
+	unsigned int setBits = 0;
+	dirtyBlocks.clear();
+	for (size_t word = 0; word < bits.size(); word++)
+	{
+		uint64_t wordBits = bits[word];
+		if (!wordBits)
+			continue;
+		for (unsigned int lane = 0; lane < 64; lane += lanes)
+			if ((wordBits >> lane) & laneMask)
+				dirtyBlocks.push_back((unsigned int)(word * 64 + lane));
+		for (; wordBits; wordBits &= wordBits - 1)
+			setBits++;
+	}
+	return setBits;
+}
+
+void TransformPool::UpdateDirty()
+{
+	lastComposeCount = 0;
+	lastTrigCount = frameTrigCount;
+	frameTrigCount = 0;
+	lastUpdateCount = GatherBlocks(dirty);
+	bool anyChanged = anyUncomposed;
+	anyUncomposed = false;
+	for (size_t word = 0; word < dirty.size(); word++)
+	{
+		changed[word] = dirty[word];
+		anyChanged |= changed[word] != 0;
+		dirty[word] = 0;
+	}
+	if (!anyChanged)
+		return;
+
+	if (!dirtyBlocks.empty())
+	{
+		if (useAVX2)
+			TransformBatch::UpdateBlocksAVX2(GetArrays(), dirtyBlocks.data(), dirtyBlocks.size());
+		else
+			TransformBatch::UpdateBlocksSSE(GetArrays(), dirtyBlocks.data(), dirtyBlocks.size());
+	}
+
+	// Depth by depth, a parent is always finished before its children come up
+	// a child is composed when its own local or its parent's world changed (in here, or in an UpdateOne since the last sweep),
+	// and then counts as changed for its children
+	for (const std::vector<unsigned int>& bucket : depthBuckets)
+		for (unsigned int child : bucket)
+		{
+			if (!GetBit(changed, child) && !GetBit(changed, parent[child]) && GetBit(composed, child))
+				continue;
+			Compose(child);
+			SetBit(composed, child);
+			SetBit(changed, child);
+			lastComposeCount++;
+		}
+
+	//whatever moved in here gets a new version and needs its normal matrix again, built when it is asked for
+	//(what UpdateOne already rebuilt got its version then and isn't in changed)
+	for (size_t word = 0; word < changed.size(); word++)
+	{
+		uint64_t bits = changed[word];
+		if (!bits)
+			continue;
+		normalStale[word] |= bits;
+		for (; bits; bits &= bits - 1)
+			Touch((unsigned int)(word * 64 + CountTrailingZeros(bits)));
+		changed[word] = 0;
+	}
+}
+
+void TransformPool::UpdateNormals()
+{
+	lastNormalCount = GatherBlocks(normalStale);
+	if (!lastNormalCount)
+		return;
+
+	//local inverse transposes in one go, then the children compose theirs parents first like in UpdateDirty
+	if (useAVX2)
+		TransformBatch::UpdateNormalBlocksAVX2(GetArrays(), dirtyBlocks.data(), dirtyBlocks.size());
+	else
+		TransformBatch::UpdateNormalBlocksSSE(GetArrays(), dirtyBlocks.data(), dirtyBlocks.size());
+	for (const std::vector<unsigned int>& bucket : depthBuckets)
+		for (unsigned int child : bucket)
+			if (GetBit(normalStale, child))
+				ComposeNormal(child);
+	std::fill(normalStale.begin(), normalStale.end(), 0);
+}
+
+void TransformPool::UpdateOne(unsigned int index)
+{
+	//top down so the parent's world is ready before it gets composed into this one
+	if (parent[index] != NO_PARENT)
+		UpdateOne(parent[index]);
+
+	if (IsDirty(index))
+	{
+		//the SSE block around it, every transform in there comes out up to date
+		unsigned int first = index & ~3u;
+		TransformBatch::UpdateBlocksSSE(GetArrays(), &first, 1);
+		for (unsigned int i = first; i < first + 4; i++)
+		{
+			if (!IsDirty(i))
+				continue;
+			dirty[i >> 6] &= ~(1ull << (i & 63));
+			//a root's world is its local, a child only has a new local and still has to be composed
+			if (parent[i] == NO_PARENT)
+				WorldChanged(i);
+			else
+				ClearComposed(i);
+		}
+	}
+	//only when something it depends on changed, so reading it again hands out the same matrix and version
+	if (parent[index] != NO_PARENT && !GetBit(composed, index))
+	{
+		Compose(index);
+		SetBit(composed, index);
+		WorldChanged(index);
+	}
+}
+
+void TransformPool::Grow()
+{
+	//in whole dirty words so the blocks never straddle the end
+	size_t oldCapacity = local.size();
+	size_t newCapacity = oldCapacity ? oldCapacity * 2 : 64;
+	for (int i = 0; i < 3; i++)
+	{
+		position[i].resize(newCapacity, 0.0f);
+		pitchYawRoll[i].resize(newCapacity, 0.0f);
+		scale[i].resize(newCapacity, 1.0f);
+	}
+	for (int i = 0; i < 4; i++)
+		quaternion[i].resize(newCapacity, i == 3 ? 1.0f : 0.0f);
+	for (int i = 0; i < 9; i++)
+	{
+		rotation[i].resize(newCapacity, i % 4 == 0 ? 1.0f : 0.0f);
+		renderRotation[i].resize(newCapacity, i % 4 == 0 ? 1.0f : 0.0f);
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		previousPosition[i].resize(newCapacity, 0.0f);
+		previousScale[i].resize(newCapacity, 1.0f);
+		renderPosition[i].resize(newCapacity, 0.0f);
+		renderScale[i].resize(newCapacity, 1.0f);
+	}
+	for (int i = 0; i < 4; i++)
+		previousQuaternion[i].resize(newCapacity, i == 3 ? 1.0f : 0.0f);
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+	local.resize(newCapacity, identity);
+	localInverseTranspose.resize(newCapacity, identity);
+	world.resize(newCapacity, identity);
+	worldInverseTranspose.resize(newCapacity, identity);
+	dirty.resize(newCapacity / 64, 0);
+	changed.resize(newCapacity / 64, 0);
+	composed.resize(newCapacity / 64, 0);
+	normalStale.resize(newCapacity / 64, 0);
+	moving.resize(newCapacity / 64, 0);
+	interpolating.resize(newCapacity / 64, 0);
+	spawned.resize(newCapacity / 64, 0);
+	version.resize(newCapacity, 0);
+	parent.resize(newCapacity, NO_PARENT);
+	firstChild.resize(newCapacity, NO_PARENT);
+	nextSibling.resize(newCapacity, NO_PARENT);
+	previousSibling.resize(newCapacity, NO_PARENT);
+	depth.resize(newCapacity, 0);
+	bucketSlot.resize(newCapacity, 0);
+
+	//handed out lowest index first so live transforms stay packed at the front
+	for (size_t i = newCapacity; i > oldCapacity; i--)
+		freeList.push_back((unsigned int)(i - 1));
+}
+
+TransformArrays TransformPool::GetArrays()
+{
+	//matrices come from the render state
+	TransformArrays arrays;
+	for (int i = 0; i < 3; i++)
+	{
+		arrays.position[i] = renderPosition[i].data();
+		arrays.scale[i] = renderScale[i].data();
+	}
+	for (int i = 0; i < 9; i++)
+		arrays.rotation[i] = renderRotation[i].data();
+	arrays.local = local.data();
+	arrays.localInverseTranspose = localInverseTranspose.data();
+	return arrays;
+}
+
+InterpolationArrays TransformPool::GetInterpolationArrays()
+{
+	InterpolationArrays arrays;
+	for (int i = 0; i < 3; i++)
+	{
+		arrays.previousPosition[i] = previousPosition[i].data();
+		arrays.previousScale[i] = previousScale[i].data();
+		arrays.position[i] = position[i].data();
+		arrays.scale[i] = scale[i].data();
+		arrays.renderPosition[i] = renderPosition[i].data();
+		arrays.renderScale[i] = renderScale[i].data();
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		arrays.previousQuaternion[i] = previousQuaternion[i].data();
+		arrays.quaternion[i] = quaternion[i].data();
+	}
+	for (int i = 0; i < 9; i++)
+		arrays.renderRotation[i] = renderRotation[i].data();
+	return arrays;
+}
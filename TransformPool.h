@@ -0,0 +1,222 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//raw pointers into the pool's arrays for the batch kernels (TransformBatch.h)
+struct TransformArrays
+{
+	const float* position[3];
+	const float* rotation[9]; //row major, rotation[row * 3 + column]
+	const float* scale[3];
+	DirectX::XMFLOAT4X4* local;
+	DirectX::XMFLOAT4X4* localInverseTranspose;
+};
+
+//previous and current simulation state in, the blended state the matrices get built from out
+struct InterpolationArrays
+{
+	const float* previousPosition[3];
+	const float* previousQuaternion[4];
+	const float* previousScale[3];
+	const float* position[3];
+	const float* quaternion[4];
+	const float* scale[3];
+	float* renderPosition[3];
+	float* renderRotation[9];
+	float* renderScale[3];
+};
+
+// Every Transform's data, stored as structure of arrays
+// - position, orientation and scale are the source of truth (relative to the parent), the matrices are derived
+// - orientation is a quaternion plus its rotation rows (right/up/forward), built once when the rotation is set,
+//   pitch/yaw/roll is kept next to it for the sliders and the camera's pitch clamp
+// - setters only flip a bit in the dirty bitset, UpdateDirty then rebuilds every dirty local matrix in one pass,
+//   8 at a time with AVX2 (when the cpu has it) or 4 at a time with SSE, no trig in there
+// - normal matrices (inverse transposes) are lazy, UpdateDirty only flags them stale and they get built
+//   from rotation and 1 / scale when someone reads one (or all at once with UpdateNormals), never with a general inverse
+// - children are kept in one flat array per depth, so composing world = local * parent world is a linear sweep
+//   from depth 1 down where every parent is already done, and only children whose own local or parent changed get touched
+// - a root's world matrix is its local matrix, only children have world matrices of their own
+// - fixed timestep: changes made between BeginFixedStep and EndFixedStep are simulation, the state from before the
+//   step is kept and Interpolate blends the two (lerp, nlerp for the quaternion) into the render state the matrices
+//   are built from, in one batch over every transform that moved; changes made outside a step (ui, camera, spawning)
+//   are teleports and show up right away
+// - so the getters return the simulation state and the matrices show the rendered (blended) one
+// - every world matrix change stamps the transform with the next global version, caches keep the version they
+//   last saw and compare, so nobody has to consume a dirty flag to notice a change
+// - Transform is just an index in here, see Transform.h
+class TransformPool
+{
+public:
+	//lanes per block, arrays are padded to this so a block never reads past the end
+	static constexpr unsigned int BLOCK_SIZE = 8;
+	static constexpr unsigned int NO_PARENT = ~0u;
+
+	//the pool every Transform lives in
+	static TransformPool& Get();
+
+	unsigned int Allocate();
+	//children of a freed transform become roots
+	void Free(unsigned int index);
+
+	//rebuilds the dirty local matrices and then the world matrices below them, call once per frame before drawing
+	void UpdateDirty();
+	//just what one world matrix depends on (its local and its ancestors'), for reads between UpdateDirty calls
+	void UpdateOne(unsigned int index);
+	//every stale normal matrix in one batch pass, for when (nearly) everything is about to be read anyway
+	void UpdateNormals();
+
+	//around every fixed simulation step
+	void BeginFixedStep();
+	void EndFixedStep() { inFixedStep = false; }
+	//blends everything that moved in the last step by alpha (0 = previous step, 1 = current) and marks it dirty,
+	//call once per frame before UpdateDirty
+	void Interpolate(float alpha);
+
+	void MarkDirty(unsigned int index) { SetBit(dirty, index); }
+	bool IsDirty(unsigned int index) const { return GetBit(dirty, index); }
+	//the world matrix is out of date, checks the parent chain too
+	bool IsWorldDirty(unsigned int index) const;
+
+	//changes whenever the world matrix does (after it got rebuilt), never goes back and never repeats across transforms
+	uint64_t GetVersion(unsigned int index) const { return version[index]; }
+	//the latest version handed out to any transform, moves when anything moved
+	uint64_t GetGlobalVersion() const { return globalVersion; }
+
+	//false when it would create a cycle, the local values are kept (and now count relative to the new parent)
+	bool SetParent(unsigned int index, unsigned int parent);
+	unsigned int GetParent(unsigned int index) const { return parent[index]; }
+	unsigned int GetDepth(unsigned int index) const { return depth[index]; }
+	unsigned int GetMaxDepth() const { return (unsigned int)depthBuckets.size(); }
+	unsigned int GetChildCount() const; //transforms with a parent
+
+	DirectX::XMFLOAT3 GetPosition(unsigned int index) const { return { position[0][index], position[1][index], position[2][index] }; }
+	DirectX::XMFLOAT3 GetPitchYawRoll(unsigned int index) const { return { pitchYawRoll[0][index], pitchYawRoll[1][index], pitchYawRoll[2][index] }; }
+	DirectX::XMFLOAT3 GetScale(unsigned int index) const { return { scale[0][index], scale[1][index], scale[2][index] }; }
+	DirectX::XMFLOAT4 GetQuaternion(unsigned int index) const { return { quaternion[0][index], quaternion[1][index], quaternion[2][index], quaternion[3][index] }; }
+	//local space basis, always current (no update needed)
+	DirectX::XMFLOAT3 GetRight(unsigned int index) const { return GetRotationRow(index, 0); }
+	DirectX::XMFLOAT3 GetUp(unsigned int index) const { return GetRotationRow(index, 1); }
+	DirectX::XMFLOAT3 GetForward(unsigned int index) const { return GetRotationRow(index, 2); }
+	const DirectX::XMFLOAT4X4& GetLocalMatrix(unsigned int index) const { return local[index]; }
+	const DirectX::XMFLOAT4X4& GetWorldMatrix(unsigned int index) const { return parent[index] == NO_PARENT ? local[index] : world[index]; }
+	//builds it first when stale, the world matrix has to be up to date (see IsWorldDirty)
+	const DirectX::XMFLOAT4X4& GetWorldInverseTransposeMatrix(unsigned int index);
+	bool IsNormalStale(unsigned int index) const { return GetBit(normalStale, index); }
+	//what was last built, never builds anything so any number of threads can read at once (after UpdateNormals it is current)
+	const DirectX::XMFLOAT4X4& GetBuiltWorldInverseTransposeMatrix(unsigned int index) const { return parent[index] == NO_PARENT ? localInverseTranspose[index] : worldInverseTranspose[index]; }
+
+	void SetPosition(unsigned int index, DirectX::XMFLOAT3 value);
+	void SetPitchYawRoll(unsigned int index, DirectX::XMFLOAT3 value);
+	//normalized first, pitch/yaw/roll is worked out from it
+	void SetQuaternion(unsigned int index, DirectX::XMFLOAT4 value);
+	void SetScale(unsigned int index, DirectX::XMFLOAT3 value);
+	//every value of source into index, nothing gets recomputed
+	void CopyValues(unsigned int index, unsigned int source);
+
+	unsigned int GetCount() const { return count; } //live transforms
+	unsigned int GetCapacity() const { return (unsigned int)local.size(); }
+	unsigned int GetLastUpdateCount() const { return lastUpdateCount; } //dirty transforms in the last UpdateDirty
+	unsigned int GetLastComposeCount() const { return lastComposeCount; } //world matrices rebuilt in the last UpdateDirty
+	unsigned int GetLastNormalCount() const { return lastNormalCount; } //normal matrices built by the last UpdateNormals
+	unsigned int GetLastInterpolateCount() const { return lastInterpolateCount; } //transforms blended by the last Interpolate
+	//scalar trig calls (a sin/cos pair, asin or atan2 each) made by rotation setters between the last two UpdateDirty calls
+	unsigned int GetLastTrigCount() const { return lastTrigCount; }
+	unsigned long long GetTotalTrigCount() const { return totalTrigCount; }
+	bool UsesAVX2() const { return useAVX2; }
+	//for benchmarking the fallback on a machine that has AVX2
+	void SetUseAVX2(bool use);
+
+private:
+	TransformPool();
+
+	std::vector<float> position[3];
+	std::vector<float> pitchYawRoll[3];
+	std::vector<float> scale[3];
+	std::vector<float> quaternion[4];
+	std::vector<float> rotation[9];
+	//simulation state before the current fixed step
+	std::vector<float> previousPosition[3];
+	std::vector<float> previousQuaternion[4];
+	std::vector<float> previousScale[3];
+	//what the local matrices are built from, the blend of previous and current
+	std::vector<float> renderPosition[3];
+	std::vector<float> renderRotation[9];
+	std::vector<float> renderScale[3];
+	std::vector<DirectX::XMFLOAT4X4> local;
+	std::vector<DirectX::XMFLOAT4X4> localInverseTranspose; //lazy, see normalStale
+	std::vector<DirectX::XMFLOAT4X4> world; //children only
+	std::vector<DirectX::XMFLOAT4X4> worldInverseTranspose;
+	std::vector<uint64_t> dirty; //one bit per transform, the local values changed
+	std::vector<uint64_t> changed; //world matrix rebuilt in the current UpdateDirty sweep, children have to follow
+	std::vector<uint64_t> composed; //children only, the world matrix was composed from the current local and parent world
+	bool anyUncomposed = false; //some child's composed bit got cleared since the last sweep
+	std::vector<uint64_t> normalStale; //world matrix changed since the inverse transpose was built
+	std::vector<uint64_t> moving; //changed during the current fixed step, previous and current differ
+	std::vector<uint64_t> interpolating; //render state isn't the current state yet
+	std::vector<uint64_t> spawned; //allocated during the current fixed step, its changes are teleports until the next one
+	std::vector<uint64_t> version;
+	uint64_t globalVersion = 0;
+	std::vector<unsigned int> freeList;
+	std::vector<unsigned int> dirtyBlocks; //scratch for UpdateDirty and UpdateNormals
+
+	// Hierarchy
+	// - parent/child links, siblings are a doubly linked list so unlinking is O(1)
+	// - depthBuckets[d - 1] holds every transform at depth d, bucketSlot is where in there, roots aren't in any
+	std::vector<unsigned int> parent;
+	std::vector<unsigned int> firstChild;
+	std::vector<unsigned int> nextSibling;
+	std::vector<unsigned int> previousSibling;
+	std::vector<unsigned int> depth;
+	std::vector<unsigned int> bucketSlot;
+	std::vector<std::vector<unsigned int>> depthBuckets;
+
+	unsigned int count = 0;
+	unsigned int lastUpdateCount = 0;
+	unsigned int lastComposeCount = 0;
+	unsigned int lastNormalCount = 0;
+	unsigned int lastInterpolateCount = 0;
+	bool inFixedStep = false;
+	bool anySpawned = false;
+	unsigned int frameTrigCount = 0;
+	unsigned int lastTrigCount = 0;
+	unsigned long long totalTrigCount = 0;
+	bool hasAVX2 = false;
+	bool useAVX2 = false;
+
+	void Grow();
+	unsigned int GatherBlocks(const std::vector<uint64_t>& bits); //into dirtyBlocks, returns how many bits are set
+	void StoreOrientation(unsigned int index, DirectX::FXMVECTOR quaternion);
+	void Touch(unsigned int index) { version[index] = ++globalVersion; }
+	void WorldChanged(unsigned int index); //new version, stale normal, and the children have to compose again
+	void ClearComposed(unsigned int index) { composed[index >> 6] &= ~(1ull << (index & 63)); anyUncomposed = true; }
+	void CountTrig(unsigned int calls) { frameTrigCount += calls; totalTrigCount += calls; }
+	DirectX::XMFLOAT3 GetRotationRow(unsigned int index, int row) const { return { rotation[row * 3][index], rotation[row * 3 + 1][index], rotation[row * 3 + 2][index] }; }
+	TransformArrays GetArrays();
+	InterpolationArrays GetInterpolationArrays();
+	void Commit(unsigned int index); //after a setter, a teleport outside fixed steps
+	void Compose(unsigned int index);
+	void ComposeNormal(unsigned int index);
+	void Unlink(unsigned int index);
+	void SetDepth(unsigned int index, unsigned int newDepth); //moves the whole subtree between buckets
+
+	static void SetBit(std::vector<uint64_t>& bits, unsigned int index) { bits[index >> 6] |= 1ull << (index & 63); }
+	static bool GetBit(const std::vector<uint64_t>& bits, unsigned int index) { return (bits[index >> 6] >> (index & 63)) & 1; }
+};
+
+//batch kernels, defined in TransformPool.cpp (SSE) and TransformPoolAVX2.cpp (compiled with /arch:AVX2)
+//block starts are multiples of their lane count, every lane of a block is rebuilt
+namespace TransformBatch
+{
+	//local matrices
+	void UpdateBlocksSSE(const TransformArrays& arrays, const unsigned int* blockStarts, size_t blockCount);
+	void UpdateBlocksAVX2(const TransformArrays& arrays, const unsigned int* blockStarts, size_t blockCount);
+	//local inverse transposes
+	void UpdateNormalBlocksSSE(const TransformArrays& arrays, const unsigned int* blockStarts, size_t blockCount);
+	void UpdateNormalBlocksAVX2(const TransformArrays& arrays, const unsigned int* blockStarts, size_t blockCount);
+	//render state
+	void InterpolateBlocksSSE(const InterpolationArrays& arrays, const unsigned int* blockStarts, size_t blockCount, float alpha);
+	void InterpolateBlocksAVX2(const InterpolationArrays& arrays, const unsigned int* blockStarts, size_t blockCount, float alpha);
+}
@@ -0,0 +1,63 @@
+// Compiled with /arch:AVX2 (see the project file), only called when TransformPool found AVX2 and FMA at runtime
+#include "TransformPool.h"
+#include <immintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	//8 lanes
+	struct AVX2
+	{
+		using T = __m256;
+		static constexpr unsigned int LANES = 8;
+		static T Load(const float* p) { return _mm256_loadu_ps(p); }
+		static void Store(float* p, T v) { _mm256_storeu_ps(p, v); }
+		static T Set(float f) { return _mm256_set1_ps(f); }
+		static T Add(T a, T b) { return _mm256_add_ps(a, b); }
+		static T Sub(T a, T b) { return _mm256_sub_ps(a, b); }
+		static T Mul(T a, T b) { return _mm256_mul_ps(a, b); }
+		static T Div(T a, T b) { return _mm256_div_ps(a, b); }
+		static T Sqrt(T a) { return _mm256_sqrt_ps(a); }
+		static T And(T a, T b) { return _mm256_and_ps(a, b); }
+		static T Xor(T a, T b) { return _mm256_xor_ps(a, b); }
+		static void StoreRows(XMFLOAT4X4* out, int row, T v[4])
+		{
+			//4x4 transpose inside each 128 bit half, the low half holds lanes 0-3 and the high half lanes 4-7
+			T t0 = _mm256_unpacklo_ps(v[0], v[1]);
+			T t1 = _mm256_unpackhi_ps(v[0], v[1]);
+			T t2 = _mm256_unpacklo_ps(v[2], v[3]);
+			T t3 = _mm256_unpackhi_ps(v[2], v[3]);
+			T r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+			T r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+			T r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+			T r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+			T rows[4] = { r0, r1, r2, r3 };
+			for (int i = 0; i < 4; i++)
+			{
+				_mm_storeu_ps(out[i].m[row], _mm256_castps256_ps128(rows[i]));
+				_mm_storeu_ps(out[i + 4].m[row], _mm256_extractf128_ps(rows[i], 1));
+			}
+		}
+	};
+
+#include "TransformBatch.h"
+}
+
+void TransformBatch::UpdateBlocksAVX2(const TransformArrays& arrays, const unsigned int* blockStarts, size_t blockCount)
+{
+	for (size_t i = 0; i < blockCount; i++)
+		UpdateBlock<AVX2>(arrays, blockStarts[i]);
+}
+
+void TransformBatch::UpdateNormalBlocksAVX2(const TransformArrays& arrays, const unsigned int* blockStarts, size_t blockCount)
+{
+	for (size_t i = 0; i < blockCount; i++)
+		UpdateNormalBlock<AVX2>(arrays, blockStarts[i]);
+}
+
+void TransformBatch::InterpolateBlocksAVX2(const InterpolationArrays& arrays, const unsigned int* blockStarts, size_t blockCount, float alpha)
+{
+	for (size_t i = 0; i < blockCount; i++)
+		InterpolateBlock<AVX2>(arrays, blockStarts[i], alpha);
+}
@@ -8,5 +8,5 @@ struct Vertex //ensure it is consistent with VertexToPixel
 	DirectX::XMFLOAT2 UV;			// The texture coordinates of the vertex
 	DirectX::XMFLOAT3 Normal;		// The normal of the vertex
 	//tangent here when needed
-	UINT InstanceID;
+	unsigned int InstanceID; //UINT, spelled out so the header doesn't need windows.h
 };
\ No newline at end of file
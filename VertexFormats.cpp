@@ -0,0 +1,266 @@
+#include "VertexFormats.h"
+#include <emmintrin.h>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// float <-> half conversions in plain SSE2 (no F16C), after Fabian Giesen's float_to_half_fast3_rtne / half_to_float_fast
+	// in: 4 floats, out: 4 halves in the low 16 bits of each lane (upper bits may hold the sign extension)
+	inline __m128i FloatToHalf(__m128 f)
+	{
+		const __m128i maskSign = _mm_set1_epi32((int)0x80000000u);
+		const __m128i f16Max = _mm_set1_epi32((127 + 16) << 23);
+		const __m128i nanBit = _mm_set1_epi32(0x200);
+		const __m128i infinityHalf = _mm_set1_epi32(0x7C00);
+		const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+		const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+		const __m128i normalBias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+		__m128 justSign = _mm_and_ps(_mm_castsi128_ps(maskSign), f);
+		__m128 absF = _mm_xor_ps(f, justSign);
+		__m128i absInt = _mm_castps_si128(absF);
+		__m128 isNan = _mm_cmpunord_ps(absF, absF);
+		__m128i isRegular = _mm_cmpgt_epi32(f16Max, absInt);
+		__m128i infOrNan = _mm_or_si128(_mm_and_si128(_mm_castps_si128(isNan), nanBit), infinityHalf);
+		__m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absInt);
+
+		//subnormal results, let the fpu do the rounding
+		__m128 subnormal1 = _mm_add_ps(absF, _mm_castsi128_ps(subnormalMagic));
+		__m128i subnormal2 = _mm_sub_epi32(_mm_castps_si128(subnormal1), subnormalMagic);
+
+		//normal results, rebias the exponent and round to nearest even
+		__m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absInt, 31 - 13), 31);
+		__m128i rounded = _mm_sub_epi32(_mm_add_epi32(absInt, normalBias), mantissaOdd);
+		__m128i normal = _mm_srli_epi32(rounded, 13);
+
+		__m128i nonSpecial = _mm_or_si128(_mm_and_si128(subnormal2, isSubnormal), _mm_andnot_si128(isSubnormal, normal));
+		__m128i joined = _mm_or_si128(_mm_and_si128(nonSpecial, isRegular), _mm_andnot_si128(isRegular, infOrNan));
+		return _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(justSign), 16));
+	}
+
+	//in: 4 halves zero extended to 32 bits
+	inline __m128 HalfToFloat(__m128i h)
+	{
+		const __m128i maskNoSign = _mm_set1_epi32(0x7FFF);
+		const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+		const __m128i wasInfNan = _mm_set1_epi32(0x7BFF);
+		const __m128 infNanExponent = _mm_castsi128_ps(_mm_set1_epi32(255 << 23));
+
+		__m128i exponentMantissa = _mm_and_si128(maskNoSign, h);
+		__m128i justSign = _mm_xor_si128(h, exponentMantissa);
+		__m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponentMantissa, 13)), magic);
+		__m128i isInfNan = _mm_cmpgt_epi32(exponentMantissa, wasInfNan);
+		__m128 signAndInf = _mm_or_ps(_mm_castsi128_ps(_mm_slli_epi32(justSign, 16)), _mm_and_ps(_mm_castsi128_ps(isInfNan), infNanExponent));
+		return _mm_or_ps(scaled, signAndInf);
+	}
+
+	inline __m128 Abs(__m128 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+
+	//+1 or -1 with the sign of v, 0 counts as positive so the octahedral fold stays stable
+	inline __m128 SignNotZero(__m128 v)
+	{
+		return _mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(v, _mm_set1_ps(-0.0f)));
+	}
+
+	inline __m128i Low16(__m128i v) { return _mm_and_si128(v, _mm_set1_epi32(0xFFFF)); }
+
+	inline void Transpose(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+	{
+		__m128 r0 = _mm_castsi128_ps(a), r1 = _mm_castsi128_ps(b), r2 = _mm_castsi128_ps(c), r3 = _mm_castsi128_ps(d);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		a = _mm_castps_si128(r0); b = _mm_castps_si128(r1); c = _mm_castps_si128(r2); d = _mm_castps_si128(r3);
+	}
+
+	//encodes exactly 4 vertices, the caller pads the tail
+	void Encode4(const Vertex* v, __m128 boundsMin, __m128 invExtent, CompactVertex* out)
+	{
+		//gather AoS -> SoA, each load grabs 4 consecutive floats of a vertex
+		__m128 px = _mm_loadu_ps(&v[0].Position.x), py = _mm_loadu_ps(&v[1].Position.x), pz = _mm_loadu_ps(&v[2].Position.x), pw = _mm_loadu_ps(&v[3].Position.x);
+		__m128 uvA = _mm_loadu_ps(&v[0].UV.x), uvB = _mm_loadu_ps(&v[1].UV.x), uvC = _mm_loadu_ps(&v[2].UV.x), uvD = _mm_loadu_ps(&v[3].UV.x);
+		__m128 nA = _mm_loadu_ps(&v[0].Normal.x), nB = _mm_loadu_ps(&v[1].Normal.x), nC = _mm_loadu_ps(&v[2].Normal.x), nD = _mm_loadu_ps(&v[3].Normal.x);
+		_MM_TRANSPOSE4_PS(px, py, pz, pw);
+		_MM_TRANSPOSE4_PS(uvA, uvB, uvC, uvD);
+		_MM_TRANSPOSE4_PS(nA, nB, nC, nD);
+		//now px/py/pz are x/y/z of the 4 vertices, uvA/uvB are u/v and nA/nB/nC are normal x/y/z
+
+		//positions, 16 bit unorm inside the bounds
+		const __m128 unormScale = _mm_set1_ps(65535.0f);
+		const __m128 zero = _mm_setzero_ps();
+		auto quantize = [&](__m128 p, int lane)
+		{
+			__m128 minLane = _mm_shuffle_ps(boundsMin, boundsMin, _MM_SHUFFLE(0, 0, 0, 0));
+			__m128 scaleLane = _mm_shuffle_ps(invExtent, invExtent, _MM_SHUFFLE(0, 0, 0, 0));
+			if (lane == 1) { minLane = _mm_shuffle_ps(boundsMin, boundsMin, _MM_SHUFFLE(1, 1, 1, 1)); scaleLane = _mm_shuffle_ps(invExtent, invExtent, _MM_SHUFFLE(1, 1, 1, 1)); }
+			if (lane == 2) { minLane = _mm_shuffle_ps(boundsMin, boundsMin, _MM_SHUFFLE(2, 2, 2, 2)); scaleLane = _mm_shuffle_ps(invExtent, invExtent, _MM_SHUFFLE(2, 2, 2, 2)); }
+			__m128 normalized = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(p, minLane), scaleLane), zero), _mm_set1_ps(1.0f));
+			return _mm_cvtps_epi32(_mm_mul_ps(normalized, unormScale)); //round to nearest
+		};
+		__m128i qx = quantize(px, 0), qy = quantize(py, 1), qz = quantize(pz, 2);
+
+		//uvs as halves
+		__m128i hu = FloatToHalf(uvA), hv = FloatToHalf(uvB);
+
+		//normals, project onto the octahedron then fold the lower hemisphere over the diagonals
+		__m128 nx = nA, ny = nB, nz = nC;
+		__m128 l1 = _mm_add_ps(_mm_add_ps(Abs(nx), Abs(ny)), Abs(nz));
+		__m128 invL1 = _mm_div_ps(_mm_set1_ps(1.0f), _mm_max_ps(l1, _mm_set1_ps(1e-20f)));
+		__m128 ox = _mm_mul_ps(nx, invL1), oy = _mm_mul_ps(ny, invL1);
+		__m128 foldX = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), Abs(oy)), SignNotZero(ox));
+		__m128 foldY = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), Abs(ox)), SignNotZero(oy));
+		__m128 lower = _mm_cmplt_ps(nz, zero);
+		ox = _mm_or_ps(_mm_and_ps(lower, foldX), _mm_andnot_ps(lower, ox));
+		oy = _mm_or_ps(_mm_and_ps(lower, foldY), _mm_andnot_ps(lower, oy));
+		const __m128 snormScale = _mm_set1_ps(32767.0f);
+		__m128i sx = _mm_cvtps_epi32(_mm_mul_ps(ox, snormScale));
+		__m128i sy = _mm_cvtps_epi32(_mm_mul_ps(oy, snormScale));
+
+		//pack pairs of 16 bit values into dwords, then transpose back to one row per vertex
+		__m128i d0 = _mm_or_si128(Low16(qx), _mm_slli_epi32(qy, 16));
+		__m128i d1 = Low16(qz);
+		__m128i d2 = _mm_or_si128(Low16(hu), _mm_slli_epi32(hv, 16));
+		__m128i d3 = _mm_or_si128(Low16(sx), _mm_slli_epi32(sy, 16));
+		Transpose(d0, d1, d2, d3);
+		_mm_storeu_si128((__m128i*)&out[0], d0);
+		_mm_storeu_si128((__m128i*)&out[1], d1);
+		_mm_storeu_si128((__m128i*)&out[2], d2);
+		_mm_storeu_si128((__m128i*)&out[3], d3);
+	}
+
+	void Decode4(const CompactVertex* v, __m128 boundsMin, __m128 extent, Vertex* out)
+	{
+		__m128i d0 = _mm_loadu_si128((const __m128i*)&v[0]);
+		__m128i d1 = _mm_loadu_si128((const __m128i*)&v[1]);
+		__m128i d2 = _mm_loadu_si128((const __m128i*)&v[2]);
+		__m128i d3 = _mm_loadu_si128((const __m128i*)&v[3]);
+		Transpose(d0, d1, d2, d3);
+
+		const __m128 invUnorm = _mm_set1_ps(1.0f / 65535.0f);
+		__m128 px = _mm_mul_ps(_mm_cvtepi32_ps(Low16(d0)), invUnorm);
+		__m128 py = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(d0, 16)), invUnorm);
+		__m128 pz = _mm_mul_ps(_mm_cvtepi32_ps(Low16(d1)), invUnorm);
+		px = _mm_add_ps(_mm_shuffle_ps(boundsMin, boundsMin, _MM_SHUFFLE(0, 0, 0, 0)), _mm_mul_ps(px, _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(0, 0, 0, 0))));
+		py = _mm_add_ps(_mm_shuffle_ps(boundsMin, boundsMin, _MM_SHUFFLE(1, 1, 1, 1)), _mm_mul_ps(py, _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(1, 1, 1, 1))));
+		pz = _mm_add_ps(_mm_shuffle_ps(boundsMin, boundsMin, _MM_SHUFFLE(2, 2, 2, 2)), _mm_mul_ps(pz, _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(2, 2, 2, 2))));
+
+		__m128 u = HalfToFloat(Low16(d2));
+		__m128 uv = HalfToFloat(_mm_srli_epi32(d2, 16));
+
+		//sign extend the snorm halves, clamp -32768 to -1 like the gpu does
+		const __m128 invSnorm = _mm_set1_ps(1.0f / 32767.0f);
+		const __m128 minusOne = _mm_set1_ps(-1.0f);
+		__m128 ox = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(d3, 16), 16)), invSnorm), minusOne);
+		__m128 oy = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(d3, 16)), invSnorm), minusOne);
+
+		//unfold the octahedron
+		__m128 nz = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), Abs(ox)), Abs(oy));
+		__m128 t = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), nz), _mm_setzero_ps());
+		__m128 nx = _mm_sub_ps(ox, _mm_mul_ps(t, SignNotZero(ox)));
+		__m128 ny = _mm_sub_ps(oy, _mm_mul_ps(t, SignNotZero(oy)));
+		__m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz))));
+		nx = _mm_mul_ps(nx, invLength);
+		ny = _mm_mul_ps(ny, invLength);
+		nz = _mm_mul_ps(nz, invLength);
+
+		alignas(16) float lanes[8][4];
+		_mm_store_ps(lanes[0], px); _mm_store_ps(lanes[1], py); _mm_store_ps(lanes[2], pz);
+		_mm_store_ps(lanes[3], u); _mm_store_ps(lanes[4], uv);
+		_mm_store_ps(lanes[5], nx); _mm_store_ps(lanes[6], ny); _mm_store_ps(lanes[7], nz);
+		for (int i = 0; i < 4; i++)
+		{
+			out[i].Position = XMFLOAT3(lanes[0][i], lanes[1][i], lanes[2][i]);
+			out[i].UV = XMFLOAT2(lanes[3][i], lanes[4][i]);
+			out[i].Normal = XMFLOAT3(lanes[5][i], lanes[6][i], lanes[7][i]);
+			out[i].InstanceID = 0;
+		}
+	}
+
+	void BoundsVectors(XMFLOAT3 boundsMin, XMFLOAT3 boundsMax, __m128& minV, __m128& extentV, __m128& invExtentV)
+	{
+		minV = _mm_setr_ps(boundsMin.x, boundsMin.y, boundsMin.z, 0.0f);
+		extentV = _mm_sub_ps(_mm_setr_ps(boundsMax.x, boundsMax.y, boundsMax.z, 0.0f), minV);
+		//flat axes (a quad has no depth) quantize to 0 instead of dividing by zero
+		__m128 nonZero = _mm_cmpgt_ps(extentV, _mm_setzero_ps());
+		invExtentV = _mm_and_ps(nonZero, _mm_div_ps(_mm_set1_ps(1.0f), _mm_or_ps(extentV, _mm_andnot_ps(nonZero, _mm_set1_ps(1.0f)))));
+	}
+}
+
+size_t VertexQuantization::GetStride(VertexFormat format)
+{
+	switch (format)
+	{
+	case VertexFormat::Compact: return sizeof(CompactVertex);
+	case VertexFormat::Full:
+	default: return sizeof(Vertex);
+	}
+}
+
+void VertexQuantization::Encode(const Vertex* vertices, size_t count, XMFLOAT3 boundsMin, XMFLOAT3 boundsMax, CompactVertex* out)
+{
+	__m128 minV, extentV, invExtentV;
+	BoundsVectors(boundsMin, boundsMax, minV, extentV, invExtentV);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		Encode4(&vertices[i], minV, invExtentV, &out[i]);
+
+	if (i < count)
+	{
+		//pad the tail by repeating the last vertex
+		Vertex tail[4];
+		CompactVertex tailOut[4];
+		for (size_t t = 0; t < 4; t++)
+			tail[t] = vertices[i + t < count ? i + t : count - 1];
+		Encode4(tail, minV, invExtentV, tailOut);
+		memcpy(&out[i], tailOut, (count - i) * sizeof(CompactVertex));
+	}
+}
+
+void VertexQuantization::Decode(const CompactVertex* vertices, size_t count, XMFLOAT3 boundsMin, XMFLOAT3 boundsMax, Vertex* out)
+{
+	__m128 minV, extentV, invExtentV;
+	BoundsVectors(boundsMin, boundsMax, minV, extentV, invExtentV);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		Decode4(&vertices[i], minV, extentV, &out[i]);
+
+	if (i < count)
+	{
+		CompactVertex tail[4];
+		Vertex tailOut[4];
+		for (size_t t = 0; t < 4; t++)
+			tail[t] = vertices[i + t < count ? i + t : count - 1];
+		Decode4(tail, minV, extentV, tailOut);
+		memcpy(&out[i], tailOut, (count - i) * sizeof(Vertex));
+	}
+}
+
+QuantizationError VertexQuantization::MeasureError(const Vertex* original, const CompactVertex* encoded, size_t count, XMFLOAT3 boundsMin, XMFLOAT3 boundsMax)
+{
+	QuantizationError error;
+	std::vector<Vertex> decoded(count);
+	Decode(encoded, count, boundsMin, boundsMax, decoded.data());
+
+	float minNormalDot = 1.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		const Vertex& a = original[i];
+		const Vertex& b = decoded[i];
+		float dx = a.Position.x - b.Position.x, dy = a.Position.y - b.Position.y, dz = a.Position.z - b.Position.z;
+		error.position = fmaxf(error.position, sqrtf(dx * dx + dy * dy + dz * dz));
+		error.uv = fmaxf(error.uv, fmaxf(fabsf(a.UV.x - b.UV.x), fabsf(a.UV.y - b.UV.y)));
+
+		float length = sqrtf(a.Normal.x * a.Normal.x + a.Normal.y * a.Normal.y + a.Normal.z * a.Normal.z);
+		if (length > 0.0f)
+		{
+			float d = (a.Normal.x * b.Normal.x + a.Normal.y * b.Normal.y + a.Normal.z * b.Normal.z) / length;
+			minNormalDot = fminf(minNormalDot, d);
+		}
+	}
+	error.normalDegrees = acosf(fmaxf(-1.0f, fminf(1.0f, minNormalDot))) * (180.0f / 3.14159265f);
+	return error;
+}
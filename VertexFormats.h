@@ -0,0 +1,46 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include "Vertex.h"
+
+//vertex layouts a mesh can be uploaded with
+enum class VertexFormat
+{
+	Full,		//Vertex, 36 bytes of floats
+	Compact,	//CompactVertex, 16 bytes
+};
+
+// 16 byte quantized vertex, decoded by CompactVertexShader.hlsl
+// - position: 16 bit unorm relative to the mesh bounds (R16G16B16A16_UNORM, w is padding)
+// - uv: half floats (R16G16_FLOAT)
+// - normal: octahedral encoded 16 bit snorm (R16G16_SNORM)
+struct CompactVertex
+{
+	uint16_t Position[4];
+	uint16_t UV[2];
+	int16_t Normal[2];
+};
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex must stay 16 bytes");
+
+//worst case round trip error of an encode
+struct QuantizationError
+{
+	float position = 0.0f;		//max distance in local space units
+	float uv = 0.0f;			//max per component difference
+	float normalDegrees = 0.0f;	//max angle between original and decoded normal
+};
+
+// SSE2 encoder/decoder between Vertex and CompactVertex, 4 vertices at a time
+// positions are stored relative to boundsMin over (boundsMax - boundsMin) so the shader
+// needs that offset and scale to decode them
+namespace VertexQuantization
+{
+	size_t GetStride(VertexFormat format);
+
+	void Encode(const Vertex* vertices, size_t count, DirectX::XMFLOAT3 boundsMin, DirectX::XMFLOAT3 boundsMax, CompactVertex* out);
+	void Decode(const CompactVertex* vertices, size_t count, DirectX::XMFLOAT3 boundsMin, DirectX::XMFLOAT3 boundsMax, Vertex* out);
+
+	//decodes the encoded data and compares it with the source
+	QuantizationError MeasureError(const Vertex* original, const CompactVertex* encoded, size_t count, DirectX::XMFLOAT3 boundsMin, DirectX::XMFLOAT3 boundsMax);
+}
@@ -0,0 +1,67 @@
+#include "VertexWelder.h"
+#include <cstdint>
+
+namespace
+{
+	constexpr unsigned int EMPTY_SLOT = 0xFFFFFFFFu;
+
+	inline uint32_t HashCorner(const ObjIndex& c)
+	{
+		//cheap multiplicative mix, the triplets are small sequential ints so they need spreading
+		uint32_t h = (uint32_t)c.Position * 0x9E3779B1u;
+		h ^= (uint32_t)c.UV * 0x85EBCA77u;
+		h ^= (uint32_t)c.Normal * 0xC2B2AE3Du;
+		h ^= h >> 15;
+		h *= 0x2C1B3C6Du;
+		h ^= h >> 12;
+		return h;
+	}
+
+	inline bool SameCorner(const ObjIndex& a, const ObjIndex& b)
+	{
+		return a.Position == b.Position && a.UV == b.UV && a.Normal == b.Normal;
+	}
+}
+
+size_t VertexWelder::Weld(const ObjIndex* corners, size_t cornerCount, std::vector<ObjIndex>& uniqueCorners, std::vector<unsigned int>& indices)
+{
+	uniqueCorners.clear();
+	indices.clear();
+	indices.resize(cornerCount);
+
+	//power of two with load factor <= 0.5 so linear probes stay short
+	size_t tableSize = 16;
+	while (tableSize < cornerCount * 2)
+		tableSize <<= 1;
+	const size_t mask = tableSize - 1;
+
+	//the table stores indices into uniqueCorners, the key lives there instead of being duplicated
+	std::vector<unsigned int> table(tableSize, EMPTY_SLOT);
+	uniqueCorners.reserve(cornerCount / 2);
+
+	for (size_t i = 0; i < cornerCount; i++)
+	{
+		const ObjIndex& corner = corners[i];
+		size_t slot = HashCorner(corner) & mask;
+		while (true)
+		{
+			unsigned int existing = table[slot];
+			if (existing == EMPTY_SLOT)
+			{
+				existing = (unsigned int)uniqueCorners.size();
+				table[slot] = existing;
+				uniqueCorners.push_back(corner);
+				indices[i] = existing;
+				break;
+			}
+			if (SameCorner(uniqueCorners[existing], corner))
+			{
+				indices[i] = existing;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	return uniqueCorners.size();
+}
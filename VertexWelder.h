@@ -0,0 +1,14 @@
+#pragma once
+#include <vector>
+#include "ObjParser.h"
+
+// Deduplicates obj corners so the index buffer actually shares vertices
+// - two corners are the same vertex when their (position, uv, normal) index triplets match
+// - uses an open addressing hash table sized up front, so there is no per insert allocation
+namespace VertexWelder
+{
+	//uniqueCorners gets one entry per distinct triplet in first use order
+	//indices gets one entry per input corner pointing into uniqueCorners
+	//returns the number of unique corners
+	size_t Weld(const ObjIndex* corners, size_t cornerCount, std::vector<ObjIndex>& uniqueCorners, std::vector<unsigned int>& indices);
+}
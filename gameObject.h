@@ -1,30 +0,0 @@
-#pragma once
-#include <wrl/client.h>
-#include <DirectXMath.h>
-#include <memory>
-
-#include "Mesh.h"
-#include "Material.h"
-#include "Transform.h"
-#include "Camera.h"
-#include "SharedBuffers.h"
-
-class GameObject
-{
-   public:
-	 GameObject(std::shared_ptr<Mesh> target, std::shared_ptr<Material> material);
-	 ~GameObject();
-	 std::shared_ptr<Mesh> GetMesh();
-	 std::shared_ptr<Transform> GetTransform();
-	 std::shared_ptr<Material> GetMaterial();
-
-	 void SetMaterial(std::shared_ptr<Material> material);
-	 void SetMesh(std::shared_ptr<Mesh> mesh);
-	 void Draw(std::shared_ptr<Camera> camera, UINT objectIndex);
-	 void DrawInstanced(std::shared_ptr<Camera> camera, int instanceCount);
-
-   private:
-	std::shared_ptr<Mesh> mesh;
-	std::shared_ptr<Transform> transform;
-	std::shared_ptr<Material> material;
-};
\ No newline at end of file